@@ -0,0 +1,78 @@
+#include "AssetBaker.hpp"
+#include "MeshImporter.hpp"
+#include "ThreadPool.hpp"
+
+#include <stdexcept>
+#include <exception>
+#include <iostream>
+#include <string>
+
+/**
+* Usage : AssetBaker [SourceDirectory] [OutputDirectory] [--quality fast|normal|high] [--force]
+* Defaults to "." and "Baked", run it from the working directory of VkRenderer so the baked paths
+* match the ones the renderer looks up. Only assets that changed since the last run are baked.
+*/
+int main(int argc, char ** argv)
+{
+	VkRenderer::BakeSettings Settings;
+	uint32_t DirectoryCount = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string Arg = argv[i];
+		bool bHasValue = i + 1 < argc;
+
+		if (Arg == "--quality" && bHasValue)
+		{
+			std::string Quality = argv[++i];
+			if (Quality != "fast" && Quality != "normal" && Quality != "high")
+			{
+				std::cerr << "Unknown quality " << Quality << std::endl;
+				return EXIT_FAILURE;
+			}
+			Settings.TextureQuality = Quality == "fast" ? VkRenderer::BC_QUALITY_FAST :
+				Quality == "high" ? VkRenderer::BC_QUALITY_HIGH : VkRenderer::BC_QUALITY_NORMAL;
+		}
+		else if (Arg == "--force")
+		{
+			Settings.bForce = true;
+		}
+		else if (Arg.compare(0, 2, "--") != 0 && DirectoryCount < 2)
+		{
+			(DirectoryCount++ == 0 ? Settings.SourceDirectory : Settings.OutputDirectory) = Arg;
+		}
+		else
+		{
+			std::cerr << "Unknown argument " << Arg << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	/** The renderer loads the baked meshes with its default import settings, any change of them rebakes every mesh */
+	const VkRenderer::MeshImportSettings MeshSettings;
+	Settings.MeshSettingsHash = VkRenderer::GetMeshImportSettingsHash(MeshSettings);
+
+	VkRenderer::ThreadPool Pool;
+	Pool.Init(0);
+
+	auto BakeMesh = [&](const std::string & SourceFilename, const std::string & BakedFilename)
+	{
+		VkRenderer::BakeMeshScene(MeshSettings, SourceFilename, BakedFilename, Pool, std::cout);
+	};
+
+	VkRenderer::BakeStatistics Statistics;
+
+	try
+	{
+		Statistics = VkRenderer::BakeAssets(Settings, BakeMesh, Pool, std::cout);
+	}
+	catch (const std::exception & Ex)
+	{
+		std::cerr << Ex.what() << std::endl;
+		Statistics.Failed++;
+	}
+
+	Pool.Destroy();
+
+	return Statistics.Failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,71 @@
+#include "Benchmarks.hpp"
+#include "BcEncoder.hpp"
+#include "ThreadPool.hpp"
+
+#include <stb_image.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+void RunBcEncoderBenchmark(
+	const std::string & Filename
+)
+{
+	int Width = 0, Height = 0, Channels = 0;
+	stbi_uc * pPixels = stbi_load(Filename.c_str(), &Width, &Height, &Channels, STBI_rgb_alpha);
+
+	if (pPixels == nullptr)
+	{
+		throw std::runtime_error("Failed to load texture image!");
+	}
+
+	ThreadPool Pool;
+	Pool.Init(0);
+
+	const uint32_t TexWidth = static_cast<uint32_t>(Width);
+	const uint32_t TexHeight = static_cast<uint32_t>(Height);
+	const std::string ThreadsName = "SIMD, " + std::to_string(Pool.GetThreadCount()) + " threads";
+
+	std::vector<uint8_t> Blocks;
+	std::vector<uint8_t> Decoded(static_cast<size_t>(TexWidth) * TexHeight * 4);
+
+	std::cout << Filename << " (" << TexWidth << "x" << TexHeight << ")" << std::endl;
+
+	for (BcFormat Format : { BC_FORMAT_BC4, BC_FORMAT_BC5, BC_FORMAT_BC7 })
+	{
+		for (BcQuality Quality : { BC_QUALITY_FAST, BC_QUALITY_NORMAL, BC_QUALITY_HIGH })
+		{
+			BcEncodeSettings Settings;
+			Settings.Format = Format;
+			Settings.Quality = Quality;
+
+			Blocks.assign(GetBcImageSize(Format, TexWidth, TexHeight), 0);
+
+			auto Encode = [&](const char * pName, ThreadPool * pPool, bool bScalar)
+			{
+				Settings.bScalar = bScalar;
+
+				BcEncodeStatistics Statistics;
+				EncodeBcImage(Settings, pPixels, TexWidth, TexHeight, Blocks.data(), pPool, &Statistics);
+				DecodeBcImage(Format, Blocks.data(), TexWidth, TexHeight, Decoded.data());
+
+				std::cout << GetBcFormatName(Format) << " " << GetBcQualityName(Quality) << ", " << pName << ": "
+					<< Statistics.Milliseconds << " ms, " << Statistics.GetMegatexelsPerSecond() << " Mtexel/s, PSNR "
+					<< ComputeBcPsnr(Format, pPixels, Decoded.data(), TexWidth, TexHeight) << " dB" << std::endl;
+			};
+
+			Encode("scalar, 1 thread", nullptr, true);
+			Encode("SIMD, 1 thread", nullptr, false);
+			Encode(ThreadsName.c_str(), &Pool, false);
+		}
+	}
+
+	stbi_image_free(pPixels);
+
+	Pool.Destroy();
+}
+
+NAMESPACE_END
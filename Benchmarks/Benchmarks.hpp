@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/**
+* CPU-only benchmarks of the renderer modules. They link the modules directly, without Vulkan or a
+* window, take the file they run on, print their results to std::cout and throw std::runtime_error
+* on failure. Benchmarks that need a device stay in App.
+*/
+
+/** Move the camera along a few paths around the model and print the culled fractions and the CPU time of BuildDrawList. */
+void RunCullingBenchmark(
+	const std::string & Filename
+);
+
+/** Time ParseObj on one and on all threads against Assimp's importer on the same file. */
+void RunObjParserBenchmark(
+	const std::string & Filename
+);
+
+/**
+* Encode the image to every BC format at every quality, scalar and SIMD on one thread and SIMD on all
+* threads, and print the throughput and the PSNR of the decoded result.
+*/
+void RunBcEncoderBenchmark(
+	const std::string & Filename
+);
+
+/** Import the model with Assimp and time its tangent step against every GenerateTangents path, checking they match bit for bit. */
+void RunTangentBenchmark(
+	const std::string & Filename
+);
+
+NAMESPACE_END
@@ -0,0 +1,134 @@
+#include "Benchmarks.hpp"
+#include "Camera.hpp"
+#include "DrawList.hpp"
+#include "MeshImporter.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+void RunCullingBenchmark(
+	const std::string & Filename
+)
+{
+	struct CameraPath
+	{
+		const char * pName;
+		float YawBegin, YawEnd;
+		float PitchBegin, PitchEnd;
+		float RadiusBegin, RadiusEnd;
+	};
+
+	/** Orbits at a few distances, a sweep over the top and a dolly from close up to far away */
+	const CameraPath Paths[] =
+	{
+		{ "Orbit", 0.0f, 360.0f, 15.0f, 15.0f, 3.0f, 3.0f },
+		{ "Close orbit", 0.0f, 360.0f, 0.0f, 0.0f, 0.75f, 0.75f },
+		{ "Far orbit", 0.0f, 360.0f, 30.0f, 30.0f, 12.0f, 12.0f },
+		{ "Overhead sweep", 45.0f, 45.0f, -80.0f, 80.0f, 3.0f, 3.0f },
+		{ "Dolly", 30.0f, 30.0f, 10.0f, 10.0f, 0.5f, 20.0f }
+	};
+	const uint32_t StepCount = 360;
+
+	ThreadPool Pool;
+	Pool.Init(0);
+
+	/** The renderer's cache next to the model spares the import, the benchmark never writes it */
+	const MeshImportSettings ImportSettings;
+	MeshScene Scene;
+	MeshCacheKey Key;
+
+	if (!ComputeMeshImportCacheKey(ImportSettings, Filename, Key))
+	{
+		throw std::runtime_error("Failed to open model file!");
+	}
+
+	if (!LoadMeshScene(Filename + ".meshcache", Key, true, Scene, std::cout))
+	{
+		ImportMeshScene(ImportSettings, Filename, Pool, Scene, std::cout);
+	}
+
+	Scene.Instances.erase(
+		std::remove_if(Scene.Instances.begin(), Scene.Instances.end(), [&Scene](const SceneInstance & Instance)
+		{
+			return Instance.MeshIndex >= Scene.Meshes.size();
+		}),
+		Scene.Instances.end()
+	);
+
+	std::vector<InstanceBounds> Bounds;
+	std::vector<uint32_t> InstanceOrder;
+	BuildInstanceBounds(Scene, Pool, Bounds, InstanceOrder);
+
+	Pool.Destroy();
+
+	/** The cones are only tested when the pipeline culls back faces */
+	DrawListSettings Settings;
+	Settings.bBackfaceCulling = true;
+
+	Camera PathCamera;
+	std::vector<DrawCommand> DrawCommands;
+	CullingStatistics Statistics;
+	std::vector<float> MaterialPixelsPerUv;
+
+	std::cout << "Culling benchmark, " << Scene.Meshlets.size() << " meshlets, " << StepCount << " views per path at "
+		<< WINDOW_INIT_WIDTH << "x" << WINDOW_INIT_HEIGH << ", back face culling on" << std::endl;
+
+	for (const CameraPath & Path : Paths)
+	{
+		CullingStatistics Sum;
+		double Milliseconds[2] = { 0.0, 0.0 };
+		size_t DrawCount = 0;
+
+		for (uint32_t Step = 0; Step < StepCount; Step++)
+		{
+			float T = static_cast<float>(Step) / static_cast<float>(StepCount - 1);
+			PathCamera.SetOrbit(
+				glm::radians(glm::mix(Path.YawBegin, Path.YawEnd, T)),
+				glm::radians(glm::mix(Path.PitchBegin, Path.PitchEnd, T)),
+				glm::mix(Path.RadiusBegin, Path.RadiusEnd, T)
+			);
+
+			DrawListView View;
+			PathCamera.RetriveData(View.Target, View.Eye, View.Up, View.Fov, View.NearZ, View.FarZ);
+			View.Width = WINDOW_INIT_WIDTH;
+			View.Height = WINDOW_INIT_HEIGH;
+
+			/** Once without culling for the baseline cost of the draw list, once with it */
+			for (int Culling = 0; Culling < 2; Culling++)
+			{
+				Settings.bMeshletCullingEnabled = Culling != 0;
+
+				auto StartTime = std::chrono::high_resolution_clock::now();
+
+				BuildDrawList(Settings, View, Scene, Bounds, InstanceOrder, DrawCommands, Statistics, MaterialPixelsPerUv);
+
+				Milliseconds[Culling] += std::chrono::duration<double, std::chrono::milliseconds::period>(
+					std::chrono::high_resolution_clock::now() - StartTime
+					).count();
+			}
+
+			Sum.MeshletCount += Statistics.MeshletCount;
+			Sum.FrustumCulledMeshletCount += Statistics.FrustumCulledMeshletCount;
+			Sum.BackfaceCulledMeshletCount += Statistics.BackfaceCulledMeshletCount;
+			Sum.TriangleCount += Statistics.TriangleCount;
+			Sum.CulledTriangleCount += Statistics.CulledTriangleCount;
+			DrawCount += DrawCommands.size();
+		}
+
+		double Meshlets = static_cast<double>(std::max<size_t>(Sum.MeshletCount, 1));
+		double Triangles = static_cast<double>(std::max<size_t>(Sum.TriangleCount, 1));
+
+		std::cout << Path.pName << ": meshlets culled " << 100.0 * Sum.FrustumCulledMeshletCount / Meshlets << "% frustum "
+			<< 100.0 * Sum.BackfaceCulledMeshletCount / Meshlets << "% back face, triangles culled "
+			<< 100.0 * Sum.CulledTriangleCount / Triangles << "%, draws " << DrawCount / StepCount << ", build "
+			<< Milliseconds[0] / StepCount << " ms -> " << Milliseconds[1] / StepCount << " ms" << std::endl;
+	}
+}
+
+NAMESPACE_END
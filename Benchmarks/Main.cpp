@@ -0,0 +1,66 @@
+#include "Benchmarks.hpp"
+
+#include <stdexcept>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct BenchmarkEntry
+{
+	const char * pName;
+	/** What the file argument is, for the usage */
+	const char * pArgument;
+	void (*pRun)(const std::string & Filename);
+};
+
+static const std::vector<BenchmarkEntry> s_Benchmarks =
+{
+	{ "culling", "Model", VkRenderer::RunCullingBenchmark },
+	{ "tangents", "Model", VkRenderer::RunTangentBenchmark },
+	{ "obj", "ObjFile", VkRenderer::RunObjParserBenchmark },
+	{ "bc", "Image", VkRenderer::RunBcEncoderBenchmark }
+};
+
+/**
+* Usage : Benchmarks <Benchmark> <File>
+* Without arguments the benchmarks are listed. Run it from the working directory of VkRenderer
+* so the model and texture paths match.
+*/
+int main(int argc, char ** argv)
+{
+	if (argc != 3)
+	{
+		std::cerr << "Usage : Benchmarks <Benchmark> <File>" << std::endl;
+		for (const BenchmarkEntry & Entry : s_Benchmarks)
+		{
+			std::cerr << "        Benchmarks " << Entry.pName << " " << Entry.pArgument << std::endl;
+		}
+		return EXIT_FAILURE;
+	}
+
+	const std::string Name = argv[1];
+
+	for (const BenchmarkEntry & Entry : s_Benchmarks)
+	{
+		if (Name != Entry.pName)
+		{
+			continue;
+		}
+
+		try
+		{
+			Entry.pRun(argv[2]);
+		}
+		catch (const std::exception & Ex)
+		{
+			std::cerr << Ex.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	std::cerr << "Unknown benchmark " << Name << std::endl;
+	return EXIT_FAILURE;
+}
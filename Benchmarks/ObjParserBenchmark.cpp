@@ -0,0 +1,60 @@
+#include "Benchmarks.hpp"
+#include "ObjParser.hpp"
+#include "ThreadPool.hpp"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <chrono>
+#include <iostream>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+void RunObjParserBenchmark(
+	const std::string & Filename
+)
+{
+	ThreadPool Pool;
+	Pool.Init(0);
+
+	auto PrintThroughput = [](const char * pName, size_t Bytes, size_t Triangles, double Milliseconds)
+	{
+		std::cout << pName << ": " << Milliseconds << " ms, " << Bytes / (1024.0 * 1024.0) / (Milliseconds / 1000.0)
+			<< " MB/s, " << Triangles << " triangles" << std::endl;
+	};
+
+	/** The single threaded run goes first and also brings the file into the page cache */
+	ObjModel Model;
+	ObjParseStatistics Statistics;
+
+	ParseObj(Filename, nullptr, Model, &Statistics);
+	PrintThroughput("ParseObj, 1 thread", Statistics.Bytes, Model.Corners.size() / 3, Statistics.Milliseconds);
+
+	ParseObj(Filename, &Pool, Model, &Statistics);
+	std::string Name = "ParseObj, " + std::to_string(Pool.GetThreadCount()) + " threads, " + std::to_string(Statistics.Chunks) + " chunks";
+	PrintThroughput(Name.c_str(), Statistics.Bytes, Model.Corners.size() / 3, Statistics.Milliseconds);
+
+	Pool.Destroy();
+
+	const size_t Bytes = Statistics.Bytes;
+	Model = ObjModel();
+
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	Assimp::Importer Import;
+	const aiScene * pScene = Import.ReadFile(Filename, aiProcess_Triangulate | aiProcess_FlipUVs);
+
+	double Milliseconds = std::chrono::duration<double, std::chrono::milliseconds::period>(
+		std::chrono::high_resolution_clock::now() - StartTime
+		).count();
+
+	size_t Triangles = 0;
+	for (uint32_t i = 0; pScene && i < pScene->mNumMeshes; i++)
+	{
+		Triangles += pScene->mMeshes[i]->mNumFaces;
+	}
+	PrintThroughput("Assimp", Bytes, Triangles, Milliseconds);
+}
+
+NAMESPACE_END
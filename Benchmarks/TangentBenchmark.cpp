@@ -0,0 +1,114 @@
+#include "Benchmarks.hpp"
+#include "MeshImporter.hpp"
+#include "TangentGenerator.hpp"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+void RunTangentBenchmark(
+	const std::string & Filename
+)
+{
+	const uint32_t ImportFlags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_OptimizeMeshes;
+
+	Assimp::Importer Import;
+	const aiScene * pScene = Import.ReadFile(Filename, ImportFlags);
+
+	if (!pScene || pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !pScene->mRootNode)
+	{
+		throw std::runtime_error("Failed to import model!");
+	}
+
+	std::vector<std::vector<uint32_t>> Indices(pScene->mNumMeshes);
+	std::vector<TangentStaging> Stagings(pScene->mNumMeshes);
+	size_t TriangleCount = 0;
+
+	for (uint32_t m = 0; m < pScene->mNumMeshes; m++)
+	{
+		const aiMesh * pMesh = pScene->mMeshes[m];
+		for (uint32_t i = 0; i < pMesh->mNumFaces; i++)
+		{
+			if (pMesh->mFaces[i].mNumIndices == 3)
+			{
+				Indices[m].insert(Indices[m].end(), pMesh->mFaces[i].mIndices, pMesh->mFaces[i].mIndices + 3);
+			}
+		}
+		FillTangentStaging(pMesh, Stagings[m]);
+		TriangleCount += Indices[m].size() / 3;
+	}
+
+	auto PrintTime = [TriangleCount](const char * pName, double Milliseconds)
+	{
+		std::cout << pName << ": " << Milliseconds << " ms, " << TriangleCount / 1000.0 / std::max(Milliseconds, 1e-3)
+			<< " M triangles/s" << std::endl;
+	};
+
+	std::cout << "Tangent benchmark, " << TriangleCount << " triangles" << std::endl;
+
+	/** The first path is the reference the others are compared against bit by bit */
+	std::vector<std::vector<float>> Reference(pScene->mNumMeshes);
+
+	for (TangentPath Path : { TANGENT_PATH_SCALAR, TANGENT_PATH_SSE2, TANGENT_PATH_AVX2 })
+	{
+		if (!IsTangentPathSupported(Path))
+		{
+			std::cout << GetTangentPathName(Path) << ": not supported" << std::endl;
+			continue;
+		}
+
+		double Milliseconds = 0.0;
+		bool bIdentical = true;
+
+		for (uint32_t m = 0; m < pScene->mNumMeshes; m++)
+		{
+			TangentStaging & Staging = Stagings[m];
+
+			auto StartTime = std::chrono::high_resolution_clock::now();
+
+			GenerateTangents(Indices[m], Staging, Path);
+
+			Milliseconds += std::chrono::duration<double, std::chrono::milliseconds::period>(
+				std::chrono::high_resolution_clock::now() - StartTime
+				).count();
+
+			std::vector<float> Tangents(Staging.TangentX);
+			Tangents.insert(Tangents.end(), Staging.TangentY.begin(), Staging.TangentY.end());
+			Tangents.insert(Tangents.end(), Staging.TangentZ.begin(), Staging.TangentZ.end());
+
+			if (Reference[m].empty())
+			{
+				Reference[m].swap(Tangents);
+			}
+			else
+			{
+				bIdentical = bIdentical && std::memcmp(Reference[m].data(), Tangents.data(), Tangents.size() * sizeof(float)) == 0;
+			}
+		}
+
+		PrintTime(GetTangentPathName(Path), Milliseconds);
+		if (Path != TANGENT_PATH_SCALAR)
+		{
+			std::cout << GetTangentPathName(Path) << (bIdentical ? ": bit identical to scalar" : ": DIFFERS from scalar") << std::endl;
+		}
+	}
+
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	Import.ApplyPostProcessing(aiProcess_CalcTangentSpace);
+
+	PrintTime("Assimp aiProcess_CalcTangentSpace", std::chrono::duration<double, std::chrono::milliseconds::period>(
+		std::chrono::high_resolution_clock::now() - StartTime
+		).count());
+}
+
+NAMESPACE_END
@@ -0,0 +1,208 @@
+#include "TestFramework.hpp"
+#include "AssetBaker.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+static const char * s_BoxObj =
+	"mtllib Box.mtl\n"
+	"v 0.0 0.0 0.0\n"
+	"v 1.0 0.0 0.0\n"
+	"v 0.0 1.0 0.0\n"
+	"usemtl Red\n"
+	"f 1 2 3\n";
+
+static const char * s_BoxMtl =
+	"newmtl Red\n"
+	"Kd 1.0 0.0 0.0\n";
+
+/**
+* Runs BakeAssets over Directory/Source into Directory/Baked with a mesh baker that only records
+* what it was asked to bake and writes a placeholder output, or throws if bFail is set.
+*/
+struct TestBake
+{
+	std::string SourceDirectory;
+	BakeSettings Settings;
+	std::vector<std::string> BakedSources;
+	bool bFail = false;
+
+	explicit TestBake(
+		const std::string & Name
+	)
+	{
+		std::string Directory = GetTestDirectory(Name);
+		SourceDirectory = Directory + "/Source";
+		std::filesystem::create_directories(SourceDirectory);
+
+		Settings.SourceDirectory = SourceDirectory;
+		Settings.OutputDirectory = Directory + "/Baked";
+	}
+
+	BakeStatistics Run()
+	{
+		BakedSources.clear();
+
+		ThreadPool Pool;
+		Pool.Init(2);
+
+		std::ostringstream Log;
+		BakeStatistics Statistics = BakeAssets(Settings, [this](const std::string & SourceFilename, const std::string & BakedFilename)
+		{
+			if (bFail)
+			{
+				throw std::runtime_error("Failed to import model!");
+			}
+
+			BakedSources.push_back(std::filesystem::path(SourceFilename).filename().string());
+			std::ofstream(BakedFilename, std::ios::binary) << SourceFilename;
+		}, Pool, Log);
+
+		Pool.Destroy();
+		return Statistics;
+	}
+};
+
+static void CheckBakeStatistics(
+	const BakeStatistics & Statistics,
+	uint32_t Baked,
+	uint32_t UpToDate,
+	uint32_t Failed
+)
+{
+	CHECK(Statistics.Baked == Baked);
+	CHECK(Statistics.UpToDate == UpToDate);
+	CHECK(Statistics.Failed == Failed);
+}
+
+/** Moves the write time of Filename forward without changing its content. */
+static void TouchFile(
+	const std::string & Filename
+)
+{
+	std::filesystem::last_write_time(Filename, std::filesystem::last_write_time(Filename) + std::chrono::hours(1));
+}
+
+TEST_CASE(AssetBakerSkipsUpToDateAndTouchedFiles)
+{
+	TestBake Bake("AssetBakerSkipsUpToDateAndTouchedFiles");
+	std::string Box = WriteTestFile(Bake.SourceDirectory, "Box.obj", s_BoxObj);
+	std::string Mtl = WriteTestFile(Bake.SourceDirectory, "Box.mtl", s_BoxMtl);
+	WriteTestFile(Bake.SourceDirectory, "Readme.txt", "Not an asset");
+
+	CheckBakeStatistics(Bake.Run(), 1, 0, 0);
+	CHECK(Bake.BakedSources == std::vector<std::string>({ "Box.obj" }));
+	CHECK(std::filesystem::is_regular_file(GetBakedFilename(Bake.Settings.OutputDirectory, "Box.obj")));
+
+	CheckBakeStatistics(Bake.Run(), 0, 1, 0);
+	CHECK(Bake.BakedSources.empty());
+
+	/** A newer write time alone makes the baker hash the file again, the same hash keeps the output */
+	TouchFile(Box);
+	TouchFile(Mtl);
+	CheckBakeStatistics(Bake.Run(), 0, 1, 0);
+
+	/** And the new write times were recorded, so the next run does not even hash */
+	CheckBakeStatistics(Bake.Run(), 0, 1, 0);
+
+	Bake.Settings.bForce = true;
+	CheckBakeStatistics(Bake.Run(), 1, 0, 0);
+}
+
+TEST_CASE(AssetBakerRebakesEditedFiles)
+{
+	TestBake Bake("AssetBakerRebakesEditedFiles");
+	WriteTestFile(Bake.SourceDirectory, "Box.obj", s_BoxObj);
+	WriteTestFile(Bake.SourceDirectory, "Box.mtl", s_BoxMtl);
+	WriteTestFile(Bake.SourceDirectory, "Plane.obj", "v 0 0 0\nv 1 0 0\nv 0 0 1\nf 1 2 3\n");
+
+	CheckBakeStatistics(Bake.Run(), 2, 0, 0);
+
+	/** Only the edited model is baked again */
+	std::string Edited = std::string(s_BoxObj) + "f 3 2 1\n";
+	WriteTestFile(Bake.SourceDirectory, "Box.obj", Edited);
+	CheckBakeStatistics(Bake.Run(), 1, 1, 0);
+	CHECK(Bake.BakedSources == std::vector<std::string>({ "Box.obj" }));
+
+	/** Only a changed size or write time makes the baker hash a file again, an edit that keeps both is trusted to be none */
+	std::string Box = Bake.SourceDirectory + "/Box.obj";
+	std::filesystem::file_time_type WriteTime = std::filesystem::last_write_time(Box);
+	Edited[Edited.size() - 2] = '2';
+	WriteTestFile(Bake.SourceDirectory, "Box.obj", Edited);
+	std::filesystem::last_write_time(Box, WriteTime);
+	CheckBakeStatistics(Bake.Run(), 0, 2, 0);
+
+	TouchFile(Box);
+	CheckBakeStatistics(Bake.Run(), 1, 1, 0);
+
+	/** Other settings rebake everything */
+	Bake.Settings.MeshSettingsHash = 1;
+	CheckBakeStatistics(Bake.Run(), 2, 0, 0);
+}
+
+TEST_CASE(AssetBakerRebakesChangedMaterialLibraries)
+{
+	TestBake Bake("AssetBakerRebakesChangedMaterialLibraries");
+	WriteTestFile(Bake.SourceDirectory, "Box.obj", s_BoxObj);
+	WriteTestFile(Bake.SourceDirectory, "Box.mtl", s_BoxMtl);
+
+	CheckBakeStatistics(Bake.Run(), 1, 0, 0);
+
+	WriteTestFile(Bake.SourceDirectory, "Box.mtl", "newmtl Red\nKd 0.25 0.0 0.0\n");
+	CheckBakeStatistics(Bake.Run(), 1, 0, 0);
+	CHECK(Bake.BakedSources == std::vector<std::string>({ "Box.obj" }));
+
+	/** A library that goes missing changes the model, one that stays missing does not */
+	std::filesystem::remove(Bake.SourceDirectory + "/Box.mtl");
+	CheckBakeStatistics(Bake.Run(), 1, 0, 0);
+	CheckBakeStatistics(Bake.Run(), 0, 1, 0);
+
+	WriteTestFile(Bake.SourceDirectory, "Box.mtl", s_BoxMtl);
+	CheckBakeStatistics(Bake.Run(), 1, 0, 0);
+}
+
+TEST_CASE(AssetBakerForgetsDeletedFiles)
+{
+	TestBake Bake("AssetBakerForgetsDeletedFiles");
+	WriteTestFile(Bake.SourceDirectory, "Box.obj", s_BoxObj);
+	WriteTestFile(Bake.SourceDirectory, "Box.mtl", s_BoxMtl);
+	WriteTestFile(Bake.SourceDirectory, "Plane.obj", "v 0 0 0\nv 1 0 0\nv 0 0 1\nf 1 2 3\n");
+
+	CheckBakeStatistics(Bake.Run(), 2, 0, 0);
+
+	std::filesystem::remove(Bake.SourceDirectory + "/Plane.obj");
+	CheckBakeStatistics(Bake.Run(), 0, 1, 0);
+
+	/** The deleted source dropped out of the manifest, bringing it back bakes it even though the old output is still there */
+	CHECK(std::filesystem::is_regular_file(GetBakedFilename(Bake.Settings.OutputDirectory, "Plane.obj")));
+	WriteTestFile(Bake.SourceDirectory, "Plane.obj", "v 0 0 0\nv 1 0 0\nv 0 0 1\nf 1 2 3\n");
+	CheckBakeStatistics(Bake.Run(), 1, 1, 0);
+	CHECK(Bake.BakedSources == std::vector<std::string>({ "Plane.obj" }));
+
+	/** A deleted output is baked again although its source did not change */
+	std::filesystem::remove(GetBakedFilename(Bake.Settings.OutputDirectory, "Box.obj"));
+	CheckBakeStatistics(Bake.Run(), 1, 1, 0);
+	CHECK(Bake.BakedSources == std::vector<std::string>({ "Box.obj" }));
+}
+
+TEST_CASE(AssetBakerRetriesFailedBakes)
+{
+	TestBake Bake("AssetBakerRetriesFailedBakes");
+	WriteTestFile(Bake.SourceDirectory, "Box.obj", s_BoxObj);
+
+	Bake.bFail = true;
+	CheckBakeStatistics(Bake.Run(), 0, 0, 1);
+	CheckBakeStatistics(Bake.Run(), 0, 0, 1);
+
+	Bake.bFail = false;
+	CheckBakeStatistics(Bake.Run(), 1, 0, 0);
+	CheckBakeStatistics(Bake.Run(), 0, 1, 0);
+}
@@ -0,0 +1,214 @@
+#include "TestFramework.hpp"
+#include "BcEncoder.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+struct TestImage
+{
+	const char * pName;
+	uint32_t Width;
+	uint32_t Height;
+	std::vector<uint8_t> Rgba;
+};
+
+static uint8_t ToUnorm8(
+	float Value
+)
+{
+	return static_cast<uint8_t>(std::round(std::min(std::max(Value, 0.0f), 1.0f) * 255.0f));
+}
+
+/** Width and Height are not multiples of four, so the edge blocks repeat texels */
+static TestImage MakeGradientImage()
+{
+	TestImage Image = {};
+	Image.pName = "Gradient";
+	Image.Width = 61;
+	Image.Height = 45;
+
+	for (uint32_t y = 0; y < Image.Height; y++)
+	{
+		for (uint32_t x = 0; x < Image.Width; x++)
+		{
+			float U = x / (Image.Width - 1.0f);
+			float V = y / (Image.Height - 1.0f);
+			Image.Rgba.insert(Image.Rgba.end(), { ToUnorm8(U), ToUnorm8(V), ToUnorm8(1.0f - 0.5f * (U + V)), ToUnorm8(0.25f + 0.75f * U * V) });
+		}
+	}
+
+	return Image;
+}
+
+static TestImage MakeNoiseImage()
+{
+	TestImage Image = {};
+	Image.pName = "Noise";
+	Image.Width = 64;
+	Image.Height = 64;
+
+	std::mt19937 Random(99);
+	std::uniform_int_distribution<int> Byte(0, 255);
+
+	for (uint32_t i = 0; i < Image.Width * Image.Height; i++)
+	{
+		Image.Rgba.insert(Image.Rgba.end(), { static_cast<uint8_t>(Byte(Random)), static_cast<uint8_t>(Byte(Random)), static_cast<uint8_t>(Byte(Random)), 255 });
+	}
+
+	return Image;
+}
+
+/** Tangent space normals of a bumpy heightfield, x and y in red and green as BC5 stores them */
+static TestImage MakeNormalMapImage()
+{
+	TestImage Image = {};
+	Image.pName = "NormalMap";
+	Image.Width = 64;
+	Image.Height = 64;
+
+	for (uint32_t y = 0; y < Image.Height; y++)
+	{
+		for (uint32_t x = 0; x < Image.Width; x++)
+		{
+			float Dx = 0.6f * std::cos(x * 0.3f) * std::cos(y * 0.17f);
+			float Dy = -0.6f * std::sin(x * 0.3f) * std::sin(y * 0.17f);
+			float Length = std::sqrt(Dx * Dx + Dy * Dy + 1.0f);
+
+			Image.Rgba.insert(Image.Rgba.end(), {
+				ToUnorm8(-Dx / Length * 0.5f + 0.5f),
+				ToUnorm8(-Dy / Length * 0.5f + 0.5f),
+				ToUnorm8(1.0f / Length * 0.5f + 0.5f),
+				255
+			});
+		}
+	}
+
+	return Image;
+}
+
+/** A smooth scalar map in red only, like the roughness or occlusion maps BC4 is used for */
+static TestImage MakeSingleChannelImage()
+{
+	TestImage Image = {};
+	Image.pName = "SingleChannel";
+	Image.Width = 64;
+	Image.Height = 64;
+
+	for (uint32_t y = 0; y < Image.Height; y++)
+	{
+		for (uint32_t x = 0; x < Image.Width; x++)
+		{
+			float Value = 0.5f + 0.4f * std::sin(x * 0.11f + y * 0.07f) + 0.1f * std::cos(y * 0.5f);
+			Image.Rgba.insert(Image.Rgba.end(), { ToUnorm8(Value), 0, 0, 255 });
+		}
+	}
+
+	return Image;
+}
+
+static double EncodeAndMeasure(
+	const TestImage & Image,
+	const BcEncodeSettings & Settings,
+	std::vector<uint8_t> * pBlocks = nullptr
+)
+{
+	std::vector<uint8_t> Blocks(GetBcImageSize(Settings.Format, Image.Width, Image.Height));
+	EncodeBcImage(Settings, Image.Rgba.data(), Image.Width, Image.Height, Blocks.data());
+
+	std::vector<uint8_t> Decoded(Image.Rgba.size());
+	DecodeBcImage(Settings.Format, Blocks.data(), Image.Width, Image.Height, Decoded.data());
+
+	if (pBlocks)
+	{
+		pBlocks->swap(Blocks);
+	}
+
+	return ComputeBcPsnr(Settings.Format, Image.Rgba.data(), Decoded.data(), Image.Width, Image.Height);
+}
+
+/**
+* Encodes Image at every quality and checks the PSNR against MinPsnr, the floor for the fastest
+* preset. FAST must not beat HIGH, NORMAL sits anywhere in between.
+*/
+static void CheckPsnr(
+	const TestImage & Image,
+	BcFormat Format,
+	double MinPsnr
+)
+{
+	double Psnrs[3] = {};
+
+	for (BcQuality Quality : { BC_QUALITY_FAST, BC_QUALITY_NORMAL, BC_QUALITY_HIGH })
+	{
+		BcEncodeSettings Settings;
+		Settings.Format = Format;
+		Settings.Quality = Quality;
+
+		Psnrs[Quality] = EncodeAndMeasure(Image, Settings);
+
+		std::cout << "  " << GetBcFormatName(Format) << " " << GetBcQualityName(Quality) << " " << Image.pName << ": " << Psnrs[Quality] << " dB" << std::endl;
+		CHECK(Psnrs[Quality] >= MinPsnr);
+	}
+
+	CHECK(Psnrs[BC_QUALITY_FAST] <= Psnrs[BC_QUALITY_HIGH]);
+}
+
+/** The floors sit about 3 dB under what the encoder reaches today, a drop below them is a real regression */
+TEST_CASE(BcEncoderBc7Psnr)
+{
+	CheckPsnr(MakeGradientImage(), BC_FORMAT_BC7, 37.0);
+	CheckPsnr(MakeNormalMapImage(), BC_FORMAT_BC7, 33.0);
+	/** Uncorrelated texels are the worst case for any block format */
+	CheckPsnr(MakeNoiseImage(), BC_FORMAT_BC7, 13.0);
+}
+
+TEST_CASE(BcEncoderBc5Psnr)
+{
+	CheckPsnr(MakeNormalMapImage(), BC_FORMAT_BC5, 41.0);
+	CheckPsnr(MakeGradientImage(), BC_FORMAT_BC5, 50.0);
+	CheckPsnr(MakeNoiseImage(), BC_FORMAT_BC5, 26.0);
+}
+
+TEST_CASE(BcEncoderBc4Psnr)
+{
+	CheckPsnr(MakeSingleChannelImage(), BC_FORMAT_BC4, 40.0);
+	/** A linear ramp in red fits the eight interpolated values exactly */
+	CheckPsnr(MakeGradientImage(), BC_FORMAT_BC4, 50.0);
+	CheckPsnr(MakeNoiseImage(), BC_FORMAT_BC4, 26.0);
+}
+
+TEST_CASE(BcEncoderScalarAndThreadedMatch)
+{
+	TestImage Image = MakeGradientImage();
+
+	ThreadPool Pool;
+	Pool.Init(4);
+
+	for (BcFormat Format : { BC_FORMAT_BC4, BC_FORMAT_BC5, BC_FORMAT_BC7 })
+	{
+		BcEncodeSettings Settings;
+		Settings.Format = Format;
+		Settings.Quality = BC_QUALITY_HIGH;
+
+		std::vector<uint8_t> Reference;
+		EncodeAndMeasure(Image, Settings, &Reference);
+
+		Settings.bScalar = true;
+		std::vector<uint8_t> Scalar;
+		EncodeAndMeasure(Image, Settings, &Scalar);
+		CHECK(Scalar == Reference);
+
+		Settings.bScalar = false;
+		std::vector<uint8_t> Threaded(Reference.size());
+		EncodeBcImage(Settings, Image.Rgba.data(), Image.Width, Image.Height, Threaded.data(), &Pool);
+		CHECK(Threaded == Reference);
+	}
+
+	Pool.Destroy();
+}
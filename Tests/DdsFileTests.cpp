@@ -0,0 +1,211 @@
+#include "TestFramework.hpp"
+#include "DdsFile.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+/** File offsets of the header fields the tests patch, the DDS_HEADER follows the four byte magic */
+static const size_t s_WidthOffset = 4 + 12;
+static const size_t s_MipMapCountOffset = 4 + 24;
+static const size_t s_PixelFormatFlagsOffset = 4 + 76;
+static const size_t s_FourCCOffset = 4 + 80;
+static const size_t s_RgbBitCountOffset = 4 + 84;
+static const size_t s_MasksOffset = 4 + 88;
+static const size_t s_Caps2Offset = 4 + 108;
+static const size_t s_Dx10Offset = 4 + 124;
+
+static void PatchUint32(
+	std::vector<uint8_t> & File,
+	size_t Offset,
+	uint32_t Value
+)
+{
+	memcpy(&File[Offset], &Value, sizeof(Value));
+}
+
+/** A 2D texture with the full mip chain written by WriteDds, every level filled with its level index. */
+static std::vector<uint8_t> MakeDdsFile(
+	const std::string & Name,
+	VkFormat Format,
+	uint32_t Width,
+	uint32_t Height
+)
+{
+	std::vector<std::vector<uint8_t>> Levels;
+
+	for (uint32_t Level = 0; Width >> Level || Height >> Level; Level++)
+	{
+		size_t Size = GetDdsLevelSize(Format, std::max(Width >> Level, 1u), std::max(Height >> Level, 1u));
+		Levels.push_back(std::vector<uint8_t>(Size, static_cast<uint8_t>(Level)));
+	}
+
+	std::string Filename = GetTestDirectory(Name) + "/Texture.dds";
+	REQUIRE(WriteDds(Filename, Format, Width, Height, Levels));
+
+	MappedFile File;
+	REQUIRE(File.Open(Filename));
+	return std::vector<uint8_t>(File.GetData(), File.GetData() + File.GetSize());
+}
+
+static bool ParseDdsFile(
+	const std::vector<uint8_t> & File
+)
+{
+	DdsImage Image;
+	return ParseDds(File.data(), File.size(), Image);
+}
+
+TEST_CASE(DdsFileRoundTrip)
+{
+	/** Not a multiple of the block size, the small levels round up to one block */
+	std::vector<uint8_t> File = MakeDdsFile("DdsFileRoundTrip", VK_FORMAT_BC7_UNORM_BLOCK, 37, 10);
+
+	DdsImage Image;
+	REQUIRE(ParseDds(File.data(), File.size(), Image));
+	CHECK(Image.Format == VK_FORMAT_BC7_UNORM_BLOCK);
+	CHECK(Image.Width == 37);
+	CHECK(Image.Height == 10);
+	REQUIRE(Image.MipLevels == 6);
+
+	const size_t BlockCounts[] = { 10 * 3, 5 * 2, 3 * 1, 1, 1, 1 };
+	size_t Offset = 0;
+
+	for (uint32_t Level = 0; Level < Image.MipLevels; Level++)
+	{
+		CHECK(Image.LevelOffsets[Level] == Offset);
+		CHECK(Image.LevelSizes[Level] == BlockCounts[Level] * 16);
+		CHECK(Image.pData[Image.LevelOffsets[Level]] == Level);
+		CHECK(Image.pData[Image.LevelOffsets[Level] + Image.LevelSizes[Level] - 1] == Level);
+		Offset += Image.LevelSizes[Level];
+	}
+
+	CHECK(Image.DataSize == Offset);
+	CHECK(Image.pData + Image.DataSize == File.data() + File.size());
+}
+
+TEST_CASE(DdsFileReadsLegacyHeaders)
+{
+	/** The DX10 header is dropped and the pixel format is described by the DDS_HEADER alone */
+	std::vector<uint8_t> Dx10 = MakeDdsFile("DdsFileReadsLegacyHeaders", VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 16, 16);
+	std::vector<uint8_t> File(Dx10.begin(), Dx10.begin() + s_Dx10Offset);
+	File.insert(File.end(), Dx10.begin() + s_Dx10Offset + 20, Dx10.end());
+
+	DdsImage Image;
+	PatchUint32(File, s_FourCCOffset, MakeFourCC('D', 'X', 'T', '1'));
+	REQUIRE(ParseDds(File.data(), File.size(), Image));
+	CHECK(Image.Format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK);
+	CHECK(Image.MipLevels == 5);
+	CHECK(Image.pData == File.data() + s_Dx10Offset);
+
+	PatchUint32(File, s_FourCCOffset, MakeFourCC('A', 'T', 'I', '1'));
+	REQUIRE(ParseDds(File.data(), File.size(), Image));
+	CHECK(Image.Format == VK_FORMAT_BC4_UNORM_BLOCK);
+
+	/** 32-bit BGRA masks, the 16x16 level alone is as large as the whole BC1 chain */
+	PatchUint32(File, s_PixelFormatFlagsOffset, 0x40 | 0x1);
+	PatchUint32(File, s_RgbBitCountOffset, 32);
+	PatchUint32(File, s_MasksOffset, 0x00FF0000);
+	PatchUint32(File, s_MasksOffset + 4, 0x0000FF00);
+	PatchUint32(File, s_MasksOffset + 8, 0x000000FF);
+	PatchUint32(File, s_MasksOffset + 12, 0xFF000000);
+	PatchUint32(File, s_MipMapCountOffset, 1);
+	File.resize(s_Dx10Offset + 16 * 16 * 4);
+	REQUIRE(ParseDds(File.data(), File.size(), Image));
+	CHECK(Image.Format == VK_FORMAT_B8G8R8A8_UNORM);
+	CHECK(Image.MipLevels == 1);
+
+	/** A zero count means one level */
+	PatchUint32(File, s_MipMapCountOffset, 0);
+	REQUIRE(ParseDds(File.data(), File.size(), Image));
+	CHECK(Image.MipLevels == 1);
+}
+
+TEST_CASE(DdsFileRejectsTruncatedFiles)
+{
+	std::vector<uint8_t> File = MakeDdsFile("DdsFileRejectsTruncatedFiles", VK_FORMAT_BC5_UNORM_BLOCK, 32, 32);
+	REQUIRE(ParseDdsFile(File));
+
+	/** Inside the magic, the DDS_HEADER, the DX10 header and the last mip level */
+	for (size_t Size : { size_t(0), size_t(3), size_t(64), s_Dx10Offset, s_Dx10Offset + 19, s_Dx10Offset + 20, File.size() - 1 })
+	{
+		std::vector<uint8_t> Truncated(File.begin(), File.begin() + Size);
+		CHECK(!ParseDdsFile(Truncated));
+	}
+
+	std::vector<uint8_t> BadMagic = File;
+	BadMagic[0] = 'X';
+	CHECK(!ParseDdsFile(BadMagic));
+}
+
+TEST_CASE(DdsFileRejectsCubeMapsVolumesAndArrays)
+{
+	std::vector<uint8_t> File = MakeDdsFile("DdsFileRejectsCubeMapsVolumesAndArrays", VK_FORMAT_R8G8B8A8_UNORM, 8, 8);
+	REQUIRE(ParseDdsFile(File));
+
+	std::vector<uint8_t> CubeMap = File;
+	PatchUint32(CubeMap, s_Caps2Offset, 0x200 | 0xFC00);
+	CHECK(!ParseDdsFile(CubeMap));
+
+	std::vector<uint8_t> Volume = File;
+	PatchUint32(Volume, s_Caps2Offset, 0x200000);
+	CHECK(!ParseDdsFile(Volume));
+
+	/** The DX10 header describes the same cases on its own */
+	std::vector<uint8_t> Dx10CubeMap = File;
+	PatchUint32(Dx10CubeMap, s_Dx10Offset + 8, 0x4);
+	CHECK(!ParseDdsFile(Dx10CubeMap));
+
+	std::vector<uint8_t> Dx10Volume = File;
+	PatchUint32(Dx10Volume, s_Dx10Offset + 4, 4);
+	CHECK(!ParseDdsFile(Dx10Volume));
+
+	std::vector<uint8_t> Dx10Array = File;
+	PatchUint32(Dx10Array, s_Dx10Offset + 12, 2);
+	CHECK(!ParseDdsFile(Dx10Array));
+}
+
+TEST_CASE(DdsFileRejectsUnknownFormats)
+{
+	std::vector<uint8_t> File = MakeDdsFile("DdsFileRejectsUnknownFormats", VK_FORMAT_BC3_UNORM_BLOCK, 8, 8);
+	REQUIRE(ParseDdsFile(File));
+
+	/** DXGI_FORMAT_R32G32B32A32_FLOAT and DXGI_FORMAT_BC7_UNORM_SRGB */
+	for (uint32_t DxgiFormat : { 2u, 99u })
+	{
+		std::vector<uint8_t> Unknown = File;
+		PatchUint32(Unknown, s_Dx10Offset, DxgiFormat);
+		CHECK(!ParseDdsFile(Unknown));
+	}
+
+	std::vector<uint8_t> UnknownFourCC = File;
+	PatchUint32(UnknownFourCC, s_FourCCOffset, MakeFourCC('D', 'X', 'T', '2'));
+	CHECK(!ParseDdsFile(UnknownFourCC));
+
+	/** RGB without alpha, the fourth byte is undefined */
+	std::vector<uint8_t> Rgbx = File;
+	PatchUint32(Rgbx, s_PixelFormatFlagsOffset, 0x40);
+	PatchUint32(Rgbx, s_RgbBitCountOffset, 32);
+	PatchUint32(Rgbx, s_MasksOffset, 0x000000FF);
+	PatchUint32(Rgbx, s_MasksOffset + 4, 0x0000FF00);
+	PatchUint32(Rgbx, s_MasksOffset + 8, 0x00FF0000);
+	CHECK(!ParseDdsFile(Rgbx));
+}
+
+TEST_CASE(DdsFileRejectsOversizedDimensions)
+{
+	std::vector<uint8_t> File = MakeDdsFile("DdsFileRejectsOversizedDimensions", VK_FORMAT_BC7_UNORM_BLOCK, 4, 4);
+	PatchUint32(File, s_MipMapCountOffset, 1);
+	REQUIRE(ParseDdsFile(File));
+
+	/** Block counts must not wrap around to a chain that fits the file */
+	PatchUint32(File, s_WidthOffset, UINT32_MAX);
+	CHECK(!ParseDdsFile(File));
+
+	PatchUint32(File, s_WidthOffset, 0);
+	CHECK(!ParseDdsFile(File));
+}
@@ -0,0 +1,14 @@
+#include "TestFramework.hpp"
+
+#include <cstdlib>
+#include <string>
+
+/**
+* Usage : Tests [Filter]
+* Runs every test whose name contains Filter, all of them without it. The Vulkan entry
+* points are mocked, no GPU is needed. Run it from the working directory of VkRenderer.
+*/
+int main(int argc, char ** argv)
+{
+	return VkRenderer::RunTests(argc > 1 ? argv[1] : "") ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,372 @@
+#include "TestFramework.hpp"
+#include "MockVulkan.hpp"
+#include "MemoryAllocator.hpp"
+
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+static const VkMemoryPropertyFlags DeviceLocal = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+static const VkMemoryPropertyFlags HostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+static bool SharesPage(
+	const MockDevice::Binding & A,
+	const MockDevice::Binding & B,
+	VkDeviceSize Granularity
+)
+{
+	VkDeviceSize FirstPageA = A.Offset / Granularity;
+	VkDeviceSize LastPageA = (A.Offset + A.Size - 1) / Granularity;
+	VkDeviceSize FirstPageB = B.Offset / Granularity;
+	VkDeviceSize LastPageB = (B.Offset + B.Size - 1) / Granularity;
+	return A.Memory == B.Memory && FirstPageA <= LastPageB && FirstPageB <= LastPageA;
+}
+
+TEST_CASE(MemoryBlockCoalescesFreeRanges)
+{
+	MemoryBlock Block(1024, 0, true, false);
+
+	VkDeviceSize A, B, C, D;
+	REQUIRE(Block.Allocate(256, 1, A) && A == 0);
+	REQUIRE(Block.Allocate(256, 1, B) && B == 256);
+	REQUIRE(Block.Allocate(256, 1, C) && C == 512);
+	REQUIRE(Block.Allocate(256, 1, D) && D == 768);
+
+	/** Neither neighbour of B is free yet, A then merges with B's range from the left */
+	Block.Free(B, 256);
+	Block.Free(A, 256);
+
+	VkDeviceSize Merged;
+	CHECK(Block.Allocate(512, 1, Merged) && Merged == 0);
+	Block.Free(Merged, 512);
+
+	/** C merges with the free range in front and D behind it */
+	Block.Free(D, 256);
+	Block.Free(C, 256);
+
+	CHECK(Block.IsEmpty());
+	CHECK(Block.GetUsedBytes() == 0);
+
+	VkDeviceSize Whole;
+	CHECK(Block.Allocate(1024, 1, Whole) && Whole == 0);
+}
+
+TEST_CASE(MemoryBlockReusesAlignmentPadding)
+{
+	MemoryBlock Block(4096, 0, true, false);
+
+	VkDeviceSize A, B, C, D;
+	REQUIRE(Block.Allocate(1, 1, A) && A == 0);
+	REQUIRE(Block.Allocate(256, 256, B) && B == 256);
+	CHECK(Block.Allocate(255, 1, C) && C == 1);
+	CHECK(Block.Allocate(1, 1, D) && D == 512);
+	CHECK(Block.GetUsedBytes() == 513);
+	CHECK(Block.GetAllocationCount() == 4);
+}
+
+TEST_CASE(MemoryBlockRejectsWhatDoesNotFit)
+{
+	MemoryBlock Block(1024, 0, true, false);
+
+	VkDeviceSize A, B;
+	REQUIRE(Block.Allocate(1000, 1, A));
+	CHECK(!Block.Allocate(100, 1, B));
+	CHECK(!Block.Allocate(24, 64, B));
+	CHECK(Block.Allocate(24, 8, B) && B == 1000);
+	CHECK(Block.GetUsedBytes() == 1024);
+}
+
+TEST_CASE(MemoryAllocatorSubAllocatesFromOneBlock)
+{
+	MockDevice & Device = ResetMockDevice();
+	Device.BufferRequirements = { 65536, 256, 0x1 };
+
+	MemoryAllocator Allocator;
+	Allocator.Init(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	std::vector<MemoryAllocation> Allocations(1000);
+	for (MemoryAllocation & Allocation : Allocations)
+	{
+		Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), DeviceLocal, Allocation);
+	}
+
+	CHECK(Device.AllocateCount == 1);
+
+	for (size_t i = 0; i < Allocations.size(); i++)
+	{
+		CHECK(Allocations[i].Memory == Allocations[0].Memory);
+		CHECK(Allocations[i].Offset % 256 == 0);
+		CHECK(Allocations[i].pMappedData == nullptr);
+		if (i > 0)
+		{
+			CHECK(Allocations[i].Offset >= Allocations[i - 1].Offset + 65536);
+		}
+	}
+
+	std::vector<MemoryHeapStatistics> Statistics = Allocator.GetStatistics();
+	REQUIRE(Statistics.size() == 2);
+	CHECK(Statistics[0].BlockCount == 1);
+	CHECK(Statistics[0].AllocationCount == 1000);
+	CHECK(Statistics[0].UsedBytes == 1000 * 65536);
+	CHECK(Statistics[0].BlockBytes == 256ull * 1024 * 1024);
+	CHECK(Statistics[1].BlockCount == 0);
+
+	for (MemoryAllocation & Allocation : Allocations)
+	{
+		Allocator.Free(Allocation);
+		CHECK(Allocation.pBlock == nullptr);
+	}
+
+	Allocator.Destroy();
+	CHECK(Device.Memories.empty());
+	CHECK(Device.InvalidUsageCount == 0);
+}
+
+TEST_CASE(MemoryAllocatorRespectsBufferImageGranularity)
+{
+	MockDevice & Device = ResetMockDevice();
+	const VkDeviceSize Granularity = Device.Properties.limits.bufferImageGranularity;
+
+	MemoryAllocator Allocator;
+	Allocator.Init(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	/** Sizes and alignments well below the granularity, so that packing them tightly would mix pages */
+	std::vector<MemoryAllocation> Allocations(128);
+	std::vector<uint64_t> Resources;
+	for (size_t i = 0; i < Allocations.size(); i++)
+	{
+		Device.BufferRequirements = { 1000 + 16 * i, 16, 0x3 };
+		Device.ImageRequirements = { 3000 + 64 * i, 1024, 0x1 };
+
+		if (i % 2 == 0)
+		{
+			VkBuffer Buffer = CreateMockHandle<VkBuffer>();
+			Allocator.AllocateForBuffer(Buffer, DeviceLocal, Allocations[i]);
+			Resources.push_back(GetMockHandleId(Buffer));
+		}
+		else
+		{
+			VkImage Image = CreateMockHandle<VkImage>();
+			Allocator.AllocateForImage(Image, DeviceLocal, Allocations[i]);
+			Resources.push_back(GetMockHandleId(Image));
+		}
+	}
+
+	REQUIRE(Device.Bindings.size() == Resources.size());
+
+	for (uint64_t Linear : Resources)
+	{
+		for (uint64_t Optimal : Resources)
+		{
+			const MockDevice::Binding & A = Device.Bindings[Linear];
+			const MockDevice::Binding & B = Device.Bindings[Optimal];
+			if (A.bLinear && !B.bLinear)
+			{
+				CHECK(!SharesPage(A, B, Granularity));
+			}
+		}
+	}
+
+	/** One block for the buffers and one for the images */
+	CHECK(Device.AllocateCount == 2);
+
+	for (MemoryAllocation & Allocation : Allocations)
+	{
+		Allocator.Free(Allocation);
+	}
+
+	Allocator.Destroy();
+	CHECK(Device.Memories.empty());
+	CHECK(Device.InvalidUsageCount == 0);
+}
+
+TEST_CASE(MemoryAllocatorReleasesEmptyBlocks)
+{
+	MockDevice & Device = ResetMockDevice();
+	/** A quarter of the 32MB blocks carved from the 256MB host visible heap */
+	Device.BufferRequirements = { 8 * 1024 * 1024, 256, 0x2 };
+
+	MemoryAllocator Allocator;
+	Allocator.Init(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	std::vector<MemoryAllocation> Allocations(5);
+	for (MemoryAllocation & Allocation : Allocations)
+	{
+		Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), HostVisible, Allocation);
+	}
+
+	REQUIRE(Device.AllocateCount == 2);
+	CHECK(Allocations[4].Memory != Allocations[0].Memory);
+
+	/** The second block becomes empty and is kept around */
+	Allocator.Free(Allocations[4]);
+	CHECK(Device.FreeCount == 0);
+
+	/** The first one as well, but there already is an empty block for the memory type */
+	for (size_t i = 0; i < 4; i++)
+	{
+		Allocator.Free(Allocations[i]);
+	}
+	CHECK(Device.FreeCount == 1);
+	CHECK(Device.Memories.size() == 1);
+	CHECK(Allocator.GetStatistics()[1].BlockCount == 1);
+	CHECK(Allocator.GetStatistics()[1].UsedBytes == 0);
+
+	/** The kept block serves the next allocation without a new vkAllocateMemory */
+	MemoryAllocation Allocation;
+	Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), HostVisible, Allocation);
+	CHECK(Device.AllocateCount == 2);
+
+	Allocator.Free(Allocation);
+	Allocator.Destroy();
+	CHECK(Device.Memories.empty());
+	CHECK(Device.InvalidUsageCount == 0);
+}
+
+TEST_CASE(MemoryAllocatorGivesLargeResourcesDedicatedBlocks)
+{
+	MockDevice & Device = ResetMockDevice();
+	Device.ImageRequirements = { 200ull * 1024 * 1024, 65536, 0x1 };
+
+	MemoryAllocator Allocator;
+	Allocator.Init(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	MemoryAllocation Allocation;
+	Allocator.AllocateForImage(CreateMockHandle<VkImage>(), DeviceLocal, Allocation);
+
+	REQUIRE(Device.Memories.count(GetMockHandleId(Allocation.Memory)) == 1);
+	CHECK(Device.Memories[GetMockHandleId(Allocation.Memory)].Size == 200ull * 1024 * 1024);
+	CHECK(Allocation.Offset == 0);
+
+	/** Dedicated blocks are never kept */
+	Allocator.Free(Allocation);
+	CHECK(Device.Memories.empty());
+
+	Allocator.Destroy();
+	CHECK(Device.InvalidUsageCount == 0);
+}
+
+TEST_CASE(MemoryAllocatorMapsHostVisibleBlocks)
+{
+	MockDevice & Device = ResetMockDevice();
+
+	MemoryAllocator Allocator;
+	Allocator.Init(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	MemoryAllocation A, B;
+	Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), HostVisible, A);
+	Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), HostVisible, B);
+
+	REQUIRE(A.Memory == B.Memory);
+	MockDevice::Memory & Memory = Device.Memories[GetMockHandleId(A.Memory)];
+	CHECK(Memory.bMapped);
+	CHECK(A.pMappedData == Memory.Data.data() + A.Offset);
+	CHECK(B.pMappedData == Memory.Data.data() + B.Offset);
+
+	/** Mapping once per block, not once per allocation */
+	CHECK(Device.InvalidUsageCount == 0);
+
+	Allocator.Free(A);
+	Allocator.Free(B);
+	Allocator.Destroy();
+	CHECK(Device.Memories.empty());
+	CHECK(Device.InvalidUsageCount == 0);
+}
+
+TEST_CASE(MemoryAllocatorThrowsWithoutSuitableMemoryType)
+{
+	MockDevice & Device = ResetMockDevice();
+	/** Only the host visible type is allowed, but device local memory is asked for */
+	Device.BufferRequirements = { 256, 256, 0x2 };
+
+	MemoryAllocator Allocator;
+	Allocator.Init(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	MemoryAllocation Allocation;
+	CHECK_THROWS(Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), DeviceLocal, Allocation));
+	CHECK(Device.AllocateCount == 0);
+
+	Allocator.Destroy();
+}
+
+TEST_CASE(MemoryAllocatorRetriesSmallerBlocks)
+{
+	MockDevice & Device = ResetMockDevice();
+	Device.BufferRequirements = { 65536, 256, 0x1 };
+	/** The 256MB and 128MB blocks do not fit anymore, 64MB does */
+	Device.MaxAllocationSize = 100ull * 1024 * 1024;
+
+	MemoryAllocator Allocator;
+	Allocator.Init(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	MemoryAllocation A, B;
+	Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), DeviceLocal, A);
+	Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), DeviceLocal, B);
+
+	REQUIRE(Device.Memories.size() == 1);
+	CHECK(Device.Memories[GetMockHandleId(A.Memory)].Size == 64ull * 1024 * 1024);
+	CHECK(A.Memory == B.Memory);
+	CHECK(Allocator.GetStatistics()[0].BlockBytes == 64ull * 1024 * 1024);
+
+	/** Not even a quarter of the block fits */
+	Device.MaxAllocationSize = 32ull * 1024 * 1024;
+	Device.BufferRequirements = { 16ull * 1024 * 1024, 256, 0x2 };
+
+	MemoryAllocation C, D;
+	Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), HostVisible, C);
+	Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), HostVisible, D);
+	Device.MaxAllocationSize = 4ull * 1024 * 1024;
+
+	MemoryAllocation E;
+	CHECK_THROWS(Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), HostVisible, E));
+	CHECK(E.pBlock == nullptr);
+
+	Allocator.Free(A);
+	Allocator.Free(B);
+	Allocator.Free(C);
+	Allocator.Free(D);
+	Allocator.Destroy();
+	CHECK(Device.Memories.empty());
+	CHECK(Device.InvalidUsageCount == 0);
+}
+
+TEST_CASE(MemoryAllocatorFreesBlockIfMappingFails)
+{
+	MockDevice & Device = ResetMockDevice();
+	Device.MapResult = VK_ERROR_MEMORY_MAP_FAILED;
+
+	MemoryAllocator Allocator;
+	Allocator.Init(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	MemoryAllocation Allocation;
+	CHECK_THROWS(Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), HostVisible, Allocation));
+	CHECK(Device.AllocateCount == 1);
+	CHECK(Device.Memories.empty());
+	CHECK(Allocator.GetStatistics()[1].BlockCount == 0);
+
+	Allocator.Destroy();
+	CHECK(Device.InvalidUsageCount == 0);
+}
+
+TEST_CASE(MemoryAllocatorThrowsIfBindingFails)
+{
+	MockDevice & Device = ResetMockDevice();
+	Device.BindResult = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+	MemoryAllocator Allocator;
+	Allocator.Init(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	MemoryAllocation Buffer, Image;
+	CHECK_THROWS(Allocator.AllocateForBuffer(CreateMockHandle<VkBuffer>(), DeviceLocal, Buffer));
+	CHECK_THROWS(Allocator.AllocateForImage(CreateMockHandle<VkImage>(), DeviceLocal, Image));
+
+	/** Nothing is left allocated from the blocks */
+	CHECK(Buffer.pBlock == nullptr);
+	CHECK(Image.pBlock == nullptr);
+	CHECK(Allocator.GetStatistics()[0].AllocationCount == 0);
+	CHECK(Device.Bindings.empty());
+
+	Allocator.Destroy();
+	CHECK(Device.Memories.empty());
+	CHECK(Device.InvalidUsageCount == 0);
+}
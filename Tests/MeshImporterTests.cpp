@@ -0,0 +1,112 @@
+#include "TestFramework.hpp"
+#include "MeshImporter.hpp"
+
+#include <filesystem>
+#include <sstream>
+#include <string>
+
+using namespace GLOBAL_NAMESPACE;
+
+static const char * s_TriangleObj =
+	"v 0.0 0.0 0.0\n"
+	"v 1.0 0.0 0.0\n"
+	"v 0.0 1.0 0.0\n"
+	"f 1 2 3\n";
+
+/** Writes a one triangle scene keyed to Source the way BakeMeshScene does, without importing it. */
+static void WriteBakedTriangle(
+	const MeshImportSettings & Settings,
+	const std::string & Source,
+	const std::string & Baked
+)
+{
+	MeshCacheKey Key;
+	REQUIRE(ComputeMeshImportCacheKey(Settings, Source, Key));
+
+	MeshScene Scene;
+	Scene.Vertices.resize(3);
+	Scene.Vertices[1].Position = glm::vec3(1.0f, 0.0f, 0.0f);
+	Scene.Vertices[2].Position = glm::vec3(0.0f, 1.0f, 0.0f);
+	Scene.Indices = { 0, 1, 2 };
+	Scene.Materials.resize(1);
+	Scene.Materials[0].Name = "Default";
+
+	REQUIRE(WriteMeshScene(Baked, Key, Scene));
+}
+
+TEST_CASE(MeshImporterRejectsStaleBakes)
+{
+	std::string Directory = GetTestDirectory("MeshImporterRejectsStaleBakes");
+	std::string Source = WriteTestFile(Directory, "Triangle.obj", s_TriangleObj);
+	std::string Baked = Directory + "/Triangle.obj.meshcache";
+
+	MeshImportSettings Settings;
+	WriteBakedTriangle(Settings, Source, Baked);
+
+	std::ostringstream Log;
+	MeshScene Scene;
+	REQUIRE(LoadBakedMeshScene(Settings, Baked, Source, Scene, Log));
+	CHECK(Scene.Vertices.size() == 3);
+	CHECK(Scene.Indices.size() == 3);
+	REQUIRE(Scene.Materials.size() == 1);
+	CHECK(Scene.Materials[0].Name == "Default");
+
+	/** Same size, other content, only the hash tells them apart */
+	WriteTestFile(Directory, "Triangle.obj", "v 0.0 0.0 0.0\nv 2.0 0.0 0.0\nv 0.0 1.0 0.0\nf 1 2 3\n");
+	CHECK(!LoadBakedMeshScene(Settings, Baked, Source, Scene, Log));
+
+	WriteTestFile(Directory, "Triangle.obj", std::string(s_TriangleObj) + "f 3 2 1\n");
+	CHECK(!LoadBakedMeshScene(Settings, Baked, Source, Scene, Log));
+
+	WriteTestFile(Directory, "Triangle.obj", s_TriangleObj);
+	CHECK(LoadBakedMeshScene(Settings, Baked, Source, Scene, Log));
+}
+
+TEST_CASE(MeshImporterUsesBakesWithoutSource)
+{
+	std::string Directory = GetTestDirectory("MeshImporterUsesBakesWithoutSource");
+	std::string Source = WriteTestFile(Directory, "Triangle.obj", s_TriangleObj);
+	std::string Baked = Directory + "/Triangle.obj.meshcache";
+
+	MeshImportSettings Settings;
+	WriteBakedTriangle(Settings, Source, Baked);
+	std::filesystem::remove(Source);
+
+	/** A shipped bake stands on its own, but it must still be made with the same settings */
+	std::ostringstream Log;
+	MeshScene Scene;
+	CHECK(LoadBakedMeshScene(Settings, Baked, Source, Scene, Log));
+	CHECK(Scene.Vertices.size() == 3);
+
+	MeshImportSettings Welded = Settings;
+	Welded.VertexWeldEpsilon = 0.001f;
+	CHECK(!LoadBakedMeshScene(Welded, Baked, Source, Scene, Log));
+
+	CHECK(!LoadBakedMeshScene(Settings, Directory + "/Missing.obj.meshcache", Source, Scene, Log));
+}
+
+TEST_CASE(MeshImporterRejectsOtherLodSettings)
+{
+	std::string Directory = GetTestDirectory("MeshImporterRejectsOtherLodSettings");
+	std::string Source = WriteTestFile(Directory, "Triangle.obj", s_TriangleObj);
+	std::string Baked = Directory + "/Triangle.obj.meshcache";
+
+	MeshImportSettings Settings;
+	WriteBakedTriangle(Settings, Source, Baked);
+
+	/** The LOD chain is part of the cache, so it must be rebuilt and the AssetBaker must rebake */
+	MeshImportSettings Reduction = Settings;
+	Reduction.LodReduction = 0.25f;
+	MeshImportSettings MinReduction = Settings;
+	MinReduction.LodMinReduction = 0.2f;
+
+	std::ostringstream Log;
+	MeshScene Scene;
+	CHECK(LoadBakedMeshScene(Settings, Baked, Source, Scene, Log));
+	CHECK(!LoadBakedMeshScene(Reduction, Baked, Source, Scene, Log));
+	CHECK(!LoadBakedMeshScene(MinReduction, Baked, Source, Scene, Log));
+
+	CHECK(GetMeshImportSettingsHash(Reduction) != GetMeshImportSettingsHash(Settings));
+	CHECK(GetMeshImportSettingsHash(MinReduction) != GetMeshImportSettingsHash(Settings));
+	CHECK(GetMeshImportSettingsHash(MinReduction) != GetMeshImportSettingsHash(Reduction));
+}
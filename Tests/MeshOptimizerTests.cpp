@@ -0,0 +1,273 @@
+#include "TestFramework.hpp"
+#include "TestMeshes.hpp"
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+static std::vector<uint32_t> RemapIndices(
+	const std::vector<uint32_t> & Indices,
+	const std::vector<uint32_t> & Remap
+)
+{
+	std::vector<uint32_t> Remapped;
+
+	for (uint32_t Index : Indices)
+	{
+		Remapped.push_back(Remap[Index]);
+	}
+
+	return Remapped;
+}
+
+TEST_CASE(MeshOptimizerVertexCachePreservesTriangles)
+{
+	TestMesh Mesh = MakeGridMesh(32, 32);
+	std::vector<uint32_t> Indices = Mesh.Indices;
+
+	std::vector<uint32_t> Clusters;
+	OptimizeVertexCache(Indices, Mesh.VertexCount(), Clusters);
+
+	CHECK(GetTriangleSet(Indices) == GetTriangleSet(Mesh.Indices));
+
+	REQUIRE(!Clusters.empty());
+	CHECK(Clusters[0] == 0);
+	CHECK(std::is_sorted(Clusters.begin(), Clusters.end()));
+	CHECK(Clusters.back() < Indices.size() / 3);
+}
+
+TEST_CASE(MeshOptimizerVertexCacheDoesNotIncreaseAcmr)
+{
+	TestMesh Mesh = MakeGridMesh(64, 64);
+	std::vector<uint32_t> Indices = Mesh.Indices;
+
+	VertexCacheStatistics Before = AnalyzeVertexCache(Indices, Mesh.VertexCount());
+
+	std::vector<uint32_t> Clusters;
+	OptimizeVertexCache(Indices, Mesh.VertexCount(), Clusters);
+
+	VertexCacheStatistics After = AnalyzeVertexCache(Indices, Mesh.VertexCount());
+
+	CHECK(After.Acmr <= Before.Acmr);
+	/** Every vertex is transformed at least once */
+	CHECK(After.Atvr >= 1.0f);
+}
+
+TEST_CASE(MeshOptimizerOverdrawPreservesTriangles)
+{
+	TestMesh Mesh = MakeGridMesh(32, 32);
+	std::vector<uint32_t> Indices = Mesh.Indices;
+
+	std::vector<uint32_t> Clusters;
+	OptimizeVertexCache(Indices, Mesh.VertexCount(), Clusters);
+	std::vector<uint32_t> CacheOptimized = Indices;
+
+	OptimizeOverdraw(Indices, Clusters, Mesh.Positions.data(), sizeof(float) * 3, Mesh.VertexCount());
+
+	CHECK(GetTriangleSet(Indices) == GetTriangleSet(Mesh.Indices));
+
+	/** Threshold bounds how much of the cache efficiency the cluster sort may give away */
+	float CacheAcmr = AnalyzeVertexCache(CacheOptimized, Mesh.VertexCount()).Acmr;
+	float OverdrawAcmr = AnalyzeVertexCache(Indices, Mesh.VertexCount()).Acmr;
+	CHECK(OverdrawAcmr <= CacheAcmr * 1.05f + 0.05f);
+}
+
+TEST_CASE(MeshOptimizerVertexFetchPreservesTriangles)
+{
+	TestMesh Mesh = MakeGridMesh(16, 16);
+	std::vector<uint32_t> Indices = Mesh.Indices;
+
+	std::vector<uint32_t> Clusters;
+	OptimizeVertexCache(Indices, Mesh.VertexCount(), Clusters);
+	std::vector<uint32_t> CacheOptimized = Indices;
+
+	std::vector<uint32_t> Remap;
+	size_t NewVertexCount = OptimizeVertexFetch(Indices, Mesh.VertexCount(), Remap);
+
+	CHECK(NewVertexCount == Mesh.VertexCount());
+	CHECK(GetTriangleSet(Indices) == GetTriangleSet(RemapIndices(CacheOptimized, Remap)));
+}
+
+TEST_CASE(MeshOptimizerVertexFetchRemapIsBijection)
+{
+	TestMesh Mesh = MakeGridMesh(8, 8);
+	std::vector<uint32_t> Indices = Mesh.Indices;
+
+	/** Two vertices no triangle references, they are dropped */
+	size_t VertexCount = Mesh.VertexCount() + 2;
+
+	std::vector<uint32_t> Clusters;
+	OptimizeVertexCache(Indices, VertexCount, Clusters);
+
+	std::vector<uint32_t> Remap;
+	size_t NewVertexCount = OptimizeVertexFetch(Indices, VertexCount, Remap);
+
+	REQUIRE(Remap.size() == VertexCount);
+	CHECK(NewVertexCount == Mesh.VertexCount());
+	CHECK(Remap[VertexCount - 2] == UINT32_MAX);
+	CHECK(Remap[VertexCount - 1] == UINT32_MAX);
+
+	std::vector<uint32_t> Sources(NewVertexCount, UINT32_MAX);
+	for (uint32_t Old = 0; Old < Mesh.VertexCount(); Old++)
+	{
+		REQUIRE(Remap[Old] < NewVertexCount);
+		CHECK(Sources[Remap[Old]] == UINT32_MAX);
+		Sources[Remap[Old]] = Old;
+	}
+
+	/** New indices are handed out in order of first use */
+	uint32_t NextVertex = 0;
+	for (uint32_t Index : Indices)
+	{
+		CHECK(Index <= NextVertex);
+		if (Index == NextVertex)
+		{
+			NextVertex++;
+		}
+	}
+
+	CHECK(NextVertex == NewVertexCount);
+}
+
+TEST_CASE(MeshOptimizerHandlesEmptyMesh)
+{
+	std::vector<uint32_t> Indices;
+	std::vector<uint32_t> Clusters;
+	std::vector<uint32_t> Remap;
+
+	OptimizeVertexCache(Indices, 0, Clusters);
+	CHECK(Indices.empty());
+	CHECK(Clusters.empty());
+
+	OptimizeOverdraw(Indices, Clusters, nullptr, sizeof(float) * 3, 0);
+	CHECK(Indices.empty());
+
+	CHECK(OptimizeVertexFetch(Indices, 0, Remap) == 0);
+	CHECK(Remap.empty());
+
+	VertexCacheStatistics Statistics = AnalyzeVertexCache(Indices, 0);
+	CHECK(Statistics.VertexTransforms == 0);
+	CHECK(Statistics.Acmr == 0.0f);
+}
+
+TEST_CASE(MeshOptimizerHandlesSingleTriangle)
+{
+	const std::vector<float> Positions = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+	const std::vector<uint32_t> Original = { 2, 0, 1 };
+	std::vector<uint32_t> Indices = Original;
+
+	std::vector<uint32_t> Clusters;
+	OptimizeVertexCache(Indices, 3, Clusters);
+	CHECK(GetTriangleSet(Indices) == GetTriangleSet(Original));
+	CHECK(Clusters == std::vector<uint32_t>({ 0 }));
+
+	OptimizeOverdraw(Indices, Clusters, Positions.data(), sizeof(float) * 3, 3);
+	CHECK(GetTriangleSet(Indices) == GetTriangleSet(Original));
+
+	std::vector<uint32_t> Remap;
+	CHECK(OptimizeVertexFetch(Indices, 3, Remap) == 3);
+	CHECK(Indices == std::vector<uint32_t>({ 0, 1, 2 }));
+	CHECK(GetTriangleSet(Indices) == GetTriangleSet(RemapIndices(Original, Remap)));
+
+	VertexCacheStatistics Statistics = AnalyzeVertexCache(Indices, 3);
+	CHECK(Statistics.VertexTransforms == 3);
+	CHECK(Statistics.Acmr == 3.0f);
+}
+
+/** Maps the sub-mesh relative indices back to the vertices they were copied from. */
+static std::vector<uint32_t> GetSourceIndices(
+	const std::vector<uint32_t> & Indices,
+	const std::vector<uint32_t> & VertexSources,
+	const std::vector<SubMesh> & SubMeshes
+)
+{
+	std::vector<uint32_t> Sources;
+
+	for (const SubMesh & Mesh : SubMeshes)
+	{
+		for (uint32_t i = Mesh.FirstIndex; i < Mesh.FirstIndex + Mesh.IndexCount; i++)
+		{
+			Sources.push_back(VertexSources[Mesh.VertexOffset + Indices[i]]);
+		}
+	}
+
+	return Sources;
+}
+
+static void CheckSplitMesh(
+	const TestMesh & Mesh,
+	uint32_t MaxVertices
+)
+{
+	std::vector<uint32_t> Indices = Mesh.Indices;
+	std::vector<uint32_t> VertexSources;
+	std::vector<SubMesh> SubMeshes;
+	SplitMesh(Indices, Mesh.VertexCount(), MaxVertices, VertexSources, SubMeshes);
+
+	REQUIRE(!SubMeshes.empty());
+	CHECK(SubMeshes.size() > 1 || Mesh.VertexCount() <= MaxVertices);
+	CHECK(Indices.size() == Mesh.Indices.size());
+
+	uint32_t NextIndex = 0;
+	uint32_t NextVertex = 0;
+
+	for (const SubMesh & Sub : SubMeshes)
+	{
+		/** Contiguous ranges of the index buffer and of the duplicated vertices */
+		CHECK(Sub.FirstIndex == NextIndex);
+		CHECK(Sub.VertexOffset == NextVertex);
+		CHECK(Sub.VertexCount <= MaxVertices);
+		CHECK(Sub.IndexCount % 3 == 0);
+
+		for (uint32_t i = Sub.FirstIndex; i < Sub.FirstIndex + Sub.IndexCount; i++)
+		{
+			CHECK(Indices[i] < Sub.VertexCount);
+		}
+
+		NextIndex += Sub.IndexCount;
+		NextVertex += Sub.VertexCount;
+	}
+
+	CHECK(NextIndex == Indices.size());
+	CHECK(NextVertex == VertexSources.size());
+	CHECK(GetTriangleSet(GetSourceIndices(Indices, VertexSources, SubMeshes)) == GetTriangleSet(Mesh.Indices));
+}
+
+TEST_CASE(MeshOptimizerSplitMeshRespects16BitLimit)
+{
+	/** 301 * 301 vertices, more than 16-bit indices can address */
+	TestMesh Mesh = MakeGridMesh(300, 300);
+	REQUIRE(Mesh.VertexCount() > MESH_MAX_16BIT_VERTICES);
+
+	CheckSplitMesh(Mesh, MESH_MAX_16BIT_VERTICES);
+}
+
+TEST_CASE(MeshOptimizerSplitMeshPreservesTriangles)
+{
+	TestMesh Mesh = MakeGridMesh(32, 32);
+
+	std::vector<uint32_t> Clusters;
+	OptimizeVertexCache(Mesh.Indices, Mesh.VertexCount(), Clusters);
+
+	CheckSplitMesh(Mesh, 64);
+	/** A triangle needs at most three new vertices */
+	CheckSplitMesh(Mesh, 3);
+}
+
+TEST_CASE(MeshOptimizerSplitMeshKeepsFittingMesh)
+{
+	TestMesh Mesh = MakeGridMesh(4, 4);
+	std::vector<uint32_t> Indices = Mesh.Indices;
+
+	std::vector<uint32_t> VertexSources;
+	std::vector<SubMesh> SubMeshes;
+	SplitMesh(Indices, Mesh.VertexCount(), MESH_MAX_16BIT_VERTICES, VertexSources, SubMeshes);
+
+	REQUIRE(SubMeshes.size() == 1);
+	CHECK(Indices == Mesh.Indices);
+	CHECK(SubMeshes[0].IndexCount == Indices.size());
+	CHECK(SubMeshes[0].VertexCount == Mesh.VertexCount());
+	CHECK(VertexSources.size() == Mesh.VertexCount());
+}
@@ -0,0 +1,138 @@
+#include "TestFramework.hpp"
+#include "TestMeshes.hpp"
+#include "MeshSimplifier.hpp"
+
+#include <cmath>
+#include <limits>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+using TestEdge = std::pair<uint32_t, uint32_t>;
+
+/** Half-edges without their opposite, the boundary of the mesh. */
+static std::set<TestEdge> GetOpenEdges(
+	const std::vector<uint32_t> & Indices
+)
+{
+	std::set<TestEdge> Edges;
+
+	for (size_t i = 0; i < Indices.size(); i += 3)
+	{
+		for (size_t k = 0; k < 3; k++)
+		{
+			Edges.insert(TestEdge(Indices[i + k], Indices[i + (k + 1) % 3]));
+		}
+	}
+
+	std::set<TestEdge> OpenEdges;
+
+	for (const TestEdge & Edge : Edges)
+	{
+		if (Edges.count(TestEdge(Edge.second, Edge.first)) == 0)
+		{
+			OpenEdges.insert(Edge);
+		}
+	}
+
+	return OpenEdges;
+}
+
+/** A bumpy grid, so the collapses have an error to weigh against each other. */
+static TestMesh MakeHeightfieldMesh(
+	uint32_t Quads
+)
+{
+	TestMesh Mesh = MakeGridMesh(Quads, Quads);
+
+	for (size_t i = 0; i < Mesh.Positions.size(); i += 3)
+	{
+		Mesh.Positions[i + 2] = 0.5f * std::sin(Mesh.Positions[i] * 0.3f) * std::cos(Mesh.Positions[i + 1] * 0.2f);
+	}
+
+	return Mesh;
+}
+
+static void CheckValidTriangles(
+	const std::vector<uint32_t> & Indices,
+	size_t VertexCount
+)
+{
+	CHECK(Indices.size() % 3 == 0);
+
+	for (size_t i = 0; i < Indices.size(); i += 3)
+	{
+		CHECK(Indices[i] < VertexCount && Indices[i + 1] < VertexCount && Indices[i + 2] < VertexCount);
+		CHECK(Indices[i] != Indices[i + 1] && Indices[i + 1] != Indices[i + 2] && Indices[i] != Indices[i + 2]);
+	}
+}
+
+TEST_CASE(MeshSimplifierReachesTarget)
+{
+	TestMesh Mesh = MakeHeightfieldMesh(64);
+
+	for (size_t Divisor : { 2, 4, 16 })
+	{
+		size_t TargetIndexCount = Mesh.Indices.size() / Divisor;
+
+		std::vector<uint32_t> Result;
+		float Error = SimplifyMesh(
+			Mesh.Indices, Mesh.Positions.data(), sizeof(float) * 3, Mesh.VertexCount(),
+			TargetIndexCount, std::numeric_limits<float>::max(), false, Result
+		);
+
+		CHECK(Result.size() <= TargetIndexCount);
+		/** Each collapse removes two triangles at most, so it stops right below the target */
+		CHECK(Result.size() + 6 > TargetIndexCount);
+		CHECK(Error >= 0.0f);
+		CheckValidTriangles(Result, Mesh.VertexCount());
+	}
+}
+
+TEST_CASE(MeshSimplifierStopsAtMaxError)
+{
+	TestMesh Mesh = MakeHeightfieldMesh(32);
+
+	std::vector<uint32_t> Result;
+	float MaxError = 1e-3f;
+	float Error = SimplifyMesh(
+		Mesh.Indices, Mesh.Positions.data(), sizeof(float) * 3, Mesh.VertexCount(),
+		0, MaxError, false, Result
+	);
+
+	CHECK(Error <= MaxError);
+	CHECK(!Result.empty());
+	CHECK(Result.size() < Mesh.Indices.size());
+	CheckValidTriangles(Result, Mesh.VertexCount());
+}
+
+TEST_CASE(MeshSimplifierKeepsLockedBorders)
+{
+	TestMesh Mesh = MakeHeightfieldMesh(32);
+	std::set<TestEdge> Border = GetOpenEdges(Mesh.Indices);
+	REQUIRE(Border.size() == 4 * 32);
+
+	size_t TargetIndexCount = Mesh.Indices.size() / 4;
+
+	std::vector<uint32_t> Locked;
+	SimplifyMesh(
+		Mesh.Indices, Mesh.Positions.data(), sizeof(float) * 3, Mesh.VertexCount(),
+		TargetIndexCount, std::numeric_limits<float>::max(), true, Locked
+	);
+
+	/** Vertices only move onto other vertices, a border vertex that moved would leave its edges */
+	CHECK(Locked.size() <= TargetIndexCount);
+	CHECK(GetOpenEdges(Locked) == Border);
+	CheckValidTriangles(Locked, Mesh.VertexCount());
+
+	std::vector<uint32_t> Unlocked;
+	SimplifyMesh(
+		Mesh.Indices, Mesh.Positions.data(), sizeof(float) * 3, Mesh.VertexCount(),
+		TargetIndexCount, std::numeric_limits<float>::max(), false, Unlocked
+	);
+
+	/** Without the lock the straight grid border is the cheapest thing to collapse */
+	CHECK(GetOpenEdges(Unlocked).size() < Border.size());
+}
@@ -0,0 +1,165 @@
+#include "TestFramework.hpp"
+#include "TestMeshes.hpp"
+#include "MeshletBuilder.hpp"
+
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+/** A UV sphere of radius one with outward facing counter clockwise triangles, the poles are duplicated per segment. */
+static TestMesh MakeSphereMesh(
+	uint32_t Segments,
+	uint32_t Rings
+)
+{
+	TestMesh Mesh;
+
+	for (uint32_t Ring = 0; Ring <= Rings; Ring++)
+	{
+		float Theta = 3.14159265f * Ring / Rings;
+
+		for (uint32_t Segment = 0; Segment <= Segments; Segment++)
+		{
+			float Phi = 2.0f * 3.14159265f * Segment / Segments;
+			Mesh.Positions.push_back(std::sin(Theta) * std::cos(Phi));
+			Mesh.Positions.push_back(std::sin(Theta) * std::sin(Phi));
+			Mesh.Positions.push_back(std::cos(Theta));
+		}
+	}
+
+	for (uint32_t Ring = 0; Ring < Rings; Ring++)
+	{
+		for (uint32_t Segment = 0; Segment < Segments; Segment++)
+		{
+			uint32_t V0 = Ring * (Segments + 1) + Segment;
+			uint32_t V1 = V0 + 1;
+			uint32_t V2 = V0 + Segments + 1;
+			uint32_t V3 = V2 + 1;
+
+			if (Ring > 0)
+			{
+				Mesh.Indices.insert(Mesh.Indices.end(), { V0, V2, V1 });
+			}
+			if (Ring + 1 < Rings)
+			{
+				Mesh.Indices.insert(Mesh.Indices.end(), { V1, V2, V3 });
+			}
+		}
+	}
+
+	return Mesh;
+}
+
+static glm::vec3 GetTestPosition(
+	const TestMesh & Mesh,
+	uint32_t Vertex
+)
+{
+	return glm::vec3(Mesh.Positions[Vertex * 3], Mesh.Positions[Vertex * 3 + 1], Mesh.Positions[Vertex * 3 + 2]);
+}
+
+static void CheckMeshlets(
+	const TestMesh & Mesh,
+	float ConeWeight
+)
+{
+	std::vector<uint32_t> Indices = Mesh.Indices;
+	std::vector<Meshlet> Meshlets;
+	BuildMeshlets(Indices, Mesh.Positions.data(), sizeof(float) * 3, Mesh.VertexCount(), Meshlets, ConeWeight);
+
+	REQUIRE(!Meshlets.empty());
+	CHECK(GetTriangleSet(Indices) == GetTriangleSet(Mesh.Indices));
+
+	uint32_t NextIndex = 0;
+
+	for (const Meshlet & Cluster : Meshlets)
+	{
+		CHECK(Cluster.FirstIndex == NextIndex);
+		CHECK(Cluster.IndexCount > 0 && Cluster.IndexCount % 3 == 0);
+		CHECK(Cluster.IndexCount / 3 <= MESHLET_MAX_TRIANGLES);
+		NextIndex += Cluster.IndexCount;
+
+		std::set<uint32_t> Vertices(Indices.begin() + Cluster.FirstIndex, Indices.begin() + Cluster.FirstIndex + Cluster.IndexCount);
+		CHECK(Vertices.size() <= MESHLET_MAX_VERTICES);
+		CHECK(Cluster.VertexCount == Vertices.size());
+
+		/** Relative slack for the float math of the sphere fit */
+		for (uint32_t Vertex : Vertices)
+		{
+			CHECK(glm::length(GetTestPosition(Mesh, Vertex) - Cluster.Center) <= Cluster.Radius * 1.0001f + 1e-5f);
+		}
+	}
+
+	CHECK(NextIndex == Indices.size());
+}
+
+TEST_CASE(MeshletBuilderRespectsLimitsOnGrid)
+{
+	CheckMeshlets(MakeGridMesh(64, 64), 0.0f);
+	CheckMeshlets(MakeGridMesh(64, 64), 0.5f);
+}
+
+TEST_CASE(MeshletBuilderRespectsLimitsOnSphere)
+{
+	CheckMeshlets(MakeSphereMesh(64, 32), 0.0f);
+	CheckMeshlets(MakeSphereMesh(64, 32), 0.5f);
+	CheckMeshlets(MakeSphereMesh(64, 32), 1.0f);
+}
+
+TEST_CASE(MeshletBuilderHandlesSmallMeshes)
+{
+	std::vector<uint32_t> Indices;
+	std::vector<Meshlet> Meshlets(1);
+	BuildMeshlets(Indices, nullptr, sizeof(float) * 3, 0, Meshlets);
+	CHECK(Meshlets.empty());
+
+	CheckMeshlets(MakeGridMesh(1, 1), 0.5f);
+}
+
+TEST_CASE(MeshletBuilderConesOnlyCullBackfaces)
+{
+	TestMesh Mesh = MakeSphereMesh(64, 32);
+	std::vector<uint32_t> Indices = Mesh.Indices;
+	std::vector<Meshlet> Meshlets;
+	BuildMeshlets(Indices, Mesh.Positions.data(), sizeof(float) * 3, Mesh.VertexCount(), Meshlets);
+
+	std::mt19937 Random(42);
+	std::uniform_real_distribution<float> Unit(-4.0f, 4.0f);
+
+	uint32_t CulledCount = 0;
+
+	for (int i = 0; i < 64; i++)
+	{
+		glm::vec3 Viewer(Unit(Random), Unit(Random), Unit(Random));
+		if (glm::length(Viewer) < 1.5f)
+		{
+			continue;
+		}
+
+		for (const Meshlet & Cluster : Meshlets)
+		{
+			if (glm::dot(glm::normalize(Cluster.ConeApex - Viewer), Cluster.ConeAxis) <= Cluster.ConeCutoff)
+			{
+				continue;
+			}
+
+			CulledCount++;
+
+			for (uint32_t k = Cluster.FirstIndex; k < Cluster.FirstIndex + Cluster.IndexCount; k += 3)
+			{
+				glm::vec3 P0 = GetTestPosition(Mesh, Indices[k]);
+				glm::vec3 P1 = GetTestPosition(Mesh, Indices[k + 1]);
+				glm::vec3 P2 = GetTestPosition(Mesh, Indices[k + 2]);
+				glm::vec3 Normal = glm::cross(P1 - P0, P2 - P0);
+
+				CHECK(glm::dot(Normal, Viewer - P0) <= 1e-5f);
+			}
+		}
+	}
+
+	/** The sphere is convex, a viewer outside it must see some clusters from the back */
+	CHECK(CulledCount > 0);
+}
@@ -0,0 +1,216 @@
+#include "MockVulkan.hpp"
+
+using namespace GLOBAL_NAMESPACE;
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+static MockDevice s_MockDevice;
+
+MockDevice & ResetMockDevice()
+{
+	s_MockDevice = MockDevice();
+
+	VkPhysicalDeviceLimits & Limits = s_MockDevice.Properties.limits;
+	Limits.bufferImageGranularity = 4096;
+	Limits.minUniformBufferOffsetAlignment = 256;
+	Limits.maxImageDimension2D = 16384;
+
+	VkPhysicalDeviceMemoryProperties & MemoryProperties = s_MockDevice.MemoryProperties;
+	MemoryProperties.memoryHeapCount = 2;
+	MemoryProperties.memoryHeaps[0].size = 2048ull * 1024 * 1024;
+	MemoryProperties.memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+	MemoryProperties.memoryHeaps[1].size = 256ull * 1024 * 1024;
+	MemoryProperties.memoryTypeCount = 2;
+	MemoryProperties.memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	MemoryProperties.memoryTypes[0].heapIndex = 0;
+	MemoryProperties.memoryTypes[1].propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	MemoryProperties.memoryTypes[1].heapIndex = 1;
+
+	s_MockDevice.BufferRequirements = { 256, 256, 0x3 };
+	s_MockDevice.ImageRequirements = { 65536, 65536, 0x1 };
+
+	return s_MockDevice;
+}
+
+MockDevice & GetMockDevice()
+{
+	return s_MockDevice;
+}
+
+static void BindMemory(
+	uint64_t Resource,
+	VkDeviceMemory Memory,
+	VkDeviceSize Offset,
+	VkDeviceSize Size,
+	bool bLinear
+)
+{
+	auto Iter = s_MockDevice.Memories.find(GetMockHandleId(Memory));
+	if (Iter == s_MockDevice.Memories.end() || Offset + Size > Iter->second.Size)
+	{
+		s_MockDevice.InvalidUsageCount++;
+		return;
+	}
+
+	s_MockDevice.Bindings[Resource] = { GetMockHandleId(Memory), Offset, Size, bLinear };
+}
+
+NAMESPACE_END
+
+void vkGetPhysicalDeviceProperties(
+	VkPhysicalDevice PhysicalDevice,
+	VkPhysicalDeviceProperties * pProperties
+)
+{
+	*pProperties = s_MockDevice.Properties;
+}
+
+void vkGetPhysicalDeviceMemoryProperties(
+	VkPhysicalDevice PhysicalDevice,
+	VkPhysicalDeviceMemoryProperties * pMemoryProperties
+)
+{
+	*pMemoryProperties = s_MockDevice.MemoryProperties;
+}
+
+VkResult vkAllocateMemory(
+	VkDevice Device,
+	const VkMemoryAllocateInfo * pAllocateInfo,
+	const VkAllocationCallbacks * pAllocator,
+	VkDeviceMemory * pMemory
+)
+{
+	if (pAllocateInfo->memoryTypeIndex >= s_MockDevice.MemoryProperties.memoryTypeCount)
+	{
+		s_MockDevice.InvalidUsageCount++;
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+	}
+
+	if (pAllocateInfo->allocationSize > s_MockDevice.MaxAllocationSize)
+	{
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+	}
+
+	*pMemory = CreateMockHandle<VkDeviceMemory>();
+
+	MockDevice::Memory & Memory = s_MockDevice.Memories[GetMockHandleId(*pMemory)];
+	Memory.Size = pAllocateInfo->allocationSize;
+	Memory.MemoryTypeIndex = pAllocateInfo->memoryTypeIndex;
+
+	s_MockDevice.AllocateCount++;
+	return VK_SUCCESS;
+}
+
+void vkFreeMemory(
+	VkDevice Device,
+	VkDeviceMemory Memory,
+	const VkAllocationCallbacks * pAllocator
+)
+{
+	if (s_MockDevice.Memories.erase(GetMockHandleId(Memory)) == 0)
+	{
+		s_MockDevice.InvalidUsageCount++;
+		return;
+	}
+
+	s_MockDevice.FreeCount++;
+}
+
+VkResult vkMapMemory(
+	VkDevice Device,
+	VkDeviceMemory Memory,
+	VkDeviceSize Offset,
+	VkDeviceSize Size,
+	VkMemoryMapFlags Flags,
+	void ** ppData
+)
+{
+	auto Iter = s_MockDevice.Memories.find(GetMockHandleId(Memory));
+	if (Iter == s_MockDevice.Memories.end() || Iter->second.bMapped)
+	{
+		s_MockDevice.InvalidUsageCount++;
+		return VK_ERROR_MEMORY_MAP_FAILED;
+	}
+
+	if (s_MockDevice.MapResult != VK_SUCCESS)
+	{
+		return s_MockDevice.MapResult;
+	}
+
+	MockDevice::Memory & Mapped = Iter->second;
+	if (!(s_MockDevice.MemoryProperties.memoryTypes[Mapped.MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+	{
+		s_MockDevice.InvalidUsageCount++;
+		return VK_ERROR_MEMORY_MAP_FAILED;
+	}
+
+	Mapped.Data.resize(static_cast<size_t>(Mapped.Size));
+	Mapped.bMapped = true;
+	*ppData = Mapped.Data.data() + Offset;
+	return VK_SUCCESS;
+}
+
+void vkUnmapMemory(
+	VkDevice Device,
+	VkDeviceMemory Memory
+)
+{
+	auto Iter = s_MockDevice.Memories.find(GetMockHandleId(Memory));
+	if (Iter == s_MockDevice.Memories.end() || !Iter->second.bMapped)
+	{
+		s_MockDevice.InvalidUsageCount++;
+		return;
+	}
+
+	Iter->second.bMapped = false;
+}
+
+void vkGetBufferMemoryRequirements(
+	VkDevice Device,
+	VkBuffer Buffer,
+	VkMemoryRequirements * pMemoryRequirements
+)
+{
+	*pMemoryRequirements = s_MockDevice.BufferRequirements;
+}
+
+void vkGetImageMemoryRequirements(
+	VkDevice Device,
+	VkImage Image,
+	VkMemoryRequirements * pMemoryRequirements
+)
+{
+	*pMemoryRequirements = s_MockDevice.ImageRequirements;
+}
+
+VkResult vkBindBufferMemory(
+	VkDevice Device,
+	VkBuffer Buffer,
+	VkDeviceMemory Memory,
+	VkDeviceSize MemoryOffset
+)
+{
+	if (s_MockDevice.BindResult != VK_SUCCESS)
+	{
+		return s_MockDevice.BindResult;
+	}
+
+	BindMemory(GetMockHandleId(Buffer), Memory, MemoryOffset, s_MockDevice.BufferRequirements.size, true);
+	return VK_SUCCESS;
+}
+
+VkResult vkBindImageMemory(
+	VkDevice Device,
+	VkImage Image,
+	VkDeviceMemory Memory,
+	VkDeviceSize MemoryOffset
+)
+{
+	if (s_MockDevice.BindResult != VK_SUCCESS)
+	{
+		return s_MockDevice.BindResult;
+	}
+
+	BindMemory(GetMockHandleId(Image), Memory, MemoryOffset, s_MockDevice.ImageRequirements.size, false);
+	return VK_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/**
+* State behind the Vulkan entry points defined in MockVulkan.cpp. The test project does
+* not link vulkan-1.lib, device memory is host memory and every call is recorded so the
+* tests can check what the code under test did to the device.
+*/
+struct MockDevice
+{
+	struct Memory
+	{
+		VkDeviceSize Size = 0;
+		uint32_t MemoryTypeIndex = 0;
+		bool bMapped = false;
+		/** Only backed once it is mapped */
+		std::vector<uint8_t> Data;
+	};
+
+	struct Binding
+	{
+		uint64_t Memory = 0;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+		bool bLinear = true;
+	};
+
+	VkPhysicalDeviceProperties Properties = {};
+	VkPhysicalDeviceMemoryProperties MemoryProperties = {};
+
+	/** Returned for every buffer / image, set by the test before it allocates */
+	VkMemoryRequirements BufferRequirements = {};
+	VkMemoryRequirements ImageRequirements = {};
+
+	/** Live device memory by handle */
+	std::map<uint64_t, Memory> Memories;
+	/** Bound memory by buffer / image handle */
+	std::map<uint64_t, Binding> Bindings;
+
+	/** vkAllocateMemory fails with VK_ERROR_OUT_OF_DEVICE_MEMORY above this size */
+	VkDeviceSize MaxAllocationSize = ~0ull;
+	/** Returned by vkMapMemory / vkBind*Memory instead of succeeding if set */
+	VkResult MapResult = VK_SUCCESS;
+	VkResult BindResult = VK_SUCCESS;
+
+	uint32_t AllocateCount = 0;
+	uint32_t FreeCount = 0;
+	/** Calls the validation layers would complain about, e.g. mapping twice or freeing an unknown handle */
+	uint32_t InvalidUsageCount = 0;
+
+	uint64_t NextHandle = 1;
+};
+
+/**
+* Resets the mock to a device with a 2GB device local heap (memory type 0) and a 256MB host
+* visible, host coherent heap (memory type 1).
+*/
+MockDevice & ResetMockDevice();
+
+MockDevice & GetMockDevice();
+
+/** Works for both the pointer (64 bit) and the uint64_t (32 bit) definition of the non dispatchable handles. */
+template <typename THandle>
+THandle CreateMockHandle()
+{
+	return (THandle)(uintptr_t)GetMockDevice().NextHandle++;
+}
+
+template <typename THandle>
+uint64_t GetMockHandleId(THandle Handle)
+{
+	return (uint64_t)(uintptr_t)Handle;
+}
+
+NAMESPACE_END
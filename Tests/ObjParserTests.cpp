@@ -0,0 +1,242 @@
+#include "TestFramework.hpp"
+#include "ObjParser.hpp"
+#include "ThreadPool.hpp"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <assimp/material.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+/**
+* Two materials switched back and forth, quads that are fan triangulated, negative (relative) indices
+* and lines the parser skips. Only convex quads and triangles, Assimp triangulates larger polygons by
+* ear clipping which may pick other diagonals than the fan.
+*/
+static const char * s_ObjFixture =
+	"# Cube with two materials\n"
+	"mtllib Fixture.mtl\n"
+	"o Cube\n"
+	"v -1.0 -1.0 1.0\n"
+	"v 1.0 -1.0 1.0\n"
+	"v 1.0 1.0 1.0\n"
+	"v -1.0 1.0 1.0\n"
+	"v -1.0 -1.0 -1.0\n"
+	"v 1.0 -1.0 -1.0\n"
+	"v 1.0 1.0 -1.0\n"
+	"v -1.0 1.0 -1.0\n"
+	"vt 0.0 0.0\n"
+	"vt 1.0 0.0\n"
+	"vt 1.0 1.0\n"
+	"vt 0.0 1.0\n"
+	"vt 0.25 0.75\n"
+	"vn 0.0 0.0 1.0\n"
+	"vn 0.0 0.0 -1.0\n"
+	"vn 1.0 0.0 0.0\n"
+	"vn -1.0 0.0 0.0\n"
+	"vn 0.0 1.0 0.0\n"
+	"vn 0.0 -1.0 0.0\n"
+	"s 1\n"
+	"usemtl Red\n"
+	"f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+	"f 6/1/2 5/2/2 8/3/2 7/4/2\n"
+	"\n"
+	"usemtl Green\n"
+	"f 2/1/3 6/2/3 7/3/3\n"
+	"f -7/1/-4 -2/3/-4 -1/5/-4\n"
+	"usemtl Red\n"
+	"f 4/1/5 3/2/5 7/3/5 8/4/5\n"
+	"f -8/1/-1 -7/2/-1 -3/3/-1 -4/4/-1\n";
+
+static const char * s_MtlFixture =
+	"newmtl Red\n"
+	"Kd 1.0 0.0 0.0\n"
+	"newmtl Green\n"
+	"Kd 0.0 1.0 0.0\n";
+
+/** Position, UV (flipped like aiProcess_FlipUVs) and normal of one corner. */
+using ObjTestCorner = std::array<float, 8>;
+
+static std::map<std::string, std::vector<ObjTestCorner>> GetObjCorners(
+	const ObjModel & Model
+)
+{
+	std::map<std::string, std::vector<ObjTestCorner>> Corners;
+
+	for (const ObjMaterialRun & Run : Model.MaterialRuns)
+	{
+		std::vector<ObjTestCorner> & MaterialCorners = Corners[Model.MaterialNames[Run.Material]];
+
+		for (size_t c = Run.FirstCorner; c < Run.FirstCorner + Run.CornerCount; c++)
+		{
+			const ObjCorner & Corner = Model.Corners[c];
+			REQUIRE(Corner.TexCoord != UINT32_MAX && Corner.Normal != UINT32_MAX);
+
+			MaterialCorners.push_back({
+				Model.Positions[Corner.Position * 3], Model.Positions[Corner.Position * 3 + 1], Model.Positions[Corner.Position * 3 + 2],
+				Model.TexCoords[Corner.TexCoord * 2], 1.0f - Model.TexCoords[Corner.TexCoord * 2 + 1],
+				Model.Normals[Corner.Normal * 3], Model.Normals[Corner.Normal * 3 + 1], Model.Normals[Corner.Normal * 3 + 2]
+			});
+		}
+	}
+
+	return Corners;
+}
+
+/** The meshes of one material concatenated in scene order, one vertex per corner as Assimp imports OBJ files. */
+static std::map<std::string, std::vector<ObjTestCorner>> GetAssimpCorners(
+	const aiScene * pScene
+)
+{
+	std::map<std::string, std::vector<ObjTestCorner>> Corners;
+
+	for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+	{
+		const aiMesh * pMesh = pScene->mMeshes[i];
+		REQUIRE(pMesh->HasNormals() && pMesh->HasTextureCoords(0));
+
+		aiString Name;
+		REQUIRE(pScene->mMaterials[pMesh->mMaterialIndex]->Get(AI_MATKEY_NAME, Name) == AI_SUCCESS);
+		std::vector<ObjTestCorner> & MaterialCorners = Corners[Name.C_Str()];
+
+		for (uint32_t f = 0; f < pMesh->mNumFaces; f++)
+		{
+			REQUIRE(pMesh->mFaces[f].mNumIndices == 3);
+
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t Vertex = pMesh->mFaces[f].mIndices[k];
+				const aiVector3D & Position = pMesh->mVertices[Vertex];
+				const aiVector3D & TexCoord = pMesh->mTextureCoords[0][Vertex];
+				const aiVector3D & Normal = pMesh->mNormals[Vertex];
+
+				MaterialCorners.push_back({ Position.x, Position.y, Position.z, TexCoord.x, TexCoord.y, Normal.x, Normal.y, Normal.z });
+			}
+		}
+	}
+
+	return Corners;
+}
+
+TEST_CASE(ObjParserMatchesAssimp)
+{
+	std::string Directory = GetTestDirectory("ObjParserMatchesAssimp");
+	std::string Filename = WriteTestFile(Directory, "Fixture.obj", s_ObjFixture);
+	WriteTestFile(Directory, "Fixture.mtl", s_MtlFixture);
+
+	ObjModel Model;
+	ParseObj(Filename, nullptr, Model);
+
+	CHECK(Model.Positions.size() == 8 * 3);
+	CHECK(Model.Corners.size() == (2 * 2 + 2 + 2 * 2) * 3);
+	CHECK(Model.MaterialNames == std::vector<std::string>({ "Red", "Green" }));
+	CHECK(Model.MaterialLibraries == std::vector<std::string>({ "Fixture.mtl" }));
+	CHECK(Model.MaterialRuns.size() == 3);
+
+	Assimp::Importer Importer;
+	const aiScene * pScene = Importer.ReadFile(Filename, aiProcess_Triangulate | aiProcess_FlipUVs);
+	REQUIRE(pScene != nullptr);
+
+	std::map<std::string, std::vector<ObjTestCorner>> ObjCorners = GetObjCorners(Model);
+	std::map<std::string, std::vector<ObjTestCorner>> AssimpCorners = GetAssimpCorners(pScene);
+
+	REQUIRE(ObjCorners.size() == 2);
+	CHECK(ObjCorners == AssimpCorners);
+}
+
+/** A grid large enough to be split into several chunks, every other row of faces uses negative (relative) indices. */
+static std::string MakeLargeObj(
+	uint32_t Quads
+)
+{
+	std::ostringstream Obj;
+
+	for (uint32_t y = 0; y <= Quads; y++)
+	{
+		for (uint32_t x = 0; x <= Quads; x++)
+		{
+			Obj << "v " << x * 0.125f << " " << y * 0.125f << " " << (x ^ y) * 0.01f << "\n";
+			Obj << "vt " << x / static_cast<float>(Quads) << " " << y / static_cast<float>(Quads) << "\n";
+		}
+	}
+
+	for (uint32_t y = 0; y < Quads; y++)
+	{
+		Obj << "usemtl " << (y % 3 == 0 ? "A" : "B") << "\n";
+
+		/** All vertices come first, -1 is the last of them */
+		int64_t Base = y % 2 == 0 ? 0 : -static_cast<int64_t>((Quads + 1) * (Quads + 1)) - 1;
+
+		for (uint32_t x = 0; x < Quads; x++)
+		{
+			int64_t V0 = Base + y * (Quads + 1) + x + 1;
+			int64_t V2 = V0 + Quads + 1;
+			Obj << "f " << V0 << "/" << V0 << " " << V0 + 1 << "/" << V0 + 1 << " " << V2 + 1 << "/" << V2 + 1 << " " << V2 << "/" << V2 << "\n";
+		}
+	}
+
+	return Obj.str();
+}
+
+TEST_CASE(ObjParserChunksMatchSingleThreaded)
+{
+	std::string Directory = GetTestDirectory("ObjParserChunksMatchSingleThreaded");
+	std::string Filename = WriteTestFile(Directory, "Large.obj", MakeLargeObj(400));
+
+	ObjModel Single;
+	ObjParseStatistics SingleStatistics;
+	ParseObj(Filename, nullptr, Single, &SingleStatistics);
+	CHECK(SingleStatistics.Chunks == 1);
+
+	ThreadPool Pool;
+	Pool.Init(4);
+
+	ObjModel Chunked;
+	ObjParseStatistics ChunkedStatistics;
+	ParseObj(Filename, &Pool, Chunked, &ChunkedStatistics);
+
+	Pool.Destroy();
+
+	CHECK(ChunkedStatistics.Chunks > 1);
+	CHECK(Chunked.Positions == Single.Positions);
+	CHECK(Chunked.TexCoords == Single.TexCoords);
+	CHECK(Chunked.MaterialNames == Single.MaterialNames);
+	REQUIRE(Chunked.Corners.size() == Single.Corners.size());
+	REQUIRE(Chunked.MaterialRuns.size() == Single.MaterialRuns.size());
+
+	for (size_t i = 0; i < Single.Corners.size(); i++)
+	{
+		CHECK(Chunked.Corners[i].Position == Single.Corners[i].Position);
+		CHECK(Chunked.Corners[i].TexCoord == Single.Corners[i].TexCoord);
+		CHECK(Chunked.Corners[i].Normal == UINT32_MAX);
+	}
+
+	for (size_t i = 0; i < Single.MaterialRuns.size(); i++)
+	{
+		CHECK(Chunked.MaterialRuns[i].Material == Single.MaterialRuns[i].Material);
+		CHECK(Chunked.MaterialRuns[i].FirstCorner == Single.MaterialRuns[i].FirstCorner);
+		CHECK(Chunked.MaterialRuns[i].CornerCount == Single.MaterialRuns[i].CornerCount);
+	}
+}
+
+TEST_CASE(ObjParserRejectsBrokenFiles)
+{
+	std::string Directory = GetTestDirectory("ObjParserRejectsBrokenFiles");
+	ObjModel Model;
+
+	CHECK_THROWS(ParseObj(Directory + "/Missing.obj", nullptr, Model));
+
+	std::string Filename = WriteTestFile(Directory, "MissingVertex.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n");
+	CHECK_THROWS(ParseObj(Filename, nullptr, Model));
+
+	Filename = WriteTestFile(Directory, "MissingRelativeVertex.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf -1 -2 -4\n");
+	CHECK_THROWS(ParseObj(Filename, nullptr, Model));
+}
@@ -0,0 +1,142 @@
+#include "TestFramework.hpp"
+#include "TestMeshes.hpp"
+#include "TangentGenerator.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+/**
+* A bumpy grid with the UVs mirrored on its left half and collapsed on one row, so the
+* generator runs through the mirrored, the degenerate and the regular case.
+*/
+static TangentStaging MakeTangentStaging(
+	const TestMesh & Mesh,
+	uint32_t QuadsX
+)
+{
+	TangentStaging Staging;
+	Staging.Resize(Mesh.VertexCount());
+
+	for (size_t i = 0; i < Mesh.VertexCount(); i++)
+	{
+		float X = Mesh.Positions[i * 3];
+		float Y = Mesh.Positions[i * 3 + 1];
+
+		Staging.PositionX[i] = X;
+		Staging.PositionY[i] = Y;
+		Staging.PositionZ[i] = 0.25f * std::sin(X * 0.7f) * std::cos(Y * 0.4f);
+
+		float NormalX = -0.175f * std::cos(X * 0.7f) * std::cos(Y * 0.4f);
+		float NormalY = 0.1f * std::sin(X * 0.7f) * std::sin(Y * 0.4f);
+		float Length = std::sqrt(NormalX * NormalX + NormalY * NormalY + 1.0f);
+		Staging.NormalX[i] = NormalX / Length;
+		Staging.NormalY[i] = NormalY / Length;
+		Staging.NormalZ[i] = 1.0f / Length;
+
+		float U = X / QuadsX;
+		Staging.TexCoordU[i] = X * 2.0f < QuadsX ? 1.0f - U : U;
+		Staging.TexCoordV[i] = Y == 3.0f ? 0.0f : Y * 0.1f;
+	}
+
+	return Staging;
+}
+
+/** Every corner gets its own vertex, like a mesh that was never welded. */
+static void Unweld(
+	const TestMesh & Mesh,
+	TestMesh & Unwelded
+)
+{
+	Unwelded.Positions.clear();
+	Unwelded.Indices.clear();
+
+	for (uint32_t Index : Mesh.Indices)
+	{
+		Unwelded.Indices.push_back(static_cast<uint32_t>(Unwelded.Positions.size() / 3));
+		Unwelded.Positions.insert(Unwelded.Positions.end(), Mesh.Positions.begin() + Index * 3, Mesh.Positions.begin() + Index * 3 + 3);
+	}
+}
+
+static bool IsTangentOutputEqual(
+	const TangentStaging & Lhs,
+	const TangentStaging & Rhs
+)
+{
+	size_t Bytes = Lhs.GetVertexCount() * sizeof(float);
+
+	return Lhs.GetVertexCount() == Rhs.GetVertexCount() &&
+		memcmp(Lhs.TangentX.data(), Rhs.TangentX.data(), Bytes) == 0 &&
+		memcmp(Lhs.TangentY.data(), Rhs.TangentY.data(), Bytes) == 0 &&
+		memcmp(Lhs.TangentZ.data(), Rhs.TangentZ.data(), Bytes) == 0;
+}
+
+static void CheckPathsBitIdentical(
+	const TestMesh & Mesh,
+	uint32_t QuadsX
+)
+{
+	TangentStaging Scalar = MakeTangentStaging(Mesh, QuadsX);
+	REQUIRE(GenerateTangents(Mesh.Indices, Scalar, TANGENT_PATH_SCALAR) == TANGENT_PATH_SCALAR);
+
+	for (size_t i = 0; i < Scalar.GetVertexCount(); i++)
+	{
+		float Length = std::sqrt(Scalar.TangentX[i] * Scalar.TangentX[i] + Scalar.TangentY[i] * Scalar.TangentY[i] + Scalar.TangentZ[i] * Scalar.TangentZ[i]);
+		CHECK(std::abs(Length - 1.0f) < 1e-3f);
+	}
+
+	for (TangentPath Path : { TANGENT_PATH_SSE2, TANGENT_PATH_AVX2, TANGENT_PATH_AUTO })
+	{
+		if (!IsTangentPathSupported(Path))
+		{
+			std::cout << GetTangentPathName(Path) << " is not supported by this CPU, skipped" << std::endl;
+			continue;
+		}
+
+		TangentStaging Simd = MakeTangentStaging(Mesh, QuadsX);
+		GenerateTangents(Mesh.Indices, Simd, Path);
+
+		CHECK(IsTangentOutputEqual(Simd, Scalar));
+	}
+}
+
+TEST_CASE(TangentGeneratorPathsBitIdentical)
+{
+	/** 13 * 10 vertices, not a multiple of the SIMD width so the tails run as well */
+	TestMesh Mesh = MakeGridMesh(12, 9);
+	CheckPathsBitIdentical(Mesh, 12);
+}
+
+TEST_CASE(TangentGeneratorPathsBitIdenticalUnwelded)
+{
+	TestMesh Mesh = MakeGridMesh(12, 9);
+	TestMesh Unwelded;
+	Unweld(Mesh, Unwelded);
+
+	CheckPathsBitIdentical(Unwelded, 12);
+}
+
+TEST_CASE(TangentGeneratorUnweldedMatchesWelded)
+{
+	TestMesh Mesh = MakeGridMesh(12, 9);
+	TestMesh Unwelded;
+	Unweld(Mesh, Unwelded);
+
+	TangentStaging Welded = MakeTangentStaging(Mesh, 12);
+	GenerateTangents(Mesh.Indices, Welded, TANGENT_PATH_SCALAR);
+
+	TangentStaging Split = MakeTangentStaging(Unwelded, 12);
+	GenerateTangents(Unwelded.Indices, Split, TANGENT_PATH_SCALAR);
+
+	/** Corners with the same position, normal and UV are smoothed together whether or not they share a vertex */
+	for (size_t i = 0; i < Unwelded.Indices.size(); i++)
+	{
+		uint32_t Source = Mesh.Indices[i];
+		CHECK(std::abs(Split.TangentX[i] - Welded.TangentX[Source]) < 1e-4f);
+		CHECK(std::abs(Split.TangentY[i] - Welded.TangentY[Source]) < 1e-4f);
+		CHECK(std::abs(Split.TangentZ[i] - Welded.TangentZ[Source]) < 1e-4f);
+	}
+}
@@ -0,0 +1,118 @@
+#include "TestFramework.hpp"
+
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+struct TestEntry
+{
+	const char * pName;
+	TestFunction Function;
+};
+
+/** Function local so that registrars in other translation units can run first */
+static std::vector<TestEntry> & GetTests()
+{
+	static std::vector<TestEntry> Tests;
+	return Tests;
+}
+
+static bool s_bCurrentTestFailed = false;
+
+TestRegistrar::TestRegistrar(
+	const char * pName,
+	TestFunction Function
+)
+{
+	GetTests().push_back({ pName, Function });
+}
+
+void ReportFailure(
+	const char * pFile,
+	int Line,
+	const std::string & Message
+)
+{
+	s_bCurrentTestFailed = true;
+	std::cout << "  " << pFile << "(" << Line << "): " << Message << std::endl;
+}
+
+std::string GetTestDirectory(
+	const std::string & Name
+)
+{
+	std::filesystem::path Directory = std::filesystem::temp_directory_path() / "VkRendererTests" / Name;
+
+	std::filesystem::remove_all(Directory);
+	std::filesystem::create_directories(Directory);
+
+	return Directory.generic_string();
+}
+
+std::string WriteTestFile(
+	const std::string & Directory,
+	const std::string & Filename,
+	const std::string & Content
+)
+{
+	std::string Path = Directory + "/" + Filename;
+
+	std::ofstream File(Path, std::ios::binary);
+	File.write(Content.data(), Content.size());
+
+	if (!File)
+	{
+		throw std::runtime_error("Failed to write test file!");
+	}
+
+	return Path;
+}
+
+bool RunTests(
+	const std::string & Filter
+)
+{
+	uint32_t RunCount = 0;
+	uint32_t FailedCount = 0;
+
+	for (const TestEntry & Test : GetTests())
+	{
+		if (std::string(Test.pName).find(Filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		std::cout << "[" << Test.pName << "]" << std::endl;
+		s_bCurrentTestFailed = false;
+
+		try
+		{
+			Test.Function();
+		}
+		catch (const TestAbort &)
+		{
+		}
+		catch (const std::exception & Ex)
+		{
+			ReportFailure(__FILE__, __LINE__, std::string("Unexpected exception : ") + Ex.what());
+		}
+
+		RunCount++;
+		if (s_bCurrentTestFailed)
+		{
+			FailedCount++;
+			std::cout << "[" << Test.pName << "] FAILED" << std::endl;
+		}
+	}
+
+	std::cout << RunCount - FailedCount << " of " << RunCount << " tests passed" << std::endl;
+	return FailedCount == 0;
+}
+
+NAMESPACE_END
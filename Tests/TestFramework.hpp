@@ -0,0 +1,66 @@
+#pragma once
+
+#include <exception>
+#include <string>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+using TestFunction = void(*)();
+
+/** Adds a test to the list RunTests works through, used by TEST_CASE. */
+class TestRegistrar
+{
+public:
+	TestRegistrar(
+		const char * pName,
+		TestFunction Function
+	);
+};
+
+/** Thrown by REQUIRE to abort the running test after a failed check. */
+struct TestAbort
+{
+};
+
+/** Marks the running test as failed and prints where. */
+void ReportFailure(
+	const char * pFile,
+	int Line,
+	const std::string & Message
+);
+
+/** An empty directory under the system temp directory for the files a test writes, cleared on every call. */
+std::string GetTestDirectory(
+	const std::string & Name
+);
+
+/** Writes Content to Directory/Filename and returns the full path. */
+std::string WriteTestFile(
+	const std::string & Directory,
+	const std::string & Filename,
+	const std::string & Content
+);
+
+/** Runs every test whose name contains Filter, returns false if any of them failed. */
+bool RunTests(
+	const std::string & Filter
+);
+
+NAMESPACE_END
+
+#define TEST_CASE(Name) \
+	static void Name(); \
+	static GLOBAL_NAMESPACE::TestRegistrar Name##Registrar(#Name, &Name); \
+	static void Name()
+
+#define CHECK(Expr) \
+	do { if (!(Expr)) { GLOBAL_NAMESPACE::ReportFailure(__FILE__, __LINE__, #Expr); } } while (0)
+
+#define REQUIRE(Expr) \
+	do { if (!(Expr)) { GLOBAL_NAMESPACE::ReportFailure(__FILE__, __LINE__, #Expr); throw GLOBAL_NAMESPACE::TestAbort(); } } while (0)
+
+#define CHECK_THROWS(Expr) \
+	do { bool bThrown = false; try { Expr; } catch (const std::exception &) { bThrown = true; } \
+	if (!bThrown) { GLOBAL_NAMESPACE::ReportFailure(__FILE__, __LINE__, #Expr " did not throw"); } } while (0)
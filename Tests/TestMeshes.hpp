@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** A flat grid in the XY plane, tightly packed xyz positions. */
+struct TestMesh
+{
+	std::vector<float> Positions;
+	std::vector<uint32_t> Indices;
+
+	size_t VertexCount() const
+	{
+		return Positions.size() / 3;
+	}
+};
+
+/** QuadsX * QuadsY quads of size one, two counter clockwise triangles each, emitted row by row. */
+inline TestMesh MakeGridMesh(
+	uint32_t QuadsX,
+	uint32_t QuadsY
+)
+{
+	TestMesh Mesh;
+
+	for (uint32_t y = 0; y <= QuadsY; y++)
+	{
+		for (uint32_t x = 0; x <= QuadsX; x++)
+		{
+			Mesh.Positions.push_back(static_cast<float>(x));
+			Mesh.Positions.push_back(static_cast<float>(y));
+			Mesh.Positions.push_back(0.0f);
+		}
+	}
+
+	for (uint32_t y = 0; y < QuadsY; y++)
+	{
+		for (uint32_t x = 0; x < QuadsX; x++)
+		{
+			uint32_t V0 = y * (QuadsX + 1) + x;
+			uint32_t V1 = V0 + 1;
+			uint32_t V2 = V0 + QuadsX + 1;
+			uint32_t V3 = V2 + 1;
+
+			Mesh.Indices.insert(Mesh.Indices.end(), { V0, V1, V3, V0, V3, V2 });
+		}
+	}
+
+	return Mesh;
+}
+
+using TestTriangle = std::array<uint32_t, 3>;
+
+/**
+* The triangles as a sorted multiset, each one rotated so its smallest index comes first.
+* Rotating keeps the winding, so a flipped triangle still compares different.
+*/
+inline std::vector<TestTriangle> GetTriangleSet(
+	const std::vector<uint32_t> & Indices
+)
+{
+	std::vector<TestTriangle> Triangles;
+
+	for (size_t i = 0; i + 2 < Indices.size(); i += 3)
+	{
+		TestTriangle Triangle = { Indices[i], Indices[i + 1], Indices[i + 2] };
+		std::rotate(Triangle.begin(), std::min_element(Triangle.begin(), Triangle.end()), Triangle.end());
+		Triangles.push_back(Triangle);
+	}
+
+	std::sort(Triangles.begin(), Triangles.end());
+	return Triangles;
+}
+
+NAMESPACE_END
@@ -0,0 +1,190 @@
+#include "TestFramework.hpp"
+#include "TextureStreamingPlanner.hpp"
+
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+/**
+* A square texture of Size texels with one byte per texel and a tail of 16 texels. Every level is
+* rounded up to 4 KB like a device would pad small levels, so the chain is larger than the texels.
+*/
+static TextureStreamingState MakeTexture(
+	uint32_t Size,
+	uint32_t ResidentLevel,
+	uint64_t LastDrawnFrame
+)
+{
+	TextureStreamingState Texture;
+
+	while ((Size >> Texture.TailLevel) > 16)
+	{
+		Texture.TailLevel++;
+	}
+
+	uint32_t MipLevels = 0;
+	while (Size >> MipLevels)
+	{
+		MipLevels++;
+	}
+
+	for (uint32_t Level = 0; Level <= Texture.TailLevel; Level++)
+	{
+		VkDeviceSize Bytes = 0;
+		for (uint32_t i = Level; i < MipLevels; i++)
+		{
+			VkDeviceSize Side = Size >> i;
+			Bytes += (Side * Side + 4095) / 4096 * 4096;
+		}
+		Texture.ChainBytes.push_back(Bytes);
+	}
+
+	Texture.ResidentLevel = ResidentLevel;
+	Texture.WantedLevel = Texture.TailLevel;
+	Texture.LastDrawnFrame = LastDrawnFrame;
+	return Texture;
+}
+
+/** The uploads of every request land, as Update would see them a few frames later. */
+static void CompleteRequests(
+	std::vector<TextureStreamingState> & Textures
+)
+{
+	for (TextureStreamingState & Texture : Textures)
+	{
+		if (Texture.PendingLevel != UINT32_MAX)
+		{
+			Texture.ResidentLevel = Texture.PendingLevel;
+			Texture.PendingLevel = UINT32_MAX;
+		}
+	}
+}
+
+static VkDeviceSize GetResidentBytes(
+	const std::vector<TextureStreamingState> & Textures
+)
+{
+	VkDeviceSize Bytes = 0;
+	for (const TextureStreamingState & Texture : Textures)
+	{
+		Bytes += Texture.ChainBytes[Texture.ResidentLevel];
+	}
+	return Bytes;
+}
+
+TEST_CASE(TextureStreamingPlannerStaysWithinBudget)
+{
+	std::vector<TextureStreamingState> Textures;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		Textures.push_back(MakeTexture(1024 >> (i % 3), 0, 0));
+		Textures.back().ResidentLevel = Textures.back().TailLevel;
+	}
+
+	/** Room for about two full chains, every texture asks for its finest level */
+	const VkDeviceSize BudgetBytes = Textures[0].ChainBytes[0] * 2 + Textures[1].ChainBytes[0] / 2;
+
+	for (uint64_t Frame = 1; Frame <= 16; Frame++)
+	{
+		for (TextureStreamingState & Texture : Textures)
+		{
+			Texture.WantedLevel = 0;
+			Texture.LastDrawnFrame = Frame;
+		}
+
+		std::vector<TextureStreamingRequest> Requests;
+		ScheduleTextureRequests(Textures, BudgetBytes, 4, Requests);
+
+		CHECK(GetPlannedTextureBytes(Textures) <= BudgetBytes);
+		CHECK(Requests.size() <= 4);
+
+		for (const TextureStreamingRequest & Request : Requests)
+		{
+			CHECK(Textures[Request.TextureIndex].PendingLevel == Request.Level);
+		}
+
+		CompleteRequests(Textures);
+		CHECK(GetResidentBytes(Textures) <= BudgetBytes);
+	}
+
+	/** The budget was used, not just respected */
+	CHECK(GetResidentBytes(Textures) > BudgetBytes / 2);
+}
+
+TEST_CASE(TextureStreamingPlannerShrinksToLoweredBudget)
+{
+	std::vector<TextureStreamingState> Textures;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		Textures.push_back(MakeTexture(512, 0, 1));
+		Textures.back().WantedLevel = 0;
+	}
+
+	/** All of them are drawn and want everything, but the budget only fits a fraction */
+	const VkDeviceSize BudgetBytes = Textures[0].ChainBytes[0] * 3 / 2;
+
+	std::vector<TextureStreamingRequest> Requests;
+	ScheduleTextureRequests(Textures, BudgetBytes, 4, Requests);
+
+	CHECK(GetPlannedTextureBytes(Textures) <= BudgetBytes);
+	CHECK(!Requests.empty());
+
+	/** One level at a time, nothing is streamed in while evicting */
+	for (const TextureStreamingRequest & Request : Requests)
+	{
+		CHECK(Request.Level == 1);
+	}
+
+	CompleteRequests(Textures);
+	CHECK(GetResidentBytes(Textures) <= BudgetBytes);
+}
+
+TEST_CASE(TextureStreamingPlannerEvictsLeastRecentlyDrawnFirst)
+{
+	/** Fully resident and no longer drawn, last drawn in frames 7, 2, 9 and 4 */
+	std::vector<TextureStreamingState> Textures;
+	Textures.push_back(MakeTexture(256, 0, 7));
+	Textures.push_back(MakeTexture(256, 0, 2));
+	Textures.push_back(MakeTexture(256, 0, 9));
+	Textures.push_back(MakeTexture(256, 0, 4));
+
+	const TextureStreamingState & Texture = Textures[0];
+	const VkDeviceSize FullBytes = Texture.ChainBytes[0];
+	const VkDeviceSize TailBytes = Texture.ChainBytes[Texture.TailLevel];
+
+	/** Fits two full chains and two tails, so exactly the two oldest go */
+	std::vector<TextureStreamingRequest> Requests;
+	ScheduleTextureRequests(Textures, FullBytes * 2 + TailBytes * 2, 4, Requests);
+
+	REQUIRE(Requests.size() == 2);
+	CHECK(Requests[0].TextureIndex == 1 && Requests[0].Level == Texture.TailLevel);
+	CHECK(Requests[1].TextureIndex == 3 && Requests[1].Level == Texture.TailLevel);
+	CHECK(Textures[0].PendingLevel == UINT32_MAX);
+	CHECK(Textures[2].PendingLevel == UINT32_MAX);
+
+	/** Within budget nothing is evicted, however long ago it was drawn */
+	CompleteRequests(Textures);
+	Requests.clear();
+	ScheduleTextureRequests(Textures, FullBytes * 2 + TailBytes * 2, 4, Requests);
+
+	CHECK(Requests.empty());
+}
+
+TEST_CASE(TextureStreamingPlannerPlansWithDeviceSizes)
+{
+	/** Every level is padded to 4 KB, the first level adds 1 KB of texels but 4 KB to the plan */
+	std::vector<TextureStreamingState> Textures;
+	Textures.push_back(MakeTexture(32, 1, 0));
+	Textures[0].WantedLevel = 0;
+
+	REQUIRE(Textures[0].ChainBytes[0] == 5 * 4096 + 4096 && Textures[0].ChainBytes[1] == 5 * 4096);
+
+	/** The 1 KB would fit in the 2 KB left, the 4 KB the device needs would not */
+	std::vector<TextureStreamingRequest> Requests;
+	ScheduleTextureRequests(Textures, 5 * 4096 + 2048, 4, Requests);
+	CHECK(Requests.empty());
+
+	ScheduleTextureRequests(Textures, 6 * 4096, 4, Requests);
+	REQUIRE(Requests.size() == 1);
+	CHECK(Requests[0].Level == 0);
+}
@@ -0,0 +1,282 @@
+#include "TestFramework.hpp"
+#include "VertexFormat.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+namespace
+{
+
+struct TestVertex
+{
+	glm::vec3 Position;
+	glm::vec3 Color;
+	glm::vec3 Normal;
+	glm::vec3 Tangent;
+	glm::vec2 TexCoord;
+};
+
+/**
+* Bounds on MeasureVertexQuantizationError for each option, the tests fail if a format change loses
+* more precision than this:
+* - unorm16 positions / texture coordinates round to the nearest of 65535 steps over the mesh bounds,
+*   at most half a step per axis, so length(Scale) / 65535 / 2.
+* - Octahedral snorm16 picks the best of the four neighbouring codes, about 0.005 degrees at worst.
+* - 10_10_10_2 rounds each component to one of 1023 steps over [-1, 1], half a step is 1 / 1023
+*   per component, which tilts the direction by up to sqrt(3) / 1023 radians, about 0.1 degrees.
+* - Half floats have an 11 bit mantissa, texture coordinates in [0, 1) are off by 2^-12 per axis at most.
+* The float32 options are lossless.
+*/
+const float s_OctSnorm16MaxAngle = 0.01f;
+const float s_Unorm10MaxAngle = 0.1f;
+const float s_HalfMaxTexCoordError = std::sqrt(2.0f) * std::ldexp(1.0f, -12);
+
+/** Slack for the float math in the dequantization itself */
+const float s_FloatTolerance = 1e-5f;
+
+/** Random directions plus the axes and the octahedron seams, where the octahedral encoding folds */
+std::vector<TestVertex> MakeTestVertices()
+{
+	std::vector<glm::vec3> Directions =
+	{
+		{ 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+		{ 1.0f, 1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f },
+		{ 1.0f, -1.0f, -1.0f }, { -1.0f, -1.0f, -1.0f }
+	};
+
+	std::mt19937 Random(1234);
+	std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+
+	while (Directions.size() < 4096)
+	{
+		glm::vec3 Direction(Unit(Random), Unit(Random), Unit(Random));
+		float Length = glm::length(Direction);
+
+		if (Length > 0.1f && Length <= 1.0f)
+		{
+			Directions.push_back(Direction);
+		}
+	}
+
+	std::vector<TestVertex> Vertices;
+
+	for (const glm::vec3 & Direction : Directions)
+	{
+		TestVertex Vertex;
+		Vertex.Position = glm::vec3(4.0f, 1.0f, 0.5f) * glm::vec3(Unit(Random), Unit(Random), Unit(Random)) + glm::vec3(1.0f, 1.0f, 0.0f);
+		Vertex.Color = glm::vec3(1.0f);
+		Vertex.Normal = glm::normalize(Direction);
+
+		glm::vec3 Axis = std::abs(Vertex.Normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		Vertex.Tangent = glm::normalize(glm::cross(Vertex.Normal, Axis));
+
+		Vertex.TexCoord = glm::vec2(Unit(Random), Unit(Random)) * 0.5f + 0.5f;
+		Vertex.TexCoord = glm::min(Vertex.TexCoord, glm::vec2(0.999f));
+		Vertices.push_back(Vertex);
+	}
+
+	return Vertices;
+}
+
+/** Packs the vertices in both layouts, the decoded values must not depend on the layout. */
+std::vector<VertexQuantizationError> MeasureFormat(
+	VertexFormat Format,
+	const std::vector<TestVertex> & Vertices,
+	VertexDequantization & Dequantization
+)
+{
+	std::vector<VertexQuantizationError> Errors;
+
+	for (VertexLayout Layout : { VERTEX_LAYOUT_INTERLEAVED, VERTEX_LAYOUT_SPLIT_POSITIONS })
+	{
+		Format.Layout = Layout;
+
+		std::vector<std::vector<uint8_t>> Streams;
+		Dequantization = PackVertices(Format, Vertices, Streams);
+
+		REQUIRE(Streams.size() == GetVertexStreamCount(Format));
+		Errors.push_back(MeasureVertexQuantizationError(Format, Dequantization, Vertices, Streams));
+	}
+
+	return Errors;
+}
+
+VertexFormat MakeFloatFormat()
+{
+	VertexFormat Format;
+	Format.Position = VERTEX_POSITION_FLOAT32;
+	Format.Direction = VERTEX_DIRECTION_FLOAT32;
+	Format.TexCoord = VERTEX_TEXCOORD_FLOAT32;
+	return Format;
+}
+
+}
+
+TEST_CASE(VertexFormatFloat32IsLossless)
+{
+	std::vector<TestVertex> Vertices = MakeTestVertices();
+	VertexDequantization Dequantization;
+
+	for (const VertexQuantizationError & Error : MeasureFormat(MakeFloatFormat(), Vertices, Dequantization))
+	{
+		CHECK(Error.Position == 0.0f);
+		CHECK(Error.NormalAngle == 0.0f);
+		CHECK(Error.TangentAngle == 0.0f);
+		CHECK(Error.TexCoord == 0.0f);
+	}
+}
+
+TEST_CASE(VertexFormatQuantizedPositionsWithinHalfStep)
+{
+	std::vector<TestVertex> Vertices = MakeTestVertices();
+	VertexDequantization Dequantization;
+
+	VertexFormat Format = MakeFloatFormat();
+	Format.Position = VERTEX_POSITION_UNORM16;
+
+	for (const VertexQuantizationError & Error : MeasureFormat(Format, Vertices, Dequantization))
+	{
+		float MaxError = glm::length(Dequantization.PositionScale) / 65535.0f * 0.5f;
+		CHECK(Error.Position > 0.0f);
+		CHECK(Error.Position <= MaxError + s_FloatTolerance);
+		CHECK(Error.NormalAngle == 0.0f);
+		CHECK(Error.TexCoord == 0.0f);
+	}
+}
+
+TEST_CASE(VertexFormatOctahedralDirectionsWithinBound)
+{
+	std::vector<TestVertex> Vertices = MakeTestVertices();
+	VertexDequantization Dequantization;
+
+	VertexFormat Format = MakeFloatFormat();
+	Format.Direction = VERTEX_DIRECTION_OCT_SNORM16;
+
+	for (const VertexQuantizationError & Error : MeasureFormat(Format, Vertices, Dequantization))
+	{
+		CHECK(Error.NormalAngle <= s_OctSnorm16MaxAngle);
+		CHECK(Error.TangentAngle <= s_OctSnorm16MaxAngle);
+		CHECK(Error.Position == 0.0f);
+	}
+}
+
+TEST_CASE(VertexFormatUnorm10DirectionsWithinBound)
+{
+	std::vector<TestVertex> Vertices = MakeTestVertices();
+	VertexDequantization Dequantization;
+
+	VertexFormat Format = MakeFloatFormat();
+	Format.Direction = VERTEX_DIRECTION_UNORM10;
+
+	for (const VertexQuantizationError & Error : MeasureFormat(Format, Vertices, Dequantization))
+	{
+		CHECK(Error.NormalAngle <= s_Unorm10MaxAngle);
+		CHECK(Error.TangentAngle <= s_Unorm10MaxAngle);
+		/** Octahedral spends its 32 bits better, 10_10_10_2 should never beat it */
+		CHECK(Error.NormalAngle > s_OctSnorm16MaxAngle);
+	}
+}
+
+TEST_CASE(VertexFormatHalfTexCoordsWithinBound)
+{
+	std::vector<TestVertex> Vertices = MakeTestVertices();
+	VertexDequantization Dequantization;
+
+	VertexFormat Format = MakeFloatFormat();
+	Format.TexCoord = VERTEX_TEXCOORD_HALF;
+
+	for (const VertexQuantizationError & Error : MeasureFormat(Format, Vertices, Dequantization))
+	{
+		CHECK(Error.TexCoord > 0.0f);
+		CHECK(Error.TexCoord <= s_HalfMaxTexCoordError);
+		CHECK(Error.Position == 0.0f);
+	}
+}
+
+TEST_CASE(VertexFormatUnorm16TexCoordsWithinHalfStep)
+{
+	std::vector<TestVertex> Vertices = MakeTestVertices();
+	VertexDequantization Dequantization;
+
+	VertexFormat Format = MakeFloatFormat();
+	Format.TexCoord = VERTEX_TEXCOORD_UNORM16;
+
+	for (const VertexQuantizationError & Error : MeasureFormat(Format, Vertices, Dequantization))
+	{
+		float MaxError = glm::length(Dequantization.TexCoordScale) / 65535.0f * 0.5f;
+		CHECK(Error.TexCoord > 0.0f);
+		CHECK(Error.TexCoord <= MaxError + s_FloatTolerance);
+	}
+}
+
+TEST_CASE(VertexFormatDefaultWithinBounds)
+{
+	std::vector<TestVertex> Vertices = MakeTestVertices();
+	VertexDequantization Dequantization;
+
+	/** Everything quantized at once, the errors of the attributes must not add up */
+	for (const VertexQuantizationError & Error : MeasureFormat(VertexFormat(), Vertices, Dequantization))
+	{
+		CHECK(Error.Position <= glm::length(Dequantization.PositionScale) / 65535.0f * 0.5f + s_FloatTolerance);
+		CHECK(Error.NormalAngle <= s_OctSnorm16MaxAngle);
+		CHECK(Error.TangentAngle <= s_OctSnorm16MaxAngle);
+		CHECK(Error.TexCoord <= s_HalfMaxTexCoordError);
+	}
+}
+
+TEST_CASE(VertexFormatRangesQuantizeToTheirOwnBounds)
+{
+	/** Two copies of the test mesh far apart, like two meshes of one scene */
+	std::vector<TestVertex> Vertices = MakeTestVertices();
+	const size_t MeshVertexCount = Vertices.size();
+
+	for (size_t i = 0; i < MeshVertexCount; i++)
+	{
+		TestVertex Vertex = Vertices[i];
+		Vertex.Position += glm::vec3(1000.0f, 0.0f, 0.0f);
+		Vertices.push_back(Vertex);
+	}
+
+	std::vector<VertexRange> Ranges = { { 0, MeshVertexCount }, { MeshVertexCount, MeshVertexCount } };
+
+	std::vector<std::vector<uint8_t>> Streams;
+	std::vector<VertexDequantization> Dequantizations = PackVertices(VertexFormat(), Vertices, Ranges, Streams);
+	REQUIRE(Dequantizations.size() == 2);
+
+	/** Each range only pays for its own extent, not for the distance between them */
+	for (size_t r = 0; r < Ranges.size(); r++)
+	{
+		const VertexDequantization & Dequantization = Dequantizations[r];
+		CHECK(glm::length(Dequantization.PositionScale) < 10.0f);
+
+		VertexQuantizationError Error = MeasureVertexQuantizationError(VertexFormat(), { Dequantization }, { Ranges[r] }, Vertices, Streams);
+		/** Floats around 1000 are only accurate to about 1e-4 */
+		CHECK(Error.Position <= glm::length(Dequantization.PositionScale) / 65535.0f * 0.5f + 1e-3f);
+	}
+
+	std::vector<std::vector<uint8_t>> WholeStreams;
+	VertexDequantization Whole = PackVertices(VertexFormat(), Vertices, WholeStreams);
+
+	VertexQuantizationError RangeError = MeasureVertexQuantizationError(VertexFormat(), Dequantizations, Ranges, Vertices, Streams);
+	VertexQuantizationError WholeError = MeasureVertexQuantizationError(VertexFormat(), Whole, Vertices, WholeStreams);
+	CHECK(RangeError.Position * 50.0f < WholeError.Position);
+}
+
+TEST_CASE(VertexFormatSplitLayoutPutsPositionsAlone)
+{
+	VertexFormat Format;
+	Format.Layout = VERTEX_LAYOUT_SPLIT_POSITIONS;
+
+	REQUIRE(GetVertexStreamCount(Format) == 2);
+	CHECK(GetVertexStreamStride(Format, 0) == sizeof(uint16_t) * 4);
+	CHECK(GetVertexStreamStride(Format, 0) + GetVertexStreamStride(Format, 1) == GetVertexStride(Format));
+
+	Format.Layout = VERTEX_LAYOUT_INTERLEAVED;
+	CHECK(GetVertexStreamCount(Format) == 1);
+	CHECK(GetVertexStreamStride(Format, 0) == GetVertexStride(Format));
+}
@@ -0,0 +1,185 @@
+#include "TestFramework.hpp"
+#include "TestMeshes.hpp"
+#include "VertexWelder.hpp"
+#include "ThreadPool.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace GLOBAL_NAMESPACE;
+
+/** Position and UV, every float of it is compared by the welder. */
+struct WeldVertex
+{
+	float Position[3];
+	float TexCoord[2];
+};
+
+/** Every corner of the grid as its own vertex, the UV follows the position so equal corners are equal vertices. */
+static std::vector<WeldVertex> MakeUnweldedGrid(
+	uint32_t Quads,
+	std::vector<uint32_t> & Sources
+)
+{
+	TestMesh Mesh = MakeGridMesh(Quads, Quads);
+	std::vector<WeldVertex> Vertices;
+	Sources = Mesh.Indices;
+
+	for (uint32_t Index : Mesh.Indices)
+	{
+		WeldVertex Vertex;
+		Vertex.Position[0] = Mesh.Positions[Index * 3];
+		Vertex.Position[1] = Mesh.Positions[Index * 3 + 1];
+		Vertex.Position[2] = Mesh.Positions[Index * 3 + 2];
+		Vertex.TexCoord[0] = Vertex.Position[0] / Quads;
+		Vertex.TexCoord[1] = Vertex.Position[1] / Quads;
+		Vertices.push_back(Vertex);
+	}
+
+	return Vertices;
+}
+
+/** Corners of the same grid vertex share a new index, others do not, and new indices follow first occurrence. */
+static void CheckGridRemap(
+	const std::vector<uint32_t> & Sources,
+	const std::vector<uint32_t> & Remap,
+	size_t VertexCount
+)
+{
+	std::vector<uint32_t> SourceToNew(Sources.size(), UINT32_MAX);
+	std::vector<uint32_t> NewToSource(VertexCount, UINT32_MAX);
+	uint32_t NextVertex = 0;
+
+	for (size_t i = 0; i < Sources.size(); i++)
+	{
+		REQUIRE(Remap[i] < VertexCount);
+
+		if (SourceToNew[Sources[i]] == UINT32_MAX)
+		{
+			CHECK(Remap[i] == NextVertex);
+			NextVertex++;
+
+			SourceToNew[Sources[i]] = Remap[i];
+			CHECK(NewToSource[Remap[i]] == UINT32_MAX);
+			NewToSource[Remap[i]] = Sources[i];
+		}
+
+		CHECK(Remap[i] == SourceToNew[Sources[i]]);
+	}
+
+	CHECK(NextVertex == VertexCount);
+}
+
+TEST_CASE(VertexWelderDuplicateRatio)
+{
+	std::vector<uint32_t> Sources;
+	std::vector<WeldVertex> Vertices = MakeUnweldedGrid(32, Sources);
+
+	std::vector<uint32_t> Remap;
+	VertexWeldStatistics Statistics;
+	size_t VertexCount = WeldVertices(Vertices.data(), sizeof(WeldVertex), Vertices.size(), Remap, 0.0f, nullptr, &Statistics);
+
+	/** Six corners per quad collapse to the 33 * 33 grid vertices */
+	CHECK(VertexCount == 33 * 33);
+	CHECK(Statistics.VerticesBefore == 32 * 32 * 6);
+	CHECK(Statistics.VerticesAfter == VertexCount);
+	CHECK(Statistics.Partitions == 1);
+	CHECK(std::abs(Statistics.GetDuplicateRatio() - (1.0f - 33.0f * 33.0f / (32.0f * 32.0f * 6.0f))) < 1e-6f);
+
+	CheckGridRemap(Sources, Remap, VertexCount);
+}
+
+TEST_CASE(VertexWelderComparesEveryAttribute)
+{
+	std::vector<WeldVertex> Vertices =
+	{
+		{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+		{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f } },
+		{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } }
+	};
+
+	std::vector<uint32_t> Remap;
+	CHECK(WeldVertices(Vertices.data(), sizeof(WeldVertex), Vertices.size(), Remap) == 2);
+	CHECK(Remap == std::vector<uint32_t>({ 0, 1, 0 }));
+}
+
+TEST_CASE(VertexWelderSnapsToEpsilon)
+{
+	std::vector<uint32_t> Sources;
+	std::vector<WeldVertex> Vertices = MakeUnweldedGrid(16, Sources);
+
+	/** Noise well inside a grid cell, the grid values sit at cell centres */
+	const float Epsilon = 1.0f / 1024.0f;
+	std::mt19937 Random(7);
+	std::uniform_real_distribution<float> Noise(-Epsilon * 0.25f, Epsilon * 0.25f);
+
+	for (WeldVertex & Vertex : Vertices)
+	{
+		for (float & Value : Vertex.Position)
+		{
+			Value += Noise(Random);
+		}
+	}
+
+	std::vector<uint32_t> Remap;
+	size_t Exact = WeldVertices(Vertices.data(), sizeof(WeldVertex), Vertices.size(), Remap);
+	CHECK(Exact > 17 * 17);
+
+	size_t Snapped = WeldVertices(Vertices.data(), sizeof(WeldVertex), Vertices.size(), Remap, Epsilon);
+	CHECK(Snapped == 17 * 17);
+	CheckGridRemap(Sources, Remap, Snapped);
+
+	/** Farther apart than the spacing never welds */
+	std::vector<WeldVertex> Apart =
+	{
+		{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+		{ { Epsilon * 1.5f, 0.0f, 0.0f }, { 0.0f, 0.0f } }
+	};
+	CHECK(WeldVertices(Apart.data(), sizeof(WeldVertex), Apart.size(), Remap, Epsilon) == 2);
+
+	/** Negative zero snaps to the same key as zero */
+	std::vector<WeldVertex> Zeros =
+	{
+		{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+		{ { -0.0f, -Epsilon * 0.25f, 0.0f }, { 0.0f, -0.0f } }
+	};
+	CHECK(WeldVertices(Zeros.data(), sizeof(WeldVertex), Zeros.size(), Remap, Epsilon) == 1);
+}
+
+TEST_CASE(VertexWelderPartitionedMatchesSingleThreaded)
+{
+	std::vector<uint32_t> Sources;
+	std::vector<WeldVertex> Vertices = MakeUnweldedGrid(128, Sources);
+	REQUIRE(Vertices.size() >= VERTEX_WELDER_MIN_PARALLEL_VERTICES);
+
+	std::vector<uint32_t> SingleRemap;
+	VertexWeldStatistics Single;
+	size_t SingleCount = WeldVertices(Vertices.data(), sizeof(WeldVertex), Vertices.size(), SingleRemap, 0.0f, nullptr, &Single);
+	CHECK(Single.Partitions == 1);
+
+	/** One partition per thread, a single thread takes the single-threaded path */
+	for (uint32_t ThreadCount : { 1, 3, 8 })
+	{
+		ThreadPool Pool;
+		Pool.Init(ThreadCount);
+
+		for (float Epsilon : { 0.0f, 1.0f / 1024.0f })
+		{
+			std::vector<uint32_t> SingleSnapped;
+			WeldVertices(Vertices.data(), sizeof(WeldVertex), Vertices.size(), SingleSnapped, Epsilon);
+
+			std::vector<uint32_t> Remap;
+			VertexWeldStatistics Partitioned;
+			size_t Count = WeldVertices(Vertices.data(), sizeof(WeldVertex), Vertices.size(), Remap, Epsilon, &Pool, &Partitioned);
+
+			CHECK(Partitioned.Partitions == ThreadCount);
+			CHECK(Count == SingleCount);
+			CHECK(Remap == SingleSnapped);
+		}
+
+		Pool.Destroy();
+	}
+
+	CheckGridRemap(Sources, SingleRemap, SingleCount);
+}
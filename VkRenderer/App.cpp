@@ -1,16 +1,17 @@
 #include "App.hpp"
+#include "TextureLoader.hpp"
+#include "AssetBaker.hpp"
+#include "MeshOptimizer.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
-
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-
 #include <set>
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <limits>
 #include <iostream>
@@ -28,6 +29,22 @@ void App::Run()
 	Destroy();
 }
 
+void App::RunHeadless(
+	const HeadlessSettings & Settings
+)
+{
+	m_bHeadless = true;
+	m_HeadlessSettings = Settings;
+	m_InitWidth = Settings.Width;
+	m_InitHeight = Settings.Height;
+	m_VertexFormat.Layout = Settings.Layout;
+	m_bDepthPrepassEnabled = Settings.bDepthPrepass;
+
+	InitVulkan();
+	HeadlessLoop();
+	Destroy();
+}
+
 /** App */void App::InitWindow()
 {
 	glfwInit();
@@ -46,6 +63,8 @@ void App::Run()
 
 /** App */void App::InitVulkan()
 {
+	m_ThreadPool.Init(0);
+
 	CreateInstance();
 
 	SetupDebugMessenger();
@@ -56,7 +75,16 @@ void App::Run()
 
 	CreateLogicalDevice();
 
-	CreateSwapChain();
+	CreatePipelineCache();
+
+	if (m_bHeadless)
+	{
+		CreateOffscreenTargets();
+	}
+	else
+	{
+		CreateSwapChain();
+	}
 
 	CreateSwapChainImageViews();
 
@@ -66,7 +94,7 @@ void App::Run()
 
 	CreateGraphicsPipeline();
 
-	CreateCommandPool();
+	CreateFrameContexts();
 
 	CreateColorResource();
 
@@ -74,27 +102,30 @@ void App::Run()
 
 	CreateFramebuffers();
 
-	LoadAndCreateTextures();
-
 	LoadObjModel();
 
+	/** After the model, the material table decides which textures are loaded */
+	LoadAndCreateTextures();
+
 	CreateVertexBuffer();
 
 	CreateIndexBuffer();
 
-	CreateMvpUniformBuffer();
-
-	CreateLightUniformBuffer();
+	BuildInstances();
 
-	CreateMaterialUniformBuffer();
+	CreateUniformRingBuffer();
 
 	CreateDescriptorPool();
 
 	CreateDescriptorSets();
 
-	CreateDrawingCommandBuffers();
-
 	CreateSyncObjects();
+
+	/** Every texture, mesh buffer and attachment transition recorded above goes out in one batch */
+	m_UploadContext.Flush();
+	std::cout << "Upload batches submitted: " << m_UploadContext.GetSubmitCount() << std::endl;
+
+	m_MemoryAllocator.PrintStatistics(std::cout);
 }
 
 /** App */void App::MainLoop()
@@ -119,21 +150,33 @@ void App::Run()
 		if (DeltaTime >= TitleUpdateTime)
 		{
 			m_FPS = static_cast<double>(Frame) / DeltaTime;
+			m_RecordMilliseconds = m_RecordMillisecondsSum / static_cast<double>(Frame);
+			m_RecordMillisecondsSum = 0.0;
 			PrevTime = CurrTime;
 			Frame = 0;
 
 			glm::vec3 Eye = m_Camera.GetCachedEye();
 
-			char Buffer[256];
+			const CullingStatistics & Culling = m_CullingStatistics;
+			float CulledPercent = Culling.TriangleCount > 0 ? 100.0f * Culling.CulledTriangleCount / Culling.TriangleCount : 0.0f;
+
+			TextureStreamingStatistics Streaming = m_TextureStreamer.GetStatistics();
+
+			char Buffer[320];
 			sprintf_s(
-				Buffer, "%s [%s] [Vertex : %d Facet : %d] [Eye : (%.2f, %.2f, %.2f)] [%s] Fps: %d", 
+				Buffer, "%s [%s] [Vertex : %d Facet : %d Drawn : %d Culled : %.0f%%] [Tex : %.0f / %.0f MB] [Eye : (%.2f, %.2f, %.2f)] [%s] Fps: %d Record: %.3f ms", 
 				m_Title.c_str(), 
 				m_GpuName.c_str(),
 				static_cast<int32_t>(m_VertexNum), 
 				static_cast<int32_t>(m_FacetNum),
+				static_cast<int32_t>(m_DrawnFacetNum),
+				CulledPercent,
+				Streaming.ResidentBytes / (1024.0 * 1024.0),
+				Streaming.BudgetBytes / (1024.0 * 1024.0),
 				Eye.x, Eye.y, Eye.z,
 				m_GraphicsPipelinesDescription[m_GraphicsPipelineDisplayMode | m_GraphicsPipelineCullMode],
-				static_cast<int32_t>(m_FPS)
+				static_cast<int32_t>(m_FPS),
+				m_RecordMilliseconds
 			);
 			glfwSetWindowTitle(m_pWindow, Buffer);
 		}
@@ -152,6 +195,8 @@ void App::Run()
 		std::numeric_limits<uint64_t>::max()
 	);
 
+	ReleaseRetiredSwapChains(m_CurrentFrame);
+
 	uint32_t ImageIndex;
 	VkResult Result = vkAcquireNextImageKHR(
 		m_Device, 
@@ -172,7 +217,18 @@ void App::Run()
 		std::runtime_error("Failed to acquire swap chain image!");
 	}
 
-	UpdateUniformBuffer(ImageIndex);
+	UpdateUniformBuffer(static_cast<uint32_t>(m_CurrentFrame));
+
+	/** The descriptors of this frame are rewritten here, its fence has signaled */
+	UpdateTextureStreaming(static_cast<uint32_t>(m_CurrentFrame));
+
+	auto RecordStartTime = std::chrono::high_resolution_clock::now();
+
+	RecordDrawingCommandBuffer(static_cast<uint32_t>(m_CurrentFrame), ImageIndex);
+
+	m_RecordMillisecondsSum += std::chrono::duration<double, std::chrono::milliseconds::period>(
+		std::chrono::high_resolution_clock::now() - RecordStartTime
+		).count();
 
 	VkSubmitInfo SubmitInfo = {};
 	SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -183,12 +239,19 @@ void App::Run()
 	SubmitInfo.pWaitSemaphores = WaitSemaphores;
 	SubmitInfo.pWaitDstStageMask = WaitStages;
 	SubmitInfo.commandBufferCount = 1;
-	SubmitInfo.pCommandBuffers = &m_DrawingCommandBuffers[ImageIndex];
+	SubmitInfo.pCommandBuffers = &m_FrameContexts[m_CurrentFrame].CommandBuffer;
 
 	VkSemaphore SignalSemaphores[] = { m_RenderFinishedSemaphores[m_CurrentFrame] };
 	SubmitInfo.signalSemaphoreCount = 1;
 	SubmitInfo.pSignalSemaphores = SignalSemaphores;
 
+	/** First frame after a recreation, usually done by now since recording overlapped the transitions */
+	if (m_SwapChainUploadTicket != 0)
+	{
+		m_UploadContext.Wait(m_SwapChainUploadTicket);
+		m_SwapChainUploadTicket = 0;
+	}
+
 	vkResetFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame]);
 
 	if (vkQueueSubmit(m_GraphicsQueue, 1, &SubmitInfo, m_InFlightFences[m_CurrentFrame]) != VK_SUCCESS)
@@ -223,6 +286,104 @@ void App::Run()
 	m_CurrentFrame = (m_CurrentFrame + 1) % m_MaxFramesInFlights;
 }
 
+/** App */void App::HeadlessLoop()
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t Frame = 0; Frame < m_HeadlessSettings.FrameCount; Frame++)
+	{
+		FrameContext & Context = m_FrameContexts[m_CurrentFrame];
+
+		vkWaitForFences(
+			m_Device, 
+			1, 
+			&m_InFlightFences[m_CurrentFrame], 
+			VK_TRUE, 
+			std::numeric_limits<uint64_t>::max()
+		);
+
+		/** The copy submitted the last time this context was used has landed by now */
+		ReadTimestamps(Context);
+		WriteReadback(Context);
+
+		UpdateUniformBuffer(static_cast<uint32_t>(m_CurrentFrame));
+
+		auto RecordStartTime = std::chrono::high_resolution_clock::now();
+
+		/** Each frame in flight renders into its own offscreen target */
+		RecordDrawingCommandBuffer(static_cast<uint32_t>(m_CurrentFrame), static_cast<uint32_t>(m_CurrentFrame));
+
+		m_RecordMillisecondsSum += std::chrono::duration<double, std::chrono::milliseconds::period>(
+			std::chrono::high_resolution_clock::now() - RecordStartTime
+			).count();
+
+		Context.ReadbackFrame = Frame;
+
+		VkSubmitInfo SubmitInfo = {};
+		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SubmitInfo.commandBufferCount = 1;
+		SubmitInfo.pCommandBuffers = &Context.CommandBuffer;
+
+		vkResetFences(m_Device, 1, &m_InFlightFences[m_CurrentFrame]);
+
+		if (vkQueueSubmit(m_GraphicsQueue, 1, &SubmitInfo, m_InFlightFences[m_CurrentFrame]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit draw command buffer!");
+		}
+
+		m_CurrentFrame = (m_CurrentFrame + 1) % m_MaxFramesInFlights;
+	}
+
+	/** Collect the frames still in flight, oldest first */
+	for (int i = 0; i < m_MaxFramesInFlights; i++)
+	{
+		vkWaitForFences(
+			m_Device, 
+			1, 
+			&m_InFlightFences[m_CurrentFrame], 
+			VK_TRUE, 
+			std::numeric_limits<uint64_t>::max()
+		);
+
+		ReadTimestamps(m_FrameContexts[m_CurrentFrame]);
+		WriteReadback(m_FrameContexts[m_CurrentFrame]);
+
+		m_CurrentFrame = (m_CurrentFrame + 1) % m_MaxFramesInFlights;
+	}
+
+	for (auto & FrameWrite : m_PendingFrameWrites)
+	{
+		FrameWrite.get();
+	}
+	m_PendingFrameWrites.clear();
+
+	double Milliseconds = std::chrono::duration<double, std::chrono::milliseconds::period>(
+		std::chrono::high_resolution_clock::now() - StartTime
+		).count();
+	uint32_t FrameCount = std::max(1u, m_HeadlessSettings.FrameCount);
+
+	std::cout << "Rendered " << m_HeadlessSettings.FrameCount << " frames of "
+		<< m_SwapChainInfo.SwapChainExtent.width << "x" << m_SwapChainInfo.SwapChainExtent.height
+		<< " on " << m_GpuName << " in " << Milliseconds << " ms ("
+		<< Milliseconds / FrameCount << " ms per frame, record "
+		<< m_RecordMillisecondsSum / FrameCount << " ms)" << std::endl;
+
+	/** Positions are all a depth prepass fetches, the color pass fetches every stream */
+	const uint32_t PositionBytes = GetVertexStreamStride(m_VertexFormat, 0);
+
+	std::cout << (m_VertexFormat.Layout == VERTEX_LAYOUT_SPLIT_POSITIONS ? "Split" : "Interleaved") << " vertex streams, "
+		<< (IsDepthPrepassUsed() ? "with" : "without") << " depth prepass: the depth pass fetches "
+		<< PositionBytes << " bytes per vertex, the color pass " << GetVertexStride(m_VertexFormat) << std::endl;
+
+	if (m_GpuTimedFrameCount > 0)
+	{
+		std::cout << "GPU time per frame: depth prepass " << m_DepthPassGpuMillisecondsSum / m_GpuTimedFrameCount
+			<< " ms, color pass " << m_ColorPassGpuMillisecondsSum / m_GpuTimedFrameCount << " ms" << std::endl;
+	}
+
+	vkDeviceWaitIdle(m_Device);
+}
+
 /** App */void App::Destroy()
 {
 	for (size_t i = 0; i < m_MaxFramesInFlights; i++)
@@ -238,35 +399,64 @@ void App::Run()
 
 	vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, nullptr);
 
-	for (size_t i = 0; i < m_SwapChainInfo.BufferCount(); i++)
+	m_UniformRingBuffer.Destroy(m_Device, m_MemoryAllocator);
+
+	DestroyBuffer(m_Device, m_MemoryAllocator, m_IndexBuffer);
+	DestroyBuffer(m_Device, m_MemoryAllocator, m_VertexBuffer);
+
+	/** Only the images it replaced, the streamed ones are destroyed with the rest below */
+	if (IsTextureStreamingUsed())
 	{
-		DestroyBuffer(m_Device, m_MaterialUniformBuffers[i]);
+		m_TextureStreamer.Destroy();
 	}
 
-	for (size_t i = 0; i < m_SwapChainInfo.BufferCount(); i++)
+	for (auto & SceneTexture : m_SceneTextures)
 	{
-		DestroyBuffer(m_Device, m_LightUniformBuffers[i]);
+		DestroyTexture(m_Device, m_MemoryAllocator, SceneTexture.second);
 	}
 
-	for (size_t i = 0; i < m_SwapChainInfo.BufferCount(); i++)
+	for (auto & SceneOrmTexture : m_SceneOrmTextures)
+	{
+		DestroyTexture(m_Device, m_MemoryAllocator, SceneOrmTexture.second);
+	}
+
+	DestroyTexture(m_Device, m_MemoryAllocator, m_OrmTexture);
+	DestroyTexture(m_Device, m_MemoryAllocator, m_NormalTexture);
+	DestroyTexture(m_Device, m_MemoryAllocator, m_AlbedoTexture);
+
+	for (auto & Context : m_FrameContexts)
 	{
-		DestroyBuffer(m_Device, m_MvpUniformBuffers[i]);
+		vkDestroyCommandPool(m_Device, Context.CommandPool, nullptr);
+
+		for (auto & SecondaryCommandPool : Context.SecondaryCommandPools)
+		{
+			vkDestroyCommandPool(m_Device, SecondaryCommandPool, nullptr);
+		}
+
+		if (m_bHeadless)
+		{
+			DestroyBuffer(m_Device, m_MemoryAllocator, Context.ReadbackBuffer);
+		}
+
+		if (Context.TimestampQueryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(m_Device, Context.TimestampQueryPool, nullptr);
+		}
 	}
 
-	DestroyBuffer(m_Device, m_IndexBuffer);
-	DestroyBuffer(m_Device, m_VertexBuffer);
+	m_PipelineCache.Save(std::cout);
+	m_PipelineCache.Destroy();
 
-	DestroyTexture(m_Device, m_AoTexture);
-	DestroyTexture(m_Device, m_RoughnessTexture);
-	DestroyTexture(m_Device, m_MetallicTexture);
-	DestroyTexture(m_Device, m_NormalTexture);
-	DestroyTexture(m_Device, m_AlbedoTexture);
+	m_UploadContext.Destroy();
 
-	vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+	m_MemoryAllocator.Destroy();
 	
 	vkDestroyDevice(m_Device, nullptr);
 	
-	vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
+	if (!m_bHeadless)
+	{
+		vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
+	}
 	
 	if (m_bEnableValidationLayers)
 	{
@@ -275,13 +465,17 @@ void App::Run()
 	
 	vkDestroyInstance(m_Instance, nullptr);
 
-	glfwDestroyWindow(m_pWindow);
+	if (!m_bHeadless)
+	{
+		glfwDestroyWindow(m_pWindow);
 	
-	glfwTerminate();
+		glfwTerminate();
+	}
+	m_ThreadPool.Destroy();
 }
 
 /** App Helper */void App::UpdateUniformBuffer(
-	uint32_t CurrentImage
+	uint32_t CurrentFrame
 )
 {
 	/** Update MVP matrix */
@@ -297,8 +491,6 @@ void App::Run()
 	m_Camera.RetriveData(Target, Eye, Up, Fov, NearZ, FarZ);
 
 	MvpUniformBufferObject Transformation = {};
-	Transformation.Model = glm::mat4(1.0f);
-	Transformation.ModelInvTranspose = glm::transpose(glm::inverse(Transformation.Model));
 	Transformation.View = glm::lookAt(Eye, Target, Up);
 	Transformation.Projection = glm::perspective(
 		Fov.y,
@@ -309,7 +501,11 @@ void App::Run()
 	/** GLM was originally designed for OpenGL, where the Y coordinate of the clip coordinates is inverted */
 	Transformation.Projection[1][1] *= -1.0f;
 
-	MapMemory(m_Device, m_MvpUniformBuffers[CurrentImage].Memory, sizeof(Transformation), &Transformation);
+	FrameUniforms Uniforms = AllocateFrameUniforms(CurrentFrame);
+	m_FrameContexts[CurrentFrame].DynamicOffsets = Uniforms.DynamicOffsets;
+
+	/** The ring buffer is persistently mapped, write straight into it */
+	*Uniforms.pMvp = Transformation;
 
 	/** Update light information */
 	LightUniformBufferObject Lighting = {};
@@ -331,7 +527,7 @@ void App::Run()
 	Lighting.LightColor[7] = glm::vec4(38.0f, 38.0f, 38.0f, 1.0f);
 	Lighting.ViewPosition = m_Camera.GetCachedEye();
 
-	MapMemory(m_Device, m_LightUniformBuffers[CurrentImage].Memory, sizeof(Lighting), &Lighting);
+	*Uniforms.pLight = Lighting;
 
 	/** Update material information */
 	MaterialUniformBufferObject Material = {};
@@ -340,7 +536,21 @@ void App::Run()
 	Material.Metallic = 1.0f;
 	Material.Roughness = 1.0f;
 
-	MapMemory(m_Device, m_MaterialUniformBuffers[CurrentImage].Memory, sizeof(Material), &Material);
+	*Uniforms.pMaterial = Material;
+}
+
+/** App Helper */App::FrameUniforms App::AllocateFrameUniforms(
+	uint32_t CurrentFrame
+)
+{
+	FrameUniforms Uniforms;
+
+	m_UniformRingBuffer.BeginRegion(CurrentFrame);
+	Uniforms.pMvp = m_UniformRingBuffer.Allocate<MvpUniformBufferObject>(Uniforms.DynamicOffsets[0]);
+	Uniforms.pLight = m_UniformRingBuffer.Allocate<LightUniformBufferObject>(Uniforms.DynamicOffsets[1]);
+	Uniforms.pMaterial = m_UniformRingBuffer.Allocate<MaterialUniformBufferObject>(Uniforms.DynamicOffsets[2]);
+
+	return Uniforms;
 }
 
 /** App Helper */void App::RecreateSwapChainAndRelevantObject()
@@ -352,17 +562,33 @@ void App::Run()
 		glfwWaitEvents();
 	}
 
-	vkDeviceWaitIdle(m_Device);
-
-	DestroySwapChainAndRelevantObject();
+	/** The frames in flight keep rendering to the old objects, they are destroyed once their fences signal */
+	RetireSwapChain();
 
+	/** The current swapchain is handed over as oldSwapchain */
 	CreateSwapChain();
 
 	CreateSwapChainImageViews();
 
-	CreateRenderPass();
+	/** Viewport and scissor are dynamic, so a new extent alone does not invalidate the pipelines */
+	if (m_SwapChainInfo.SwapChainImageFormat != m_GraphicsPipelinesFormat ||
+		m_SwapChainInfo.MsaaSamples != m_GraphicsPipelinesSamples)
+	{
+		/** Rare enough to not defer, the recorded command buffers reference the pipelines */
+		vkWaitForFences(
+			m_Device,
+			static_cast<uint32_t>(m_InFlightFences.size()),
+			m_InFlightFences.data(),
+			VK_TRUE,
+			std::numeric_limits<uint64_t>::max()
+		);
 
-	CreateGraphicsPipeline();
+		DestroyGraphicsPipelines();
+
+		CreateRenderPass();
+
+		CreateGraphicsPipeline();
+	}
 
 	CreateColorResource();
 
@@ -370,60 +596,142 @@ void App::Run()
 
 	CreateFramebuffers();
 
-	CreateDrawingCommandBuffers();
+	/** Only submitted here, the next frame waits for it right before rendering to the new attachments */
+	m_SwapChainUploadTicket = m_UploadContext.Submit();
 }
 
 /** App Helper */void App::DestroySwapChainAndRelevantObject()
 {
-	vkDestroyImageView(m_Device, m_SwapChainInfo.DepthImageView, nullptr);
-	vkDestroyImage(m_Device, m_SwapChainInfo.DepthImage, nullptr);
-	vkFreeMemory(m_Device, m_SwapChainInfo.DepthImageMemory, nullptr);
+	/** Only called once the device is idle */
+	for (auto & Retired : m_RetiredSwapChains)
+	{
+		DestroySwapChainResources(Retired.Info);
+		vkDestroySwapchainKHR(m_Device, Retired.Info.SwapChain, nullptr);
+	}
+
+	m_RetiredSwapChains.clear();
 
-	vkDestroyImageView(m_Device, m_SwapChainInfo.ColorImageView, nullptr);
-	vkDestroyImage(m_Device, m_SwapChainInfo.ColorImage, nullptr);
-	vkFreeMemory(m_Device, m_SwapChainInfo.ColorImageMemory, nullptr);
+	DestroySwapChainResources(m_SwapChainInfo);
 
-	for (auto & Framebuffer : m_SwapChainInfo.SwapChainFramebuffers)
+	DestroyGraphicsPipelines();
+
+	if (m_bHeadless)
 	{
-		vkDestroyFramebuffer(m_Device, Framebuffer, nullptr);
+		for (size_t i = 0; i < m_SwapChainInfo.BufferCount(); i++)
+		{
+			vkDestroyImage(m_Device, m_SwapChainInfo.SwapChainImages[i], nullptr);
+			m_MemoryAllocator.Free(m_OffscreenTargetAllocations[i]);
+		}
+
+		m_SwapChainInfo.SwapChainImages.clear();
+		m_OffscreenTargetAllocations.clear();
+		return;
 	}
 
-	for (auto & Kv : m_GraphicsPipelines)
+	vkDestroySwapchainKHR(m_Device, m_SwapChainInfo.SwapChain, nullptr);
+	m_SwapChainInfo.SwapChain = VK_NULL_HANDLE;
+}
+
+/** App Helper */void App::DestroySwapChainResources(
+	SwapChainInfo & Info
+)
+{
+	vkDestroyImageView(m_Device, Info.DepthImageView, nullptr);
+	vkDestroyImage(m_Device, Info.DepthImage, nullptr);
+	m_MemoryAllocator.Free(Info.DepthImageAllocation);
+
+	vkDestroyImageView(m_Device, Info.ColorImageView, nullptr);
+	vkDestroyImage(m_Device, Info.ColorImage, nullptr);
+	m_MemoryAllocator.Free(Info.ColorImageAllocation);
+
+	for (auto & Framebuffer : Info.SwapChainFramebuffers)
 	{
-		vkDestroyPipeline(m_Device, Kv.second, nullptr);
+		vkDestroyFramebuffer(m_Device, Framebuffer, nullptr);
 	}
 
-	vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+	for (auto & SwapChainImageView : Info.SwapChainImageViews)
+	{
+		vkDestroyImageView(m_Device, SwapChainImageView, nullptr);
+	}
+}
 
-	vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+/** App Helper */void App::RetireSwapChain()
+{
+	RetiredSwapChain Retired;
+	Retired.Info = m_SwapChainInfo;
+	Retired.PendingFrames.resize(m_InFlightFences.size());
 
-	for (auto & SwapChainImageView : m_SwapChainInfo.SwapChainImageViews)
+	for (size_t i = 0; i < m_InFlightFences.size(); i++)
 	{
-		vkDestroyImageView(m_Device, SwapChainImageView, nullptr);
+		/** A signaled fence means the last submission of that frame is done with the old objects */
+		Retired.PendingFrames[i] = vkGetFenceStatus(m_Device, m_InFlightFences[i]) == VK_NOT_READY;
 	}
 
-	vkDestroySwapchainKHR(m_Device, m_SwapChainInfo.SwapChain, nullptr);
+	/** The handle stays, it is passed as oldSwapchain and replaced by CreateSwapChain */
+	m_SwapChainInfo.SwapChainImages.clear();
+	m_SwapChainInfo.SwapChainImageViews.clear();
+	m_SwapChainInfo.SwapChainFramebuffers.clear();
+	m_SwapChainInfo.ColorImage = VK_NULL_HANDLE;
+	m_SwapChainInfo.ColorImageAllocation = MemoryAllocation();
+	m_SwapChainInfo.ColorImageView = VK_NULL_HANDLE;
+	m_SwapChainInfo.DepthImage = VK_NULL_HANDLE;
+	m_SwapChainInfo.DepthImageAllocation = MemoryAllocation();
+	m_SwapChainInfo.DepthImageView = VK_NULL_HANDLE;
 
-	vkFreeCommandBuffers(
-		m_Device, 
-		m_CommandPool, 
-		static_cast<uint32_t>(m_DrawingCommandBuffers.size()), 
-		m_DrawingCommandBuffers.data()
-	);
+	/** Even if nothing is in flight it is destroyed by the next frame, after the new swapchain took its place */
+	m_RetiredSwapChains.push_back(std::move(Retired));
 }
 
-void App::RecreateDrawingCommandBuffer()
+/** App Helper */void App::ReleaseRetiredSwapChains(
+	size_t Frame
+)
 {
-	vkQueueWaitIdle(m_GraphicsQueue);
+	for (size_t i = 0; i < m_RetiredSwapChains.size();)
+	{
+		RetiredSwapChain & Retired = m_RetiredSwapChains[i];
 
-	vkFreeCommandBuffers(
-		m_Device,
-		m_CommandPool,
-		static_cast<uint32_t>(m_DrawingCommandBuffers.size()),
-		m_DrawingCommandBuffers.data()
-	);
+		if (Frame < Retired.PendingFrames.size())
+		{
+			Retired.PendingFrames[Frame] = false;
+		}
+
+		if (std::find(Retired.PendingFrames.begin(), Retired.PendingFrames.end(), true) != Retired.PendingFrames.end())
+		{
+			i++;
+			continue;
+		}
+
+		DestroySwapChainResources(Retired.Info);
+		vkDestroySwapchainKHR(m_Device, Retired.Info.SwapChain, nullptr);
+
+		m_RetiredSwapChains.erase(m_RetiredSwapChains.begin() + i);
+	}
+}
+
+/** App Helper */void App::DestroyGraphicsPipelines()
+{
+	for (auto & Kv : m_GraphicsPipelines)
+	{
+		vkDestroyPipeline(m_Device, Kv.second, nullptr);
+	}
+
+	m_GraphicsPipelines.clear();
+
+	for (auto & Kv : m_DepthPipelines)
+	{
+		vkDestroyPipeline(m_Device, Kv.second, nullptr);
+	}
+
+	m_DepthPipelines.clear();
+
+	vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
 
-	CreateDrawingCommandBuffers();
+	vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+}
+
+/** App Helper */std::vector<const char *> App::GetDeviceExtensions() const
+{
+	return m_bHeadless ? std::vector<const char *>() : m_DeviceExtensions;
 }
 
 /** Vulkan Init */void App::CreateInstance()
@@ -445,7 +753,14 @@ void App::RecreateDrawingCommandBuffer()
 	CreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	CreateInfo.pApplicationInfo = &AppInfo;
 
-	auto Extensions = GetRequiredExtensions(m_bEnableValidationLayers);
+	auto Extensions = GetRequiredExtensions(m_bEnableValidationLayers, m_bHeadless);
+
+	/** VK_EXT_memory_budget is queried through vkGetPhysicalDeviceMemoryProperties2KHR */
+	m_bPhysicalDeviceProperties2Supported = CheckInstanceExtensionSupport(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+	if (m_bPhysicalDeviceProperties2Supported)
+	{
+		Extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+	}
 
 	CreateInfo.enabledExtensionCount = static_cast<uint32_t>(Extensions.size());
 	CreateInfo.ppEnabledExtensionNames = Extensions.data();
@@ -499,6 +814,12 @@ void App::RecreateDrawingCommandBuffer()
 
 /** Vulkan Init */void App::CreateSurface()
 {
+	/** Nothing is presented in headless mode */
+	if (m_bHeadless)
+	{
+		return;
+	}
+
 	if (glfwCreateWindowSurface(m_Instance, m_pWindow, nullptr, &m_Surface) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create window surface!");
@@ -521,7 +842,7 @@ void App::RecreateDrawingCommandBuffer()
 	VkDeviceSize MaxMemory = 0;
 	for (uint32_t i = 0; i < DeviceCount; i++)
 	{
-		if (IsPhysicalDeviceSuitable(PhysicalDevices[i], m_Surface, m_DeviceExtensions))
+		if (IsPhysicalDeviceSuitable(PhysicalDevices[i], m_Surface, GetDeviceExtensions()))
 		{
 			VkPhysicalDeviceProperties PhysicalDeviceProperties;
 			vkGetPhysicalDeviceProperties(PhysicalDevices[i], &PhysicalDeviceProperties);
@@ -569,6 +890,13 @@ void App::RecreateDrawingCommandBuffer()
 		Indices.PresentFamily.value() 
 	};
 
+	bool bDedicatedTransfer = m_bUseDedicatedTransferQueue && Indices.TransferFamily.has_value();
+
+	if (bDedicatedTransfer)
+	{
+		UniqueQueueFamilies.insert(Indices.TransferFamily.value());
+	}
+
 	for (uint32_t QueueFamily : UniqueQueueFamilies)
 	{
 		VkDeviceQueueCreateInfo QueueCreateInfo = {};
@@ -579,18 +907,33 @@ void App::RecreateDrawingCommandBuffer()
 		QueueCreateInfos.push_back(QueueCreateInfo);
 	}
 
+	VkPhysicalDeviceFeatures SupportedFeatures;
+	vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &SupportedFeatures);
+
+	m_bTextureCompressionSupported = SupportedFeatures.textureCompressionBC == VK_TRUE;
+
 	VkPhysicalDeviceFeatures DeviceFeatures = {};
 	DeviceFeatures.samplerAnisotropy = VK_TRUE;
 	DeviceFeatures.sampleRateShading = VK_TRUE;
 	DeviceFeatures.fillModeNonSolid = VK_TRUE;
+	DeviceFeatures.textureCompressionBC = SupportedFeatures.textureCompressionBC;
 
 	VkDeviceCreateInfo CreateInfo = {};
 	CreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	CreateInfo.pQueueCreateInfos = QueueCreateInfos.data();
 	CreateInfo.queueCreateInfoCount = static_cast<uint32_t>(QueueCreateInfos.size());
 	CreateInfo.pEnabledFeatures = &DeviceFeatures;
-	CreateInfo.ppEnabledExtensionNames = m_DeviceExtensions.data();
-	CreateInfo.enabledExtensionCount = static_cast<uint32_t>(m_DeviceExtensions.size());
+	std::vector<const char *> DeviceExtensions = GetDeviceExtensions();
+
+	m_bMemoryBudgetSupported = m_bPhysicalDeviceProperties2Supported &&
+		CheckPhysicalDeviceExtensionsSupport(m_PhysicalDevice, { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME });
+	if (m_bMemoryBudgetSupported)
+	{
+		DeviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
+	CreateInfo.ppEnabledExtensionNames = DeviceExtensions.data();
+	CreateInfo.enabledExtensionCount = static_cast<uint32_t>(DeviceExtensions.size());
 
 	if (m_bEnableValidationLayers)
 	{
@@ -609,6 +952,29 @@ void App::RecreateDrawingCommandBuffer()
 
 	vkGetDeviceQueue(m_Device, Indices.GraphicsFamily.value(), 0, &m_GraphicsQueue);
 	vkGetDeviceQueue(m_Device, Indices.PresentFamily.value(), 0, &m_PresentQueue);
+
+	if (bDedicatedTransfer)
+	{
+		vkGetDeviceQueue(m_Device, Indices.TransferFamily.value(), 0, &m_TransferQueue);
+	}
+
+	m_MemoryAllocator.Init(m_PhysicalDevice, m_Device);
+
+	m_UploadContext.Init(
+		m_PhysicalDevice,
+		m_Device,
+		m_MemoryAllocator,
+		Indices.GraphicsFamily.value(),
+		m_GraphicsQueue,
+		bDedicatedTransfer ? Indices.TransferFamily.value() : Indices.GraphicsFamily.value(),
+		m_TransferQueue,
+		m_UploadStagingSize
+	);
+}
+
+/** Vulkan Init */void App::CreatePipelineCache()
+{
+	m_PipelineCache.Init(m_PhysicalDevice, m_Device, m_PipelineCachePath, std::cout);
 }
 
 /** Vulkan Init */void App::CreateSwapChain()
@@ -659,7 +1025,9 @@ void App::RecreateDrawingCommandBuffer()
 	CreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	CreateInfo.presentMode = PresentMode;
 	CreateInfo.clipped = VK_TRUE;
-	CreateInfo.oldSwapchain = VK_NULL_HANDLE;
+	/** Lets the presentation engine keep showing the old images until the new ones are ready */
+	VkSwapchainKHR OldSwapChain = m_SwapChainInfo.SwapChain;
+	CreateInfo.oldSwapchain = OldSwapChain;
 
 	if (vkCreateSwapchainKHR(m_Device, &CreateInfo, nullptr, &m_SwapChainInfo.SwapChain) != VK_SUCCESS)
 	{
@@ -674,6 +1042,32 @@ void App::RecreateDrawingCommandBuffer()
 	m_SwapChainInfo.SwapChainExtent = Extent;
 }
 
+/** Vulkan Init */void App::CreateOffscreenTargets()
+{
+	m_SwapChainInfo.SwapChainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	m_SwapChainInfo.SwapChainExtent = { m_InitWidth, m_InitHeight };
+	m_SwapChainInfo.SwapChainImages.resize(m_MaxFramesInFlights);
+	m_OffscreenTargetAllocations.resize(m_MaxFramesInFlights);
+
+	for (size_t i = 0; i < m_SwapChainInfo.BufferCount(); i++)
+	{
+		CreateImage(
+			m_Device,
+			m_MemoryAllocator,
+			m_SwapChainInfo.SwapChainExtent.width,
+			m_SwapChainInfo.SwapChainExtent.height,
+			1,
+			VK_SAMPLE_COUNT_1_BIT,
+			m_SwapChainInfo.SwapChainImageFormat,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			m_SwapChainInfo.SwapChainImages[i],
+			m_OffscreenTargetAllocations[i]
+		);
+	}
+}
+
 /** Vulkan Init */void App::CreateSwapChainImageViews()
 {
 	m_SwapChainInfo.SwapChainImageViews.resize(m_SwapChainInfo.SwapChainImages.size());
@@ -720,7 +1114,8 @@ void App::RecreateDrawingCommandBuffer()
 	ColorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	ColorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	ColorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	ColorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	/** Offscreen targets are copied to the readback buffer right after the pass */
+	ColorAttachmentResolve.finalLayout = m_bHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	VkAttachmentReference ColorAttachmentRef = {};
 	ColorAttachmentRef.attachment = 0;
@@ -746,13 +1141,21 @@ void App::RecreateDrawingCommandBuffer()
 		ColorAttachment, DepthAttachment, ColorAttachmentResolve
 	};
 
-	VkSubpassDependency Dependency = {};
-	Dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	Dependency.dstSubpass = 0;
-	Dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	Dependency.srcAccessMask = 0;
-	Dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	Dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	std::array<VkSubpassDependency, 2> Dependencies = {};
+	Dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	Dependencies[0].dstSubpass = 0;
+	Dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	Dependencies[0].srcAccessMask = 0;
+	Dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	Dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	/** The readback copy must see the resolved pixels */
+	Dependencies[1].srcSubpass = 0;
+	Dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	Dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	Dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	Dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	Dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
 	VkRenderPassCreateInfo CreateInfo = {};
 	CreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -760,8 +1163,8 @@ void App::RecreateDrawingCommandBuffer()
 	CreateInfo.pAttachments = Attachments.data();
 	CreateInfo.subpassCount = 1;
 	CreateInfo.pSubpasses = &Subpass;
-	CreateInfo.dependencyCount = 1;
-	CreateInfo.pDependencies = &Dependency;
+	CreateInfo.dependencyCount = m_bHeadless ? 2 : 1;
+	CreateInfo.pDependencies = Dependencies.data();
 
 	if (vkCreateRenderPass(m_Device, &CreateInfo, nullptr, &m_RenderPass) != VK_SUCCESS)
 	{
@@ -773,21 +1176,21 @@ void App::RecreateDrawingCommandBuffer()
 {
 	VkDescriptorSetLayoutBinding MvpUboLayoutBinding = {};
 	MvpUboLayoutBinding.binding = 0;
-	MvpUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	MvpUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	MvpUboLayoutBinding.descriptorCount = 1;
 	MvpUboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 	MvpUboLayoutBinding.pImmutableSamplers = nullptr;
 
 	VkDescriptorSetLayoutBinding LightUboLayoutBinding = {};
 	LightUboLayoutBinding.binding = 1;
-	LightUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	LightUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	LightUboLayoutBinding.descriptorCount = 1;
 	LightUboLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	LightUboLayoutBinding.pImmutableSamplers = nullptr;
 
 	VkDescriptorSetLayoutBinding MaterialUboLayoutBinding = {};
 	MaterialUboLayoutBinding.binding = 2;
-	MaterialUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	MaterialUboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	MaterialUboLayoutBinding.descriptorCount = 1;
 	MaterialUboLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	MaterialUboLayoutBinding.pImmutableSamplers = nullptr;
@@ -806,37 +1209,22 @@ void App::RecreateDrawingCommandBuffer()
 	NormalSamplerLayoutBinding.pImmutableSamplers = nullptr;
 	NormalSamplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-	VkDescriptorSetLayoutBinding MetallicSamplerLayoutBinding = {};
-	MetallicSamplerLayoutBinding.binding = 5;
-	MetallicSamplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	MetallicSamplerLayoutBinding.descriptorCount = 1;
-	MetallicSamplerLayoutBinding.pImmutableSamplers = nullptr;
-	MetallicSamplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-	VkDescriptorSetLayoutBinding RoughnessSamplerLayoutBinding = {};
-	RoughnessSamplerLayoutBinding.binding = 6;
-	RoughnessSamplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	RoughnessSamplerLayoutBinding.descriptorCount = 1;
-	RoughnessSamplerLayoutBinding.pImmutableSamplers = nullptr;
-	RoughnessSamplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-	VkDescriptorSetLayoutBinding AoSamplerLayoutBinding = {};
-	AoSamplerLayoutBinding.binding = 7;
-	AoSamplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	AoSamplerLayoutBinding.descriptorCount = 1;
-	AoSamplerLayoutBinding.pImmutableSamplers = nullptr;
-	AoSamplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-	std::array<VkDescriptorSetLayoutBinding, 8> Bindings =
+	/** Occlusion, roughness and metallic packed into R, G and B */
+	VkDescriptorSetLayoutBinding OrmSamplerLayoutBinding = {};
+	OrmSamplerLayoutBinding.binding = 5;
+	OrmSamplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	OrmSamplerLayoutBinding.descriptorCount = 1;
+	OrmSamplerLayoutBinding.pImmutableSamplers = nullptr;
+	OrmSamplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	std::array<VkDescriptorSetLayoutBinding, 6> Bindings =
 	{
 		MvpUboLayoutBinding,
 		LightUboLayoutBinding,
 		MaterialUboLayoutBinding,
 		AlbedoSamplerLayoutBinding,
 		NormalSamplerLayoutBinding,
-		MetallicSamplerLayoutBinding,
-		RoughnessSamplerLayoutBinding,
-		AoSamplerLayoutBinding
+		OrmSamplerLayoutBinding
 	};
 
 	VkDescriptorSetLayoutCreateInfo LayoutCreateInfo = {};
@@ -870,6 +1258,24 @@ void App::RecreateDrawingCommandBuffer()
 	VertShaderStageCreateInfo.module = VertShaderModule;
 	VertShaderStageCreateInfo.pName = "main";
 
+	/** The vertex shader decodes whatever m_VertexFormat packs */
+	std::array<int32_t, 3> VertexSpecializationData = GetVertexSpecializationConstants(m_VertexFormat);
+	std::array<VkSpecializationMapEntry, 3> VertexSpecializationEntries = {};
+	for (uint32_t i = 0; i < VertexSpecializationEntries.size(); i++)
+	{
+		VertexSpecializationEntries[i].constantID = i;
+		VertexSpecializationEntries[i].offset = i * sizeof(int32_t);
+		VertexSpecializationEntries[i].size = sizeof(int32_t);
+	}
+
+	VkSpecializationInfo VertexSpecializationInfo = {};
+	VertexSpecializationInfo.mapEntryCount = static_cast<uint32_t>(VertexSpecializationEntries.size());
+	VertexSpecializationInfo.pMapEntries = VertexSpecializationEntries.data();
+	VertexSpecializationInfo.dataSize = sizeof(VertexSpecializationData);
+	VertexSpecializationInfo.pData = VertexSpecializationData.data();
+
+	VertShaderStageCreateInfo.pSpecializationInfo = &VertexSpecializationInfo;
+
 	VkPipelineShaderStageCreateInfo FragShaderStageCreateInfo = {};
 	FragShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	FragShaderStageCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -883,13 +1289,13 @@ void App::RecreateDrawingCommandBuffer()
 	};
 
 	// Vertex input
-	auto BindingDescription = Vertex::GetBindingDescription();
-	auto AttributeDescription = Vertex::GetAttributeDescription();
+	auto BindingDescriptions = GetVertexBindingDescriptions(m_VertexFormat);
+	auto AttributeDescription = GetVertexAttributeDescriptions(m_VertexFormat);
 
 	VkPipelineVertexInputStateCreateInfo VertexInputStateCreateInfo = {};
 	VertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	VertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-	VertexInputStateCreateInfo.pVertexBindingDescriptions = &BindingDescription;
+	VertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(BindingDescriptions.size());
+	VertexInputStateCreateInfo.pVertexBindingDescriptions = BindingDescriptions.data();
 	VertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(AttributeDescription.size());
 	VertexInputStateCreateInfo.pVertexAttributeDescriptions = AttributeDescription.data();
 
@@ -900,24 +1306,13 @@ void App::RecreateDrawingCommandBuffer()
 	InputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
 
 	// Viewports and scissors
-	VkViewport Viewport = {};
-	Viewport.x = 0.0f;
-	Viewport.y = 0.0f;
-	Viewport.width = static_cast<float>(m_SwapChainInfo.SwapChainExtent.width);
-	Viewport.height = static_cast<float>(m_SwapChainInfo.SwapChainExtent.height);
-	Viewport.minDepth = 0.0f;
-	Viewport.maxDepth = 1.0f;
-
-	VkRect2D Scissor = {};
-	Scissor.offset = { 0, 0 };
-	Scissor.extent = m_SwapChainInfo.SwapChainExtent;
-
+	// Both are dynamic and set while recording, so the pipelines do not depend on the swapchain extent
 	VkPipelineViewportStateCreateInfo ViewportStateCreateInfo = {};
 	ViewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	ViewportStateCreateInfo.viewportCount = 1;
-	ViewportStateCreateInfo.pViewports = &Viewport;
+	ViewportStateCreateInfo.pViewports = nullptr;
 	ViewportStateCreateInfo.scissorCount = 1;
-	ViewportStateCreateInfo.pScissors = &Scissor;
+	ViewportStateCreateInfo.pScissors = nullptr;
 
 	// Rasterizer
 	VkPipelineRasterizationStateCreateInfo RasterizationStateCreateInfo = {};
@@ -948,7 +1343,8 @@ void App::RecreateDrawingCommandBuffer()
 	DepthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 	DepthStencilCreateInfo.depthTestEnable = VK_TRUE;
 	DepthStencilCreateInfo.depthWriteEnable = VK_TRUE;
-	DepthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+	/** Equal passes too, so the color pass draws over the depth its own prepass wrote */
+	DepthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
 	DepthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
 	DepthStencilCreateInfo.minDepthBounds = 0.0f;
 	DepthStencilCreateInfo.maxDepthBounds = 1.0f;
@@ -983,15 +1379,29 @@ void App::RecreateDrawingCommandBuffer()
 	ColorBlendStateCreateInfo.blendConstants[3] = 0.0f;
 
 	// Dynamic state
-	// TODO : Use it later...
+	std::array<VkDynamicState, 2> DynamicStates = 
+	{
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+
+	VkPipelineDynamicStateCreateInfo DynamicStateCreateInfo = {};
+	DynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	DynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(DynamicStates.size());
+	DynamicStateCreateInfo.pDynamicStates = DynamicStates.data();
 
 	// Pipeline layout
 	VkPipelineLayoutCreateInfo PipelineLayoutCreateInfo = {};
 	PipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	PipelineLayoutCreateInfo.setLayoutCount = 1;
 	PipelineLayoutCreateInfo.pSetLayouts = &m_DescriptorSetLayout;
-	PipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-	PipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+	VkPushConstantRange InstanceRange = {};
+	InstanceRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	InstanceRange.offset = 0;
+	InstanceRange.size = sizeof(InstancePushConstants);
+
+	PipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+	PipelineLayoutCreateInfo.pPushConstantRanges = &InstanceRange;
 
 	if (vkCreatePipelineLayout(m_Device, &PipelineLayoutCreateInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
 	{
@@ -1010,19 +1420,21 @@ void App::RecreateDrawingCommandBuffer()
 	GraphicsPipelineCreateInfo.pMultisampleState = &MultisampleStateCreateInfo;
 	GraphicsPipelineCreateInfo.pDepthStencilState = &DepthStencilCreateInfo;
 	GraphicsPipelineCreateInfo.pColorBlendState = &ColorBlendStateCreateInfo;
-	GraphicsPipelineCreateInfo.pDynamicState = nullptr;
+	GraphicsPipelineCreateInfo.pDynamicState = &DynamicStateCreateInfo;
 	GraphicsPipelineCreateInfo.layout = m_PipelineLayout;
 	GraphicsPipelineCreateInfo.renderPass = m_RenderPass;
 	GraphicsPipelineCreateInfo.subpass = 0;
 	GraphicsPipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
 	GraphicsPipelineCreateInfo.basePipelineIndex = -1;
 
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
 	/** GRAPHICS_PIPELINE_TYPE_FILL & GRAPHICS_PIPELINE_TYPE_FRONT_CULL */
 	RasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
 	RasterizationStateCreateInfo.cullMode = VK_CULL_MODE_FRONT_BIT;
 	if (vkCreateGraphicsPipelines(
 		m_Device,
-		VK_NULL_HANDLE, 
+		m_PipelineCache.GetHandle(),
 		1, 
 		&GraphicsPipelineCreateInfo,
 		nullptr, 
@@ -1038,7 +1450,7 @@ void App::RecreateDrawingCommandBuffer()
 	RasterizationStateCreateInfo.cullMode = VK_CULL_MODE_FRONT_BIT;
 	if (vkCreateGraphicsPipelines(
 		m_Device,
-		VK_NULL_HANDLE,
+		m_PipelineCache.GetHandle(),
 		1,
 		&GraphicsPipelineCreateInfo,
 		nullptr,
@@ -1054,7 +1466,7 @@ void App::RecreateDrawingCommandBuffer()
 	RasterizationStateCreateInfo.cullMode = VK_CULL_MODE_FRONT_BIT;
 	if (vkCreateGraphicsPipelines(
 		m_Device,
-		VK_NULL_HANDLE,
+		m_PipelineCache.GetHandle(),
 		1,
 		&GraphicsPipelineCreateInfo,
 		nullptr,
@@ -1070,7 +1482,7 @@ void App::RecreateDrawingCommandBuffer()
 	RasterizationStateCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
 	if (vkCreateGraphicsPipelines(
 		m_Device,
-		VK_NULL_HANDLE,
+		m_PipelineCache.GetHandle(),
 		1,
 		&GraphicsPipelineCreateInfo,
 		nullptr,
@@ -1086,7 +1498,7 @@ void App::RecreateDrawingCommandBuffer()
 	RasterizationStateCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
 	if (vkCreateGraphicsPipelines(
 		m_Device,
-		VK_NULL_HANDLE,
+		m_PipelineCache.GetHandle(),
 		1,
 		&GraphicsPipelineCreateInfo,
 		nullptr,
@@ -1102,7 +1514,7 @@ void App::RecreateDrawingCommandBuffer()
 	RasterizationStateCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
 	if (vkCreateGraphicsPipelines(
 		m_Device,
-		VK_NULL_HANDLE,
+		m_PipelineCache.GetHandle(),
 		1,
 		&GraphicsPipelineCreateInfo,
 		nullptr,
@@ -1118,7 +1530,7 @@ void App::RecreateDrawingCommandBuffer()
 	RasterizationStateCreateInfo.cullMode = VK_CULL_MODE_NONE;
 	if (vkCreateGraphicsPipelines(
 		m_Device,
-		VK_NULL_HANDLE,
+		m_PipelineCache.GetHandle(),
 		1,
 		&GraphicsPipelineCreateInfo,
 		nullptr,
@@ -1134,7 +1546,7 @@ void App::RecreateDrawingCommandBuffer()
 	RasterizationStateCreateInfo.cullMode = VK_CULL_MODE_NONE;
 	if (vkCreateGraphicsPipelines(
 		m_Device,
-		VK_NULL_HANDLE,
+		m_PipelineCache.GetHandle(),
 		1,
 		&GraphicsPipelineCreateInfo,
 		nullptr,
@@ -1150,7 +1562,7 @@ void App::RecreateDrawingCommandBuffer()
 	RasterizationStateCreateInfo.cullMode = VK_CULL_MODE_NONE;
 	if (vkCreateGraphicsPipelines(
 		m_Device,
-		VK_NULL_HANDLE,
+		m_PipelineCache.GetHandle(),
 		1,
 		&GraphicsPipelineCreateInfo,
 		nullptr,
@@ -1161,22 +1573,176 @@ void App::RecreateDrawingCommandBuffer()
 	}
 	/************************************************************************/
 
-	vkDestroyShaderModule(m_Device, VertShaderModule, nullptr);
-	vkDestroyShaderModule(m_Device, FragShaderModule, nullptr);
-}
+	/** Depth prepass, position stream only and no color writes */
+	auto DepthShaderCode = ReadFile(m_DepthVertexShaderPath);
+	VkShaderModule DepthShaderModule = CreateShaderModule(m_Device, DepthShaderCode);
 
-/** Vulkan Init */void App::CreateCommandPool()
-{
-	QueueFamilyIndices Indices = FindQueueFamilies(m_PhysicalDevice, m_Surface);
+	VkPipelineShaderStageCreateInfo DepthShaderStageCreateInfo = VertShaderStageCreateInfo;
+	DepthShaderStageCreateInfo.module = DepthShaderModule;
+
+	VertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
+	VertexInputStateCreateInfo.vertexAttributeDescriptionCount = 1;
+
+	RasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
+	MultisampleStateCreateInfo.sampleShadingEnable = VK_FALSE;
+	ColorBlendAttachmentState.colorWriteMask = 0;
 
-	VkCommandPoolCreateInfo CmdPoolCreateInfo = {};
-	CmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	CmdPoolCreateInfo.queueFamilyIndex = Indices.GraphicsFamily.value();
-	CmdPoolCreateInfo.flags = 0;
+	GraphicsPipelineCreateInfo.stageCount = 1;
+	GraphicsPipelineCreateInfo.pStages = &DepthShaderStageCreateInfo;
 
-	if (vkCreateCommandPool(m_Device, &CmdPoolCreateInfo, nullptr, &m_CommandPool) != VK_SUCCESS)
+	std::array<std::pair<int, VkCullModeFlags>, 3> DepthCullModes =
 	{
-		throw std::runtime_error("Failed to create command pool!");
+		std::make_pair(static_cast<int>(GRAPHICS_PIPELINE_TYPE_FRONT_CULL), static_cast<VkCullModeFlags>(VK_CULL_MODE_FRONT_BIT)),
+		std::make_pair(static_cast<int>(GRAPHICS_PIPELINE_TYPE_BACK_CULL), static_cast<VkCullModeFlags>(VK_CULL_MODE_BACK_BIT)),
+		std::make_pair(static_cast<int>(GRAPHICS_PIPELINE_TYPE_NONE_CULL), static_cast<VkCullModeFlags>(VK_CULL_MODE_NONE))
+	};
+
+	for (const auto & CullMode : DepthCullModes)
+	{
+		RasterizationStateCreateInfo.cullMode = CullMode.second;
+		if (vkCreateGraphicsPipelines(
+			m_Device,
+			m_PipelineCache.GetHandle(),
+			1,
+			&GraphicsPipelineCreateInfo,
+			nullptr,
+			&m_DepthPipelines[CullMode.first]
+		) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create graphics pipeline!");
+		}
+	}
+
+	double CreationTime = std::chrono::duration<double, std::chrono::milliseconds::period>(
+		std::chrono::high_resolution_clock::now() - StartTime
+		).count();
+
+	std::cout << "Created " << m_GraphicsPipelines.size() + m_DepthPipelines.size() << " graphics pipelines in " << CreationTime << " ms ("
+		<< (m_PipelineCache.IsWarm() ? "warm" : "cold") << " pipeline cache)" << std::endl;
+
+	m_GraphicsPipelinesFormat = m_SwapChainInfo.SwapChainImageFormat;
+	m_GraphicsPipelinesSamples = m_SwapChainInfo.MsaaSamples;
+
+	vkDestroyShaderModule(m_Device, VertShaderModule, nullptr);
+	vkDestroyShaderModule(m_Device, FragShaderModule, nullptr);
+	vkDestroyShaderModule(m_Device, DepthShaderModule, nullptr);
+}
+
+/** Vulkan Init */void App::CreateFrameContexts()
+{
+	QueueFamilyIndices Indices = FindQueueFamilies(m_PhysicalDevice, m_Surface);
+
+	m_FrameContexts.resize(m_MaxFramesInFlights);
+
+	/** Headless runs are the benchmarks, they time the passes on the GPU if the graphics queue supports it */
+	if (m_bHeadless)
+	{
+		uint32_t QueueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &QueueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> QueueFamilies(QueueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &QueueFamilyCount, QueueFamilies.data());
+
+		VkPhysicalDeviceProperties PhysicalDeviceProperties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &PhysicalDeviceProperties);
+
+		uint32_t ValidBits = QueueFamilies[Indices.GraphicsFamily.value()].timestampValidBits;
+		if (ValidBits > 0)
+		{
+			m_TimestampPeriod = PhysicalDeviceProperties.limits.timestampPeriod;
+			m_TimestampMask = ValidBits >= 64 ? UINT64_MAX : (1ull << ValidBits) - 1;
+		}
+	}
+
+	for (auto & Context : m_FrameContexts)
+	{
+		VkCommandPoolCreateInfo CmdPoolCreateInfo = {};
+		CmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		CmdPoolCreateInfo.queueFamilyIndex = Indices.GraphicsFamily.value();
+		CmdPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		if (vkCreateCommandPool(m_Device, &CmdPoolCreateInfo, nullptr, &Context.CommandPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create command pool!");
+		}
+
+		VkCommandBufferAllocateInfo CmdBufferAllocInfo = {};
+		CmdBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		CmdBufferAllocInfo.commandPool = Context.CommandPool;
+		CmdBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		CmdBufferAllocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(m_Device, &CmdBufferAllocInfo, &Context.CommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate command buffers!");
+		}
+
+		/** Every worker may record at the same time, so each recording task gets a pool of its own */
+		uint32_t TaskCount = m_ThreadPool.GetThreadCount();
+		Context.SecondaryCommandPools.resize(TaskCount);
+		Context.SecondaryCommandBuffers.resize(TaskCount);
+		Context.DepthCommandBuffers.resize(TaskCount);
+
+		for (uint32_t i = 0; i < TaskCount; i++)
+		{
+			if (vkCreateCommandPool(m_Device, &CmdPoolCreateInfo, nullptr, &Context.SecondaryCommandPools[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create command pool!");
+			}
+
+			CmdBufferAllocInfo.commandPool = Context.SecondaryCommandPools[i];
+			CmdBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+
+			if (vkAllocateCommandBuffers(m_Device, &CmdBufferAllocInfo, &Context.SecondaryCommandBuffers[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate command buffers!");
+			}
+
+			if (vkAllocateCommandBuffers(m_Device, &CmdBufferAllocInfo, &Context.DepthCommandBuffers[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate command buffers!");
+			}
+		}
+
+		if (m_bHeadless)
+		{
+			/** Cached memory makes the CPU reads fast, fall back to whatever is host visible */
+			VkMemoryPropertyFlags Properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+			VkPhysicalDeviceMemoryProperties MemoryProperties;
+			vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &MemoryProperties);
+
+			for (uint32_t i = 0; i < MemoryProperties.memoryTypeCount; i++)
+			{
+				if ((MemoryProperties.memoryTypes[i].propertyFlags & (Properties | VK_MEMORY_PROPERTY_HOST_CACHED_BIT)) ==
+					(Properties | VK_MEMORY_PROPERTY_HOST_CACHED_BIT))
+				{
+					Properties |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+					break;
+				}
+			}
+
+			CreateBuffer(
+				m_Device,
+				m_MemoryAllocator,
+				static_cast<VkDeviceSize>(m_SwapChainInfo.SwapChainExtent.width) * m_SwapChainInfo.SwapChainExtent.height * 4,
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				Properties,
+				Context.ReadbackBuffer
+			);
+		}
+
+		if (m_TimestampPeriod > 0.0f)
+		{
+			VkQueryPoolCreateInfo QueryPoolCreateInfo = {};
+			QueryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			QueryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			QueryPoolCreateInfo.queryCount = 3;
+
+			if (vkCreateQueryPool(m_Device, &QueryPoolCreateInfo, nullptr, &Context.TimestampQueryPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create query pool!");
+			}
+		}
 	}
 }
 
@@ -1185,8 +1751,8 @@ void App::RecreateDrawingCommandBuffer()
 	VkFormat ColorFormat = m_SwapChainInfo.SwapChainImageFormat;
 
 	CreateImage(
-		m_PhysicalDevice,
 		m_Device,
+		m_MemoryAllocator,
 		m_SwapChainInfo.SwapChainExtent.width,
 		m_SwapChainInfo.SwapChainExtent.height,
 		1,
@@ -1196,7 +1762,7 @@ void App::RecreateDrawingCommandBuffer()
 		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		m_SwapChainInfo.ColorImage,
-		m_SwapChainInfo.ColorImageMemory
+		m_SwapChainInfo.ColorImageAllocation
 	);
 
 	CreateImageView(
@@ -1208,10 +1774,8 @@ void App::RecreateDrawingCommandBuffer()
 		m_SwapChainInfo.ColorImageView
 	);
 
-	TransitionImageLayout(
-		m_Device,
-		m_GraphicsQueue,
-		m_CommandPool,
+	CmdTransitionImageLayout(
+		m_UploadContext.GetGraphicsCommandBuffer(),
 		m_SwapChainInfo.ColorImage,
 		ColorFormat,
 		1,
@@ -1224,8 +1788,8 @@ void App::RecreateDrawingCommandBuffer()
 {
 	VkFormat DepthFormat = FindDepthFormat(m_PhysicalDevice);
 	CreateImage(
-		m_PhysicalDevice,
 		m_Device,
+		m_MemoryAllocator,
 		m_SwapChainInfo.SwapChainExtent.width,
 		m_SwapChainInfo.SwapChainExtent.height,
 		1,
@@ -1235,7 +1799,7 @@ void App::RecreateDrawingCommandBuffer()
 		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		m_SwapChainInfo.DepthImage,
-		m_SwapChainInfo.DepthImageMemory
+		m_SwapChainInfo.DepthImageAllocation
 	);
 
 	CreateImageView(
@@ -1247,10 +1811,8 @@ void App::RecreateDrawingCommandBuffer()
 		m_SwapChainInfo.DepthImageView
 	);
 
-	TransitionImageLayout(
-		m_Device,
-		m_GraphicsQueue,
-		m_CommandPool,
+	CmdTransitionImageLayout(
+		m_UploadContext.GetGraphicsCommandBuffer(),
 		m_SwapChainInfo.DepthImage,
 		DepthFormat,
 		1,
@@ -1290,471 +1852,1145 @@ void App::RecreateDrawingCommandBuffer()
 
 /** Vulkan Init */void App::LoadAndCreateTextures()
 {
-	CreateTextureFromFile(
+	const OrmFilenames DefaultOrmFilenames = { m_AoTexturePath, m_RoughnessTexturePath, m_MetallicTexturePath };
+
+	std::vector<TextureLoadRequest> Requests =
+	{
+		{ GetBakedTextureFilename(m_AlbedoTexturePath), &m_AlbedoTexture, TEXTURE_CONTENT_COLOR },
+		{ GetBakedTextureFilename(m_NormalTexturePath), &m_NormalTexture, TEXTURE_CONTENT_NORMAL },
+		{ GetBakedOrmFilename(DefaultOrmFilenames), &m_OrmTexture, TEXTURE_CONTENT_ORM, DefaultOrmFilenames }
+	};
+
+	/** Each distinct texture of the material table is loaded once, missing files keep the defaults above */
+	for (uint32_t MaterialIndex = 0; MaterialIndex < static_cast<uint32_t>(m_Scene.Materials.size()); MaterialIndex++)
+	{
+		const SceneMaterial & Material = m_Scene.Materials[MaterialIndex];
+
+		for (SceneTextureSlot Slot : { SCENE_TEXTURE_ALBEDO, SCENE_TEXTURE_NORMAL })
+		{
+			const std::string & Path = Material.Textures[Slot];
+
+			if (Path.empty() || m_SceneTextures.count(Path) > 0)
+			{
+				continue;
+			}
+
+			/** Materials keep the source paths, their baked textures are looked up here */
+			const std::string Filename = GetBakedTextureFilename(Path);
+			if (!std::ifstream(Filename).good())
+			{
+				continue;
+			}
+
+			/** Map nodes stay put, so the request can point into the map. The first slot using a file decides its format. */
+			Requests.push_back({ Filename, &m_SceneTextures[Path], Slot == SCENE_TEXTURE_NORMAL ? TEXTURE_CONTENT_NORMAL : TEXTURE_CONTENT_COLOR });
+		}
+
+		/** Metallic, roughness and AO are packed into one texture per distinct combination of maps */
+		const OrmFilenames ChannelFilenames = GetMaterialOrmFilenames(MaterialIndex);
+		if (ChannelFilenames == OrmFilenames() || m_SceneOrmTextures.count(ChannelFilenames) > 0)
+		{
+			continue;
+		}
+
+		const std::string Filename = GetBakedOrmFilename(ChannelFilenames);
+		bool bAnyChannel = std::any_of(ChannelFilenames.begin(), ChannelFilenames.end(), [](const std::string & Channel)
+		{
+			return !Channel.empty() && std::ifstream(Channel).good();
+		});
+
+		if (Filename.empty() && !bAnyChannel)
+		{
+			continue;
+		}
+
+		Requests.push_back({ Filename, &m_SceneOrmTextures[ChannelFilenames], TEXTURE_CONTENT_ORM, ChannelFilenames });
+	}
+
+	if (IsTextureStreamingUsed())
+	{
+		m_TextureStreamer.Init(
+			m_Instance,
+			m_PhysicalDevice,
+			m_Device,
+			m_MemoryAllocator,
+			m_UploadContext,
+			m_bMemoryBudgetSupported,
+			m_TextureStreamingSettings
+		);
+
+		/** Baked DDS textures only upload their tail now, everything else is loaded in full below */
+		size_t RequestCount = Requests.size();
+		Requests.erase(
+			std::remove_if(Requests.begin(), Requests.end(), [this](const TextureLoadRequest & Request)
+			{
+				return m_TextureStreamer.AddTexture(Request.Filename, Request.pTexture);
+			}),
+			Requests.end()
+		);
+
+		std::cout << "Streaming " << RequestCount - Requests.size() << " of " << RequestCount << " textures"
+			<< (m_bMemoryBudgetSupported ? " within the VK_EXT_memory_budget budget" : " within the device local heap") << std::endl;
+	}
+
+	TextureCompressionSettings Compression;
+	Compression.bEnabled = m_bTextureCompressionEnabled && m_bTextureCompressionSupported;
+	Compression.Quality = m_TextureCompressionQuality;
+
+	LoadTextures(
 		m_PhysicalDevice,
 		m_Device,
-		m_CommandPool,
-		m_GraphicsQueue,
-		m_AlbedoTexturePath.c_str(),
-		m_AlbedoTexture
+		m_MemoryAllocator,
+		m_UploadContext,
+		m_ThreadPool,
+		Requests,
+		Compression,
+		std::cout
 	);
+}
 
-	CreateTextureFromFile(
-		m_PhysicalDevice,
-		m_Device,
-		m_CommandPool,
-		m_GraphicsQueue,
-		m_NormalTexturePath.c_str(),
-		m_NormalTexture
+/** App Helper */const TextureInfo & App::GetMaterialTexture(
+	uint32_t MaterialIndex,
+	SceneTextureSlot Slot
+) const
+{
+	auto Iter = m_SceneTextures.find(m_Scene.Materials[MaterialIndex].Textures[Slot]);
+	if (Iter != m_SceneTextures.end())
+	{
+		return Iter->second;
+	}
+
+	return Slot == SCENE_TEXTURE_NORMAL ? m_NormalTexture : m_AlbedoTexture;
+}
+
+/** App Helper */const TextureInfo & App::GetMaterialOrmTexture(
+	uint32_t MaterialIndex
+) const
+{
+	auto Iter = m_SceneOrmTextures.find(GetMaterialOrmFilenames(MaterialIndex));
+	return Iter != m_SceneOrmTextures.end() ? Iter->second : m_OrmTexture;
+}
+
+/** App Helper */OrmFilenames App::GetMaterialOrmFilenames(
+	uint32_t MaterialIndex
+) const
+{
+	const SceneMaterial & Material = m_Scene.Materials[MaterialIndex];
+
+	OrmFilenames Filenames;
+	Filenames[ORM_CHANNEL_OCCLUSION] = Material.Textures[SCENE_TEXTURE_AO];
+	Filenames[ORM_CHANNEL_ROUGHNESS] = Material.Textures[SCENE_TEXTURE_ROUGHNESS];
+	Filenames[ORM_CHANNEL_METALLIC] = Material.Textures[SCENE_TEXTURE_METALLIC];
+	return Filenames;
+}
+
+/** App Helper */bool App::IsTextureStreamingUsed() const
+{
+	return m_bTextureStreamingEnabled && !m_bHeadless;
+}
+
+/** App Helper */void App::UpdateTextureStreaming(
+	uint32_t CurrentFrame
+)
+{
+	if (!IsTextureStreamingUsed())
+	{
+		return;
+	}
+
+	/** From the draw list of the previous frame, one frame late is early enough for streaming */
+	for (uint32_t MaterialIndex = 0; MaterialIndex < static_cast<uint32_t>(m_MaterialPixelsPerUv.size()); MaterialIndex++)
+	{
+		float PixelsPerUv = m_MaterialPixelsPerUv[MaterialIndex];
+
+		m_TextureStreamer.RequestResolution(&GetMaterialTexture(MaterialIndex, SCENE_TEXTURE_ALBEDO), PixelsPerUv);
+		m_TextureStreamer.RequestResolution(&GetMaterialTexture(MaterialIndex, SCENE_TEXTURE_NORMAL), PixelsPerUv);
+		m_TextureStreamer.RequestResolution(&GetMaterialOrmTexture(MaterialIndex), PixelsPerUv);
+	}
+
+	/** The fence of this context has signaled, only the other frames in flight may still read replaced images */
+	uint64_t InUseGeneration = m_TextureStreamer.GetGeneration();
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_FrameContexts.size()); i++)
+	{
+		if (i != CurrentFrame)
+		{
+			InUseGeneration = std::min(InUseGeneration, m_FrameContexts[i].TextureGeneration);
+		}
+	}
+
+	m_TextureStreamer.Update(InUseGeneration, std::cout);
+
+	FrameContext & Context = m_FrameContexts[CurrentFrame];
+	if (Context.TextureGeneration != m_TextureStreamer.GetGeneration())
+	{
+		UpdateTextureDescriptors(Context);
+		Context.TextureGeneration = m_TextureStreamer.GetGeneration();
+	}
+}
+
+/** Vulkan Init */void App::LoadObjModel()
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	/** A baked model does not need its source, anything else is imported and cached next to it */
+	MeshScene Scene;
+	bool bLoaded = LoadBakedMeshScene(m_MeshImportSettings, GetBakedFilename(m_BakedAssetDirectory, m_ModelPath), m_ModelPath, Scene, std::cout);
+
+	MeshCacheKey Key;
+	if (!bLoaded)
+	{
+		if (!ComputeMeshImportCacheKey(m_MeshImportSettings, m_ModelPath, Key))
+		{
+			throw std::runtime_error("Failed to open model file!");
+		}
+
+		bLoaded = LoadMeshScene(m_ModelCachePath, Key, true, Scene, std::cout);
+	}
+
+	if (!bLoaded)
+	{
+		ImportMeshScene(m_MeshImportSettings, m_ModelPath, m_ThreadPool, Scene, std::cout);
+
+		if (!WriteMeshScene(m_ModelCachePath, Key, Scene))
+		{
+			std::cout << "Failed to write mesh cache " << m_ModelCachePath << std::endl;
+		}
+
+		std::cout << "Imported " << m_ModelPath << " in "
+			<< std::chrono::duration<double, std::chrono::milliseconds::period>(
+				std::chrono::high_resolution_clock::now() - StartTime
+				).count() << " ms" << std::endl;
+	}
+
+	m_Scene = std::move(Scene);
+
+	/** The index buffer also holds the coarser levels, only level 0 counts as the model */
+	m_VertexNum = m_Scene.Vertices.size();
+	m_FacetNum = 0;
+	for (const SceneMesh & Mesh : m_Scene.Meshes)
+	{
+		for (uint32_t i = Mesh.FirstSubMesh; i < Mesh.FirstSubMesh + Mesh.SubMeshCount; i++)
+		{
+			m_FacetNum += m_Scene.SubMeshes[i].IndexCount / 3;
+		}
+	}
+}
+
+/** App Helper */std::string App::GetBakedTextureFilename(
+	const std::string & Filename
+) const
+{
+	const std::string BakedFilename = GetBakedFilename(m_BakedAssetDirectory, Filename);
+	return !BakedFilename.empty() && std::ifstream(BakedFilename).good() ? BakedFilename : Filename;
+}
+
+/** App Helper */std::string App::GetBakedOrmFilename(
+	const OrmFilenames & Filenames
+) const
+{
+	const std::string OrmFilename = GetOrmFilename(Filenames);
+	if (OrmFilename.empty())
+	{
+		return "";
+	}
+
+	const std::string BakedFilename = GetBakedFilename(m_BakedAssetDirectory, OrmFilename);
+	return std::ifstream(BakedFilename).good() ? BakedFilename : "";
+}
+
+/** App Helper */void App::BuildInstances()
+{
+	m_Scene.Instances.erase(
+		std::remove_if(m_Scene.Instances.begin(), m_Scene.Instances.end(), [this](const SceneInstance & Instance)
+		{
+			return Instance.MeshIndex >= m_Scene.Meshes.size();
+		}),
+		m_Scene.Instances.end()
 	);
 
-	CreateTextureFromFile(
-		m_PhysicalDevice,
+	m_InstanceTransforms.resize(m_Scene.Instances.size());
+
+	for (uint32_t i = 0; i < m_Scene.Instances.size(); i++)
+	{
+		const SceneInstance & Instance = m_Scene.Instances[i];
+		const VertexDequantization & Dequantization = m_MeshDequantizations[Instance.MeshIndex];
+
+		m_InstanceTransforms[i].Model = Instance.World;
+		m_InstanceTransforms[i].PositionScale = glm::vec4(Dequantization.PositionScale, 0.0f);
+		m_InstanceTransforms[i].PositionOffset = glm::vec4(Dequantization.PositionOffset, 0.0f);
+		m_InstanceTransforms[i].TexCoordScaleOffset = glm::vec4(Dequantization.TexCoordScale, Dequantization.TexCoordOffset);
+	}
+
+	BuildInstanceBounds(m_Scene, m_ThreadPool, m_InstanceBounds, m_InstanceOrder);
+}
+
+/** App Helper */void App::BuildDrawCommands()
+{
+	DrawListSettings Settings;
+	Settings.LodErrorThreshold = m_LodErrorThreshold;
+	Settings.bLodEnabled = m_bLodEnabled;
+	Settings.bMeshletCullingEnabled = m_bMeshletCullingEnabled;
+	Settings.bBackfaceCulling = m_GraphicsPipelineCullMode == GRAPHICS_PIPELINE_TYPE_BACK_CULL;
+
+	DrawListView View;
+	m_Camera.RetriveData(View.Target, View.Eye, View.Up, View.Fov, View.NearZ, View.FarZ);
+	View.Width = m_SwapChainInfo.SwapChainExtent.width;
+	View.Height = m_SwapChainInfo.SwapChainExtent.height;
+
+	BuildDrawList(Settings, View, m_Scene, m_InstanceBounds, m_InstanceOrder, m_DrawCommands, m_CullingStatistics, m_MaterialPixelsPerUv);
+
+	m_DrawnFacetNum = m_CullingStatistics.TriangleCount - m_CullingStatistics.CulledTriangleCount;
+}
+
+/** Vulkan Init */void App::CreateVertexBuffer()
+{
+	/** The vertices of a mesh are contiguous, its sub-meshes and levels of detail all index into them */
+	std::vector<VertexRange> MeshRanges(m_Scene.Meshes.size());
+
+	for (size_t i = 0; i < m_Scene.Meshes.size(); i++)
+	{
+		const SceneMesh & Mesh = m_Scene.Meshes[i];
+		size_t First = m_Scene.Vertices.size(), Last = 0;
+
+		for (uint32_t s = 0; s < Mesh.SubMeshCount * Mesh.LodCount; s++)
+		{
+			const SubMesh & Part = m_Scene.SubMeshes[Mesh.FirstSubMesh + s];
+			First = std::min<size_t>(First, Part.VertexOffset);
+			Last = std::max<size_t>(Last, Part.VertexOffset + Part.VertexCount);
+		}
+
+		MeshRanges[i].First = First < Last ? First : 0;
+		MeshRanges[i].Count = First < Last ? Last - First : 0;
+	}
+
+	std::vector<std::vector<uint8_t>> VertexStreams;
+	m_MeshDequantizations = PackVertices(m_VertexFormat, m_Scene.Vertices, MeshRanges, VertexStreams);
+
+	VertexQuantizationError Error = MeasureVertexQuantizationError(m_VertexFormat, m_MeshDequantizations, MeshRanges, m_Scene.Vertices, VertexStreams);
+
+	std::cout << "Packed vertices: " << GetVertexStride(m_VertexFormat) << " instead of " << sizeof(MeshVertex)
+		<< " bytes in " << VertexStreams.size() << " streams, max error position " << Error.Position << " normal " << Error.NormalAngle
+		<< " deg tangent " << Error.TangentAngle << " deg texcoord " << Error.TexCoord << std::endl;
+
+	/** The streams share one buffer, each starting on a 16 byte boundary */
+	m_VertexStreamOffsets.resize(VertexStreams.size());
+
+	VkDeviceSize BufferSize = 0;
+	for (size_t i = 0; i < VertexStreams.size(); i++)
+	{
+		m_VertexStreamOffsets[i] = (BufferSize + 15) & ~static_cast<VkDeviceSize>(15);
+		BufferSize = m_VertexStreamOffsets[i] + VertexStreams[i].size();
+	}
+
+	CreateBuffer(
 		m_Device,
-		m_CommandPool,
-		m_GraphicsQueue,
-		m_MetallicTexturePath.c_str(),
-		m_MetallicTexture
+		m_MemoryAllocator,
+		BufferSize,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		m_VertexBuffer
 	);
 
-	CreateTextureFromFile(
-		m_PhysicalDevice,
+	for (size_t i = 0; i < VertexStreams.size(); i++)
+	{
+		m_UploadContext.UploadBuffer(
+			VertexStreams[i].data(),
+			VertexStreams[i].size(),
+			m_VertexBuffer.Buffer,
+			m_VertexStreamOffsets[i],
+			VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+		);
+	}
+}
+
+/** Vulkan Init */void App::CreateIndexBuffer()
+{
+	bool bFitsUint16 = std::all_of(m_Scene.SubMeshes.begin(), m_Scene.SubMeshes.end(), [](const SubMesh & Mesh)
+	{
+		return Mesh.VertexCount <= MESH_MAX_16BIT_VERTICES;
+	});
+
+	/** The indices are relative to their sub-mesh, so this only narrows them */
+	std::vector<uint16_t> Indices16;
+	const void * pIndices = m_Scene.Indices.data();
+	VkDeviceSize BufferSize = sizeof(m_Scene.Indices[0]) * m_Scene.Indices.size();
+	m_IndexType = VK_INDEX_TYPE_UINT32;
+
+	if (bFitsUint16)
+	{
+		Indices16.resize(m_Scene.Indices.size());
+		for (size_t i = 0; i < m_Scene.Indices.size(); i++)
+		{
+			Indices16[i] = static_cast<uint16_t>(m_Scene.Indices[i]);
+		}
+		pIndices = Indices16.data();
+		BufferSize = sizeof(Indices16[0]) * Indices16.size();
+		m_IndexType = VK_INDEX_TYPE_UINT16;
+	}
+
+	std::cout << "Index buffer: " << (bFitsUint16 ? 16 : 32) << "-bit, " << BufferSize / 1024 << " KB, "
+		<< m_Scene.SubMeshes.size() << " sub-meshes" << std::endl;
+
+	CreateBuffer(
 		m_Device,
-		m_CommandPool,
-		m_GraphicsQueue,
-		m_RoughnessTexturePath.c_str(),
-		m_RoughnessTexture
+		m_MemoryAllocator,
+		BufferSize,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		m_IndexBuffer
 	);
 
-	CreateTextureFromFile(
-		m_PhysicalDevice,
-		m_Device,
-		m_CommandPool,
-		m_GraphicsQueue,
-		m_AoTexturePath.c_str(),
-		m_AoTexture
+	m_UploadContext.UploadBuffer(
+		pIndices,
+		BufferSize,
+		m_IndexBuffer.Buffer,
+		0,
+		VK_ACCESS_INDEX_READ_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
 	);
 }
 
-void App::LoadObjModel()
+/** Vulkan Init */void App::CreateUniformRingBuffer()
 {
-	Assimp::Importer Import;
-	const aiScene * pScene = Import.ReadFile(
-		m_ModelPath, 
-		aiProcess_Triangulate |
-		aiProcess_FlipUVs | 
-		aiProcess_CalcTangentSpace | 
-		aiProcess_OptimizeMeshes
+	m_UniformRingBuffer.Init(m_PhysicalDevice);
+
+	/** One region per frame in flight, each holding every uniform block of a frame */
+	VkDeviceSize RegionSize =
+		m_UniformRingBuffer.GetAlignedSize(sizeof(MvpUniformBufferObject)) +
+		m_UniformRingBuffer.GetAlignedSize(sizeof(LightUniformBufferObject)) +
+		m_UniformRingBuffer.GetAlignedSize(sizeof(MaterialUniformBufferObject));
+
+	m_UniformRingBuffer.Create(
+		m_Device,
+		m_MemoryAllocator,
+		RegionSize,
+		static_cast<uint32_t>(m_MaxFramesInFlights)
 	);
+}
+
+/** Vulkan Init */void App::CreateDescriptorPool()
+{
+	std::array<VkDescriptorPoolSize, 6> PoolSizes = {};
+	
+	/** Every material gets its own set in every frame context */
+	uint32_t SetCount = static_cast<uint32_t>(m_Scene.Materials.size() * m_MaxFramesInFlights);
+
+	PoolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	PoolSizes[0].descriptorCount = SetCount;
+	
+	PoolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	PoolSizes[1].descriptorCount = SetCount;
+
+	PoolSizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	PoolSizes[2].descriptorCount = SetCount;
+
+	PoolSizes[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	PoolSizes[3].descriptorCount = SetCount;
+
+	PoolSizes[4].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	PoolSizes[4].descriptorCount = SetCount;
+
+	PoolSizes[5].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	PoolSizes[5].descriptorCount = SetCount;
+
+	VkDescriptorPoolCreateInfo PoolCreateInfo = {};
+	PoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	PoolCreateInfo.poolSizeCount = static_cast<uint32_t>(PoolSizes.size());
+	PoolCreateInfo.pPoolSizes = PoolSizes.data();
+	PoolCreateInfo.maxSets = SetCount;
+
+	if (vkCreateDescriptorPool(m_Device, &PoolCreateInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create descriptor pool!");
+	}
+}
+
+/** Vulkan Init */void App::CreateDescriptorSets()
+{
+	/**
+	* Uniform blocks are addressed with dynamic offsets, so one set per material could serve every frame.
+	* Streamed textures are swapped while a frame may still be reading the old image, so each frame context
+	* has its own sets and rewrites their texture bindings once its fence has signaled.
+	*/
+	std::vector<VkDescriptorSetLayout> Layouts(m_Scene.Materials.size(), m_DescriptorSetLayout);
+
+	VkDescriptorBufferInfo MvpBufferInfo = 
+		m_UniformRingBuffer.GetDescriptorBufferInfo<MvpUniformBufferObject>();
+	VkDescriptorBufferInfo LightBufferInfo = 
+		m_UniformRingBuffer.GetDescriptorBufferInfo<LightUniformBufferObject>();
+	VkDescriptorBufferInfo MaterialBufferInfo = 
+		m_UniformRingBuffer.GetDescriptorBufferInfo<MaterialUniformBufferObject>();
+
+	for (auto & Context : m_FrameContexts)
+	{
+		Context.DescriptorSets.resize(m_Scene.Materials.size());
+
+		VkDescriptorSetAllocateInfo AllocInfo = {};
+		AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		AllocInfo.descriptorPool = m_DescriptorPool;
+		AllocInfo.descriptorSetCount = static_cast<uint32_t>(Layouts.size());
+		AllocInfo.pSetLayouts = Layouts.data();
+
+		if (vkAllocateDescriptorSets(m_Device, &AllocInfo, Context.DescriptorSets.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate descriptor sets!");
+		}
+
+		for (VkDescriptorSet DescriptorSet : Context.DescriptorSets)
+		{
+			std::array<VkWriteDescriptorSet, 3> DescriptorWrites = {};
+	
+			DescriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			DescriptorWrites[0].dstSet = DescriptorSet;
+			DescriptorWrites[0].dstBinding = 0;
+			DescriptorWrites[0].dstArrayElement = 0;
+			DescriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			DescriptorWrites[0].descriptorCount = 1;
+			DescriptorWrites[0].pBufferInfo = &MvpBufferInfo;
+			DescriptorWrites[0].pImageInfo = nullptr;
+			DescriptorWrites[0].pTexelBufferView = nullptr;
+
+			DescriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			DescriptorWrites[1].dstSet = DescriptorSet;
+			DescriptorWrites[1].dstBinding = 1;
+			DescriptorWrites[1].dstArrayElement = 0;
+			DescriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			DescriptorWrites[1].descriptorCount = 1;
+			DescriptorWrites[1].pBufferInfo = &LightBufferInfo;
+			DescriptorWrites[1].pImageInfo = nullptr;
+			DescriptorWrites[1].pTexelBufferView = nullptr;
+
+			DescriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			DescriptorWrites[2].dstSet = DescriptorSet;
+			DescriptorWrites[2].dstBinding = 2;
+			DescriptorWrites[2].dstArrayElement = 0;
+			DescriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			DescriptorWrites[2].descriptorCount = 1;
+			DescriptorWrites[2].pBufferInfo = &MaterialBufferInfo;
+			DescriptorWrites[2].pImageInfo = nullptr;
+			DescriptorWrites[2].pTexelBufferView = nullptr;
+
+			vkUpdateDescriptorSets(
+				m_Device, 
+				static_cast<uint32_t>(DescriptorWrites.size()), 
+				DescriptorWrites.data(),
+				0, 
+				nullptr
+			);
+		}
 
-	if (!pScene || pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !pScene->mRootNode)
+		UpdateTextureDescriptors(Context);
+		Context.TextureGeneration = m_TextureStreamer.GetGeneration();
+	}
+}
+
+/** App Helper */void App::UpdateTextureDescriptors(
+	FrameContext & Context
+)
+{
+	for (uint32_t MaterialIndex = 0; MaterialIndex < Context.DescriptorSets.size(); MaterialIndex++)
 	{
-		throw std::runtime_error(Import.GetErrorString());
+		VkDescriptorSet DescriptorSet = Context.DescriptorSets[MaterialIndex];
+
+		VkDescriptorImageInfo AlbedoImageInfo = GetMaterialTexture(MaterialIndex, SCENE_TEXTURE_ALBEDO).GetDescriptorImageInfo();
+		VkDescriptorImageInfo NormalImageInfo = GetMaterialTexture(MaterialIndex, SCENE_TEXTURE_NORMAL).GetDescriptorImageInfo();
+		VkDescriptorImageInfo OrmImageInfo = GetMaterialOrmTexture(MaterialIndex).GetDescriptorImageInfo();
+
+		std::array<VkWriteDescriptorSet, 3> DescriptorWrites = {};
+
+		DescriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		DescriptorWrites[0].dstSet = DescriptorSet;
+		DescriptorWrites[0].dstBinding = 3;
+		DescriptorWrites[0].dstArrayElement = 0;
+		DescriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		DescriptorWrites[0].descriptorCount = 1;
+		DescriptorWrites[0].pBufferInfo = nullptr;
+		DescriptorWrites[0].pImageInfo = &AlbedoImageInfo;
+		DescriptorWrites[0].pTexelBufferView = nullptr;
+
+		DescriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		DescriptorWrites[1].dstSet = DescriptorSet;
+		DescriptorWrites[1].dstBinding = 4;
+		DescriptorWrites[1].dstArrayElement = 0;
+		DescriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		DescriptorWrites[1].descriptorCount = 1;
+		DescriptorWrites[1].pBufferInfo = nullptr;
+		DescriptorWrites[1].pImageInfo = &NormalImageInfo;
+		DescriptorWrites[1].pTexelBufferView = nullptr;
+
+		DescriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		DescriptorWrites[2].dstSet = DescriptorSet;
+		DescriptorWrites[2].dstBinding = 5;
+		DescriptorWrites[2].dstArrayElement = 0;
+		DescriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		DescriptorWrites[2].descriptorCount = 1;
+		DescriptorWrites[2].pBufferInfo = nullptr;
+		DescriptorWrites[2].pImageInfo = &OrmImageInfo;
+		DescriptorWrites[2].pTexelBufferView = nullptr;
+
+		vkUpdateDescriptorSets(
+			m_Device, 
+			static_cast<uint32_t>(DescriptorWrites.size()), 
+			DescriptorWrites.data(),
+			0, 
+			nullptr
+		);
 	}
+}
+
+/** App Helper */void App::RecordDrawingCommandBuffer(
+	uint32_t CurrentFrame,
+	uint32_t ImageIndex
+)
+{
+	FrameContext & Context = m_FrameContexts[CurrentFrame];
+	VkFramebuffer Framebuffer = m_SwapChainInfo.SwapChainFramebuffers[ImageIndex];
+
+	/** The frame fence has been waited on, nothing recorded from these pools is still executing */
+	vkResetCommandPool(m_Device, Context.CommandPool, 0);
+
+	for (auto & SecondaryCommandPool : Context.SecondaryCommandPools)
+	{
+		vkResetCommandPool(m_Device, SecondaryCommandPool, 0);
+	}
+
+	BuildDrawCommands();
+
+	uint32_t TaskCount = GetRecordingTaskCount(m_DrawCommands.size());
+
+	RecordSecondaryCommandBuffers(Context, Framebuffer, m_DrawCommands, TaskCount);
+
+	VkCommandBufferBeginInfo CmdBufferBeginInfo = {};
+	CmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	CmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	CmdBufferBeginInfo.pInheritanceInfo = nullptr;
+
+	if (vkBeginCommandBuffer(Context.CommandBuffer, &CmdBufferBeginInfo) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to begin recording command buffer!");
+	}
+
+	/** The secondaries write the timestamps, queries can only be reset outside the render pass */
+	if (Context.TimestampQueryPool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(Context.CommandBuffer, Context.TimestampQueryPool, 0, 3);
+		Context.bTimestampsWritten = true;
+	}
+
+	VkRenderPassBeginInfo PassBeginInfo = {};
+	PassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	PassBeginInfo.renderPass = m_RenderPass;
+	PassBeginInfo.framebuffer = Framebuffer;
+	PassBeginInfo.renderArea.offset = { 0, 0 };
+	PassBeginInfo.renderArea.extent = m_SwapChainInfo.SwapChainExtent;
+
+	std::array<VkClearValue, 2> ClearColors = {};
+	ClearColors[0].color = { 0.1f, 0.2f, 0.3f, 1.0f };
+	ClearColors[1].depthStencil = { 1.0f, 0 };
+
+	PassBeginInfo.clearValueCount = static_cast<uint32_t>(ClearColors.size());
+	PassBeginInfo.pClearValues = ClearColors.data();
+
+	vkCmdBeginRenderPass(Context.CommandBuffer, &PassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+	if (IsDepthPrepassUsed())
+	{
+		vkCmdExecuteCommands(Context.CommandBuffer, TaskCount, Context.DepthCommandBuffers.data());
+	}
+
+	vkCmdExecuteCommands(Context.CommandBuffer, TaskCount, Context.SecondaryCommandBuffers.data());
+
+	vkCmdEndRenderPass(Context.CommandBuffer);
+
+	if (m_bHeadless)
+	{
+		RecordReadback(Context, ImageIndex);
+	}
+
+	if (vkEndCommandBuffer(Context.CommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to record command buffer!");
+	}
+}
+
+/** App Helper */void App::RecordSecondaryCommandBuffers(
+	FrameContext & Context,
+	VkFramebuffer Framebuffer,
+	const std::vector<DrawCommand> & DrawCommands,
+	uint32_t TaskCount
+)
+{
+	VkCommandBufferInheritanceInfo InheritanceInfo = {};
+	InheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	InheritanceInfo.renderPass = m_RenderPass;
+	InheritanceInfo.subpass = 0;
+	InheritanceInfo.framebuffer = Framebuffer;
+
+	VkCommandBufferBeginInfo CmdBufferBeginInfo = {};
+	CmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	CmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	CmdBufferBeginInfo.pInheritanceInfo = &InheritanceInfo;
+
+	VkPipeline Pipeline = m_GraphicsPipelines[m_GraphicsPipelineDisplayMode | m_GraphicsPipelineCullMode];
+	VkPipeline DepthPipeline = m_DepthPipelines[m_GraphicsPipelineCullMode];
+	const bool bDepthPrepass = IsDepthPrepassUsed();
+
+	VkViewport Viewport = {};
+	Viewport.x = 0.0f;
+	Viewport.y = 0.0f;
+	Viewport.width = static_cast<float>(m_SwapChainInfo.SwapChainExtent.width);
+	Viewport.height = static_cast<float>(m_SwapChainInfo.SwapChainExtent.height);
+	Viewport.minDepth = 0.0f;
+	Viewport.maxDepth = 1.0f;
+
+	VkRect2D Scissor = {};
+	Scissor.offset = { 0, 0 };
+	Scissor.extent = m_SwapChainInfo.SwapChainExtent;
 
-	m_VertexNum = pScene->mMeshes[0]->mNumVertices;
-	m_FacetNum = pScene->mMeshes[0]->mNumFaces;
+	size_t DrawsPerTask = (DrawCommands.size() + TaskCount - 1) / TaskCount;
 
-	m_Vertices.clear();
-	m_Indices.clear();
+	/** Every stream lives in the one vertex buffer */
+	std::vector<VkBuffer> VertexBuffers(m_VertexStreamOffsets.size(), m_VertexBuffer.Buffer);
 
-	m_Vertices.reserve(m_VertexNum);
-	m_Indices.reserve(m_FacetNum * 3);
+	/** Query 0 is the frame start, 1 the end of the depth prepass and 2 the frame end */
+	VkQueryPool TimestampQueryPool = Context.TimestampQueryPool;
 
-	for (uint32_t i = 0; i < m_VertexNum; i++)
+	auto RecordDepthTask = [&](uint32_t TaskIndex, size_t First, size_t Last)
 	{
-		Vertex Vertex = {};
-
-		Vertex.Position.x = pScene->mMeshes[0]->mVertices[i].x;
-		Vertex.Position.y = pScene->mMeshes[0]->mVertices[i].y;
-		Vertex.Position.z = pScene->mMeshes[0]->mVertices[i].z;
-
-		Vertex.Color = { 1.0f, 1.0f, 1.0f };
+		VkCommandBuffer CommandBuffer = Context.DepthCommandBuffers[TaskIndex];
 
-		if (pScene->mMeshes[0]->HasNormals())
+		if (vkBeginCommandBuffer(CommandBuffer, &CmdBufferBeginInfo) != VK_SUCCESS)
 		{
-			Vertex.Normal.x = pScene->mMeshes[0]->mNormals[i].x;
-			Vertex.Normal.y = pScene->mMeshes[0]->mNormals[i].y;
-			Vertex.Normal.z = pScene->mMeshes[0]->mNormals[i].z;
+			throw std::runtime_error("Failed to begin recording command buffer!");
 		}
 
-		if (pScene->mMeshes[0]->HasTangentsAndBitangents())
+		if (TimestampQueryPool != VK_NULL_HANDLE && TaskIndex == 0)
 		{
-			Vertex.Tangent.x = pScene->mMeshes[0]->mTangents[i].x;
-			Vertex.Tangent.y = pScene->mMeshes[0]->mTangents[i].y;
-			Vertex.Tangent.z = pScene->mMeshes[0]->mTangents[i].z;
+			vkCmdWriteTimestamp(CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, TimestampQueryPool, 0);
 		}
 
-		if (pScene->mMeshes[0]->HasTextureCoords(0))
+		vkCmdBindPipeline(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, DepthPipeline);
+		vkCmdSetViewport(CommandBuffer, 0, 1, &Viewport);
+		vkCmdSetScissor(CommandBuffer, 0, 1, &Scissor);
+
+		/** Only the position stream is fetched */
+		vkCmdBindVertexBuffers(CommandBuffer, 0, 1, VertexBuffers.data(), m_VertexStreamOffsets.data());
+		vkCmdBindIndexBuffer(CommandBuffer, m_IndexBuffer.Buffer, 0, m_IndexType);
+
+		/** The transforms are the same in every material set, one bind serves all draws */
+		if (First < Last)
 		{
-			Vertex.TexCoord.x = pScene->mMeshes[0]->mTextureCoords[0][i].x;
-			Vertex.TexCoord.y = pScene->mMeshes[0]->mTextureCoords[0][i].y;
+			vkCmdBindDescriptorSets(
+				CommandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				m_PipelineLayout,
+				0,
+				1,
+				&Context.DescriptorSets[DrawCommands[First].MaterialIndex],
+				static_cast<uint32_t>(Context.DynamicOffsets.size()),
+				Context.DynamicOffsets.data()
+			);
 		}
 
-		m_Vertices.push_back(Vertex);
-	}
+		uint32_t BoundInstance = UINT32_MAX;
 
-	for (uint32_t i = 0; i < m_FacetNum; i++)
-	{
-		m_Indices.push_back(pScene->mMeshes[0]->mFaces[i].mIndices[0]);
-		m_Indices.push_back(pScene->mMeshes[0]->mFaces[i].mIndices[1]);
-		m_Indices.push_back(pScene->mMeshes[0]->mFaces[i].mIndices[2]);
-	}
-}
+		for (size_t i = First; i < Last; i++)
+		{
+			const DrawCommand & Draw = DrawCommands[i];
 
-/** Vulkan Init */void App::CreateVertexBuffer()
-{
-	VkDeviceSize BufferSize = sizeof(m_Vertices[0]) * m_Vertices.size();
+			if (Draw.InstanceIndex != BoundInstance)
+			{
+				vkCmdPushConstants(
+					CommandBuffer,
+					m_PipelineLayout,
+					VK_SHADER_STAGE_VERTEX_BIT,
+					0,
+					sizeof(InstancePushConstants),
+					&m_InstanceTransforms[Draw.InstanceIndex]
+				);
+				BoundInstance = Draw.InstanceIndex;
+			}
 
-	BufferInfo StagingBuffer;
+			vkCmdDrawIndexed(CommandBuffer, Draw.IndexCount, 1, Draw.FirstIndex, Draw.VertexOffset, 0);
+		}
 
-	CreateBuffer(
-		m_PhysicalDevice,
-		m_Device,
-		BufferSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		StagingBuffer
-	);
+		if (vkEndCommandBuffer(CommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record command buffer!");
+		}
+	};
 
-	MapMemory(m_Device, StagingBuffer.Memory, BufferSize, m_Vertices.data());
+	auto RecordTask = [&](uint32_t TaskIndex)
+	{
+		size_t First = std::min(DrawCommands.size(), TaskIndex * DrawsPerTask);
+		size_t Last = std::min(DrawCommands.size(), First + DrawsPerTask);
 
-	CreateBuffer(
-		m_PhysicalDevice,
-		m_Device,
-		BufferSize,
-		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_VertexBuffer
-	);
+		if (bDepthPrepass)
+		{
+			RecordDepthTask(TaskIndex, First, Last);
+		}
 
-	CopyBuffer(m_Device, m_CommandPool, m_GraphicsQueue, StagingBuffer, m_VertexBuffer, BufferSize);
+		VkCommandBuffer CommandBuffer = Context.SecondaryCommandBuffers[TaskIndex];
 
-	DestroyBuffer(m_Device, StagingBuffer);
-}
+		if (vkBeginCommandBuffer(CommandBuffer, &CmdBufferBeginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin recording command buffer!");
+		}
 
-/** Vulkan Init */void App::CreateIndexBuffer()
-{
-	VkDeviceSize BufferSize = sizeof(m_Indices[0]) * m_Indices.size();
+		/** Without a prepass its time is the gap between two back to back timestamps */
+		if (TimestampQueryPool != VK_NULL_HANDLE && TaskIndex == 0)
+		{
+			if (!bDepthPrepass)
+			{
+				vkCmdWriteTimestamp(CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, TimestampQueryPool, 0);
+			}
+			vkCmdWriteTimestamp(CommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, TimestampQueryPool, 1);
+		}
 
-	BufferInfo StagingBuffer;
+		/** Nothing is inherited from the primary, every secondary binds its own state */
+		vkCmdBindPipeline(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline);
+		vkCmdSetViewport(CommandBuffer, 0, 1, &Viewport);
+		vkCmdSetScissor(CommandBuffer, 0, 1, &Scissor);
 
-	CreateBuffer(
-		m_PhysicalDevice,
-		m_Device,
-		BufferSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		StagingBuffer
-	);
+		vkCmdBindVertexBuffers(
+			CommandBuffer, 
+			0, 
+			static_cast<uint32_t>(VertexBuffers.size()), 
+			VertexBuffers.data(), 
+			m_VertexStreamOffsets.data()
+		);
+		vkCmdBindIndexBuffer(CommandBuffer, m_IndexBuffer.Buffer, 0, m_IndexType);
 
-	MapMemory(m_Device, StagingBuffer.Memory, BufferSize, m_Indices.data());
+		/** The draws are sorted by material, so sets and transforms are only rebound when they change */
+		uint32_t BoundMaterial = UINT32_MAX;
+		uint32_t BoundInstance = UINT32_MAX;
 
-	CreateBuffer(
-		m_PhysicalDevice,
-		m_Device,
-		BufferSize,
-		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_IndexBuffer
-	);
+		for (size_t i = First; i < Last; i++)
+		{
+			const DrawCommand & Draw = DrawCommands[i];
 
-	CopyBuffer(m_Device, m_CommandPool, m_GraphicsQueue, StagingBuffer, m_IndexBuffer, BufferSize);
+			if (Draw.MaterialIndex != BoundMaterial)
+			{
+				vkCmdBindDescriptorSets(
+					CommandBuffer, 
+					VK_PIPELINE_BIND_POINT_GRAPHICS, 
+					m_PipelineLayout, 
+					0, 
+					1, 
+					&Context.DescriptorSets[Draw.MaterialIndex],
+					static_cast<uint32_t>(Context.DynamicOffsets.size()), 
+					Context.DynamicOffsets.data()
+				);
+				BoundMaterial = Draw.MaterialIndex;
+			}
 
-	DestroyBuffer(m_Device, StagingBuffer);
-}
+			if (Draw.InstanceIndex != BoundInstance)
+			{
+				vkCmdPushConstants(
+					CommandBuffer,
+					m_PipelineLayout,
+					VK_SHADER_STAGE_VERTEX_BIT,
+					0,
+					sizeof(InstancePushConstants),
+					&m_InstanceTransforms[Draw.InstanceIndex]
+				);
+				BoundInstance = Draw.InstanceIndex;
+			}
 
-/** Vulkan Init */void App::CreateMvpUniformBuffer()
-{
-	VkDeviceSize BufferSize = sizeof(MvpUniformBufferObject);
+			vkCmdDrawIndexed(CommandBuffer, Draw.IndexCount, 1, Draw.FirstIndex, Draw.VertexOffset, 0);
+		}
+
+		if (TimestampQueryPool != VK_NULL_HANDLE && TaskIndex == TaskCount - 1)
+		{
+			vkCmdWriteTimestamp(CommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, TimestampQueryPool, 2);
+		}
 
-	m_MvpUniformBuffers.resize(m_SwapChainInfo.SwapChainImages.size());
+		if (vkEndCommandBuffer(CommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record command buffer!");
+		}
+	};
 
-	for (size_t i = 0; i < m_SwapChainInfo.BufferCount(); i++)
+	/** A single task is recorded in place, the hand-off to a worker would only add latency */
+	if (TaskCount == 1)
 	{
-		CreateBuffer(
-			m_PhysicalDevice,
-			m_Device,
-			BufferSize,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			m_MvpUniformBuffers[i]
-		);
+		RecordTask(0);
+	}
+	else
+	{
+		m_ThreadPool.ParallelFor(TaskCount, RecordTask);
 	}
 }
 
-/** Vulkan Init */void App::CreateLightUniformBuffer()
+/** App Helper */bool App::IsDepthPrepassUsed() const
 {
-	VkDeviceSize BufferSize = sizeof(LightUniformBufferObject);
-
-	m_LightUniformBuffers.resize(m_SwapChainInfo.BufferCount());
-
-	for (size_t i = 0; i < m_SwapChainInfo.BufferCount(); i++)
-	{
-		CreateBuffer(
-			m_PhysicalDevice,
-			m_Device,
-			BufferSize,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			m_LightUniformBuffers[i]
-		);
-	}
+	return m_bDepthPrepassEnabled && m_GraphicsPipelineDisplayMode == GRAPHICS_PIPELINE_TYPE_FILL;
 }
 
-void App::CreateMaterialUniformBuffer()
+/** App Helper */void App::ReadTimestamps(
+	FrameContext & Context
+)
 {
-	VkDeviceSize BufferSize = sizeof(MaterialUniformBufferObject);
+	if (!Context.bTimestampsWritten)
+	{
+		return;
+	}
 
-	m_MaterialUniformBuffers.resize(m_SwapChainInfo.BufferCount());
+	Context.bTimestampsWritten = false;
 
-	for (size_t i = 0; i < m_SwapChainInfo.BufferCount(); i++)
+	/** The frame fence has signaled, the results are available without waiting */
+	std::array<uint64_t, 3> Timestamps = {};
+	if (vkGetQueryPoolResults(
+		m_Device,
+		Context.TimestampQueryPool,
+		0,
+		static_cast<uint32_t>(Timestamps.size()),
+		sizeof(Timestamps),
+		Timestamps.data(),
+		sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT
+	) != VK_SUCCESS)
 	{
-		CreateBuffer(
-			m_PhysicalDevice,
-			m_Device,
-			BufferSize,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			m_MaterialUniformBuffers[i]
-		);
+		return;
 	}
+
+	auto ToMilliseconds = [this](uint64_t Begin, uint64_t End)
+	{
+		return static_cast<double>((End - Begin) & m_TimestampMask) * m_TimestampPeriod / 1e6;
+	};
+
+	m_DepthPassGpuMillisecondsSum += ToMilliseconds(Timestamps[0], Timestamps[1]);
+	m_ColorPassGpuMillisecondsSum += ToMilliseconds(Timestamps[1], Timestamps[2]);
+	m_GpuTimedFrameCount++;
 }
 
-/** Vulkan Init */void App::CreateDescriptorPool()
+/** App Helper */void App::RecordReadback(
+	FrameContext & Context,
+	uint32_t ImageIndex
+)
 {
-	std::array<VkDescriptorPoolSize, 8> PoolSizes = {};
-	
-	PoolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	PoolSizes[0].descriptorCount = static_cast<uint32_t>(m_SwapChainInfo.BufferCount());
-	
-	PoolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	PoolSizes[1].descriptorCount = static_cast<uint32_t>(m_SwapChainInfo.BufferCount());
+	/** The render pass left the target in TRANSFER_SRC_OPTIMAL */
+	VkBufferImageCopy Region = {};
+	Region.bufferOffset = 0;
+	Region.bufferRowLength = 0;
+	Region.bufferImageHeight = 0;
+	Region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	Region.imageSubresource.mipLevel = 0;
+	Region.imageSubresource.baseArrayLayer = 0;
+	Region.imageSubresource.layerCount = 1;
+	Region.imageOffset = { 0, 0, 0 };
+	Region.imageExtent = { m_SwapChainInfo.SwapChainExtent.width, m_SwapChainInfo.SwapChainExtent.height, 1 };
+
+	vkCmdCopyImageToBuffer(
+		Context.CommandBuffer,
+		m_SwapChainInfo.SwapChainImages[ImageIndex],
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		Context.ReadbackBuffer.Buffer,
+		1,
+		&Region
+	);
 
-	PoolSizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	PoolSizes[2].descriptorCount = static_cast<uint32_t>(m_SwapChainInfo.BufferCount());
+	VkBufferMemoryBarrier Barrier = {};
+	Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	Barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.buffer = Context.ReadbackBuffer.Buffer;
+	Barrier.offset = 0;
+	Barrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(
+		Context.CommandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT,
+		0,
+		0, nullptr,
+		1, &Barrier,
+		0, nullptr
+	);
+}
 
-	PoolSizes[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	PoolSizes[3].descriptorCount = static_cast<uint32_t>(m_SwapChainInfo.BufferCount());
+/** App Helper */void App::WriteReadback(
+	FrameContext & Context
+)
+{
+	if (Context.ReadbackFrame < 0)
+	{
+		return;
+	}
 
-	PoolSizes[4].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	PoolSizes[4].descriptorCount = static_cast<uint32_t>(m_SwapChainInfo.BufferCount());
+	uint32_t Width = m_SwapChainInfo.SwapChainExtent.width;
+	uint32_t Height = m_SwapChainInfo.SwapChainExtent.height;
 
-	PoolSizes[5].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	PoolSizes[5].descriptorCount = static_cast<uint32_t>(m_SwapChainInfo.BufferCount());
+	/** Copy out so the buffer can be reused by the next frame while the worker encodes */
+	const uint8_t * pMapped = static_cast<const uint8_t *>(Context.ReadbackBuffer.Allocation.pMappedData);
+	std::vector<uint8_t> Pixels(pMapped, pMapped + static_cast<size_t>(Width) * Height * 4);
 
-	PoolSizes[6].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	PoolSizes[6].descriptorCount = static_cast<uint32_t>(m_SwapChainInfo.BufferCount());
+	std::string Filename = m_HeadlessSettings.OutputPrefix + std::to_string(Context.ReadbackFrame) + ".ppm";
+	Context.ReadbackFrame = -1;
 
-	PoolSizes[7].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	PoolSizes[7].descriptorCount = static_cast<uint32_t>(m_SwapChainInfo.BufferCount());
+	m_PendingFrameWrites.push_back(m_ThreadPool.Submit([Filename, Pixels = std::move(Pixels), Width, Height]()
+	{
+		if (!WritePpm(Filename, Pixels.data(), Width, Height))
+		{
+			throw std::runtime_error("Failed to write " + Filename + "!");
+		}
+	}));
+}
 
-	VkDescriptorPoolCreateInfo PoolCreateInfo = {};
-	PoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	PoolCreateInfo.poolSizeCount = static_cast<uint32_t>(PoolSizes.size());
-	PoolCreateInfo.pPoolSizes = PoolSizes.data();
-	PoolCreateInfo.maxSets = static_cast<uint32_t>(m_SwapChainInfo.BufferCount());
+/** App Helper */uint32_t App::GetRecordingTaskCount(
+	size_t DrawCount
+) const
+{
+	size_t TaskCount = (DrawCount + m_MinDrawsPerRecordingTask - 1) / m_MinDrawsPerRecordingTask;
+	return static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(TaskCount, m_ThreadPool.GetThreadCount())));
+}
 
-	if (vkCreateDescriptorPool(m_Device, &PoolCreateInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+/** App Helper */void App::RunRecordingBenchmark()
+{
+	if (m_DrawCommands.empty())
 	{
-		throw std::runtime_error("Failed to create descriptor pool!");
+		return;
 	}
-}
 
-/** Vulkan Init */void App::CreateDescriptorSets()
-{
-	std::vector<VkDescriptorSetLayout> Layouts(m_SwapChainInfo.BufferCount(), m_DescriptorSetLayout);
-	VkDescriptorSetAllocateInfo AllocInfo = {};
-	AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	AllocInfo.descriptorPool = m_DescriptorPool;
-	AllocInfo.descriptorSetCount = static_cast<uint32_t>(m_SwapChainInfo.BufferCount());
-	AllocInfo.pSetLayouts = Layouts.data();
+	/** The benchmark records into the pools of the first frame context */
+	vkDeviceWaitIdle(m_Device);
 
-	m_DescriptorSets.resize(m_SwapChainInfo.BufferCount());
-	if (vkAllocateDescriptorSets(m_Device, &AllocInfo, m_DescriptorSets.data()) != VK_SUCCESS)
+	FrameContext & Context = m_FrameContexts[0];
+	VkFramebuffer Framebuffer = m_SwapChainInfo.SwapChainFramebuffers[0];
+	const uint32_t ThreadCount = m_ThreadPool.GetThreadCount();
+	const uint32_t IterationCount = 16;
+
+	std::vector<uint32_t> TaskCounts;
+	for (uint32_t TaskCount = 1; TaskCount < ThreadCount; TaskCount *= 2)
 	{
-		throw std::runtime_error("Failed to allocate descriptor sets!");
+		TaskCounts.push_back(TaskCount);
 	}
+	TaskCounts.push_back(ThreadCount);
 
-	for (size_t i = 0; i < m_SwapChainInfo.BufferCount(); i++)
+	std::cout << "Command recording benchmark, average CPU time of " << IterationCount << " iterations" << std::endl;
+
+	for (uint32_t DrawCount : { 1u, 100u, 1000u, 10000u, 100000u })
 	{
-		VkDescriptorBufferInfo MvpBufferInfo = 
-			m_MvpUniformBuffers[i].GetDescriptorBufferInfo<MvpUniformBufferObject>();
-		VkDescriptorBufferInfo LightBufferInfo = 
-			m_LightUniformBuffers[i].GetDescriptorBufferInfo<LightUniformBufferObject>();
-		VkDescriptorBufferInfo MaterialBufferInfo = 
-			m_MaterialUniformBuffers[i].GetDescriptorBufferInfo<MaterialUniformBufferObject>();
-		VkDescriptorImageInfo AlbedoImageInfo = m_AlbedoTexture.GetDescriptorImageInfo();
-		VkDescriptorImageInfo NormalImageInfo = m_NormalTexture.GetDescriptorImageInfo();
-		VkDescriptorImageInfo MetallicImageInfo = m_MetallicTexture.GetDescriptorImageInfo();
-		VkDescriptorImageInfo RoughnessImageInfo = m_RoughnessTexture.GetDescriptorImageInfo();
-		VkDescriptorImageInfo AoImageInfo = m_AoTexture.GetDescriptorImageInfo();
-
-		std::array<VkWriteDescriptorSet, 8> DescriptorWrites = {};
-		
-		DescriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		DescriptorWrites[0].dstSet = m_DescriptorSets[i];
-		DescriptorWrites[0].dstBinding = 0;
-		DescriptorWrites[0].dstArrayElement = 0;
-		DescriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		DescriptorWrites[0].descriptorCount = 1;
-		DescriptorWrites[0].pBufferInfo = &MvpBufferInfo;
-		DescriptorWrites[0].pImageInfo = nullptr;
-		DescriptorWrites[0].pTexelBufferView = nullptr;
+		/** Every draw repeats the first one, the GPU never executes them */
+		std::vector<DrawCommand> DrawCommands(DrawCount, m_DrawCommands[0]);
 
-		DescriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		DescriptorWrites[1].dstSet = m_DescriptorSets[i];
-		DescriptorWrites[1].dstBinding = 1;
-		DescriptorWrites[1].dstArrayElement = 0;
-		DescriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		DescriptorWrites[1].descriptorCount = 1;
-		DescriptorWrites[1].pBufferInfo = &LightBufferInfo;
-		DescriptorWrites[1].pImageInfo = nullptr;
-		DescriptorWrites[1].pTexelBufferView = nullptr;
+		for (uint32_t TaskCount : TaskCounts)
+		{
+			double Milliseconds = 0.0;
 
-		DescriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		DescriptorWrites[2].dstSet = m_DescriptorSets[i];
-		DescriptorWrites[2].dstBinding = 2;
-		DescriptorWrites[2].dstArrayElement = 0;
-		DescriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		DescriptorWrites[2].descriptorCount = 1;
-		DescriptorWrites[2].pBufferInfo = &MaterialBufferInfo;
-		DescriptorWrites[2].pImageInfo = nullptr;
-		DescriptorWrites[2].pTexelBufferView = nullptr;
+			for (uint32_t i = 0; i < IterationCount; i++)
+			{
+				for (auto & SecondaryCommandPool : Context.SecondaryCommandPools)
+				{
+					vkResetCommandPool(m_Device, SecondaryCommandPool, 0);
+				}
 
-		DescriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		DescriptorWrites[3].dstSet = m_DescriptorSets[i];
-		DescriptorWrites[3].dstBinding = 3;
-		DescriptorWrites[3].dstArrayElement = 0;
-		DescriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		DescriptorWrites[3].descriptorCount = 1;
-		DescriptorWrites[3].pBufferInfo = nullptr;
-		DescriptorWrites[3].pImageInfo = &AlbedoImageInfo;
-		DescriptorWrites[3].pTexelBufferView = nullptr;
-
-		DescriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		DescriptorWrites[4].dstSet = m_DescriptorSets[i];
-		DescriptorWrites[4].dstBinding = 4;
-		DescriptorWrites[4].dstArrayElement = 0;
-		DescriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		DescriptorWrites[4].descriptorCount = 1;
-		DescriptorWrites[4].pBufferInfo = nullptr;
-		DescriptorWrites[4].pImageInfo = &NormalImageInfo;
-		DescriptorWrites[4].pTexelBufferView = nullptr;
-
-		DescriptorWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		DescriptorWrites[5].dstSet = m_DescriptorSets[i];
-		DescriptorWrites[5].dstBinding = 5;
-		DescriptorWrites[5].dstArrayElement = 0;
-		DescriptorWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		DescriptorWrites[5].descriptorCount = 1;
-		DescriptorWrites[5].pBufferInfo = nullptr;
-		DescriptorWrites[5].pImageInfo = &MetallicImageInfo;
-		DescriptorWrites[5].pTexelBufferView = nullptr;
-
-		DescriptorWrites[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		DescriptorWrites[6].dstSet = m_DescriptorSets[i];
-		DescriptorWrites[6].dstBinding = 6;
-		DescriptorWrites[6].dstArrayElement = 0;
-		DescriptorWrites[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		DescriptorWrites[6].descriptorCount = 1;
-		DescriptorWrites[6].pBufferInfo = nullptr;
-		DescriptorWrites[6].pImageInfo = &RoughnessImageInfo;
-		DescriptorWrites[6].pTexelBufferView = nullptr;
-
-		DescriptorWrites[7].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		DescriptorWrites[7].dstSet = m_DescriptorSets[i];
-		DescriptorWrites[7].dstBinding = 7;
-		DescriptorWrites[7].dstArrayElement = 0;
-		DescriptorWrites[7].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		DescriptorWrites[7].descriptorCount = 1;
-		DescriptorWrites[7].pBufferInfo = nullptr;
-		DescriptorWrites[7].pImageInfo = &AoImageInfo;
-		DescriptorWrites[7].pTexelBufferView = nullptr;
+				auto StartTime = std::chrono::high_resolution_clock::now();
 
-		vkUpdateDescriptorSets(
-			m_Device, 
-			static_cast<uint32_t>(DescriptorWrites.size()), 
-			DescriptorWrites.data(),
-			0, 
-			nullptr
-		);
+				RecordSecondaryCommandBuffers(Context, Framebuffer, DrawCommands, TaskCount);
+
+				Milliseconds += std::chrono::duration<double, std::chrono::milliseconds::period>(
+					std::chrono::high_resolution_clock::now() - StartTime
+					).count();
+			}
+
+			std::cout << "Draws: " << DrawCount << " Threads: " << TaskCount << " Record: "
+				<< Milliseconds / IterationCount << " ms" << std::endl;
+		}
 	}
 }
 
-/** Vulkan Init */void App::CreateDrawingCommandBuffers()
+/** App Helper */void App::RunUniformBenchmark()
 {
-	m_DrawingCommandBuffers.resize(m_SwapChainInfo.BufferCount());
+	/** The ring buffer regions of the frames in flight are overwritten */
+	vkDeviceWaitIdle(m_Device);
 
-	VkCommandBufferAllocateInfo CmdBufferAllocInfo = {};
-	CmdBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	CmdBufferAllocInfo.commandPool = m_CommandPool;
-	CmdBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	CmdBufferAllocInfo.commandBufferCount = static_cast<uint32_t>(m_DrawingCommandBuffers.size());
+	const uint32_t FrameCount = 10000;
+	const VkDeviceSize Sizes[3] = { sizeof(MvpUniformBufferObject), sizeof(LightUniformBufferObject), sizeof(MaterialUniformBufferObject) };
 
-	if (vkAllocateCommandBuffers(m_Device, &CmdBufferAllocInfo, m_DrawingCommandBuffers.data()) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to allocate command buffers!");
-	}
+	MvpUniformBufferObject Mvp = {};
+	LightUniformBufferObject Light = {};
+	MaterialUniformBufferObject Material = {};
+	const void * pSources[3] = { &Mvp, &Light, &Material };
 
-	for (size_t i = 0; i < m_DrawingCommandBuffers.size(); i++)
+	/** The old path: every block in a buffer with its own VkDeviceMemory, mapped and unmapped on every write */
+	VkBuffer Buffers[3] = {};
+	VkDeviceMemory Memories[3] = {};
+
+	for (uint32_t i = 0; i < 3; i++)
 	{
-		VkCommandBufferBeginInfo CmdBufferBeginInfo = {};
-		CmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		CmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-		CmdBufferBeginInfo.pInheritanceInfo = nullptr;
+		VkBufferCreateInfo BufferInfo = {};
+		BufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		BufferInfo.size = Sizes[i];
+		BufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		BufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		if (vkBeginCommandBuffer(m_DrawingCommandBuffers[i], &CmdBufferBeginInfo) != VK_SUCCESS)
+		if (vkCreateBuffer(m_Device, &BufferInfo, nullptr, &Buffers[i]) != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed to begin recording command buffer!");
+			throw std::runtime_error("Failed to create uniform buffer!");
 		}
 
-		VkRenderPassBeginInfo PassBeginInfo = {};
-		PassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		PassBeginInfo.renderPass = m_RenderPass;
-		PassBeginInfo.framebuffer = m_SwapChainInfo.SwapChainFramebuffers[i];
-		PassBeginInfo.renderArea.offset = { 0, 0 };
-		PassBeginInfo.renderArea.extent = m_SwapChainInfo.SwapChainExtent;
+		VkMemoryRequirements MemoryRequirements;
+		vkGetBufferMemoryRequirements(m_Device, Buffers[i], &MemoryRequirements);
 
-		std::array<VkClearValue, 2> ClearColors = {};
-		ClearColors[0].color = { 0.1f, 0.2f, 0.3f, 1.0f };
-		ClearColors[1].depthStencil = { 1.0f, 0 };
+		VkMemoryAllocateInfo AllocInfo = {};
+		AllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		AllocInfo.allocationSize = MemoryRequirements.size;
+		AllocInfo.memoryTypeIndex = FindMemoryType(
+			m_PhysicalDevice,
+			MemoryRequirements.memoryTypeBits,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
 
-		PassBeginInfo.clearValueCount = static_cast<uint32_t>(ClearColors.size());
-		PassBeginInfo.pClearValues = ClearColors.data();
+		if (vkAllocateMemory(m_Device, &AllocInfo, nullptr, &Memories[i]) != VK_SUCCESS ||
+			vkBindBufferMemory(m_Device, Buffers[i], Memories[i], 0) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate uniform buffer memory!");
+		}
+	}
 
-		vkCmdBeginRenderPass(m_DrawingCommandBuffers[i], &PassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	auto StartTime = std::chrono::high_resolution_clock::now();
 
-		vkCmdBindPipeline(
-			m_DrawingCommandBuffers[i], 
-			VK_PIPELINE_BIND_POINT_GRAPHICS, 
-			m_GraphicsPipelines[m_GraphicsPipelineDisplayMode | m_GraphicsPipelineCullMode]
-		);
+	for (uint32_t Frame = 0; Frame < FrameCount; Frame++)
+	{
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			void * pData = nullptr;
+			vkMapMemory(m_Device, Memories[i], 0, Sizes[i], 0, &pData);
+			memcpy(pData, pSources[i], static_cast<size_t>(Sizes[i]));
+			vkUnmapMemory(m_Device, Memories[i]);
+		}
+	}
 
-		VkBuffer VertexBuffers[] = { m_VertexBuffer.Buffer };
-		VkDeviceSize Offsets[] = { 0 };
-		vkCmdBindVertexBuffers(m_DrawingCommandBuffers[i], 0, 1, VertexBuffers, Offsets);
-		vkCmdBindIndexBuffer(m_DrawingCommandBuffers[i], m_IndexBuffer.Buffer, 0, VK_INDEX_TYPE_UINT32);
-		vkCmdBindDescriptorSets(
-			m_DrawingCommandBuffers[i], 
-			VK_PIPELINE_BIND_POINT_GRAPHICS, 
-			m_PipelineLayout, 
-			0, 
-			1, 
-			&m_DescriptorSets[i],
-			0, 
-			nullptr
-		);
+	double MapMilliseconds = std::chrono::duration<double, std::chrono::milliseconds::period>(
+		std::chrono::high_resolution_clock::now() - StartTime
+		).count();
 
-		vkCmdDrawIndexed(m_DrawingCommandBuffers[i], static_cast<uint32_t>(m_Indices.size()), 1, 0, 0, 0);
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		vkDestroyBuffer(m_Device, Buffers[i], nullptr);
+		vkFreeMemory(m_Device, Memories[i], nullptr);
+	}
 
-		vkCmdEndRenderPass(m_DrawingCommandBuffers[i]);
+	StartTime = std::chrono::high_resolution_clock::now();
 
-		if (vkEndCommandBuffer(m_DrawingCommandBuffers[i]) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to record command buffer!");
-		}
+	for (uint32_t Frame = 0; Frame < FrameCount; Frame++)
+	{
+		FrameUniforms Uniforms = AllocateFrameUniforms(Frame % m_MaxFramesInFlights);
+		*Uniforms.pMvp = Mvp;
+		*Uniforms.pLight = Light;
+		*Uniforms.pMaterial = Material;
 	}
+
+	double RingMilliseconds = std::chrono::duration<double, std::chrono::milliseconds::period>(
+		std::chrono::high_resolution_clock::now() - StartTime
+		).count();
+
+	std::cout << "Uniform update benchmark, CPU time per frame of " << FrameCount << " frames: map/memcpy/unmap "
+		<< MapMilliseconds * 1000.0 / FrameCount << " us, ring buffer " << RingMilliseconds * 1000.0 / FrameCount << " us" << std::endl;
 }
 
 /** Vulkan Init */void App::CreateSyncObjects()
@@ -1872,7 +3108,6 @@ void App::CreateMaterialUniformBuffer()
 		pApp->m_Camera.Reset();
 		pApp->m_GraphicsPipelineDisplayMode = GRAPHICS_PIPELINE_TYPE_FILL;
 		pApp->m_GraphicsPipelineCullMode = GRAPHICS_PIPELINE_TYPE_NONE_CULL;
-		pApp->RecreateDrawingCommandBuffer();
 	}
 
 	/** [D] : Change display mode */
@@ -1893,7 +3128,6 @@ void App::CreateMaterialUniformBuffer()
 			pApp->m_GraphicsPipelineDisplayMode = GRAPHICS_PIPELINE_TYPE_FILL;
 			break;
 		}
-		pApp->RecreateDrawingCommandBuffer();
 	}
 
 	/** [C] : Change cull mode */
@@ -1914,8 +3148,85 @@ void App::CreateMaterialUniformBuffer()
 			pApp->m_GraphicsPipelineCullMode = GRAPHICS_PIPELINE_TYPE_NONE_CULL;
 			break;
 		}
-		pApp->RecreateDrawingCommandBuffer();
 	}
+
+	/** [L] : Toggle the level of detail selection */
+	if (Key == GLFW_KEY_L && Action == GLFW_RELEASE)
+	{
+		pApp->m_bLodEnabled = !pApp->m_bLodEnabled;
+	}
+
+	/** [M] : Toggle the meshlet culling */
+	if (Key == GLFW_KEY_M && Action == GLFW_RELEASE)
+	{
+		pApp->m_bMeshletCullingEnabled = !pApp->m_bMeshletCullingEnabled;
+	}
+
+	/** [Z] : Toggle the depth prepass */
+	if (Key == GLFW_KEY_Z && Action == GLFW_RELEASE)
+	{
+		pApp->m_bDepthPrepassEnabled = !pApp->m_bDepthPrepassEnabled;
+	}
+
+	/** [B] : Benchmark command recording */
+	if (Key == GLFW_KEY_B && Action == GLFW_RELEASE)
+	{
+		pApp->RunRecordingBenchmark();
+	}
+
+	/** [U] : Benchmark the uniform updates */
+	if (Key == GLFW_KEY_U && Action == GLFW_RELEASE)
+	{
+		pApp->RunUniformBenchmark();
+	}
+
+	/** [R] : Print the residency of the streamed textures */
+	if (Key == GLFW_KEY_R && Action == GLFW_RELEASE && pApp->IsTextureStreamingUsed())
+	{
+		pApp->m_TextureStreamer.PrintResidency(std::cout);
+	}
+
+	/** [-] / [=] : Halve / double the texture streaming budget */
+	if ((Key == GLFW_KEY_MINUS || Key == GLFW_KEY_EQUAL) && Action == GLFW_RELEASE && pApp->IsTextureStreamingUsed())
+	{
+		VkDeviceSize Budget = pApp->m_TextureStreamer.GetStatistics().BudgetBytes;
+		Budget = Key == GLFW_KEY_MINUS ? std::max<VkDeviceSize>(Budget / 2, 1) : Budget * 2;
+
+		pApp->m_TextureStreamer.SetBudget(Budget);
+		std::cout << "Texture streaming budget: " << Budget / 1024 / 1024 << " MB" << std::endl;
+	}
+}
+
+/** Helper */bool App::WritePpm(
+	const std::string & Filename,
+	const uint8_t * pPixels,
+	uint32_t Width,
+	uint32_t Height
+)
+{
+	std::ofstream File(Filename, std::ios::binary | std::ios::trunc);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	File << "P6\n" << Width << " " << Height << "\n255\n";
+
+	std::vector<char> Row(static_cast<size_t>(Width) * 3);
+	for (uint32_t y = 0; y < Height; y++)
+	{
+		const uint8_t * pRow = pPixels + static_cast<size_t>(y) * Width * 4;
+		for (uint32_t x = 0; x < Width; x++)
+		{
+			Row[x * 3 + 0] = static_cast<char>(pRow[x * 4 + 0]);
+			Row[x * 3 + 1] = static_cast<char>(pRow[x * 4 + 1]);
+			Row[x * 3 + 2] = static_cast<char>(pRow[x * 4 + 2]);
+		}
+		File.write(Row.data(), Row.size());
+	}
+
+	File.close();
+	return !File.fail();
 }
 
 /** Helper */std::vector<char> App::ReadFile(
@@ -1935,59 +3246,4 @@ void App::CreateMaterialUniformBuffer()
 	return Buffer;
 }
 
-size_t App::VertexHash::operator()(const Vertex & Rhs) const
-{
-	return ((std::hash<glm::vec3>()(Rhs.Position) ^
-		(std::hash<glm::vec3>()(Rhs.Color) << 1)) >> 1) ^
-		(std::hash<glm::vec2>()(Rhs.TexCoord) << 1);
-}
-
-bool App::VertexEqual::operator()(const Vertex & Lhs, const Vertex & Rhs) const
-{
-	return Lhs.Position == Rhs.Position && 
-		Lhs.Color == Rhs.Color && 
-		Lhs.TexCoord == Rhs.TexCoord;
-}
-
-VkVertexInputBindingDescription App::Vertex::GetBindingDescription()
-{
-	VkVertexInputBindingDescription BindingDescription = {};
-	BindingDescription.binding = 0;
-	BindingDescription.stride = sizeof(Vertex);
-	BindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-	return BindingDescription;
-}
-
-std::array<VkVertexInputAttributeDescription, 5> App::Vertex::GetAttributeDescription()
-{
-	std::array<VkVertexInputAttributeDescription, 5> AttributeDescriptions = {};
-
-	AttributeDescriptions[0].binding = 0;
-	AttributeDescriptions[0].location = 0;
-	AttributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-	AttributeDescriptions[0].offset = offsetof(Vertex, Position);
-
-	AttributeDescriptions[1].binding = 0;
-	AttributeDescriptions[1].location = 1;
-	AttributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-	AttributeDescriptions[1].offset = offsetof(Vertex, Color);
-
-	AttributeDescriptions[2].binding = 0;
-	AttributeDescriptions[2].location = 2;
-	AttributeDescriptions[2].format = VK_FORMAT_R32G32B32_SFLOAT;
-	AttributeDescriptions[2].offset = offsetof(Vertex, Normal);
-
-	AttributeDescriptions[3].binding = 0;
-	AttributeDescriptions[3].location = 3;
-	AttributeDescriptions[3].format = VK_FORMAT_R32G32_SFLOAT;
-	AttributeDescriptions[3].offset = offsetof(Vertex, Tangent);
-
-	AttributeDescriptions[4].binding = 0;
-	AttributeDescriptions[4].location = 4;
-	AttributeDescriptions[4].format = VK_FORMAT_R32G32_SFLOAT;
-	AttributeDescriptions[4].offset = offsetof(Vertex, TexCoord);
-
-	return AttributeDescriptions;
-}
-
 NAMESPACE_END
\ No newline at end of file
@@ -25,11 +25,30 @@
 #include <vector>
 #include <array>
 #include <optional>
+#include <map>
 #include <unordered_map>
+#include <future>
 
 #include "Namespace.hpp"
 #include "Camera.hpp"
 #include "VulkanHelper.hpp"
+#include "UniformRingBuffer.hpp"
+#include "UploadContext.hpp"
+#include "ThreadPool.hpp"
+#include "MeshCache.hpp"
+#include "PipelineCache.hpp"
+#include "VertexFormat.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshletBuilder.hpp"
+#include "TangentGenerator.hpp"
+#include "VertexWelder.hpp"
+#include "ObjParser.hpp"
+#include "BcEncoder.hpp"
+#include "TextureProcessing.hpp"
+#include "TextureStreamer.hpp"
+#include "Scene.hpp"
+#include "MeshImporter.hpp"
+#include "DrawList.hpp"
 
 //TODO :
 //    1. Update the vertex/index buffer while the app is running.
@@ -39,7 +58,6 @@
 //    5. PBR material.
 //    6. Use environment map.
 //    7. Implement IBR.
-//    8. Pipeline cached.
 
 NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
 
@@ -47,28 +65,82 @@ NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
 class App
 {
 public:
+	/** A run without window, surface or swap chain, e.g. on CI machines with a software device. */
+	struct HeadlessSettings
+	{
+		uint32_t Width = WINDOW_INIT_WIDTH;
+		uint32_t Height = WINDOW_INIT_HEIGH;
+		uint32_t FrameCount = 1;
+		/** Frame i is written to <OutputPrefix><i>.ppm */
+		std::string OutputPrefix = "Frame";
+		/** Compare the vertex fetch of both layouts by rendering the same frames with each */
+		VertexLayout Layout = VERTEX_LAYOUT_SPLIT_POSITIONS;
+		bool bDepthPrepass = false;
+	};
+
 	void Run();
 
+	/** Render Settings.FrameCount frames offscreen, write each of them to disk and return. */
+	void RunHeadless(
+		const HeadlessSettings & Settings
+	);
+
 protected:
 	/** App */void InitWindow();
 	/** App */void InitVulkan();
 	/** App */void MainLoop();
+	/** App */void HeadlessLoop();
 	/** App */void Draw();
 	/** App */void Destroy();
 
 protected:
 	/** App Helper */void UpdateUniformBuffer(
-		uint32_t CurrentImage
+		uint32_t CurrentFrame
 	);
 
+	/** Record the whole frame from the current state into the command buffer of the frame context. */
+	/** App Helper */void RecordDrawingCommandBuffer(
+		uint32_t CurrentFrame,
+		uint32_t ImageIndex
+	);
+
+	/** App Helper */uint32_t GetRecordingTaskCount(
+		size_t DrawCount
+	) const;
+
+	/** Record growing draw lists with growing thread counts and print the CPU time. Bound to [B]. */
+	/** App Helper */void RunRecordingBenchmark();
+
+	/** Time writing the frame uniforms with map/memcpy/unmap of one allocation per block against the ring buffer. Bound to [U]. */
+	/** App Helper */void RunUniformBenchmark();
+
 	/** Recreate the swapchain and all the objects depend on it. Called when resizing. */
 	/** App Helper */void RecreateSwapChainAndRelevantObject();
 
-	/** Destroy the objects that are to be recreated in the RecreateSwapChain(). Called when resizing. */
+	/** Destroy the swapchain, its attachments and the pipelines. Called when exiting. */
 	/** App Helper */void DestroySwapChainAndRelevantObject();
 
-	/** Recreate the drawing command buffer. Called when display mode or cull mode is changed. */
-	/** App Helper */void RecreateDrawingCommandBuffer();
+	/** Destroy the objects that depend on the swapchain images and extent, but not the swapchain itself. */
+	/** App Helper */void DestroySwapChainResources(
+		SwapChainInfo & Info
+	);
+
+	/**
+	* Move the swapchain dependent objects to m_RetiredSwapChains, the swapchain handle is kept
+	* in m_SwapChainInfo so CreateSwapChain can pass it as oldSwapchain.
+	*/
+	/** App Helper */void RetireSwapChain();
+
+	/** Called once the fence of the frame has been waited on, destroy the retired swapchains no frame in flight uses anymore. */
+	/** App Helper */void ReleaseRetiredSwapChains(
+		size_t Frame
+	);
+
+	/** Destroy the render pass, pipeline layout and pipelines. Only needed if the format or sample count changes. */
+	/** App Helper */void DestroyGraphicsPipelines();
+
+	/** The swap chain extension is not needed in headless mode. */
+	/** App Helper */std::vector<const char *> GetDeviceExtensions() const;
 
 protected:
 	/** Vulkan Init */void CreateInstance();
@@ -81,8 +153,13 @@ protected:
 
 	/** Vulkan Init */void CreateLogicalDevice();
 
+	/** Vulkan Init */void CreatePipelineCache();
+
 	/** Vulkan Init */void CreateSwapChain();
 
+	/** Headless replacement of the swap chain, one color target per frame in flight. */
+	/** Vulkan Init */void CreateOffscreenTargets();
+
 	/** Vulkan Init */void CreateSwapChainImageViews();
 
 	/** Vulkan Init */void CreateRenderPass();
@@ -91,7 +168,7 @@ protected:
 
 	/** Vulkan Init */void CreateGraphicsPipeline();
 
-	/** Vulkan Init */void CreateCommandPool();
+	/** Vulkan Init */void CreateFrameContexts();
 
 	/** Vulkan Init */void CreateColorResource();
 
@@ -103,22 +180,21 @@ protected:
 
 	/** Vulkan Init */void LoadObjModel();
 
+	/** The baked version of a texture if it exists, Filename otherwise */
+	/** App Helper */std::string GetBakedTextureFilename(
+		const std::string & Filename
+	) const;
+
 	/** Vulkan Init */void CreateVertexBuffer();
 
 	/** Vulkan Init */void CreateIndexBuffer();
 
-	/** Vulkan Init */void CreateMvpUniformBuffer();
-
-	/** Vulkan Init */void CreateLightUniformBuffer();
-
-	/** Vulkan Init */void CreateMaterialUniformBuffer();
+	/** Vulkan Init */void CreateUniformRingBuffer();
 
 	/** Vulkan Init */void CreateDescriptorPool();
 
 	/** Vulkan Init */void CreateDescriptorSets();
 
-	/** Vulkan Init */void CreateDrawingCommandBuffers();
-
 	/** Vulkan Init */void CreateSyncObjects();
 
 protected:
@@ -166,6 +242,14 @@ protected:
 		const std::string & Filename
 	);
 
+	/** Write tightly packed RGBA8 pixels as a binary PPM, alpha is dropped. */
+	/** Helper */static bool WritePpm(
+		const std::string & Filename,
+		const uint8_t * pPixels,
+		uint32_t Width,
+		uint32_t Height
+	);
+
 protected: /** App */
 	GLFWwindow * m_pWindow = nullptr;
 	uint32_t m_InitWidth = WINDOW_INIT_WIDTH;
@@ -176,6 +260,23 @@ protected: /** App */
 	std::string m_GpuName = "";
 	bool m_bFramebufferResized = false;
 	double m_FPS = 0.0f;
+	/** Average CPU time spent recording the frame command buffer, updated with the title */
+	double m_RecordMilliseconds = 0.0;
+	double m_RecordMillisecondsSum = 0.0;
+	/** Headless only, GPU time of the depth prepass and of the color pass summed over m_GpuTimedFrameCount frames */
+	double m_DepthPassGpuMillisecondsSum = 0.0;
+	double m_ColorPassGpuMillisecondsSum = 0.0;
+	uint32_t m_GpuTimedFrameCount = 0;
+	/** Nanoseconds per timestamp tick, zero if the graphics queue can not write timestamps */
+	float m_TimestampPeriod = 0.0f;
+	uint64_t m_TimestampMask = 0;
+	/** Workers for asset loading and command recording, one per hardware thread */
+	ThreadPool m_ThreadPool;
+
+	bool m_bHeadless = false;
+	HeadlessSettings m_HeadlessSettings;
+	/** Frames handed to the workers to be written to disk */
+	std::vector<std::future<void>> m_PendingFrameWrites;
 
 protected: /** Vulkan pipeline */
 #ifdef NDEBUG
@@ -195,6 +296,7 @@ protected: /** Vulkan pipeline */
 
 	const std::string m_VertexShaderPath = "Shaders/Shader.vert.spv";
 	const std::string m_FragmentShaderPath = "Shaders/Shader.frag.spv";
+	const std::string m_DepthVertexShaderPath = "Shaders/Depth.vert.spv";
 
 	VkDebugUtilsMessengerEXT m_DebugMessenger = VK_NULL_HANDLE;
 	VkSurfaceKHR m_Surface = VK_NULL_HANDLE;
@@ -207,9 +309,37 @@ protected: /** Vulkan pipeline */
 	/** Device queues are implicitly destroyed when the device is destroyed */
 	VkQueue m_GraphicsQueue = VK_NULL_HANDLE;
 	VkQueue m_PresentQueue = VK_NULL_HANDLE;
+	/** Only valid if the device exposes a transfer only family and it is enabled */
+	VkQueue m_TransferQueue = VK_NULL_HANDLE;
+	const bool m_bUseDedicatedTransferQueue = true;
+
+	/** Must be destroyed after every buffer and image but before the device */
+	MemoryAllocator m_MemoryAllocator;
+
+	/** Must be destroyed before the memory allocator */
+	UploadContext m_UploadContext;
+	const VkDeviceSize m_UploadStagingSize = 64ull * 1024 * 1024;
+
+	/** Saved on exit, the driver header inside is validated before it is reused */
+	PipelineCache m_PipelineCache;
+	const std::string m_PipelineCachePath = "PipelineCache.bin";
 
 	SwapChainInfo m_SwapChainInfo;
 
+	/** A swapchain replaced on resize together with its views, attachments and framebuffers */
+	struct RetiredSwapChain
+	{
+		SwapChainInfo Info;
+		/** One per frame in flight, set if the frame was submitted before the swapchain was replaced */
+		std::vector<bool> PendingFrames;
+	};
+
+	/** Destroyed once the fences of the frames still using them have signaled, no device wide wait on resize */
+	std::vector<RetiredSwapChain> m_RetiredSwapChains;
+
+	/** Batch with the layout transitions of the recreated attachments, waited on by the first frame using them */
+	UploadTicket m_SwapChainUploadTicket = 0;
+
 	VkRenderPass m_RenderPass = VK_NULL_HANDLE;
 	VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
 
@@ -239,57 +369,157 @@ protected: /** Vulkan pipeline */
 	};
 
 	std::unordered_map<int, VkPipeline> m_GraphicsPipelines;
+	/** Position only, no color writes, keyed by cull mode */
+	std::unordered_map<int, VkPipeline> m_DepthPipelines;
+	/** Lay down the depth of every draw first so the color pass shades each pixel once, fill mode only */
+	bool m_bDepthPrepassEnabled = false;
+	/** The attachment format and sample count the render pass and pipelines were built for */
+	VkFormat m_GraphicsPipelinesFormat = VK_FORMAT_UNDEFINED;
+	VkSampleCountFlagBits m_GraphicsPipelinesSamples = VK_SAMPLE_COUNT_1_BIT;
 	int m_GraphicsPipelineDisplayMode = GRAPHICS_PIPELINE_TYPE_FILL;
 	int m_GraphicsPipelineCullMode = GRAPHICS_PIPELINE_TYPE_NONE_CULL;
 
-	VkCommandPool m_CommandPool = VK_NULL_HANDLE;
-	/** Command buffers will be automatically freed when their command pool is destroyed. */
-	std::vector<VkCommandBuffer> m_DrawingCommandBuffers;
-
 	const int m_MaxFramesInFlights = 2;
+
+	/** Everything a frame in flight owns while the GPU may still be reading it */
+	struct FrameContext
+	{
+		/** Transient pool, reset as a whole once the frame fence has been waited on */
+		VkCommandPool CommandPool = VK_NULL_HANDLE;
+		/** Command buffers will be automatically freed when their command pool is destroyed. */
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		/** One pool per recording task, a pool is never used by two workers at once */
+		std::vector<VkCommandPool> SecondaryCommandPools;
+		std::vector<VkCommandBuffer> SecondaryCommandBuffers;
+		/** Depth prepass of each recording task, allocated from the same pool as its color pass */
+		std::vector<VkCommandBuffer> DepthCommandBuffers;
+		/** Offsets of this frame's blocks in the uniform ring buffer */
+		std::array<uint32_t, 3> DynamicOffsets = {};
+		/** Headless only, the resolved color target is copied here at the end of the frame */
+		BufferInfo ReadbackBuffer;
+		/** Index of the frame in ReadbackBuffer once the fence signals, -1 if none */
+		int64_t ReadbackFrame = -1;
+		/** Headless only, GPU timestamps of the frame start, the end of the depth prepass and the frame end */
+		VkQueryPool TimestampQueryPool = VK_NULL_HANDLE;
+		bool bTimestampsWritten = false;
+		/** One per material, rewritten when the streamer swaps a texture while the other frames still use the old one */
+		std::vector<VkDescriptorSet> DescriptorSets;
+		/** Streamer generation the texture bindings of DescriptorSets were written at */
+		uint64_t TextureGeneration = 0;
+	};
+
+	std::vector<FrameContext> m_FrameContexts;
+
+	/** The swap chain images are owned by the swap chain, offscreen targets are ours */
+	std::vector<MemoryAllocation> m_OffscreenTargetAllocations;
+
+	/** Headless only, copy the resolved color target of the frame into its readback buffer. */
+	/** App Helper */void RecordReadback(
+		FrameContext & Context,
+		uint32_t ImageIndex
+	);
+
+	/** Headless only, add the GPU time of the last frame rendered with the frame context to the pass sums. */
+	/** App Helper */void ReadTimestamps(
+		FrameContext & Context
+	);
+
+	/** Headless only, hand the pixels read back by the frame context to a worker that writes them to disk. */
+	/** App Helper */void WriteReadback(
+		FrameContext & Context
+	);
+
+	/** Below this many draws per task handing the work to a worker costs more than it saves */
+	const uint32_t m_MinDrawsPerRecordingTask = 256;
 	std::vector<VkSemaphore> m_ImageAvailableSemaphores;
 	std::vector<VkSemaphore> m_RenderFinishedSemaphores;
 	std::vector<VkFence> m_InFlightFences;
 	size_t m_CurrentFrame = 0;
 
 protected: /** Mesh */
-	struct Vertex
-	{
-		glm::vec3 Position;
-		glm::vec3 Color;
-		glm::vec3 Normal;
-		glm::vec3 Tangent;
-		glm::vec2 TexCoord;
-
-		static VkVertexInputBindingDescription GetBindingDescription();
-		static std::array<VkVertexInputAttributeDescription, 5> GetAttributeDescription();
-	};
+	std::string m_ModelPath = "Models/Cerberus.obj";
+	/** Also what the AssetBaker bakes with, see GetMeshImportSettingsHash */
+	const MeshImportSettings m_MeshImportSettings;
+	/** Written next to the model, rebuilt whenever the model or the import settings change */
+	const std::string m_ModelCachePath = m_ModelPath + ".meshcache";
+	/** Written by the AssetBaker tool, models and textures found there are loaded instead of their sources */
+	const std::string m_BakedAssetDirectory = "Baked";
+	/** CPU side, the vertices are packed into m_VertexFormat when the vertex buffer is created */
+	MeshScene m_Scene;
 
-	struct VertexHash
-	{
-		size_t operator()(const Vertex & Rhs) const;
-	};
+	size_t m_VertexNum = 0;
+	/** Of the full detail meshes */
+	size_t m_FacetNum = 0;
+	/** Triangles drawn in the last recorded frame, after the level of detail selection and culling */
+	size_t m_DrawnFacetNum = 0;
 
-	struct VertexEqual
-	{
-		bool operator()(const Vertex & Lhs, const Vertex & Rhs) const;
-	};
+	/** Largest projected error, in pixels, the selection accepts */
+	float m_LodErrorThreshold = 1.0f;
+	bool m_bLodEnabled = true;
 
-	const std::string m_ModelPath = "Models/Cerberus.obj";
-	std::vector<Vertex> m_Vertices;
-	std::vector<uint32_t> m_Indices;
+	/** Indexed like m_InstanceTransforms */
+	std::vector<InstanceBounds> m_InstanceBounds;
+	/** Instances sorted by material, walking them in this order keeps the draws sorted without a per frame sort */
+	std::vector<uint32_t> m_InstanceOrder;
 
-	size_t m_VertexNum = 0;
-	size_t m_FacetNum = 0;
+	/** Build the per instance transforms and bounds of the loaded scene. */
+	/** App Helper */void BuildInstances();
+
+	/** Meshlets outside the frustum are skipped, and with back face culling those facing away too */
+	bool m_bMeshletCullingEnabled = true;
+
+	/** Of the last BuildDrawCommands */
+	CullingStatistics m_CullingStatistics;
+
+	/** Rebuilt every frame, one draw per run of visible meshlets in the selected level of every instance, sorted by material */
+	std::vector<DrawCommand> m_DrawCommands;
+
+	/** Pick the level of detail of every instance from its projected error, cull its meshlets and build the draw list. */
+	/** App Helper */void BuildDrawCommands();
 
+	/** Split the draws across TaskCount secondary command buffers of the frame context, recorded on the workers. */
+	/** App Helper */void RecordSecondaryCommandBuffers(
+		FrameContext & Context,
+		VkFramebuffer Framebuffer,
+		const std::vector<DrawCommand> & DrawCommands,
+		uint32_t TaskCount
+	);
+
+	/** The prepass only pays off when every pixel is shaded, so it is skipped in wireframe and point mode */
+	/** App Helper */bool IsDepthPrepassUsed() const;
+
+	/** Every stream of m_VertexFormat, one after another */
 	BufferInfo m_VertexBuffer;
+	/** Where stream i starts in m_VertexBuffer, bound to binding i */
+	std::vector<VkDeviceSize> m_VertexStreamOffsets;
 	BufferInfo m_IndexBuffer;
+	/** UINT16 whenever every sub-mesh fits, decided by CreateIndexBuffer */
+	VkIndexType m_IndexType = VK_INDEX_TYPE_UINT32;
+
+	/** Octahedral snorm16 normals/tangents, half UVs and unorm16 positions: 24 instead of 56 bytes, 8 of them for positions */
+	VertexFormat m_VertexFormat = {};
+	/** Indexed like m_Scene.Meshes, every mesh is quantized to its own bounds */
+	std::vector<VertexDequantization> m_MeshDequantizations;
 
 protected: /** UBO */
-	struct MvpUniformBufferObject
+	/**
+	* Per instance, pushed between draws. 128 bytes is the smallest push constant size an implementation may
+	* have, so the shader derives the normal matrix from Model instead of getting it pushed.
+	*/
+	struct InstancePushConstants
 	{
 		alignas(16) glm::mat4 Model;
-		alignas(16) glm::mat4 ModelInvTranspose;
+		/** Dequantization of the mesh of the instance, see VertexDequantization */
+		alignas(16) glm::vec4 PositionScale;
+		alignas(16) glm::vec4 PositionOffset;
+		alignas(16) glm::vec4 TexCoordScaleOffset;
+	};
+
+	/** Indexed by DrawCommand::InstanceIndex */
+	std::vector<InstancePushConstants> m_InstanceTransforms;
+
+	struct MvpUniformBufferObject
+	{
 		alignas(16) glm::mat4 View;
 		alignas(16) glm::mat4 Projection;
 	};
@@ -310,14 +540,33 @@ protected: /** UBO */
 		alignas(4) float Ao;
 	};
 
+	/** Where this frame's uniform blocks were written and their dynamic offsets (binding 0, 1, 2). */
+	struct FrameUniforms
+	{
+		MvpUniformBufferObject * pMvp = nullptr;
+		LightUniformBufferObject * pLight = nullptr;
+		MaterialUniformBufferObject * pMaterial = nullptr;
+		std::array<uint32_t, 3> DynamicOffsets = {};
+	};
+
+	/**
+	* Bump allocate this frame's uniform blocks from the ring buffer. The allocation order
+	* is fixed, so the offsets for a given frame in flight are the same every frame.
+	*/
+	/** App Helper */FrameUniforms AllocateFrameUniforms(
+		uint32_t CurrentFrame
+	);
+
 	VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
-	std::vector<BufferInfo> m_MvpUniformBuffers;
-	std::vector<BufferInfo> m_LightUniformBuffers;
-	std::vector<BufferInfo> m_MaterialUniformBuffers;
+	UniformRingBuffer m_UniformRingBuffer;
 
+	/** Descriptor sets are freed automatically when the pool is destroyed */
 	VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
-	/** Descriptor sets will be automatically freed when the descriptor pool is destroyed. */
-	std::vector<VkDescriptorSet> m_DescriptorSets;
+
+	/** Write the texture bindings of the frame context's descriptor sets from the current TextureInfos. */
+	/** App Helper */void UpdateTextureDescriptors(
+		FrameContext & Context
+	);
 
 protected: /** Texture */
 	const std::string m_AlbedoTexturePath = "Textures/Cerberus/Cerberus_A.png";
@@ -327,13 +576,60 @@ protected: /** Texture */
 	TextureInfo m_NormalTexture;
 
 	const std::string m_MetallicTexturePath = "Textures/Cerberus/Cerberus_M.png";
-	TextureInfo m_MetallicTexture;
-
 	const std::string m_RoughnessTexturePath = "Textures/Cerberus/Cerberus_R.png";
-	TextureInfo m_RoughnessTexture;
-
 	const std::string m_AoTexturePath = "Textures/Cerberus/Cerberus_AO.png";
-	TextureInfo m_AoTexture;
+	/** Occlusion, roughness and metallic of the three maps above packed into R, G and B, one fetch in the shader */
+	TextureInfo m_OrmTexture;
+
+	/** Block compress textures on import, BC7 for color and ORM, BC5 for normals */
+	const bool m_bTextureCompressionEnabled = true;
+	const BcQuality m_TextureCompressionQuality = BC_QUALITY_NORMAL;
+	/** Set when the device was created with textureCompressionBC */
+	bool m_bTextureCompressionSupported = false;
+	/** Set when the instance was created with VK_KHR_get_physical_device_properties2 */
+	bool m_bPhysicalDeviceProperties2Supported = false;
+	/** Set when the device was created with VK_EXT_memory_budget, the streamer then follows the driver's budget */
+	bool m_bMemoryBudgetSupported = false;
+
+	/** Textures referenced by the material table, keyed by path. Slots without an existing file use the ones above. */
+	std::unordered_map<std::string, TextureInfo> m_SceneTextures;
+	/** Packed from the metallic, roughness and AO slots of the materials, keyed by their paths */
+	std::map<OrmFilenames, TextureInfo> m_SceneOrmTextures;
+
+	/** Albedo or normal map of a material */
+	/** App Helper */const TextureInfo & GetMaterialTexture(
+		uint32_t MaterialIndex,
+		SceneTextureSlot Slot
+	) const;
+
+	/** App Helper */const TextureInfo & GetMaterialOrmTexture(
+		uint32_t MaterialIndex
+	) const;
+
+	/** Occlusion, roughness and metallic texture paths of a material, in ORM order */
+	/** App Helper */OrmFilenames GetMaterialOrmFilenames(
+		uint32_t MaterialIndex
+	) const;
+
+	/** The baked ORM texture of the maps if it exists, empty otherwise so the maps are packed on load */
+	/** App Helper */std::string GetBakedOrmFilename(
+		const OrmFilenames & Filenames
+	) const;
+
+	/** Baked DDS textures start with their smallest levels and stream the rest as the screen needs them */
+	const bool m_bTextureStreamingEnabled = true;
+	TextureStreamingSettings m_TextureStreamingSettings;
+	TextureStreamer m_TextureStreamer;
+	/** Largest number of screen pixels a UV unit of each material covered in the last BuildDrawCommands */
+	std::vector<float> m_MaterialPixelsPerUv;
+
+	/** Headless runs render a fixed number of frames and load every texture fully */
+	/** App Helper */bool IsTextureStreamingUsed() const;
+
+	/** Report the resolution each material was drawn at, move the streamer one step and refresh the frame's descriptors. */
+	/** App Helper */void UpdateTextureStreaming(
+		uint32_t CurrentFrame
+	);
 
 protected: /** Camera */
 	Camera m_Camera;
@@ -0,0 +1,743 @@
+#include "AssetBaker.hpp"
+#include "TextureProcessing.hpp"
+#include "DdsFile.hpp"
+#include "MappedFile.hpp"
+#include "Hash.hpp"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+const char * s_BakeManifestFilename = "BakeManifest.txt";
+const char * s_BakeManifestHeader = "VkRendererBake 1";
+/** Bump whenever a baked format changes, every output is rebuilt */
+const uint64_t s_BakerVersion = 1;
+/** Size recorded for a dependency that did not exist, it is up to date as long as it still does not */
+const uint64_t s_MissingSize = ~0ull;
+
+enum BakeAssetType
+{
+	BAKE_ASSET_NONE = 0,
+	BAKE_ASSET_MESH = 1,
+	BAKE_ASSET_TEXTURE = 2
+};
+
+struct BakeDependency
+{
+	std::string Filename;
+	uint64_t Size = s_MissingSize;
+	int64_t WriteTime = 0;
+	uint64_t Hash = 0;
+};
+
+/** What an output was built from, it is up to date if the current record of its source is equal */
+struct BakeRecord
+{
+	uint64_t SettingsHash = 0;
+	std::vector<BakeDependency> Dependencies;
+};
+
+/** Keyed by the baked filename */
+using BakeManifest = std::map<std::string, BakeRecord>;
+
+struct BakeJob
+{
+	std::string SourceFilename;
+	std::string BakedFilename;
+	BakeAssetType Type = BAKE_ASSET_NONE;
+	TextureContent Content = TEXTURE_CONTENT_COLOR;
+	/** ORM only: the maps it is packed from, SourceFilename just names them */
+	OrmFilenames ChannelFilenames;
+	BakeRecord Record;
+	bool bDirty = false;
+	bool bFailed = false;
+};
+
+std::string GetLowerExtension(
+	const std::filesystem::path & Path
+)
+{
+	std::string Extension = Path.extension().string();
+	std::transform(Extension.begin(), Extension.end(), Extension.begin(), [](char Char) { return static_cast<char>(std::tolower(Char)); });
+	return Extension;
+}
+
+/** Models are anything ImportScene reads, textures anything stb_image decodes */
+BakeAssetType GetBakeAssetType(
+	const std::filesystem::path & Path
+)
+{
+	const std::string Extension = GetLowerExtension(Path);
+
+	for (const char * pExtension : { ".obj", ".fbx", ".gltf", ".glb", ".dae", ".3ds", ".ply" })
+	{
+		if (Extension == pExtension)
+		{
+			return BAKE_ASSET_MESH;
+		}
+	}
+
+	for (const char * pExtension : { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".psd", ".hdr" })
+	{
+		if (Extension == pExtension)
+		{
+			return BAKE_ASSET_TEXTURE;
+		}
+	}
+
+	return BAKE_ASSET_NONE;
+}
+
+std::string GetLowerStem(
+	const std::filesystem::path & Path
+)
+{
+	std::string Stem = Path.stem().string();
+	std::transform(Stem.begin(), Stem.end(), Stem.begin(), [](char Char) { return static_cast<char>(std::tolower(Char)); });
+	return Stem;
+}
+
+/** Length of the first of the suffixes the stem ends with, 0 if none */
+size_t FindSuffix(
+	const std::string & Stem,
+	std::initializer_list<const char *> Suffixes
+)
+{
+	for (const char * pSuffix : Suffixes)
+	{
+		const size_t Length = strlen(pSuffix);
+		if (Stem.size() > Length && Stem.compare(Stem.size() - Length, Length, pSuffix) == 0)
+		{
+			return Length;
+		}
+	}
+
+	return 0;
+}
+
+/** Cerberus_AO.png is the occlusion of Textures/Cerberus/Cerberus, false for anything but an ORM map */
+bool GetOrmChannel(
+	const std::filesystem::path & Path,
+	OrmChannel & Channel,
+	std::string & Prefix
+)
+{
+	const std::string Stem = GetLowerStem(Path);
+
+	const std::initializer_list<const char *> Suffixes[ORM_CHANNEL_COUNT] =
+	{
+		{ "_ao", "_occlusion" },
+		{ "_r", "_roughness" },
+		{ "_m", "_metallic", "_metalness" }
+	};
+
+	for (uint32_t i = 0; i < ORM_CHANNEL_COUNT; i++)
+	{
+		const size_t Length = FindSuffix(Stem, Suffixes[i]);
+		if (Length > 0)
+		{
+			Channel = static_cast<OrmChannel>(i);
+			Prefix = (Path.parent_path() / Path.stem().string().substr(0, Stem.size() - Length)).generic_string();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** The mtllib statements of an OBJ, resolved against its directory like LoadObjMaterials does */
+void CollectObjLibraries(
+	const std::string & Filename,
+	std::vector<std::string> & Libraries
+)
+{
+	MappedFile File;
+	if (!File.Open(Filename) || File.GetSize() == 0)
+	{
+		return;
+	}
+
+	const std::filesystem::path BaseDirectory = std::filesystem::path(Filename).parent_path();
+	const char * pData = reinterpret_cast<const char *>(File.GetData());
+	const char * pEnd = pData + File.GetSize();
+
+	for (const char * pLine = pData; pLine < pEnd;)
+	{
+		const char * pLineEnd = std::find(pLine, pEnd, '\n');
+
+		while (pLine < pLineEnd && (*pLine == ' ' || *pLine == '\t'))
+		{
+			pLine++;
+		}
+
+		if (pLineEnd - pLine > 7 && strncmp(pLine, "mtllib", 6) == 0 && (pLine[6] == ' ' || pLine[6] == '\t'))
+		{
+			const char * pName = pLine + 7;
+			const char * pNameEnd = pLineEnd;
+
+			while (pName < pNameEnd && (*pName == ' ' || *pName == '\t'))
+			{
+				pName++;
+			}
+			while (pNameEnd > pName && isspace(static_cast<unsigned char>(pNameEnd[-1])))
+			{
+				pNameEnd--;
+			}
+
+			if (pName < pNameEnd)
+			{
+				Libraries.push_back((BaseDirectory / std::string(pName, pNameEnd)).generic_string());
+			}
+		}
+
+		pLine = pLineEnd + 1;
+	}
+}
+
+/** Hashes the file unless its size and write time match Previous, whose hash is reused then */
+void FingerprintDependency(
+	const BakeDependency * pPrevious,
+	BakeDependency & Dependency
+)
+{
+	std::error_code Error;
+	const uint64_t Size = std::filesystem::file_size(Dependency.Filename, Error);
+	const int64_t WriteTime = Error ? 0 : static_cast<int64_t>(std::filesystem::last_write_time(Dependency.Filename, Error).time_since_epoch().count());
+
+	if (Error)
+	{
+		Dependency.Size = s_MissingSize;
+		return;
+	}
+
+	Dependency.Size = Size;
+	Dependency.WriteTime = WriteTime;
+
+	if (pPrevious != nullptr && pPrevious->Size == Size && pPrevious->WriteTime == WriteTime)
+	{
+		Dependency.Hash = pPrevious->Hash;
+		return;
+	}
+
+	MappedFile File;
+	Dependency.Hash = File.Open(Dependency.Filename) ? HashBytes(File.GetData(), File.GetSize()) : 0;
+}
+
+/** Write times are only a shortcut around hashing, they do not make a record different */
+bool IsSameRecord(
+	const BakeRecord & A,
+	const BakeRecord & B
+)
+{
+	if (A.SettingsHash != B.SettingsHash || A.Dependencies.size() != B.Dependencies.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < A.Dependencies.size(); i++)
+	{
+		const BakeDependency & DependencyA = A.Dependencies[i];
+		const BakeDependency & DependencyB = B.Dependencies[i];
+
+		if (DependencyA.Filename != DependencyB.Filename || DependencyA.Size != DependencyB.Size || DependencyA.Hash != DependencyB.Hash)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+* Text, one line per output followed by one line per dependency with the filename last:
+*   bake <settings hash> <dependency count> <baked filename>
+*   dep <size> <write time> <hash> <filename>
+* An unreadable or foreign manifest reads as empty, which rebakes everything.
+*/
+void ReadBakeManifest(
+	const std::string & Filename,
+	BakeManifest & Manifest
+)
+{
+	Manifest.clear();
+
+	MappedFile File;
+	if (!File.Open(Filename) || File.GetSize() == 0)
+	{
+		return;
+	}
+
+	std::istringstream Stream(std::string(reinterpret_cast<const char *>(File.GetData()), File.GetSize()));
+	std::string Line;
+
+	if (!std::getline(Stream, Line) || Line != s_BakeManifestHeader)
+	{
+		return;
+	}
+
+	BakeRecord * pRecord = nullptr;
+
+	while (std::getline(Stream, Line))
+	{
+		std::istringstream LineStream(Line);
+		std::string Tag;
+		LineStream >> Tag;
+
+		if (Tag == "bake")
+		{
+			BakeRecord Record;
+			size_t Count = 0;
+			std::string Baked;
+			LineStream >> std::hex >> Record.SettingsHash >> std::dec >> Count >> std::ws;
+			std::getline(LineStream, Baked);
+
+			pRecord = LineStream.fail() || Baked.empty() ? nullptr : &(Manifest[Baked] = Record);
+		}
+		else if (Tag == "dep" && pRecord != nullptr)
+		{
+			BakeDependency Dependency;
+			LineStream >> Dependency.Size >> Dependency.WriteTime >> std::hex >> Dependency.Hash >> std::dec >> std::ws;
+			std::getline(LineStream, Dependency.Filename);
+
+			if (!LineStream.fail() && !Dependency.Filename.empty())
+			{
+				pRecord->Dependencies.push_back(Dependency);
+			}
+		}
+	}
+}
+
+bool WriteBakeManifest(
+	const std::string & Filename,
+	const BakeManifest & Manifest
+)
+{
+	std::ostringstream Stream;
+	Stream << s_BakeManifestHeader << "\n";
+
+	for (const auto & Entry : Manifest)
+	{
+		Stream << "bake " << std::hex << Entry.second.SettingsHash << std::dec << " " << Entry.second.Dependencies.size() << " " << Entry.first << "\n";
+
+		for (const BakeDependency & Dependency : Entry.second.Dependencies)
+		{
+			Stream << "dep " << Dependency.Size << " " << Dependency.WriteTime << " " << std::hex << Dependency.Hash << std::dec << " " << Dependency.Filename << "\n";
+		}
+	}
+
+	const std::string Text = Stream.str();
+	return WriteFileAtomically(Filename, Text.data(), Text.size());
+}
+
+struct TextureBakeResult
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t MipLevels = 0;
+	uint64_t Texels = 0;
+	size_t BakedSize = 0;
+};
+
+/** Decode, mip and encode the whole chain, across Pool if given, throws on failure */
+void BakeTexture(
+	const BakeJob & Job,
+	BcQuality Quality,
+	ThreadPool * pPool,
+	TextureBakeResult & Result
+)
+{
+	std::vector<std::vector<uint8_t>> Levels(1);
+
+	if (Job.Content == TEXTURE_CONTENT_ORM)
+	{
+		if (!GetPackedOrmSize(Job.ChannelFilenames, Result.Width, Result.Height))
+		{
+			throw std::runtime_error("Failed to load texture image!");
+		}
+
+		Levels[0].resize(static_cast<size_t>(Result.Width) * Result.Height * 4);
+		PackOrmTexture(Job.ChannelFilenames, Result.Width, Result.Height, Levels[0].data());
+	}
+	else
+	{
+		int Width = 0, Height = 0, Channels = 0;
+		stbi_uc * pPixels = stbi_load(Job.SourceFilename.c_str(), &Width, &Height, &Channels, STBI_rgb_alpha);
+
+		if (pPixels == nullptr)
+		{
+			throw std::runtime_error("Failed to load texture image!");
+		}
+
+		Result.Width = static_cast<uint32_t>(Width);
+		Result.Height = static_cast<uint32_t>(Height);
+		Levels[0].assign(pPixels, pPixels + static_cast<size_t>(Result.Width) * Result.Height * 4);
+		stbi_image_free(pPixels);
+	}
+
+	Result.MipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(Result.Width, Result.Height)))) + 1;
+	Levels.resize(Result.MipLevels);
+
+	BuildTextureMipChain(Result.Width, Result.Height, Result.MipLevels, Job.Content, Levels);
+
+	BcEncodeSettings Settings;
+	Settings.Format = GetTextureBcFormat(Job.Content);
+	Settings.Quality = Quality;
+
+	std::vector<std::vector<uint8_t>> Blocks(Result.MipLevels);
+
+	for (uint32_t Level = 0; Level < Result.MipLevels; Level++)
+	{
+		const uint32_t LevelWidth = std::max(Result.Width >> Level, 1u);
+		const uint32_t LevelHeight = std::max(Result.Height >> Level, 1u);
+
+		Blocks[Level].resize(GetBcImageSize(Settings.Format, LevelWidth, LevelHeight));
+		EncodeBcImage(Settings, Levels[Level].data(), LevelWidth, LevelHeight, Blocks[Level].data(), pPool);
+
+		/** The RGBA level is not needed anymore, large chains would otherwise be held twice */
+		Levels[Level] = std::vector<uint8_t>();
+
+		Result.Texels += static_cast<uint64_t>(LevelWidth) * LevelHeight;
+		Result.BakedSize += Blocks[Level].size();
+	}
+
+	if (!WriteDds(Job.BakedFilename, GetBcVkFormat(Settings.Format), Result.Width, Result.Height, Blocks))
+	{
+		throw std::runtime_error("Failed to write baked texture!");
+	}
+}
+
+double GetMillisecondsSince(
+	std::chrono::high_resolution_clock::time_point StartTime
+)
+{
+	return std::chrono::duration<double, std::chrono::milliseconds::period>(
+		std::chrono::high_resolution_clock::now() - StartTime
+		).count();
+}
+
+}
+
+std::string GetBakedFilename(
+	const std::string & OutputDirectory,
+	const std::string & Filename
+)
+{
+	std::filesystem::path Path = (std::filesystem::path(OutputDirectory) / std::filesystem::path(Filename).relative_path()).lexically_normal();
+
+	switch (GetBakeAssetType(Path))
+	{
+	case BAKE_ASSET_MESH: return Path.generic_string() + ".meshcache";
+	case BAKE_ASSET_TEXTURE: return Path.replace_extension(".dds").generic_string();
+	default: return std::string();
+	}
+}
+
+std::string GetOrmFilename(
+	const OrmFilenames & Filenames
+)
+{
+	std::string Prefix;
+
+	for (uint32_t i = 0; i < ORM_CHANNEL_COUNT; i++)
+	{
+		if (Filenames[i].empty())
+		{
+			continue;
+		}
+
+		OrmChannel Channel;
+		std::string ChannelPrefix;
+		if (!GetOrmChannel(std::filesystem::path(Filenames[i]).lexically_normal(), Channel, ChannelPrefix) ||
+			Channel != i ||
+			(!Prefix.empty() && Prefix != ChannelPrefix))
+		{
+			return std::string();
+		}
+
+		Prefix = ChannelPrefix;
+	}
+
+	return Prefix.empty() ? std::string() : Prefix + "_ORM.png";
+}
+
+BakeStatistics BakeAssets(
+	const BakeSettings & Settings,
+	const MeshBakeFunction & BakeMesh,
+	ThreadPool & Pool,
+	std::ostream & Log
+)
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	BakeStatistics Statistics;
+
+	const std::filesystem::path SourceDirectory(Settings.SourceDirectory);
+	const std::filesystem::path OutputDirectory(Settings.OutputDirectory);
+
+	std::error_code Error;
+	std::filesystem::create_directories(OutputDirectory, Error);
+
+	if (!std::filesystem::is_directory(SourceDirectory, Error) || !std::filesystem::is_directory(OutputDirectory, Error))
+	{
+		throw std::runtime_error("Failed to open bake directories!");
+	}
+
+	/** Scan, the output directory and hidden directories are not descended into */
+	std::vector<BakeJob> Jobs;
+	/** ORM maps by the prefix they share */
+	std::map<std::string, OrmFilenames> OrmGroups;
+
+	for (auto Iter = std::filesystem::recursive_directory_iterator(SourceDirectory, Error);
+		!Error && Iter != std::filesystem::recursive_directory_iterator();
+		Iter.increment(Error))
+	{
+		const std::filesystem::path & Path = Iter->path();
+
+		if (Iter->is_directory(Error))
+		{
+			if (Path.filename().string()[0] == '.' || std::filesystem::equivalent(Path, OutputDirectory, Error))
+			{
+				Iter.disable_recursion_pending();
+			}
+			continue;
+		}
+
+		BakeJob Job;
+		Job.Type = Iter->is_regular_file(Error) ? GetBakeAssetType(Path) : BAKE_ASSET_NONE;
+
+		if (Job.Type == BAKE_ASSET_NONE)
+		{
+			continue;
+		}
+
+		/** Normalized, "./Models/x.obj" would end up in the material paths of the baked model */
+		Job.SourceFilename = Path.lexically_normal().generic_string();
+
+		OrmChannel Channel;
+		std::string Prefix;
+		if (Job.Type == BAKE_ASSET_TEXTURE && GetOrmChannel(Job.SourceFilename, Channel, Prefix))
+		{
+			OrmGroups[Prefix][Channel] = Job.SourceFilename;
+			continue;
+		}
+
+		Job.BakedFilename = GetBakedFilename(Settings.OutputDirectory, Path.lexically_relative(SourceDirectory).generic_string());
+		Job.Content = FindSuffix(GetLowerStem(Path), { "_n", "_nrm", "_normal" }) > 0 ? TEXTURE_CONTENT_NORMAL : TEXTURE_CONTENT_COLOR;
+		Jobs.push_back(Job);
+	}
+
+	for (const auto & Group : OrmGroups)
+	{
+		BakeJob Job;
+		Job.Type = BAKE_ASSET_TEXTURE;
+		Job.Content = TEXTURE_CONTENT_ORM;
+		Job.ChannelFilenames = Group.second;
+
+		for (const std::string & Filename : Group.second)
+		{
+			Job.SourceFilename += (Job.SourceFilename.empty() ? "" : " + ") + (Filename.empty() ? "none" : Filename);
+		}
+
+		const std::filesystem::path OrmPath(GetOrmFilename(Group.second));
+		Job.BakedFilename = GetBakedFilename(Settings.OutputDirectory, OrmPath.lexically_relative(SourceDirectory.lexically_normal()).generic_string());
+		Jobs.push_back(Job);
+	}
+
+	std::sort(Jobs.begin(), Jobs.end(), [](const BakeJob & A, const BakeJob & B) { return A.SourceFilename < B.SourceFilename; });
+
+	const std::string ManifestFilename = (OutputDirectory / s_BakeManifestFilename).generic_string();
+	BakeManifest Manifest;
+	ReadBakeManifest(ManifestFilename, Manifest);
+
+	/** Fingerprint every job on the pool, only files whose size or write time changed are read */
+	Pool.ParallelFor(static_cast<uint32_t>(Jobs.size()), [&](uint32_t JobIndex)
+	{
+		BakeJob & Job = Jobs[JobIndex];
+
+		std::vector<std::string> Filenames;
+
+		if (Job.Content == TEXTURE_CONTENT_ORM)
+		{
+			std::copy_if(Job.ChannelFilenames.begin(), Job.ChannelFilenames.end(), std::back_inserter(Filenames), [](const std::string & Filename) { return !Filename.empty(); });
+		}
+		else
+		{
+			Filenames.push_back(Job.SourceFilename);
+		}
+
+		if (Job.Type == BAKE_ASSET_MESH)
+		{
+			Job.Record.SettingsHash = HashCombine(s_BakerVersion, Settings.MeshSettingsHash);
+
+			if (GetLowerExtension(Job.SourceFilename) == ".obj")
+			{
+				CollectObjLibraries(Job.SourceFilename, Filenames);
+			}
+		}
+		else
+		{
+			Job.Record.SettingsHash = HashCombine(HashCombine(s_BakerVersion, Settings.TextureQuality), Job.Content);
+		}
+
+		auto Previous = Manifest.find(Job.BakedFilename);
+
+		Job.Record.Dependencies.resize(Filenames.size());
+		for (size_t i = 0; i < Filenames.size(); i++)
+		{
+			const BakeDependency * pPrevious = nullptr;
+			if (Previous != Manifest.end() && i < Previous->second.Dependencies.size() && Previous->second.Dependencies[i].Filename == Filenames[i])
+			{
+				pPrevious = &Previous->second.Dependencies[i];
+			}
+
+			Job.Record.Dependencies[i].Filename = Filenames[i];
+			FingerprintDependency(pPrevious, Job.Record.Dependencies[i]);
+		}
+
+		std::error_code ExistsError;
+		Job.bDirty = Settings.bForce ||
+			Previous == Manifest.end() ||
+			!IsSameRecord(Previous->second, Job.Record) ||
+			!std::filesystem::is_regular_file(Job.BakedFilename, ExistsError);
+	});
+
+	std::vector<BakeJob *> DirtyTextures;
+
+	for (BakeJob & Job : Jobs)
+	{
+		if (!Job.bDirty)
+		{
+			Log << "Up to date " << Job.SourceFilename << std::endl;
+			Statistics.UpToDate++;
+			continue;
+		}
+
+		std::filesystem::create_directories(std::filesystem::path(Job.BakedFilename).parent_path(), Error);
+
+		if (Job.Type == BAKE_ASSET_TEXTURE)
+		{
+			DirtyTextures.push_back(&Job);
+		}
+	}
+
+	std::mutex LogMutex;
+	auto ReportFailure = [&](BakeJob & Job, const char * pMessage)
+	{
+		std::lock_guard<std::mutex> Lock(LogMutex);
+		Log << "Failed to bake " << Job.SourceFilename << ": " << pMessage << std::endl;
+		Job.bFailed = true;
+		Statistics.Failed++;
+	};
+
+	/** Models one after another, each import spreads over the pool by itself */
+	for (BakeJob & Job : Jobs)
+	{
+		if (!Job.bDirty || Job.Type != BAKE_ASSET_MESH)
+		{
+			continue;
+		}
+
+		auto MeshStartTime = std::chrono::high_resolution_clock::now();
+
+		try
+		{
+			BakeMesh(Job.SourceFilename, Job.BakedFilename);
+		}
+		catch (const std::exception & Ex)
+		{
+			ReportFailure(Job, Ex.what());
+			continue;
+		}
+
+		const double Milliseconds = GetMillisecondsSince(MeshStartTime);
+		const double Megabytes = Job.Record.Dependencies[0].Size / (1024.0 * 1024.0);
+
+		Log << "Baked " << Job.SourceFilename << " -> " << Job.BakedFilename << ", " << Megabytes << " MB in "
+			<< Milliseconds << " ms (" << Megabytes / (Milliseconds / 1000.0) << " MB/s)" << std::endl;
+		Statistics.Baked++;
+	}
+
+	/** Textures one per worker, unless there are too few of them to fill the pool */
+	const bool bTexturePerWorker = DirtyTextures.size() >= Pool.GetThreadCount();
+
+	auto BakeTextureJob = [&](uint32_t TextureIndex)
+	{
+		BakeJob & Job = *DirtyTextures[TextureIndex];
+		auto TextureStartTime = std::chrono::high_resolution_clock::now();
+
+		TextureBakeResult Result;
+
+		try
+		{
+			BakeTexture(Job, Settings.TextureQuality, bTexturePerWorker ? nullptr : &Pool, Result);
+		}
+		catch (const std::exception & Ex)
+		{
+			ReportFailure(Job, Ex.what());
+			return;
+		}
+
+		const double Milliseconds = GetMillisecondsSince(TextureStartTime);
+
+		std::lock_guard<std::mutex> Lock(LogMutex);
+		Log << "Baked " << Job.SourceFilename << " -> " << Job.BakedFilename << ", " << Result.Width << "x" << Result.Height << " "
+			<< GetBcFormatName(GetTextureBcFormat(Job.Content)) << " " << GetBcQualityName(Settings.TextureQuality) << ", "
+			<< Result.MipLevels << " levels, " << Result.BakedSize / 1024 << " KB in " << Milliseconds << " ms ("
+			<< Result.Texels / 1000000.0 / (Milliseconds / 1000.0) << " Mtexel/s)" << std::endl;
+		Statistics.Baked++;
+	};
+
+	if (bTexturePerWorker)
+	{
+		Pool.ParallelFor(static_cast<uint32_t>(DirtyTextures.size()), BakeTextureJob);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < DirtyTextures.size(); i++)
+		{
+			BakeTextureJob(i);
+		}
+	}
+
+	/** Sources that are gone drop out, failed bakes stay out so they are retried */
+	Manifest.clear();
+	for (const BakeJob & Job : Jobs)
+	{
+		if (!Job.bFailed)
+		{
+			Manifest[Job.BakedFilename] = Job.Record;
+		}
+	}
+
+	if (!WriteBakeManifest(ManifestFilename, Manifest))
+	{
+		Log << "Failed to write bake manifest " << ManifestFilename << std::endl;
+	}
+
+	Statistics.Milliseconds = GetMillisecondsSince(StartTime);
+
+	Log << "Baked " << Statistics.Baked << ", " << Statistics.UpToDate << " up to date, " << Statistics.Failed << " failed, in "
+		<< Statistics.Milliseconds << " ms on " << Pool.GetThreadCount() << " threads" << std::endl;
+
+	return Statistics;
+}
+
+NAMESPACE_END
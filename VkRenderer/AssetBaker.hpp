@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+#include "Namespace.hpp"
+#include "BcEncoder.hpp"
+#include "ThreadPool.hpp"
+#include "TextureProcessing.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+struct BakeSettings
+{
+	/** Scanned recursively, baked files keep their path relative to it */
+	std::string SourceDirectory = ".";
+	/** Skipped while scanning, also holds the manifest */
+	std::string OutputDirectory = "Baked";
+	BcQuality TextureQuality = BC_QUALITY_NORMAL;
+	/** Bake everything, even if the manifest says it is up to date */
+	bool bForce = false;
+	/** Set by whoever bakes the meshes, any change of it rebakes every mesh */
+	uint64_t MeshSettingsHash = 0;
+};
+
+struct BakeStatistics
+{
+	uint32_t Baked = 0;
+	uint32_t UpToDate = 0;
+	uint32_t Failed = 0;
+	double Milliseconds = 0.0;
+};
+
+/** Imports the source model and writes its baked mesh cache, throws std::runtime_error on failure. */
+using MeshBakeFunction = std::function<void(const std::string & SourceFilename, const std::string & BakedFilename)>;
+
+/**
+* Where the baked version of Filename lives below OutputDirectory: textures become .dds, models
+* get .meshcache appended. Empty if the extension is neither a model nor a texture.
+*/
+std::string GetBakedFilename(
+	const std::string & OutputDirectory,
+	const std::string & Filename
+);
+
+/**
+* The name an ORM texture packed from Filenames is baked under, Textures/Cerberus/Cerberus_ORM.png
+* for Cerberus_AO.png, Cerberus_R.png and Cerberus_M.png. Empty unless every given map lies in the
+* same directory and carries the suffix of its channel (_AO, _R or _M and their long forms) after
+* the same prefix.
+*/
+std::string GetOrmFilename(
+	const OrmFilenames & Filenames
+);
+
+/**
+* Bakes every model and texture below Settings.SourceDirectory that is out of date. A manifest in
+* the output directory records the size and hash of every file an output was built from (models
+* also depend on their material libraries) and the settings it was built with, only outputs with
+* a changed or missing entry are rebuilt. Failed bakes are left out of the manifest and retried.
+*
+* Models go through BakeMesh one after another on the calling thread, which has the whole pool to
+* itself. Textures are decoded, mipped with BuildTextureMipChain and encoded to the block format
+* of their content, one texture per worker, or each across the pool if there are fewer textures
+* than workers. The content is guessed from the name: _N is a normal map, the _AO, _R and _M maps
+* sharing a prefix are packed into one ORM texture named by GetOrmFilename, the rest is color.
+* Every asset reports its time and throughput to Log.
+*/
+BakeStatistics BakeAssets(
+	const BakeSettings & Settings,
+	const MeshBakeFunction & BakeMesh,
+	ThreadPool & Pool,
+	std::ostream & Log
+);
+
+NAMESPACE_END
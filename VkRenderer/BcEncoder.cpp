@@ -0,0 +1,1283 @@
+#include "BcEncoder.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+/** BC7 interpolation weights out of 64 for 3 and 4 bit indices */
+const uint32_t s_Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+const uint32_t s_Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/** BC7 two subset partitions, bit i is the subset of texel i */
+const uint16_t s_Partitions2[64] =
+{
+	0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+	0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+	0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+	0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+	0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+	0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+	0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+	0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+};
+
+/** Texel whose index of the second subset is stored with its top bit implied zero */
+const uint8_t s_Anchors2[64] =
+{
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15,  2,  8,  2,  2,  8,  8, 15,
+	 2,  8,  2,  2,  8,  8,  2,  2,
+	15, 15,  6,  8,  2,  8, 15, 15,
+	 2,  8,  2,  2,  2, 15, 15,  6,
+	 6,  2,  6,  8, 15, 15,  2,  2,
+	15, 15, 15, 15, 15,  2,  2, 15
+};
+
+struct BlockTexels
+{
+	/** Channel major, so the index search loads consecutive texels */
+	alignas(32) float Channels[4][16];
+};
+
+typedef void (*FindNearestFunction)(
+	const BlockTexels & Texels,
+	const float (*pPalette)[4],
+	uint32_t PaletteSize,
+	uint32_t ChannelCount,
+	float * pErrors,
+	uint8_t * pIndices
+);
+
+/**
+* For every texel the palette entry with the smallest squared distance over the first ChannelCount
+* channels, the first entry wins ties. Vectorized over texels, all widths return the same indices.
+*/
+template <typename TFloat>
+void FindNearest(
+	const BlockTexels & Texels,
+	const float (*pPalette)[4],
+	uint32_t PaletteSize,
+	uint32_t ChannelCount,
+	float * pErrors,
+	uint8_t * pIndices
+)
+{
+	for (uint32_t Texel = 0; Texel < 16; Texel += TFloat::Width)
+	{
+		TFloat Values[4];
+		for (uint32_t c = 0; c < ChannelCount; c++)
+		{
+			Values[c] = TFloat::Load(&Texels.Channels[c][Texel]);
+		}
+
+		TFloat BestError = TFloat::Set(std::numeric_limits<float>::max());
+		TFloat BestIndex = TFloat::Set(0.0f);
+
+		for (uint32_t Entry = 0; Entry < PaletteSize; Entry++)
+		{
+			TFloat Error = TFloat::Set(0.0f);
+			for (uint32_t c = 0; c < ChannelCount; c++)
+			{
+				TFloat Difference = Values[c] - TFloat::Set(pPalette[Entry][c]);
+				Error = Error + Difference * Difference;
+			}
+
+			auto bCloser = Less(Error, BestError);
+			BestError = Select(bCloser, Error, BestError);
+			BestIndex = Select(bCloser, TFloat::Set(static_cast<float>(Entry)), BestIndex);
+		}
+
+		float Indices[8];
+		BestError.Store(pErrors + Texel);
+		BestIndex.Store(Indices);
+
+		for (int i = 0; i < TFloat::Width; i++)
+		{
+			pIndices[Texel + i] = static_cast<uint8_t>(Indices[i]);
+		}
+	}
+}
+
+FindNearestFunction GetFindNearest(
+	bool bScalar
+)
+{
+#ifdef SIMD_AVX2
+	if (!bScalar && IsAvx2Supported())
+	{
+		return FindNearest<FloatX8>;
+	}
+#endif
+#ifdef SIMD_SSE2
+	if (!bScalar)
+	{
+		return FindNearest<FloatX4>;
+	}
+#endif
+	return FindNearest<FloatX1>;
+}
+
+/** Least significant bit first, the order of every BC format; the block must be zeroed */
+class BlockWriter
+{
+public:
+	explicit BlockWriter(uint8_t * pBlock) : m_pBlock(pBlock) {}
+
+	void Write(uint32_t Value, uint32_t Bits)
+	{
+		for (uint32_t i = 0; i < Bits; i++, m_Bit++)
+		{
+			m_pBlock[m_Bit >> 3] |= static_cast<uint8_t>(((Value >> i) & 1) << (m_Bit & 7));
+		}
+	}
+
+protected:
+	uint8_t * m_pBlock;
+	uint32_t m_Bit = 0;
+};
+
+class BlockReader
+{
+public:
+	explicit BlockReader(const uint8_t * pBlock) : m_pBlock(pBlock) {}
+
+	uint32_t Read(uint32_t Bits)
+	{
+		uint32_t Value = 0;
+		for (uint32_t i = 0; i < Bits; i++, m_Bit++)
+		{
+			Value |= ((m_pBlock[m_Bit >> 3] >> (m_Bit & 7)) & 1u) << i;
+		}
+		return Value;
+	}
+
+protected:
+	const uint8_t * m_pBlock;
+	uint32_t m_Bit = 0;
+};
+
+int Interpolate(int E0, int E1, uint32_t Weight)
+{
+	return ((64 - static_cast<int>(Weight)) * E0 + static_cast<int>(Weight) * E1 + 32) >> 6;
+}
+
+float Clamp255(float Value)
+{
+	return std::min(std::max(Value, 0.0f), 255.0f);
+}
+
+void LoadBlock(
+	const uint8_t * pRgba,
+	uint32_t Width,
+	uint32_t Height,
+	uint32_t BlockX,
+	uint32_t BlockY,
+	BlockTexels & Texels
+)
+{
+	for (uint32_t y = 0; y < 4; y++)
+	{
+		uint32_t Y = std::min(BlockY * 4 + y, Height - 1);
+		for (uint32_t x = 0; x < 4; x++)
+		{
+			uint32_t X = std::min(BlockX * 4 + x, Width - 1);
+			const uint8_t * pTexel = pRgba + (static_cast<size_t>(Y) * Width + X) * 4;
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				Texels.Channels[c][y * 4 + x] = pTexel[c];
+			}
+		}
+	}
+}
+
+/**
+* Principal axis of the texels in Mask, Lo and Hi are their extreme projections onto it clamped to
+* [0, 255]. Returns the summed squared distance of the texels to the axis.
+*/
+float FitLine(
+	const BlockTexels & Texels,
+	uint32_t Mask,
+	uint32_t ChannelCount,
+	float * pLo,
+	float * pHi
+)
+{
+	float Mean[4] = {};
+	uint32_t Count = 0;
+
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		if ((Mask >> t) & 1)
+		{
+			for (uint32_t c = 0; c < ChannelCount; c++)
+			{
+				Mean[c] += Texels.Channels[c][t];
+			}
+			Count++;
+		}
+	}
+
+	if (Count == 0)
+	{
+		std::fill(pLo, pLo + ChannelCount, 0.0f);
+		std::fill(pHi, pHi + ChannelCount, 0.0f);
+		return 0.0f;
+	}
+
+	for (uint32_t c = 0; c < ChannelCount; c++)
+	{
+		Mean[c] /= Count;
+	}
+
+	float Covariance[4][4] = {};
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		if ((Mask >> t) & 1)
+		{
+			for (uint32_t i = 0; i < ChannelCount; i++)
+			{
+				for (uint32_t j = 0; j < ChannelCount; j++)
+				{
+					Covariance[i][j] += (Texels.Channels[i][t] - Mean[i]) * (Texels.Channels[j][t] - Mean[j]);
+				}
+			}
+		}
+	}
+
+	/** Power iteration, starting from the channel that varies most */
+	uint32_t Widest = 0;
+	float Total = 0.0f;
+	for (uint32_t c = 0; c < ChannelCount; c++)
+	{
+		Widest = Covariance[c][c] > Covariance[Widest][Widest] ? c : Widest;
+		Total += Covariance[c][c];
+	}
+
+	float Axis[4] = {};
+	Axis[Widest] = 1.0f;
+
+	for (int Iteration = 0; Iteration < 8; Iteration++)
+	{
+		float Next[4] = {};
+		float Largest = 0.0f;
+		for (uint32_t i = 0; i < ChannelCount; i++)
+		{
+			for (uint32_t j = 0; j < ChannelCount; j++)
+			{
+				Next[i] += Covariance[i][j] * Axis[j];
+			}
+			Largest = std::max(Largest, std::fabs(Next[i]));
+		}
+
+		if (Largest == 0.0f)
+		{
+			break;
+		}
+
+		for (uint32_t c = 0; c < ChannelCount; c++)
+		{
+			Axis[c] = Next[c] / Largest;
+		}
+	}
+
+	float Length = 0.0f;
+	for (uint32_t c = 0; c < ChannelCount; c++)
+	{
+		Length += Axis[c] * Axis[c];
+	}
+	Length = std::sqrt(Length);
+
+	float MinProjection = 0.0f, MaxProjection = 0.0f, Projected = 0.0f;
+
+	if (Total > 0.0f && Length > 0.0f)
+	{
+		for (uint32_t c = 0; c < ChannelCount; c++)
+		{
+			Axis[c] /= Length;
+		}
+
+		MinProjection = std::numeric_limits<float>::max();
+		MaxProjection = std::numeric_limits<float>::lowest();
+
+		for (uint32_t t = 0; t < 16; t++)
+		{
+			if ((Mask >> t) & 1)
+			{
+				float Projection = 0.0f;
+				for (uint32_t c = 0; c < ChannelCount; c++)
+				{
+					Projection += (Texels.Channels[c][t] - Mean[c]) * Axis[c];
+				}
+				MinProjection = std::min(MinProjection, Projection);
+				MaxProjection = std::max(MaxProjection, Projection);
+				Projected += Projection * Projection;
+			}
+		}
+	}
+
+	for (uint32_t c = 0; c < ChannelCount; c++)
+	{
+		pLo[c] = Clamp255(Mean[c] + MinProjection * Axis[c]);
+		pHi[c] = Clamp255(Mean[c] + MaxProjection * Axis[c]);
+	}
+
+	return std::max(Total - Projected, 0.0f);
+}
+
+/** The endpoints with the least squared error for fixed indices, false and untouched if all texels use one weight */
+bool RefitEndpoints(
+	const BlockTexels & Texels,
+	uint32_t Mask,
+	uint32_t ChannelCount,
+	const uint8_t * pIndices,
+	const uint32_t * pWeights,
+	float * pLo,
+	float * pHi
+)
+{
+	float A = 0.0f, B = 0.0f, C = 0.0f;
+	float X[4] = {}, Y[4] = {};
+
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		if ((Mask >> t) & 1)
+		{
+			float W = pWeights[pIndices[t]] / 64.0f;
+			float V = 1.0f - W;
+			A += V * V;
+			B += V * W;
+			C += W * W;
+			for (uint32_t c = 0; c < ChannelCount; c++)
+			{
+				X[c] += V * Texels.Channels[c][t];
+				Y[c] += W * Texels.Channels[c][t];
+			}
+		}
+	}
+
+	float Determinant = A * C - B * B;
+	if (std::fabs(Determinant) < 1e-6f)
+	{
+		return false;
+	}
+
+	for (uint32_t c = 0; c < ChannelCount; c++)
+	{
+		pLo[c] = Clamp255((C * X[c] - B * Y[c]) / Determinant);
+		pHi[c] = Clamp255((A * Y[c] - B * X[c]) / Determinant);
+	}
+
+	return true;
+}
+
+/** BC4 values in index order, interpolated in float as the hardware does */
+void MakeBc4Palette(
+	int E0,
+	int E1,
+	float (*pPalette)[4]
+)
+{
+	pPalette[0][0] = static_cast<float>(E0);
+	pPalette[1][0] = static_cast<float>(E1);
+
+	if (E0 > E1)
+	{
+		for (int i = 1; i < 7; i++)
+		{
+			pPalette[i + 1][0] = ((7 - i) * E0 + i * E1) / 7.0f;
+		}
+	}
+	else
+	{
+		for (int i = 1; i < 5; i++)
+		{
+			pPalette[i + 1][0] = ((5 - i) * E0 + i * E1) / 5.0f;
+		}
+		pPalette[6][0] = 0.0f;
+		pPalette[7][0] = 255.0f;
+	}
+}
+
+/** E0 > E1 selects eight interpolated values, otherwise six plus exact 0 and 255 */
+void EncodeBc4Block(
+	const BlockTexels & Texels,
+	uint32_t Channel,
+	BcQuality Quality,
+	FindNearestFunction Find,
+	uint8_t * pBlock
+)
+{
+	BlockTexels Single;
+	memcpy(Single.Channels[0], Texels.Channels[Channel], sizeof(Single.Channels[0]));
+
+	int Min = 255, Max = 0;
+	int InnerMin = 255, InnerMax = 0;
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		int Value = static_cast<int>(Single.Channels[0][t]);
+		Min = std::min(Min, Value);
+		Max = std::max(Max, Value);
+
+		if (Value != 0 && Value != 255)
+		{
+			InnerMin = std::min(InnerMin, Value);
+			InnerMax = std::max(InnerMax, Value);
+		}
+	}
+
+	int BestE0 = Max, BestE1 = Min;
+	uint8_t BestIndices[16] = {};
+	float BestError = std::numeric_limits<float>::max();
+
+	auto TryEndpoints = [&](int E0, int E1)
+	{
+		float Palette[8][4] = {};
+		MakeBc4Palette(E0, E1, Palette);
+
+		float Errors[16];
+		uint8_t Indices[16];
+		Find(Single, Palette, 8, 1, Errors, Indices);
+
+		float Error = 0.0f;
+		for (uint32_t t = 0; t < 16; t++)
+		{
+			Error += Errors[t];
+		}
+
+		if (Error < BestError)
+		{
+			BestError = Error;
+			BestE0 = E0;
+			BestE1 = E1;
+			memcpy(BestIndices, Indices, sizeof(Indices));
+		}
+	};
+
+	if (Min == Max)
+	{
+		TryEndpoints(Max, Max);
+	}
+	else
+	{
+		/** Moving the endpoints inwards trades the extremes for the values in between */
+		const int Radius = Quality == BC_QUALITY_FAST ? 0 : Quality == BC_QUALITY_NORMAL ? 1 : 3;
+
+		for (int d0 = 0; d0 <= Radius; d0++)
+		{
+			for (int d1 = 0; d1 <= Radius; d1++)
+			{
+				if (Max - d0 > Min + d1)
+				{
+					TryEndpoints(Max - d0, Min + d1);
+				}
+			}
+		}
+
+		if (Quality != BC_QUALITY_FAST && InnerMin <= InnerMax)
+		{
+			TryEndpoints(InnerMin, InnerMax);
+		}
+	}
+
+	pBlock[0] = static_cast<uint8_t>(BestE0);
+	pBlock[1] = static_cast<uint8_t>(BestE1);
+
+	uint64_t Bits = 0;
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		Bits |= static_cast<uint64_t>(BestIndices[t]) << (3 * t);
+	}
+
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		pBlock[2 + i] = static_cast<uint8_t>(Bits >> (8 * i));
+	}
+}
+
+void DecodeBc4Block(
+	const uint8_t * pBlock,
+	uint8_t * pValues
+)
+{
+	float Palette[8][4] = {};
+	MakeBc4Palette(pBlock[0], pBlock[1], Palette);
+
+	uint64_t Bits = 0;
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		Bits |= static_cast<uint64_t>(pBlock[2 + i]) << (8 * i);
+	}
+
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		pValues[t] = static_cast<uint8_t>(Palette[(Bits >> (3 * t)) & 7][0] + 0.5f);
+	}
+}
+
+/** Mode 6 stores 7 bits plus a p-bit per endpoint, picks the p-bit closest to the unquantized endpoint */
+void QuantizeMode6(
+	const float * pEndpoint,
+	int * pValues,
+	int & PBit
+)
+{
+	float BestError = std::numeric_limits<float>::max();
+
+	for (int P = 0; P < 2; P++)
+	{
+		int Values[4];
+		float Error = 0.0f;
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			int Code = std::min(std::max(static_cast<int>(std::floor((pEndpoint[c] - P) * 0.5f + 0.5f)), 0), 127);
+			Values[c] = Code * 2 + P;
+			Error += (pEndpoint[c] - Values[c]) * (pEndpoint[c] - Values[c]);
+		}
+
+		if (Error < BestError)
+		{
+			BestError = Error;
+			PBit = P;
+			memcpy(pValues, Values, sizeof(Values));
+		}
+	}
+}
+
+/** One subset, RGBA 7.7.7.7 endpoints with unique p-bits and 4 bit indices */
+float EncodeMode6(
+	const BlockTexels & Texels,
+	const float * pLo,
+	const float * pHi,
+	uint32_t Refinements,
+	FindNearestFunction Find,
+	uint8_t * pBlock
+)
+{
+	float Endpoints[2][4];
+	memcpy(Endpoints[0], pLo, sizeof(Endpoints[0]));
+	memcpy(Endpoints[1], pHi, sizeof(Endpoints[1]));
+
+	float BestError = std::numeric_limits<float>::max();
+	int BestValues[2][4] = {};
+	int BestPBits[2] = {};
+	uint8_t BestIndices[16] = {};
+
+	for (uint32_t Pass = 0; ; Pass++)
+	{
+		int Values[2][4], PBits[2];
+		QuantizeMode6(Endpoints[0], Values[0], PBits[0]);
+		QuantizeMode6(Endpoints[1], Values[1], PBits[1]);
+
+		float Palette[16][4];
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				Palette[i][c] = static_cast<float>(Interpolate(Values[0][c], Values[1][c], s_Weights4[i]));
+			}
+		}
+
+		float Errors[16];
+		uint8_t Indices[16];
+		Find(Texels, Palette, 16, 4, Errors, Indices);
+
+		float Error = 0.0f;
+		for (uint32_t t = 0; t < 16; t++)
+		{
+			Error += Errors[t];
+		}
+
+		if (Error < BestError)
+		{
+			BestError = Error;
+			memcpy(BestValues, Values, sizeof(Values));
+			memcpy(BestPBits, PBits, sizeof(PBits));
+			memcpy(BestIndices, Indices, sizeof(Indices));
+		}
+
+		if (Pass == Refinements || !RefitEndpoints(Texels, 0xFFFF, 4, Indices, s_Weights4, Endpoints[0], Endpoints[1]))
+		{
+			break;
+		}
+	}
+
+	/** The top bit of the first index is implied zero, swapping the endpoints flips every index */
+	if (BestIndices[0] & 8)
+	{
+		std::swap(BestValues[0], BestValues[1]);
+		std::swap(BestPBits[0], BestPBits[1]);
+		for (uint32_t t = 0; t < 16; t++)
+		{
+			BestIndices[t] = static_cast<uint8_t>(15 - BestIndices[t]);
+		}
+	}
+
+	memset(pBlock, 0, 16);
+	BlockWriter Writer(pBlock);
+	Writer.Write(1 << 6, 7);
+
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		Writer.Write(BestValues[0][c] >> 1, 7);
+		Writer.Write(BestValues[1][c] >> 1, 7);
+	}
+
+	Writer.Write(BestPBits[0], 1);
+	Writer.Write(BestPBits[1], 1);
+
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		Writer.Write(BestIndices[t], t == 0 ? 3 : 4);
+	}
+
+	return BestError;
+}
+
+int ExpandMode1(int Code, int PBit)
+{
+	int Value = (Code << 1) | PBit;
+	return (Value << 1) | (Value >> 6);
+}
+
+/** Mode 1 stores 6 bits per channel and one p-bit shared by both endpoints of a subset */
+void QuantizeMode1(
+	const float (*pEndpoints)[4],
+	int (*pCodes)[3],
+	int (*pValues)[3],
+	int & PBit
+)
+{
+	float BestError = std::numeric_limits<float>::max();
+
+	for (int P = 0; P < 2; P++)
+	{
+		int Codes[2][3], Values[2][3];
+		float Error = 0.0f;
+
+		for (uint32_t e = 0; e < 2; e++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				float Target = pEndpoints[e][c];
+				int Guess = static_cast<int>(std::floor((Target * 127.0f / 255.0f - P) * 0.5f + 0.5f));
+				float ChannelError = std::numeric_limits<float>::max();
+
+				for (int Code = std::max(Guess - 1, 0); Code <= std::min(Guess + 1, 63); Code++)
+				{
+					float Difference = Target - ExpandMode1(Code, P);
+					if (Difference * Difference < ChannelError)
+					{
+						ChannelError = Difference * Difference;
+						Codes[e][c] = Code;
+						Values[e][c] = ExpandMode1(Code, P);
+					}
+				}
+
+				Error += ChannelError;
+			}
+		}
+
+		if (Error < BestError)
+		{
+			BestError = Error;
+			PBit = P;
+			memcpy(pCodes, Codes, sizeof(Codes));
+			memcpy(pValues, Values, sizeof(Values));
+		}
+	}
+}
+
+/** Two subsets, RGB 6.6.6 endpoints with a shared p-bit per subset and 3 bit indices, opaque blocks only */
+float EncodeMode1(
+	const BlockTexels & Texels,
+	uint32_t Partition,
+	uint32_t Refinements,
+	FindNearestFunction Find,
+	uint8_t * pBlock
+)
+{
+	const uint32_t Masks[2] = { ~static_cast<uint32_t>(s_Partitions2[Partition]) & 0xFFFF, s_Partitions2[Partition] };
+
+	float Endpoints[2][2][4] = {};
+	for (uint32_t s = 0; s < 2; s++)
+	{
+		FitLine(Texels, Masks[s], 3, Endpoints[s][0], Endpoints[s][1]);
+	}
+
+	float BestError = std::numeric_limits<float>::max();
+	int BestCodes[2][2][3] = {};
+	int BestPBits[2] = {};
+	uint8_t BestIndices[16] = {};
+
+	for (uint32_t Pass = 0; ; Pass++)
+	{
+		int Codes[2][2][3], Values[2][2][3], PBits[2];
+		float Errors[2][16];
+		uint8_t SubsetIndices[2][16];
+
+		for (uint32_t s = 0; s < 2; s++)
+		{
+			QuantizeMode1(Endpoints[s], Codes[s], Values[s], PBits[s]);
+
+			float Palette[8][4] = {};
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					Palette[i][c] = static_cast<float>(Interpolate(Values[s][0][c], Values[s][1][c], s_Weights3[i]));
+				}
+			}
+
+			Find(Texels, Palette, 8, 3, Errors[s], SubsetIndices[s]);
+		}
+
+		float Error = 0.0f;
+		uint8_t Indices[16];
+		for (uint32_t t = 0; t < 16; t++)
+		{
+			uint32_t Subset = (Masks[1] >> t) & 1;
+			Indices[t] = SubsetIndices[Subset][t];
+			Error += Errors[Subset][t];
+		}
+
+		if (Error < BestError)
+		{
+			BestError = Error;
+			memcpy(BestCodes, Codes, sizeof(Codes));
+			memcpy(BestPBits, PBits, sizeof(PBits));
+			memcpy(BestIndices, Indices, sizeof(Indices));
+		}
+
+		if (Pass == Refinements)
+		{
+			break;
+		}
+
+		bool bRefitted = false;
+		for (uint32_t s = 0; s < 2; s++)
+		{
+			bRefitted |= RefitEndpoints(Texels, Masks[s], 3, Indices, s_Weights3, Endpoints[s][0], Endpoints[s][1]);
+		}
+
+		if (!bRefitted)
+		{
+			break;
+		}
+	}
+
+	/** Each subset has an anchor texel whose top index bit is implied zero */
+	const uint32_t Anchors[2] = { 0, s_Anchors2[Partition] };
+	for (uint32_t s = 0; s < 2; s++)
+	{
+		if (BestIndices[Anchors[s]] & 4)
+		{
+			std::swap(BestCodes[s][0], BestCodes[s][1]);
+			for (uint32_t t = 0; t < 16; t++)
+			{
+				if (((Masks[1] >> t) & 1) == s)
+				{
+					BestIndices[t] = static_cast<uint8_t>(7 - BestIndices[t]);
+				}
+			}
+		}
+	}
+
+	memset(pBlock, 0, 16);
+	BlockWriter Writer(pBlock);
+	Writer.Write(1 << 1, 2);
+	Writer.Write(Partition, 6);
+
+	for (uint32_t c = 0; c < 3; c++)
+	{
+		for (uint32_t s = 0; s < 2; s++)
+		{
+			Writer.Write(BestCodes[s][0][c], 6);
+			Writer.Write(BestCodes[s][1][c], 6);
+		}
+	}
+
+	Writer.Write(BestPBits[0], 1);
+	Writer.Write(BestPBits[1], 1);
+
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		Writer.Write(BestIndices[t], t == Anchors[0] || t == Anchors[1] ? 2 : 3);
+	}
+
+	return BestError;
+}
+
+/** Count, RGB sums and the sums of the six distinct RGB products of a subset */
+struct PartitionMoments
+{
+	float Sums[10];
+};
+
+/** The moments of every texel on its own, partitions sum them over their mask */
+void ComputeTexelMoments(
+	const BlockTexels & Texels,
+	PartitionMoments * pMoments
+)
+{
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		float R = Texels.Channels[0][t], G = Texels.Channels[1][t], B = Texels.Channels[2][t];
+		const float Sums[10] = { 1.0f, R, G, B, R * R, R * G, R * B, G * G, G * B, B * B };
+		memcpy(pMoments[t].Sums, Sums, sizeof(Sums));
+	}
+}
+
+void SumPartitionMoments(
+	const PartitionMoments * pTexelMoments,
+	uint32_t Mask,
+	PartitionMoments & Moments
+)
+{
+	std::fill(Moments.Sums, Moments.Sums + 10, 0.0f);
+
+	/** Weighted rather than branched on, the masks are too irregular to predict */
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		const float Weight = static_cast<float>((Mask >> t) & 1);
+		for (uint32_t i = 0; i < 10; i++)
+		{
+			Moments.Sums[i] += Weight * pTexelMoments[t].Sums[i];
+		}
+	}
+}
+
+/** What FitLine returns for the subset, estimated from its moments: the variance off the principal axis */
+float GetLineResidual(
+	const PartitionMoments & Moments
+)
+{
+	const float Count = Moments.Sums[0];
+	if (Count == 0.0f)
+	{
+		return 0.0f;
+	}
+
+	const float * pSum = Moments.Sums + 1;
+	const float Covariance[3][3] =
+	{
+		{ Moments.Sums[4] - pSum[0] * pSum[0] / Count, Moments.Sums[5] - pSum[0] * pSum[1] / Count, Moments.Sums[6] - pSum[0] * pSum[2] / Count },
+		{ Moments.Sums[5] - pSum[0] * pSum[1] / Count, Moments.Sums[7] - pSum[1] * pSum[1] / Count, Moments.Sums[8] - pSum[1] * pSum[2] / Count },
+		{ Moments.Sums[6] - pSum[0] * pSum[2] / Count, Moments.Sums[8] - pSum[1] * pSum[2] / Count, Moments.Sums[9] - pSum[2] * pSum[2] / Count }
+	};
+
+	const float Total = Covariance[0][0] + Covariance[1][1] + Covariance[2][2];
+	if (Total <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	/** A few power iterations from the gray axis, then the Rayleigh quotient as the largest eigenvalue */
+	float Axis[3] = { 1.0f, 1.0f, 1.0f };
+	float Next[3];
+
+	for (int Iteration = 0; Iteration < 3; Iteration++)
+	{
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			Next[i] = Covariance[i][0] * Axis[0] + Covariance[i][1] * Axis[1] + Covariance[i][2] * Axis[2];
+		}
+
+		float Scale = std::max(std::fabs(Next[0]), std::max(std::fabs(Next[1]), std::fabs(Next[2])));
+		if (Scale == 0.0f)
+		{
+			return Total;
+		}
+
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			Axis[i] = Next[i] / Scale;
+		}
+	}
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		Next[i] = Covariance[i][0] * Axis[0] + Covariance[i][1] * Axis[1] + Covariance[i][2] * Axis[2];
+	}
+
+	const float Largest =
+		(Axis[0] * Next[0] + Axis[1] * Next[1] + Axis[2] * Next[2]) /
+		(Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2]);
+
+	return std::max(Total - Largest, 0.0f);
+}
+
+void EncodeBc7Block(
+	const BlockTexels & Texels,
+	BcQuality Quality,
+	FindNearestFunction Find,
+	uint8_t * pBlock
+)
+{
+	const uint32_t Refinements = static_cast<uint32_t>(Quality);
+
+	float Lo[4], Hi[4];
+	FitLine(Texels, 0xFFFF, 4, Lo, Hi);
+
+	float Error = EncodeMode6(Texels, Lo, Hi, Refinements, Find, pBlock);
+
+	bool bOpaque = true;
+	for (uint32_t t = 0; t < 16; t++)
+	{
+		bOpaque &= Texels.Channels[3][t] == 255.0f;
+	}
+
+	if (Quality == BC_QUALITY_FAST || Error == 0.0f || !bOpaque)
+	{
+		return;
+	}
+
+	/** Rank the partitions by how well two lines fit them, only the best few are encoded */
+	PartitionMoments TexelMoments[16], Moments;
+	ComputeTexelMoments(Texels, TexelMoments);
+	SumPartitionMoments(TexelMoments, 0xFFFF, Moments);
+
+	std::array<std::pair<float, uint32_t>, 64> Ranked;
+	for (uint32_t Partition = 0; Partition < 64; Partition++)
+	{
+		PartitionMoments Second;
+		SumPartitionMoments(TexelMoments, s_Partitions2[Partition], Second);
+
+		PartitionMoments First;
+		for (uint32_t i = 0; i < 10; i++)
+		{
+			First.Sums[i] = Moments.Sums[i] - Second.Sums[i];
+		}
+
+		Ranked[Partition] = std::make_pair(GetLineResidual(First) + GetLineResidual(Second), Partition);
+	}
+
+	const uint32_t CandidateCount = Quality == BC_QUALITY_NORMAL ? 2 : 8;
+	std::partial_sort(Ranked.begin(), Ranked.begin() + CandidateCount, Ranked.end());
+
+	for (uint32_t i = 0; i < CandidateCount; i++)
+	{
+		uint8_t Candidate[16];
+		float CandidateError = EncodeMode1(Texels, Ranked[i].second, Refinements, Find, Candidate);
+		if (CandidateError < Error)
+		{
+			Error = CandidateError;
+			memcpy(pBlock, Candidate, sizeof(Candidate));
+		}
+	}
+}
+
+void DecodeBc7Block(
+	const uint8_t * pBlock,
+	uint8_t (*pTexels)[4]
+)
+{
+	BlockReader Reader(pBlock);
+
+	uint32_t Mode = 0;
+	while (Mode < 8 && Reader.Read(1) == 0)
+	{
+		Mode++;
+	}
+
+	if (Mode == 6)
+	{
+		int Values[2][4];
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			Values[0][c] = static_cast<int>(Reader.Read(7)) << 1;
+			Values[1][c] = static_cast<int>(Reader.Read(7)) << 1;
+		}
+
+		for (uint32_t e = 0; e < 2; e++)
+		{
+			int PBit = static_cast<int>(Reader.Read(1));
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				Values[e][c] |= PBit;
+			}
+		}
+
+		for (uint32_t t = 0; t < 16; t++)
+		{
+			uint32_t Index = Reader.Read(t == 0 ? 3 : 4);
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				pTexels[t][c] = static_cast<uint8_t>(Interpolate(Values[0][c], Values[1][c], s_Weights4[Index]));
+			}
+		}
+	}
+	else if (Mode == 1)
+	{
+		uint32_t Partition = Reader.Read(6);
+
+		int Codes[2][2][3];
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			for (uint32_t s = 0; s < 2; s++)
+			{
+				Codes[s][0][c] = static_cast<int>(Reader.Read(6));
+				Codes[s][1][c] = static_cast<int>(Reader.Read(6));
+			}
+		}
+
+		int PBits[2];
+		PBits[0] = static_cast<int>(Reader.Read(1));
+		PBits[1] = static_cast<int>(Reader.Read(1));
+
+		for (uint32_t t = 0; t < 16; t++)
+		{
+			uint32_t Subset = (s_Partitions2[Partition] >> t) & 1;
+			uint32_t Index = Reader.Read(t == 0 || t == s_Anchors2[Partition] ? 2 : 3);
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				pTexels[t][c] = static_cast<uint8_t>(Interpolate(
+					ExpandMode1(Codes[Subset][0][c], PBits[Subset]),
+					ExpandMode1(Codes[Subset][1][c], PBits[Subset]),
+					s_Weights3[Index]
+				));
+			}
+			pTexels[t][3] = 255;
+		}
+	}
+	else
+	{
+		memset(pTexels, 0, 16 * 4);
+	}
+}
+
+uint32_t GetBcChannelCount(
+	BcFormat Format
+)
+{
+	return Format == BC_FORMAT_BC4 ? 1 : Format == BC_FORMAT_BC5 ? 2 : 4;
+}
+
+}
+
+double BcEncodeStatistics::GetMegatexelsPerSecond() const
+{
+	return Milliseconds > 0.0 ? Texels / (Milliseconds * 1000.0) : 0.0;
+}
+
+VkFormat GetBcVkFormat(
+	BcFormat Format
+)
+{
+	switch (Format)
+	{
+	case BC_FORMAT_BC4: return VK_FORMAT_BC4_UNORM_BLOCK;
+	case BC_FORMAT_BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+	default: return VK_FORMAT_BC7_UNORM_BLOCK;
+	}
+}
+
+uint32_t GetBcBlockBytes(
+	BcFormat Format
+)
+{
+	return Format == BC_FORMAT_BC4 ? 8 : 16;
+}
+
+size_t GetBcImageSize(
+	BcFormat Format,
+	uint32_t Width,
+	uint32_t Height
+)
+{
+	return static_cast<size_t>((Width + 3) / 4) * ((Height + 3) / 4) * GetBcBlockBytes(Format);
+}
+
+const char * GetBcFormatName(
+	BcFormat Format
+)
+{
+	switch (Format)
+	{
+	case BC_FORMAT_BC4: return "BC4";
+	case BC_FORMAT_BC5: return "BC5";
+	case BC_FORMAT_BC7: return "BC7";
+	default: return "Unknown";
+	}
+}
+
+const char * GetBcQualityName(
+	BcQuality Quality
+)
+{
+	switch (Quality)
+	{
+	case BC_QUALITY_FAST: return "Fast";
+	case BC_QUALITY_NORMAL: return "Normal";
+	case BC_QUALITY_HIGH: return "High";
+	default: return "Unknown";
+	}
+}
+
+void EncodeBcImage(
+	const BcEncodeSettings & Settings,
+	const uint8_t * pRgba,
+	uint32_t Width,
+	uint32_t Height,
+	uint8_t * pBlocks,
+	ThreadPool * pPool,
+	BcEncodeStatistics * pStatistics
+)
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	const uint32_t BlocksX = (Width + 3) / 4;
+	const uint32_t BlocksY = (Height + 3) / 4;
+	const uint32_t BlockBytes = GetBcBlockBytes(Settings.Format);
+	const FindNearestFunction Find = GetFindNearest(Settings.bScalar);
+
+	auto EncodeRows = [&](uint32_t FirstRow, uint32_t EndRow)
+	{
+		BlockTexels Texels;
+
+		for (uint32_t BlockY = FirstRow; BlockY < EndRow; BlockY++)
+		{
+			for (uint32_t BlockX = 0; BlockX < BlocksX; BlockX++)
+			{
+				LoadBlock(pRgba, Width, Height, BlockX, BlockY, Texels);
+				uint8_t * pBlock = pBlocks + (static_cast<size_t>(BlockY) * BlocksX + BlockX) * BlockBytes;
+
+				switch (Settings.Format)
+				{
+				case BC_FORMAT_BC4:
+					EncodeBc4Block(Texels, 0, Settings.Quality, Find, pBlock);
+					break;
+				case BC_FORMAT_BC5:
+					EncodeBc4Block(Texels, 0, Settings.Quality, Find, pBlock);
+					EncodeBc4Block(Texels, 1, Settings.Quality, Find, pBlock + 8);
+					break;
+				default:
+					EncodeBc7Block(Texels, Settings.Quality, Find, pBlock);
+					break;
+				}
+			}
+		}
+	};
+
+	/** A few ranges per worker keep them busy when some rows are cheaper than others */
+	uint32_t TaskCount = pPool ? std::min(BlocksY, pPool->GetThreadCount() * 4) : 1;
+
+	if (TaskCount > 1)
+	{
+		pPool->ParallelFor(TaskCount, [&](uint32_t Task)
+		{
+			EncodeRows(BlocksY * Task / TaskCount, BlocksY * (Task + 1) / TaskCount);
+		});
+	}
+	else
+	{
+		TaskCount = 1;
+		EncodeRows(0, BlocksY);
+	}
+
+	if (pStatistics)
+	{
+		pStatistics->Texels = static_cast<size_t>(Width) * Height;
+		pStatistics->Blocks = static_cast<size_t>(BlocksX) * BlocksY;
+		pStatistics->Tasks = TaskCount;
+		pStatistics->Milliseconds = std::chrono::duration<double, std::chrono::milliseconds::period>(
+			std::chrono::high_resolution_clock::now() - StartTime
+			).count();
+	}
+}
+
+void DecodeBcImage(
+	BcFormat Format,
+	const uint8_t * pBlocks,
+	uint32_t Width,
+	uint32_t Height,
+	uint8_t * pRgba
+)
+{
+	const uint32_t BlocksX = (Width + 3) / 4;
+	const uint32_t BlocksY = (Height + 3) / 4;
+	const uint32_t BlockBytes = GetBcBlockBytes(Format);
+
+	for (uint32_t BlockY = 0; BlockY < BlocksY; BlockY++)
+	{
+		for (uint32_t BlockX = 0; BlockX < BlocksX; BlockX++)
+		{
+			const uint8_t * pBlock = pBlocks + (static_cast<size_t>(BlockY) * BlocksX + BlockX) * BlockBytes;
+
+			uint8_t Texels[16][4] = {};
+			if (Format == BC_FORMAT_BC7)
+			{
+				DecodeBc7Block(pBlock, Texels);
+			}
+			else
+			{
+				uint8_t Values[16];
+				for (uint32_t Channel = 0; Channel < GetBcChannelCount(Format); Channel++)
+				{
+					DecodeBc4Block(pBlock + Channel * 8, Values);
+					for (uint32_t t = 0; t < 16; t++)
+					{
+						Texels[t][Channel] = Values[t];
+					}
+				}
+
+				for (uint32_t t = 0; t < 16; t++)
+				{
+					Texels[t][3] = 255;
+				}
+			}
+
+			for (uint32_t y = 0; y < 4 && BlockY * 4 + y < Height; y++)
+			{
+				for (uint32_t x = 0; x < 4 && BlockX * 4 + x < Width; x++)
+				{
+					size_t Texel = static_cast<size_t>(BlockY * 4 + y) * Width + BlockX * 4 + x;
+					memcpy(pRgba + Texel * 4, Texels[y * 4 + x], 4);
+				}
+			}
+		}
+	}
+}
+
+double ComputeBcPsnr(
+	BcFormat Format,
+	const uint8_t * pOriginal,
+	const uint8_t * pDecoded,
+	uint32_t Width,
+	uint32_t Height
+)
+{
+	const uint32_t ChannelCount = GetBcChannelCount(Format);
+	const size_t TexelCount = static_cast<size_t>(Width) * Height;
+
+	double SquaredError = 0.0;
+	for (size_t i = 0; i < TexelCount; i++)
+	{
+		for (uint32_t c = 0; c < ChannelCount; c++)
+		{
+			double Difference = static_cast<double>(pOriginal[i * 4 + c]) - pDecoded[i * 4 + c];
+			SquaredError += Difference * Difference;
+		}
+	}
+
+	if (SquaredError == 0.0 || TexelCount == 0)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+
+	double MeanSquaredError = SquaredError / (TexelCount * ChannelCount);
+	return 10.0 * std::log10(255.0 * 255.0 / MeanSquaredError);
+}
+
+NAMESPACE_END
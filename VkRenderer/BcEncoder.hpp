@@ -0,0 +1,116 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+class ThreadPool;
+
+enum BcFormat
+{
+	/** One channel, 8 bytes per block, for scalar maps */
+	BC_FORMAT_BC4 = 0,
+	/** Two BC4 channels, 16 bytes per block, for normal maps that store x and y */
+	BC_FORMAT_BC5 = 1,
+	/** RGBA, 16 bytes per block, for color */
+	BC_FORMAT_BC7 = 2
+};
+
+/** Trades encode time for quality, every preset writes valid blocks of the same size. */
+enum BcQuality
+{
+	/** One endpoint fit per block, BC7 uses mode 6 only */
+	BC_QUALITY_FAST = 0,
+	/** Refits the endpoints once, BC7 also tries mode 1 on the best two partitions */
+	BC_QUALITY_NORMAL = 1,
+	/** Refits twice and searches wider, BC7 tries mode 1 on the best eight partitions */
+	BC_QUALITY_HIGH = 2
+};
+
+struct BcEncodeSettings
+{
+	BcFormat Format = BC_FORMAT_BC7;
+	BcQuality Quality = BC_QUALITY_NORMAL;
+	/** Force the scalar index search, to measure what the vector paths gain. The output is identical. */
+	bool bScalar = false;
+};
+
+struct BcEncodeStatistics
+{
+	size_t Texels = 0;
+	size_t Blocks = 0;
+	/** Ranges of block rows encoded on Pool, 1 if the encoder ran on the calling thread */
+	uint32_t Tasks = 0;
+	double Milliseconds = 0.0;
+
+	double GetMegatexelsPerSecond() const;
+};
+
+VkFormat GetBcVkFormat(
+	BcFormat Format
+);
+
+uint32_t GetBcBlockBytes(
+	BcFormat Format
+);
+
+/** Bytes of one level, partial blocks at the right and bottom edge count as whole blocks. */
+size_t GetBcImageSize(
+	BcFormat Format,
+	uint32_t Width,
+	uint32_t Height
+);
+
+const char * GetBcFormatName(
+	BcFormat Format
+);
+
+const char * GetBcQualityName(
+	BcQuality Quality
+);
+
+/**
+* Encodes tightly packed RGBA8 texels into blocks, row by row of blocks. BC4 reads red, BC5 red and
+* green. Edge blocks repeat the last row and column. Ranges of block rows are encoded on Pool, inline
+* without one, the output does not depend on the thread count.
+*/
+void EncodeBcImage(
+	const BcEncodeSettings & Settings,
+	const uint8_t * pRgba,
+	uint32_t Width,
+	uint32_t Height,
+	uint8_t * pBlocks,
+	ThreadPool * pPool = nullptr,
+	BcEncodeStatistics * pStatistics = nullptr
+);
+
+/**
+* Decodes what EncodeBcImage writes into RGBA8 the way the GPU samples it, missing channels read as
+* zero and alpha as one. Only the BC7 modes the encoder uses (1 and 6) are decoded, others are black.
+*/
+void DecodeBcImage(
+	BcFormat Format,
+	const uint8_t * pBlocks,
+	uint32_t Width,
+	uint32_t Height,
+	uint8_t * pRgba
+);
+
+/** Peak signal to noise ratio in dB over the channels Format stores, infinite if both images are equal. */
+double ComputeBcPsnr(
+	BcFormat Format,
+	const uint8_t * pOriginal,
+	const uint8_t * pDecoded,
+	uint32_t Width,
+	uint32_t Height
+);
+
+NAMESPACE_END
@@ -72,6 +72,23 @@ void Camera::SetResolution(float Width, float Height)
 	m_Resolution.y = Height;
 }
 
+void Camera::SetOrbit(float Yaw, float Pitch, float Radius)
+{
+	m_Yaw = Yaw;
+	m_Pitch = Pitch;
+	m_Radius = Radius;
+	ClampYaw(m_Yaw);
+	ClampPitch(m_Pitch);
+	ClampRadius(m_Radius);
+}
+
+void Camera::GetOrbit(float & Yaw, float & Pitch, float & Radius) const
+{
+	Yaw = m_Yaw;
+	Pitch = m_Pitch;
+	Radius = m_Radius;
+}
+
 void Camera::RetriveData(glm::vec3 & Target, glm::vec3 & Eye, glm::vec3 & Up, glm::vec2 & Fov, float & NearZ, float & FarZ)
 {
 	float X = cos(m_Yaw) * cos(m_Pitch);
@@ -23,6 +23,8 @@ public:
 	void SetNearFarZ(float NearZ, float FarZ);
 	void SetFov(float FovX);
 	void SetResolution(float Width, float Height);
+	void SetOrbit(float Yaw, float Pitch, float Radius);
+	void GetOrbit(float & Yaw, float & Pitch, float & Radius) const;
 	void RetriveData(glm::vec3 & Target, glm::vec3 & Eye, glm::vec3 & Up, glm::vec2 & Fov,float & NearZ, float & FarZ);
 
 	glm::vec3 GetCachedTarget() const;
@@ -0,0 +1,321 @@
+#include "DdsFile.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+const uint32_t s_DdsMagic = MakeFourCC('D', 'D', 'S', ' ');
+const uint32_t s_DdsHeaderSize = 124;
+const uint32_t s_DdsDx10HeaderSize = 20;
+
+/** Byte offsets into DDS_HEADER, which follows the magic */
+const size_t s_HeaderFlags = 4;
+const size_t s_HeaderHeight = 8;
+const size_t s_HeaderWidth = 12;
+const size_t s_HeaderPitchOrLinearSize = 16;
+const size_t s_HeaderMipMapCount = 24;
+const size_t s_HeaderPixelFormatSize = 72;
+const size_t s_HeaderPixelFormatFlags = 76;
+const size_t s_HeaderFourCC = 80;
+const size_t s_HeaderRgbBitCount = 84;
+const size_t s_HeaderRedMask = 88;
+const size_t s_HeaderGreenMask = 92;
+const size_t s_HeaderBlueMask = 96;
+const size_t s_HeaderAlphaMask = 100;
+const size_t s_HeaderCaps = 104;
+const size_t s_HeaderCaps2 = 108;
+
+const uint32_t s_FlagCaps = 0x1;
+const uint32_t s_FlagHeight = 0x2;
+const uint32_t s_FlagWidth = 0x4;
+const uint32_t s_FlagPixelFormat = 0x1000;
+const uint32_t s_FlagMipMapCount = 0x20000;
+const uint32_t s_FlagLinearSize = 0x80000;
+
+const uint32_t s_PixelFormatAlphaPixels = 0x1;
+const uint32_t s_PixelFormatFourCC = 0x4;
+const uint32_t s_PixelFormatRgb = 0x40;
+
+const uint32_t s_CapsComplex = 0x8;
+const uint32_t s_CapsTexture = 0x1000;
+const uint32_t s_CapsMipMap = 0x400000;
+
+const uint32_t s_Caps2CubeMap = 0x200;
+const uint32_t s_Caps2Volume = 0x200000;
+
+const uint32_t s_Dx10DimensionTexture2D = 3;
+const uint32_t s_Dx10MiscTextureCube = 0x4;
+
+struct DxgiFormatMapping
+{
+	uint32_t DxgiFormat;
+	VkFormat Format;
+};
+
+/** Only formats that sample the same as the RGBA8 textures the loader decodes, so no sRGB */
+const DxgiFormatMapping s_DxgiFormats[] =
+{
+	{ 28, VK_FORMAT_R8G8B8A8_UNORM },
+	{ 87, VK_FORMAT_B8G8R8A8_UNORM },
+	{ 71, VK_FORMAT_BC1_RGBA_UNORM_BLOCK },
+	{ 74, VK_FORMAT_BC2_UNORM_BLOCK },
+	{ 77, VK_FORMAT_BC3_UNORM_BLOCK },
+	{ 80, VK_FORMAT_BC4_UNORM_BLOCK },
+	{ 83, VK_FORMAT_BC5_UNORM_BLOCK },
+	{ 98, VK_FORMAT_BC7_UNORM_BLOCK }
+};
+
+uint32_t ReadUint32(
+	const uint8_t * pData
+)
+{
+	uint32_t Value;
+	memcpy(&Value, pData, sizeof(Value));
+	return Value;
+}
+
+void WriteUint32(
+	uint8_t * pData,
+	uint32_t Value
+)
+{
+	memcpy(pData, &Value, sizeof(Value));
+}
+
+VkFormat GetLegacyFormat(
+	const uint8_t * pHeader
+)
+{
+	const uint32_t Flags = ReadUint32(pHeader + s_HeaderPixelFormatFlags);
+
+	if (Flags & s_PixelFormatFourCC)
+	{
+		const uint32_t FourCC = ReadUint32(pHeader + s_HeaderFourCC);
+
+		if (FourCC == MakeFourCC('D', 'X', 'T', '1')) return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		if (FourCC == MakeFourCC('D', 'X', 'T', '3')) return VK_FORMAT_BC2_UNORM_BLOCK;
+		if (FourCC == MakeFourCC('D', 'X', 'T', '5')) return VK_FORMAT_BC3_UNORM_BLOCK;
+		if (FourCC == MakeFourCC('A', 'T', 'I', '1') || FourCC == MakeFourCC('B', 'C', '4', 'U')) return VK_FORMAT_BC4_UNORM_BLOCK;
+		if (FourCC == MakeFourCC('A', 'T', 'I', '2') || FourCC == MakeFourCC('B', 'C', '5', 'U')) return VK_FORMAT_BC5_UNORM_BLOCK;
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	/** Without alpha the fourth byte would be undefined, only full RGBA layouts are taken */
+	if ((Flags & s_PixelFormatRgb) && (Flags & s_PixelFormatAlphaPixels) && ReadUint32(pHeader + s_HeaderRgbBitCount) == 32)
+	{
+		const uint32_t Masks[4] =
+		{
+			ReadUint32(pHeader + s_HeaderRedMask),
+			ReadUint32(pHeader + s_HeaderGreenMask),
+			ReadUint32(pHeader + s_HeaderBlueMask),
+			ReadUint32(pHeader + s_HeaderAlphaMask)
+		};
+
+		if (Masks[0] == 0x000000FF && Masks[1] == 0x0000FF00 && Masks[2] == 0x00FF0000 && Masks[3] == 0xFF000000) return VK_FORMAT_R8G8B8A8_UNORM;
+		if (Masks[0] == 0x00FF0000 && Masks[1] == 0x0000FF00 && Masks[2] == 0x000000FF && Masks[3] == 0xFF000000) return VK_FORMAT_B8G8R8A8_UNORM;
+	}
+
+	return VK_FORMAT_UNDEFINED;
+}
+
+uint32_t GetBlockBytes(
+	VkFormat Format
+)
+{
+	switch (Format)
+	{
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+	case VK_FORMAT_BC4_UNORM_BLOCK:
+		return 8;
+	case VK_FORMAT_BC2_UNORM_BLOCK:
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+}
+
+size_t GetDdsLevelSize(
+	VkFormat Format,
+	uint32_t Width,
+	uint32_t Height
+)
+{
+	if (Format == VK_FORMAT_R8G8B8A8_UNORM || Format == VK_FORMAT_B8G8R8A8_UNORM)
+	{
+		return static_cast<size_t>(Width) * Height * 4;
+	}
+
+	/** In size_t, a width close to UINT32_MAX would wrap to zero blocks */
+	return ((static_cast<size_t>(Width) + 3) / 4) * ((static_cast<size_t>(Height) + 3) / 4) * GetBlockBytes(Format);
+}
+
+bool ParseDds(
+	const uint8_t * pFile,
+	size_t FileSize,
+	DdsImage & Image
+)
+{
+	if (FileSize < 4 + s_DdsHeaderSize || ReadUint32(pFile) != s_DdsMagic)
+	{
+		return false;
+	}
+
+	const uint8_t * pHeader = pFile + 4;
+
+	if (ReadUint32(pHeader) != s_DdsHeaderSize || ReadUint32(pHeader + s_HeaderPixelFormatSize) != 32)
+	{
+		return false;
+	}
+
+	if (ReadUint32(pHeader + s_HeaderCaps2) & (s_Caps2CubeMap | s_Caps2Volume))
+	{
+		return false;
+	}
+
+	size_t DataOffset = 4 + s_DdsHeaderSize;
+	VkFormat Format = VK_FORMAT_UNDEFINED;
+
+	if ((ReadUint32(pHeader + s_HeaderPixelFormatFlags) & s_PixelFormatFourCC) &&
+		ReadUint32(pHeader + s_HeaderFourCC) == MakeFourCC('D', 'X', '1', '0'))
+	{
+		if (FileSize < DataOffset + s_DdsDx10HeaderSize)
+		{
+			return false;
+		}
+
+		const uint8_t * pDx10Header = pFile + DataOffset;
+		const uint32_t DxgiFormat = ReadUint32(pDx10Header);
+
+		if (ReadUint32(pDx10Header + 4) != s_Dx10DimensionTexture2D ||
+			(ReadUint32(pDx10Header + 8) & s_Dx10MiscTextureCube) ||
+			ReadUint32(pDx10Header + 12) != 1)
+		{
+			return false;
+		}
+
+		for (const DxgiFormatMapping & Mapping : s_DxgiFormats)
+		{
+			Format = Mapping.DxgiFormat == DxgiFormat ? Mapping.Format : Format;
+		}
+
+		DataOffset += s_DdsDx10HeaderSize;
+	}
+	else
+	{
+		Format = GetLegacyFormat(pHeader);
+	}
+
+	if (Format == VK_FORMAT_UNDEFINED)
+	{
+		return false;
+	}
+
+	Image.Format = Format;
+	Image.Width = ReadUint32(pHeader + s_HeaderWidth);
+	Image.Height = ReadUint32(pHeader + s_HeaderHeight);
+
+	if (Image.Width == 0 || Image.Height == 0)
+	{
+		return false;
+	}
+
+	/** Writers disagree on the flag, a count without it is still honored and a zero count means one level */
+	const uint32_t FullMipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(Image.Width, Image.Height)))) + 1;
+	Image.MipLevels = std::min(std::max(ReadUint32(pHeader + s_HeaderMipMapCount), 1u), FullMipLevels);
+
+	Image.LevelOffsets.resize(Image.MipLevels);
+	Image.LevelSizes.resize(Image.MipLevels);
+
+	size_t Offset = 0;
+	for (uint32_t Level = 0; Level < Image.MipLevels; Level++)
+	{
+		Image.LevelOffsets[Level] = Offset;
+		Image.LevelSizes[Level] = GetDdsLevelSize(Format, std::max(Image.Width >> Level, 1u), std::max(Image.Height >> Level, 1u));
+		Offset += Image.LevelSizes[Level];
+	}
+
+	if (FileSize - DataOffset < Offset)
+	{
+		return false;
+	}
+
+	Image.pData = pFile + DataOffset;
+	Image.DataSize = Offset;
+
+	return true;
+}
+
+bool WriteDds(
+	const std::string & Filename,
+	VkFormat Format,
+	uint32_t Width,
+	uint32_t Height,
+	const std::vector<std::vector<uint8_t>> & Levels
+)
+{
+	uint32_t DxgiFormat = 0;
+	for (const DxgiFormatMapping & Mapping : s_DxgiFormats)
+	{
+		DxgiFormat = Mapping.Format == Format ? Mapping.DxgiFormat : DxgiFormat;
+	}
+
+	if (DxgiFormat == 0 || Levels.empty())
+	{
+		return false;
+	}
+
+	size_t DataSize = 0;
+	for (uint32_t Level = 0; Level < Levels.size(); Level++)
+	{
+		if (Levels[Level].size() != GetDdsLevelSize(Format, std::max(Width >> Level, 1u), std::max(Height >> Level, 1u)))
+		{
+			return false;
+		}
+		DataSize += Levels[Level].size();
+	}
+
+	std::vector<uint8_t> File(4 + s_DdsHeaderSize + s_DdsDx10HeaderSize + DataSize, 0);
+
+	WriteUint32(&File[0], s_DdsMagic);
+
+	uint8_t * pHeader = &File[4];
+	const bool bBlockCompressed = GetBlockBytes(Format) != 0;
+
+	WriteUint32(pHeader, s_DdsHeaderSize);
+	WriteUint32(pHeader + s_HeaderFlags, s_FlagCaps | s_FlagHeight | s_FlagWidth | s_FlagPixelFormat | s_FlagMipMapCount | (bBlockCompressed ? s_FlagLinearSize : 0));
+	WriteUint32(pHeader + s_HeaderHeight, Height);
+	WriteUint32(pHeader + s_HeaderWidth, Width);
+	WriteUint32(pHeader + s_HeaderPitchOrLinearSize, static_cast<uint32_t>(bBlockCompressed ? Levels[0].size() : static_cast<size_t>(Width) * 4));
+	WriteUint32(pHeader + s_HeaderMipMapCount, static_cast<uint32_t>(Levels.size()));
+	WriteUint32(pHeader + s_HeaderPixelFormatSize, 32);
+	WriteUint32(pHeader + s_HeaderPixelFormatFlags, s_PixelFormatFourCC);
+	WriteUint32(pHeader + s_HeaderFourCC, MakeFourCC('D', 'X', '1', '0'));
+	WriteUint32(pHeader + s_HeaderCaps, s_CapsTexture | (Levels.size() > 1 ? s_CapsComplex | s_CapsMipMap : 0));
+
+	uint8_t * pDx10Header = pHeader + s_DdsHeaderSize;
+	WriteUint32(pDx10Header, DxgiFormat);
+	WriteUint32(pDx10Header + 4, s_Dx10DimensionTexture2D);
+	WriteUint32(pDx10Header + 12, 1);
+
+	uint8_t * pData = pDx10Header + s_DdsDx10HeaderSize;
+	for (const std::vector<uint8_t> & Level : Levels)
+	{
+		memcpy(pData, Level.data(), Level.size());
+		pData += Level.size();
+	}
+
+	return WriteFileAtomically(Filename, File.data(), File.size());
+}
+
+NAMESPACE_END
@@ -0,0 +1,59 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** A single 2D texture with its whole mip chain as stored in a DDS file, ready to be copied to the GPU as is. */
+struct DdsImage
+{
+	VkFormat Format = VK_FORMAT_UNDEFINED;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t MipLevels = 0;
+	/** Relative to pData, levels are tightly packed and follow each other */
+	std::vector<size_t> LevelOffsets;
+	std::vector<size_t> LevelSizes;
+	/** Points into the parsed memory, all levels */
+	const uint8_t * pData = nullptr;
+	size_t DataSize = 0;
+};
+
+/**
+* Parses the headers of a DDS file in memory, usually a MappedFile. Reads the DX10 header and the
+* legacy DXT/ATI FourCCs and 32-bit RGBA masks. Returns false for volumes, cube maps, arrays,
+* formats without a matching VkFormat and files shorter than their mip chain.
+*/
+bool ParseDds(
+	const uint8_t * pFile,
+	size_t FileSize,
+	DdsImage & Image
+);
+
+/** Bytes of one level of Format, 0 if ParseDds does not know the format. */
+size_t GetDdsLevelSize(
+	VkFormat Format,
+	uint32_t Width,
+	uint32_t Height
+);
+
+/** Writes the levels, largest first, with a DX10 header. Returns false if the format has no DXGI equivalent or the file can not be written. */
+bool WriteDds(
+	const std::string & Filename,
+	VkFormat Format,
+	uint32_t Width,
+	uint32_t Height,
+	const std::vector<std::vector<uint8_t>> & Levels
+);
+
+NAMESPACE_END
@@ -0,0 +1,240 @@
+#include "DrawList.hpp"
+#include "ThreadPool.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+void BuildInstanceBounds(
+	const MeshScene & Scene,
+	ThreadPool & Pool,
+	std::vector<InstanceBounds> & Bounds,
+	std::vector<uint32_t> & InstanceOrder
+)
+{
+	Bounds.resize(Scene.Instances.size());
+	InstanceOrder.resize(Scene.Instances.size());
+
+	/** Square root of the UV area over the object space area of the full detail triangles, a mean stretch good enough to pick a mip */
+	std::vector<float> MeshUvDensities(Scene.Meshes.size(), 0.0f);
+
+	Pool.ParallelFor(static_cast<uint32_t>(Scene.Meshes.size()), [&](uint32_t MeshIndex)
+	{
+		const SceneMesh & Mesh = Scene.Meshes[MeshIndex];
+		double Area = 0.0;
+		double UvArea = 0.0;
+
+		for (uint32_t i = Mesh.FirstSubMesh; i < Mesh.FirstSubMesh + Mesh.SubMeshCount; i++)
+		{
+			const SubMesh & Part = Scene.SubMeshes[i];
+
+			for (uint32_t Index = Part.FirstIndex; Index + 2 < Part.FirstIndex + Part.IndexCount; Index += 3)
+			{
+				const MeshVertex & V0 = Scene.Vertices[Part.VertexOffset + Scene.Indices[Index + 0]];
+				const MeshVertex & V1 = Scene.Vertices[Part.VertexOffset + Scene.Indices[Index + 1]];
+				const MeshVertex & V2 = Scene.Vertices[Part.VertexOffset + Scene.Indices[Index + 2]];
+
+				glm::vec2 Uv1 = V1.TexCoord - V0.TexCoord;
+				glm::vec2 Uv2 = V2.TexCoord - V0.TexCoord;
+
+				Area += glm::length(glm::cross(V1.Position - V0.Position, V2.Position - V0.Position));
+				UvArea += std::abs(Uv1.x * Uv2.y - Uv1.y * Uv2.x);
+			}
+		}
+
+		MeshUvDensities[MeshIndex] = Area > 0.0 ? static_cast<float>(std::sqrt(UvArea / Area)) : 0.0f;
+	});
+
+	for (uint32_t i = 0; i < Scene.Instances.size(); i++)
+	{
+		const glm::mat4 & World = Scene.Instances[i].World;
+		const SceneMesh & Mesh = Scene.Meshes[Scene.Instances[i].MeshIndex];
+
+		InstanceBounds & Instance = Bounds[i];
+		Instance.Scale = std::max(glm::length(glm::vec3(World[0])), std::max(glm::length(glm::vec3(World[1])), glm::length(glm::vec3(World[2]))));
+		Instance.Center = glm::vec3(World * glm::vec4(Mesh.BoundsCenter, 1.0f));
+		Instance.Radius = Mesh.BoundsRadius * Instance.Scale;
+		Instance.InverseWorld = glm::inverse(World);
+		Instance.bMirrored = glm::determinant(glm::mat3(World)) < 0.0f;
+		Instance.UvDensity = Instance.Scale > 0.0f ? MeshUvDensities[Scene.Instances[i].MeshIndex] / Instance.Scale : 0.0f;
+
+		InstanceOrder[i] = i;
+	}
+
+	/** Grouping by material keeps descriptor set binds to one per material and recording task */
+	std::stable_sort(InstanceOrder.begin(), InstanceOrder.end(), [&Scene](uint32_t Lhs, uint32_t Rhs)
+	{
+		return Scene.Meshes[Scene.Instances[Lhs].MeshIndex].MaterialIndex < Scene.Meshes[Scene.Instances[Rhs].MeshIndex].MaterialIndex;
+	});
+}
+
+void BuildDrawList(
+	const DrawListSettings & Settings,
+	const DrawListView & View,
+	const MeshScene & Scene,
+	const std::vector<InstanceBounds> & Bounds,
+	const std::vector<uint32_t> & InstanceOrder,
+	std::vector<DrawCommand> & DrawCommands,
+	CullingStatistics & Statistics,
+	std::vector<float> & MaterialPixelsPerUv
+)
+{
+	DrawCommands.clear();
+	Statistics = CullingStatistics();
+	MaterialPixelsPerUv.assign(Scene.Materials.size(), 0.0f);
+
+	float Aspect = static_cast<float>(View.Width) / static_cast<float>(View.Height);
+
+	/** Pixels covered by one unit of error at distance one */
+	float ProjectionScale = static_cast<float>(View.Height) / (2.0f * std::tan(View.Fov.y * 0.5f));
+
+	/** Gribb and Hartmann: the frustum planes are sums of the rows of the view projection matrix, depth is 0 to 1 */
+	glm::mat4 Rows = glm::transpose(glm::perspective(View.Fov.y, Aspect, View.NearZ, View.FarZ) * glm::lookAt(View.Eye, View.Target, View.Up));
+	std::array<glm::vec4, 6> Planes =
+	{
+		Rows[3] + Rows[0], Rows[3] - Rows[0],
+		Rows[3] + Rows[1], Rows[3] - Rows[1],
+		Rows[2], Rows[3] - Rows[2]
+	};
+	for (glm::vec4 & Plane : Planes)
+	{
+		Plane /= glm::length(glm::vec3(Plane));
+	}
+
+	/** Negative if the sphere is outside, 0 if it crosses a plane, positive if it is inside */
+	auto ClassifySphere = [&Planes](const glm::vec3 & Center, float Radius)
+	{
+		int Result = 1;
+		for (const glm::vec4 & Plane : Planes)
+		{
+			float Distance = glm::dot(glm::vec3(Plane), Center) + Plane.w;
+			if (Distance < -Radius)
+			{
+				return -1;
+			}
+			if (Distance < Radius)
+			{
+				Result = 0;
+			}
+		}
+		return Result;
+	};
+
+	for (uint32_t InstanceIndex : InstanceOrder)
+	{
+		const SceneMesh & Mesh = Scene.Meshes[Scene.Instances[InstanceIndex].MeshIndex];
+		const InstanceBounds & Instance = Bounds[InstanceIndex];
+
+		/** Measured at the nearest point of the bounds */
+		float Distance = std::max(glm::length(Instance.Center - View.Eye) - Instance.Radius, View.NearZ);
+
+		/** Coarsest level whose error still projects below the threshold */
+		uint32_t Lod = 0;
+		if (Settings.bLodEnabled)
+		{
+			float PixelsPerUnit = Instance.Scale * ProjectionScale / Distance;
+
+			while (Lod + 1 < Mesh.LodCount && Mesh.LodErrors[Lod + 1] * PixelsPerUnit <= Settings.LodErrorThreshold)
+			{
+				Lod++;
+			}
+		}
+
+		int InstanceVisibility = Settings.bMeshletCullingEnabled ? ClassifySphere(Instance.Center, Instance.Radius) : 1;
+
+		/** The texture streamer loads the mips the nearest visible instance of each material needs */
+		uint32_t MaterialIndex = Mesh.MaterialIndex < Scene.Materials.size() ? Mesh.MaterialIndex : 0;
+		if (InstanceVisibility >= 0 && Instance.UvDensity > 0.0f && MaterialIndex < MaterialPixelsPerUv.size())
+		{
+			float PixelsPerUv = ProjectionScale / (Distance * Instance.UvDensity);
+			MaterialPixelsPerUv[MaterialIndex] = std::max(MaterialPixelsPerUv[MaterialIndex], PixelsPerUv);
+		}
+		bool bConeCulling = Settings.bMeshletCullingEnabled && Settings.bBackfaceCulling && !Instance.bMirrored;
+		glm::vec3 ObjectEye = glm::vec3(Instance.InverseWorld * glm::vec4(View.Eye, 1.0f));
+		const glm::mat4 & World = Scene.Instances[InstanceIndex].World;
+
+		uint32_t FirstSubMesh = Mesh.FirstSubMesh + Lod * Mesh.SubMeshCount;
+
+		for (uint32_t i = FirstSubMesh; i < FirstSubMesh + Mesh.SubMeshCount; i++)
+		{
+			const SubMesh & Part = Scene.SubMeshes[i];
+			if (Part.IndexCount == 0)
+			{
+				continue;
+			}
+
+			Statistics.MeshletCount += Part.MeshletCount;
+			Statistics.TriangleCount += Part.IndexCount / 3;
+
+			DrawCommand Draw;
+			Draw.VertexOffset = static_cast<int32_t>(Part.VertexOffset);
+			Draw.MaterialIndex = MaterialIndex;
+			Draw.InstanceIndex = InstanceIndex;
+
+			if (InstanceVisibility < 0)
+			{
+				Statistics.FrustumCulledMeshletCount += Part.MeshletCount;
+				Statistics.CulledTriangleCount += Part.IndexCount / 3;
+				continue;
+			}
+
+			/** Nothing to cull per meshlet, draw the whole range */
+			if (Part.MeshletCount == 0 || (InstanceVisibility > 0 && !bConeCulling))
+			{
+				Draw.FirstIndex = Part.FirstIndex;
+				Draw.IndexCount = Part.IndexCount;
+				DrawCommands.push_back(Draw);
+				continue;
+			}
+
+			/** Meshlets are contiguous in the index buffer, consecutive visible ones merge into one draw */
+			Draw.IndexCount = 0;
+
+			for (uint32_t m = Part.FirstMeshlet; m < Part.FirstMeshlet + Part.MeshletCount; m++)
+			{
+				const Meshlet & Cluster = Scene.Meshlets[m];
+
+				bool bCulled = false;
+				if (InstanceVisibility == 0 &&
+					ClassifySphere(glm::vec3(World * glm::vec4(Cluster.Center, 1.0f)), Cluster.Radius * Instance.Scale) < 0)
+				{
+					Statistics.FrustumCulledMeshletCount++;
+					bCulled = true;
+				}
+				else if (bConeCulling && glm::dot(glm::normalize(Cluster.ConeApex - ObjectEye), Cluster.ConeAxis) > Cluster.ConeCutoff)
+				{
+					Statistics.BackfaceCulledMeshletCount++;
+					bCulled = true;
+				}
+
+				if (bCulled)
+				{
+					Statistics.CulledTriangleCount += Cluster.IndexCount / 3;
+					if (Draw.IndexCount > 0)
+					{
+						DrawCommands.push_back(Draw);
+						Draw.IndexCount = 0;
+					}
+					continue;
+				}
+
+				if (Draw.IndexCount == 0)
+				{
+					Draw.FirstIndex = Part.FirstIndex + Cluster.FirstIndex;
+				}
+				Draw.IndexCount += Cluster.IndexCount;
+			}
+
+			if (Draw.IndexCount > 0)
+			{
+				DrawCommands.push_back(Draw);
+			}
+		}
+	}
+}
+
+NAMESPACE_END
@@ -0,0 +1,103 @@
+#pragma once
+
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "Namespace.hpp"
+#include "MeshImporter.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+class ThreadPool;
+
+/** World space bounding sphere of an instance, and the largest scale of its transform */
+struct InstanceBounds
+{
+	glm::vec3 Center;
+	float Radius;
+	float Scale;
+	/** Meshlet cones are tested in object space, they are meaningless if the transform mirrors */
+	glm::mat4 InverseWorld;
+	bool bMirrored;
+	/** UV units per world unit on the surface of the mesh, zero if it has no texture coordinates */
+	float UvDensity;
+};
+
+/** Of the last BuildDrawList, counted on the selected levels of detail */
+struct CullingStatistics
+{
+	size_t MeshletCount = 0;
+	size_t FrustumCulledMeshletCount = 0;
+	size_t BackfaceCulledMeshletCount = 0;
+	size_t TriangleCount = 0;
+	size_t CulledTriangleCount = 0;
+};
+
+struct DrawCommand
+{
+	uint32_t IndexCount = 0;
+	uint32_t FirstIndex = 0;
+	int32_t VertexOffset = 0;
+	uint32_t MaterialIndex = 0;
+	uint32_t InstanceIndex = 0;
+};
+
+struct DrawListSettings
+{
+	/** Largest projected error, in pixels, the selection accepts */
+	float LodErrorThreshold = 1.0f;
+	bool bLodEnabled = true;
+	/** Meshlets outside the frustum are skipped, and with back face culling those facing away too */
+	bool bMeshletCullingEnabled = true;
+	/** The cones only say which meshlets face away, that is only worth something if the pipeline culls back faces */
+	bool bBackfaceCulling = false;
+};
+
+/** The camera and the viewport the draw list is built for */
+struct DrawListView
+{
+	glm::vec3 Eye;
+	glm::vec3 Target;
+	glm::vec3 Up;
+	glm::vec2 Fov;
+	float NearZ;
+	float FarZ;
+	uint32_t Width;
+	uint32_t Height;
+};
+
+/**
+* Bounds of every instance of Scene, and the instances sorted by material: walking them in this
+* order keeps the draws sorted without a per frame sort. The UV density of each mesh is measured
+* on Pool. Every instance must reference a mesh of Scene.
+*/
+void BuildInstanceBounds(
+	const MeshScene & Scene,
+	ThreadPool & Pool,
+	std::vector<InstanceBounds> & Bounds,
+	std::vector<uint32_t> & InstanceOrder
+);
+
+/**
+* Pick the level of detail of every instance from its projected error, cull its meshlets against
+* the frustum and, with back face culling, their normal cones, and build one draw per run of
+* visible meshlets in InstanceOrder. MaterialPixelsPerUv receives the screen space texel density
+* the nearest visible instance of each material needs, for the texture streamer.
+*/
+void BuildDrawList(
+	const DrawListSettings & Settings,
+	const DrawListView & View,
+	const MeshScene & Scene,
+	const std::vector<InstanceBounds> & Bounds,
+	const std::vector<uint32_t> & InstanceOrder,
+	std::vector<DrawCommand> & DrawCommands,
+	CullingStatistics & Statistics,
+	std::vector<float> & MaterialPixelsPerUv
+);
+
+NAMESPACE_END
@@ -0,0 +1,128 @@
+#include "Hash.hpp"
+
+#include <cstring>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+const uint64_t s_Prime1 = 0x9E3779B185EBCA87ull;
+const uint64_t s_Prime2 = 0xC2B2AE3D27D4EB4Full;
+const uint64_t s_Prime3 = 0x165667B19E3779F9ull;
+const uint64_t s_Prime4 = 0x85EBCA77C2B2AE63ull;
+const uint64_t s_Prime5 = 0x27D4EB2F165667C5ull;
+
+inline uint64_t RotateLeft(uint64_t Value, int Bits)
+{
+	return (Value << Bits) | (Value >> (64 - Bits));
+}
+
+inline uint64_t Read64(const uint8_t * pData)
+{
+	uint64_t Value;
+	memcpy(&Value, pData, sizeof(Value));
+	return Value;
+}
+
+inline uint32_t Read32(const uint8_t * pData)
+{
+	uint32_t Value;
+	memcpy(&Value, pData, sizeof(Value));
+	return Value;
+}
+
+inline uint64_t Round(uint64_t Accumulator, uint64_t Input)
+{
+	Accumulator += Input * s_Prime2;
+	Accumulator = RotateLeft(Accumulator, 31);
+	return Accumulator * s_Prime1;
+}
+
+inline uint64_t MergeRound(uint64_t Accumulator, uint64_t Value)
+{
+	Accumulator ^= Round(0, Value);
+	return Accumulator * s_Prime1 + s_Prime4;
+}
+
+}
+
+uint64_t HashBytes(
+	const void * pData,
+	size_t Size,
+	uint64_t Seed
+)
+{
+	const uint8_t * pBytes = static_cast<const uint8_t *>(pData);
+	const uint8_t * pEnd = pBytes + Size;
+	uint64_t Hash = 0;
+
+	if (Size >= 32)
+	{
+		/** Four independent lanes keep the multipliers busy */
+		uint64_t V1 = Seed + s_Prime1 + s_Prime2;
+		uint64_t V2 = Seed + s_Prime2;
+		uint64_t V3 = Seed;
+		uint64_t V4 = Seed - s_Prime1;
+
+		const uint8_t * pLimit = pEnd - 32;
+		do
+		{
+			V1 = Round(V1, Read64(pBytes)); pBytes += 8;
+			V2 = Round(V2, Read64(pBytes)); pBytes += 8;
+			V3 = Round(V3, Read64(pBytes)); pBytes += 8;
+			V4 = Round(V4, Read64(pBytes)); pBytes += 8;
+		} while (pBytes <= pLimit);
+
+		Hash = RotateLeft(V1, 1) + RotateLeft(V2, 7) + RotateLeft(V3, 12) + RotateLeft(V4, 18);
+		Hash = MergeRound(Hash, V1);
+		Hash = MergeRound(Hash, V2);
+		Hash = MergeRound(Hash, V3);
+		Hash = MergeRound(Hash, V4);
+	}
+	else
+	{
+		Hash = Seed + s_Prime5;
+	}
+
+	Hash += static_cast<uint64_t>(Size);
+
+	while (pBytes + 8 <= pEnd)
+	{
+		Hash ^= Round(0, Read64(pBytes));
+		Hash = RotateLeft(Hash, 27) * s_Prime1 + s_Prime4;
+		pBytes += 8;
+	}
+
+	if (pBytes + 4 <= pEnd)
+	{
+		Hash ^= static_cast<uint64_t>(Read32(pBytes)) * s_Prime1;
+		Hash = RotateLeft(Hash, 23) * s_Prime2 + s_Prime3;
+		pBytes += 4;
+	}
+
+	while (pBytes < pEnd)
+	{
+		Hash ^= (*pBytes) * s_Prime5;
+		Hash = RotateLeft(Hash, 11) * s_Prime1;
+		pBytes++;
+	}
+
+	Hash ^= Hash >> 33;
+	Hash *= s_Prime2;
+	Hash ^= Hash >> 29;
+	Hash *= s_Prime3;
+	Hash ^= Hash >> 32;
+
+	return Hash;
+}
+
+uint64_t HashCombine(
+	uint64_t Hash,
+	uint64_t Value
+)
+{
+	return HashBytes(&Value, sizeof(Value), Hash);
+}
+
+NAMESPACE_END
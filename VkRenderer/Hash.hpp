@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** 64-bit non-cryptographic hash (XXH64 algorithm), fast enough to checksum whole asset files. */
+uint64_t HashBytes(
+	const void * pData,
+	size_t Size,
+	uint64_t Seed = 0
+);
+
+/** Mix a 64-bit value into an existing hash. */
+uint64_t HashCombine(
+	uint64_t Hash,
+	uint64_t Value
+);
+
+NAMESPACE_END
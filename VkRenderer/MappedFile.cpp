@@ -0,0 +1,195 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <filesystem>
+#include <fstream>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(
+	const std::string & Filename
+)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE FileHandle = CreateFileA(
+		Filename.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		nullptr
+	);
+
+	if (FileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(FileHandle, &FileSize))
+	{
+		CloseHandle(FileHandle);
+		return false;
+	}
+
+	m_FileHandle = FileHandle;
+	m_Size = static_cast<size_t>(FileSize.QuadPart);
+	m_bOpen = true;
+
+	if (m_Size == 0)
+	{
+		return true;
+	}
+
+	m_MappingHandle = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_MappingHandle == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = static_cast<const uint8_t *>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+	m_FileDescriptor = open(Filename.c_str(), O_RDONLY);
+	if (m_FileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat FileStat;
+	if (fstat(m_FileDescriptor, &FileStat) != 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_Size = static_cast<size_t>(FileStat.st_size);
+	m_bOpen = true;
+
+	if (m_Size == 0)
+	{
+		return true;
+	}
+
+	void * pData = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+	m_pData = pData == MAP_FAILED ? nullptr : static_cast<const uint8_t *>(pData);
+#endif
+
+	if (m_pData == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_pData != nullptr)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+
+	if (m_MappingHandle != nullptr)
+	{
+		CloseHandle(m_MappingHandle);
+		m_MappingHandle = nullptr;
+	}
+
+	if (m_FileHandle != nullptr)
+	{
+		CloseHandle(m_FileHandle);
+		m_FileHandle = nullptr;
+	}
+#else
+	if (m_pData != nullptr)
+	{
+		munmap(const_cast<uint8_t *>(m_pData), m_Size);
+	}
+
+	if (m_FileDescriptor >= 0)
+	{
+		close(m_FileDescriptor);
+		m_FileDescriptor = -1;
+	}
+#endif
+
+	m_pData = nullptr;
+	m_Size = 0;
+	m_bOpen = false;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return m_bOpen;
+}
+
+const uint8_t * MappedFile::GetData() const
+{
+	return m_pData;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_Size;
+}
+
+bool WriteFileAtomically(
+	const std::string & Filename,
+	const void * pData,
+	size_t Size
+)
+{
+	std::string TemporaryFilename = Filename + ".tmp";
+
+	std::ofstream File(TemporaryFilename, std::ios::binary | std::ios::trunc);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	File.write(static_cast<const char *>(pData), static_cast<std::streamsize>(Size));
+	File.close();
+
+	bool bSuccess = !File.fail();
+
+	std::error_code Error;
+	if (bSuccess)
+	{
+		std::filesystem::rename(TemporaryFilename, Filename, Error);
+		bSuccess = !Error;
+	}
+
+	if (!bSuccess)
+	{
+		std::filesystem::remove(TemporaryFilename, Error);
+	}
+
+	return bSuccess;
+}
+
+NAMESPACE_END
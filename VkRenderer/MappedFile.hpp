@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** Chunk and file identifiers of the binary formats written by the renderer. */
+constexpr uint32_t MakeFourCC(char A, char B, char C, char D)
+{
+	return static_cast<uint32_t>(static_cast<uint8_t>(A)) |
+		(static_cast<uint32_t>(static_cast<uint8_t>(B)) << 8) |
+		(static_cast<uint32_t>(static_cast<uint8_t>(C)) << 16) |
+		(static_cast<uint32_t>(static_cast<uint8_t>(D)) << 24);
+}
+
+/** Read only memory mapping of a whole file. */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+	~MappedFile();
+
+	/** Returns false if the file does not exist or can not be mapped. */
+	bool Open(
+		const std::string & Filename
+	);
+
+	void Close();
+
+	bool IsOpen() const;
+
+	const uint8_t * GetData() const;
+
+	size_t GetSize() const;
+
+protected:
+	const uint8_t * m_pData = nullptr;
+	size_t m_Size = 0;
+	/** Empty files are valid but can not be mapped */
+	bool m_bOpen = false;
+
+#ifdef _WIN32
+	void * m_FileHandle = nullptr;
+	void * m_MappingHandle = nullptr;
+#else
+	int m_FileDescriptor = -1;
+#endif
+};
+
+/** Writes to a temporary file and renames it over Filename, readers never see a partial file. */
+bool WriteFileAtomically(
+	const std::string & Filename,
+	const void * pData,
+	size_t Size
+);
+
+NAMESPACE_END
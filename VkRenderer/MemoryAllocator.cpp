@@ -0,0 +1,414 @@
+#include "MemoryAllocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+MemoryBlock::MemoryBlock(
+	VkDeviceSize Size,
+	uint32_t MemoryTypeIndex,
+	bool bLinear,
+	bool bDedicated
+) : m_Size(Size), m_MemoryTypeIndex(MemoryTypeIndex), m_bLinear(bLinear), m_bDedicated(bDedicated)
+{
+	m_FreeRanges.push_back({ 0, Size });
+}
+
+bool MemoryBlock::Allocate(
+	VkDeviceSize Size,
+	VkDeviceSize Alignment,
+	VkDeviceSize & Offset
+)
+{
+	/** First fit, the padding in front of an aligned allocation stays in the free list */
+	for (size_t i = 0; i < m_FreeRanges.size(); i++)
+	{
+		FreeRange Range = m_FreeRanges[i];
+		VkDeviceSize AlignedOffset = (Range.Offset + Alignment - 1) / Alignment * Alignment;
+		VkDeviceSize Padding = AlignedOffset - Range.Offset;
+
+		if (Padding + Size > Range.Size)
+		{
+			continue;
+		}
+
+		VkDeviceSize Remain = Range.Size - Padding - Size;
+		m_FreeRanges.erase(m_FreeRanges.begin() + i);
+
+		if (Remain > 0)
+		{
+			m_FreeRanges.insert(m_FreeRanges.begin() + i, { AlignedOffset + Size, Remain });
+		}
+
+		if (Padding > 0)
+		{
+			m_FreeRanges.insert(m_FreeRanges.begin() + i, { Range.Offset, Padding });
+		}
+
+		Offset = AlignedOffset;
+		m_UsedBytes += Size;
+		m_AllocationCount++;
+		return true;
+	}
+
+	return false;
+}
+
+void MemoryBlock::Free(
+	VkDeviceSize Offset,
+	VkDeviceSize Size
+)
+{
+	auto Iter = std::lower_bound(
+		m_FreeRanges.begin(),
+		m_FreeRanges.end(),
+		Offset,
+		[](const FreeRange & Range, VkDeviceSize Value) { return Range.Offset < Value; }
+	);
+
+	Iter = m_FreeRanges.insert(Iter, { Offset, Size });
+
+	/** Merge with the next range */
+	auto Next = Iter + 1;
+	if (Next != m_FreeRanges.end() && Iter->Offset + Iter->Size == Next->Offset)
+	{
+		Iter->Size += Next->Size;
+		m_FreeRanges.erase(Next);
+	}
+
+	/** Merge with the previous range */
+	if (Iter != m_FreeRanges.begin())
+	{
+		auto Prev = Iter - 1;
+		if (Prev->Offset + Prev->Size == Iter->Offset)
+		{
+			Prev->Size += Iter->Size;
+			m_FreeRanges.erase(Iter);
+		}
+	}
+
+	m_UsedBytes -= Size;
+	m_AllocationCount--;
+}
+
+bool MemoryBlock::IsEmpty() const
+{
+	return m_AllocationCount == 0;
+}
+
+VkDeviceSize MemoryBlock::GetSize() const
+{
+	return m_Size;
+}
+
+VkDeviceSize MemoryBlock::GetUsedBytes() const
+{
+	return m_UsedBytes;
+}
+
+uint32_t MemoryBlock::GetAllocationCount() const
+{
+	return m_AllocationCount;
+}
+
+uint32_t MemoryBlock::GetMemoryTypeIndex() const
+{
+	return m_MemoryTypeIndex;
+}
+
+bool MemoryBlock::IsLinear() const
+{
+	return m_bLinear;
+}
+
+bool MemoryBlock::IsDedicated() const
+{
+	return m_bDedicated;
+}
+
+void MemoryAllocator::Init(
+	VkPhysicalDevice PhysicalDevice,
+	VkDevice Device
+)
+{
+	m_PhysicalDevice = PhysicalDevice;
+	m_Device = Device;
+	vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &m_MemoryProperties);
+}
+
+void MemoryAllocator::Destroy()
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	for (auto & pBlock : m_Blocks)
+	{
+		if (pBlock->pMappedData != nullptr)
+		{
+			vkUnmapMemory(m_Device, pBlock->Memory);
+		}
+		vkFreeMemory(m_Device, pBlock->Memory, nullptr);
+	}
+
+	m_Blocks.clear();
+}
+
+void MemoryAllocator::AllocateForBuffer(
+	VkBuffer Buffer,
+	VkMemoryPropertyFlags Properties,
+	MemoryAllocation & Allocation
+)
+{
+	VkMemoryRequirements MemoryRequirements;
+	vkGetBufferMemoryRequirements(m_Device, Buffer, &MemoryRequirements);
+
+	Allocate(MemoryRequirements, Properties, true, Allocation);
+
+	if (vkBindBufferMemory(m_Device, Buffer, Allocation.Memory, Allocation.Offset) != VK_SUCCESS)
+	{
+		Free(Allocation);
+		throw std::runtime_error("Failed to bind buffer memory!");
+	}
+}
+
+void MemoryAllocator::AllocateForImage(
+	VkImage Image,
+	VkMemoryPropertyFlags Properties,
+	MemoryAllocation & Allocation
+)
+{
+	VkMemoryRequirements MemoryRequirements;
+	vkGetImageMemoryRequirements(m_Device, Image, &MemoryRequirements);
+
+	Allocate(MemoryRequirements, Properties, false, Allocation);
+
+	if (vkBindImageMemory(m_Device, Image, Allocation.Memory, Allocation.Offset) != VK_SUCCESS)
+	{
+		Free(Allocation);
+		throw std::runtime_error("Failed to bind image memory!");
+	}
+}
+
+void MemoryAllocator::Free(
+	MemoryAllocation & Allocation
+)
+{
+	if (Allocation.pBlock == nullptr)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	MemoryBlock * pBlock = Allocation.pBlock;
+	pBlock->Free(Allocation.Offset, Allocation.Size);
+
+	if (pBlock->IsEmpty())
+	{
+		/** Keep one empty block per pool around so that alloc/free pairs do not hit the driver */
+		bool bKeep = !pBlock->IsDedicated() && std::none_of(
+			m_Blocks.begin(),
+			m_Blocks.end(),
+			[pBlock](const std::unique_ptr<MemoryBlock> & pOther)
+			{
+				return pOther.get() != pBlock &&
+					pOther->IsEmpty() &&
+					!pOther->IsDedicated() &&
+					pOther->GetMemoryTypeIndex() == pBlock->GetMemoryTypeIndex() &&
+					pOther->IsLinear() == pBlock->IsLinear();
+			}
+		);
+
+		if (!bKeep)
+		{
+			DestroyBlock(pBlock);
+		}
+	}
+
+	Allocation = MemoryAllocation();
+}
+
+std::vector<MemoryHeapStatistics> MemoryAllocator::GetStatistics() const
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	std::vector<MemoryHeapStatistics> Statistics(m_MemoryProperties.memoryHeapCount);
+	for (uint32_t i = 0; i < m_MemoryProperties.memoryHeapCount; i++)
+	{
+		Statistics[i].HeapSize = m_MemoryProperties.memoryHeaps[i].size;
+	}
+
+	for (const auto & pBlock : m_Blocks)
+	{
+		uint32_t HeapIndex = m_MemoryProperties.memoryTypes[pBlock->GetMemoryTypeIndex()].heapIndex;
+		Statistics[HeapIndex].BlockCount++;
+		Statistics[HeapIndex].AllocationCount += pBlock->GetAllocationCount();
+		Statistics[HeapIndex].BlockBytes += pBlock->GetSize();
+		Statistics[HeapIndex].UsedBytes += pBlock->GetUsedBytes();
+	}
+
+	return Statistics;
+}
+
+void MemoryAllocator::PrintStatistics(
+	std::ostream & Out
+) const
+{
+	std::vector<MemoryHeapStatistics> Statistics = GetStatistics();
+
+	for (size_t i = 0; i < Statistics.size(); i++)
+	{
+		Out << "[Memory heap " << i << "] "
+			<< "Blocks : " << Statistics[i].BlockCount << " "
+			<< "Allocations : " << Statistics[i].AllocationCount << " "
+			<< "Used : " << Statistics[i].UsedBytes / 1024 << " KB / "
+			<< Statistics[i].BlockBytes / 1024 << " KB "
+			<< "(Heap : " << Statistics[i].HeapSize / 1024 / 1024 << " MB)" << std::endl;
+	}
+}
+
+void MemoryAllocator::Allocate(
+	const VkMemoryRequirements & Requirements,
+	VkMemoryPropertyFlags Properties,
+	bool bLinear,
+	MemoryAllocation & Allocation
+)
+{
+	uint32_t MemoryTypeIndex = UINT32_MAX;
+	for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+	{
+		if (Requirements.memoryTypeBits & (1 << i) &&
+			(m_MemoryProperties.memoryTypes[i].propertyFlags & Properties) == Properties)
+		{
+			MemoryTypeIndex = i;
+			break;
+		}
+	}
+
+	if (MemoryTypeIndex == UINT32_MAX)
+	{
+		throw std::runtime_error("Failed to find suitable memory type");
+	}
+
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	VkDeviceSize BlockSize = GetPreferredBlockSize(MemoryTypeIndex);
+	MemoryBlock * pBlock = nullptr;
+	VkDeviceSize Offset = 0;
+
+	if (Requirements.size > BlockSize / 2)
+	{
+		/** Large resources get a block of their own */
+		pBlock = CreateBlock(Requirements.size, Requirements.size, MemoryTypeIndex, bLinear, true);
+		pBlock->Allocate(Requirements.size, Requirements.alignment, Offset);
+	}
+	else
+	{
+		for (auto & pCandidate : m_Blocks)
+		{
+			if (!pCandidate->IsDedicated() &&
+				pCandidate->GetMemoryTypeIndex() == MemoryTypeIndex &&
+				pCandidate->IsLinear() == bLinear &&
+				pCandidate->Allocate(Requirements.size, Requirements.alignment, Offset))
+			{
+				pBlock = pCandidate.get();
+				break;
+			}
+		}
+
+		if (pBlock == nullptr)
+		{
+			pBlock = CreateBlock(BlockSize, Requirements.size, MemoryTypeIndex, bLinear, false);
+			pBlock->Allocate(Requirements.size, Requirements.alignment, Offset);
+		}
+	}
+
+	Allocation.Memory = pBlock->Memory;
+	Allocation.Offset = Offset;
+	Allocation.Size = Requirements.size;
+	Allocation.pBlock = pBlock;
+	Allocation.pMappedData = pBlock->pMappedData != nullptr ?
+		static_cast<uint8_t *>(pBlock->pMappedData) + Offset : nullptr;
+}
+
+MemoryBlock * MemoryAllocator::CreateBlock(
+	VkDeviceSize Size,
+	VkDeviceSize MinSize,
+	uint32_t MemoryTypeIndex,
+	bool bLinear,
+	bool bDedicated
+)
+{
+	VkMemoryAllocateInfo AllocInfo = {};
+	AllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	AllocInfo.allocationSize = Size;
+	AllocInfo.memoryTypeIndex = MemoryTypeIndex;
+
+	VkDeviceMemory Memory = VK_NULL_HANDLE;
+	VkResult Result = vkAllocateMemory(m_Device, &AllocInfo, nullptr, &Memory);
+
+	/** A nearly full heap may still have room for a smaller block, try half and then a quarter of the size */
+	for (uint32_t i = 0; i < 2 && Result == VK_ERROR_OUT_OF_DEVICE_MEMORY && AllocInfo.allocationSize / 2 >= MinSize; i++)
+	{
+		AllocInfo.allocationSize /= 2;
+		Result = vkAllocateMemory(m_Device, &AllocInfo, nullptr, &Memory);
+	}
+
+	if (Result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate device memory block!");
+	}
+
+	void * pMappedData = nullptr;
+	if (m_MemoryProperties.memoryTypes[MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		if (vkMapMemory(m_Device, Memory, 0, VK_WHOLE_SIZE, 0, &pMappedData) != VK_SUCCESS)
+		{
+			/** Not in m_Blocks yet, Destroy would never free it */
+			vkFreeMemory(m_Device, Memory, nullptr);
+			throw std::runtime_error("Failed to map device memory block!");
+		}
+	}
+
+	std::unique_ptr<MemoryBlock> pBlock(new MemoryBlock(AllocInfo.allocationSize, MemoryTypeIndex, bLinear, bDedicated));
+	pBlock->Memory = Memory;
+	pBlock->pMappedData = pMappedData;
+
+	m_Blocks.push_back(std::move(pBlock));
+	return m_Blocks.back().get();
+}
+
+void MemoryAllocator::DestroyBlock(
+	MemoryBlock * pBlock
+)
+{
+	auto Iter = std::find_if(
+		m_Blocks.begin(),
+		m_Blocks.end(),
+		[pBlock](const std::unique_ptr<MemoryBlock> & pOther) { return pOther.get() == pBlock; }
+	);
+
+	if (Iter == m_Blocks.end())
+	{
+		return;
+	}
+
+	if (pBlock->pMappedData != nullptr)
+	{
+		vkUnmapMemory(m_Device, pBlock->Memory);
+	}
+	vkFreeMemory(m_Device, pBlock->Memory, nullptr);
+
+	m_Blocks.erase(Iter);
+}
+
+VkDeviceSize MemoryAllocator::GetPreferredBlockSize(
+	uint32_t MemoryTypeIndex
+) const
+{
+	/** Small heaps (e.g. the 256MB host visible device local heap) are not carved into 256MB blocks */
+	VkDeviceSize HeapSize = m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[MemoryTypeIndex].heapIndex].size;
+	return std::min(m_MaxBlockSize, HeapSize / 8);
+}
+
+NAMESPACE_END
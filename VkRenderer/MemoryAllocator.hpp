@@ -0,0 +1,169 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+class MemoryBlock;
+
+/** A region sub-allocated from a VkDeviceMemory block owned by the MemoryAllocator. */
+struct MemoryAllocation
+{
+	VkDeviceMemory Memory = VK_NULL_HANDLE;
+	VkDeviceSize Offset = 0;
+	VkDeviceSize Size = 0;
+	/** Host visible blocks are persistently mapped, this points at Offset inside the mapping. */
+	void * pMappedData = nullptr;
+	MemoryBlock * pBlock = nullptr;
+};
+
+struct MemoryHeapStatistics
+{
+	uint32_t BlockCount = 0;
+	uint32_t AllocationCount = 0;
+	VkDeviceSize BlockBytes = 0;
+	VkDeviceSize UsedBytes = 0;
+	VkDeviceSize HeapSize = 0;
+};
+
+/**
+* Free-list bookkeeping of one device memory block. It does not touch the device so
+* the sub-allocation logic can be exercised on its own.
+*/
+class MemoryBlock
+{
+public:
+	MemoryBlock(
+		VkDeviceSize Size,
+		uint32_t MemoryTypeIndex,
+		bool bLinear,
+		bool bDedicated
+	);
+
+	bool Allocate(
+		VkDeviceSize Size,
+		VkDeviceSize Alignment,
+		VkDeviceSize & Offset
+	);
+
+	void Free(
+		VkDeviceSize Offset,
+		VkDeviceSize Size
+	);
+
+	bool IsEmpty() const;
+
+	VkDeviceSize GetSize() const;
+	VkDeviceSize GetUsedBytes() const;
+	uint32_t GetAllocationCount() const;
+	uint32_t GetMemoryTypeIndex() const;
+	bool IsLinear() const;
+	bool IsDedicated() const;
+
+public:
+	VkDeviceMemory Memory = VK_NULL_HANDLE;
+	void * pMappedData = nullptr;
+
+protected:
+	struct FreeRange
+	{
+		VkDeviceSize Offset;
+		VkDeviceSize Size;
+	};
+
+	/** Sorted by offset, adjacent ranges are always merged. */
+	std::vector<FreeRange> m_FreeRanges;
+
+	VkDeviceSize m_Size = 0;
+	VkDeviceSize m_UsedBytes = 0;
+	uint32_t m_AllocationCount = 0;
+	uint32_t m_MemoryTypeIndex = 0;
+	bool m_bLinear = true;
+	bool m_bDedicated = false;
+};
+
+/**
+* Sub-allocates buffers and images from large per memory type blocks instead of
+* calling vkAllocateMemory for every resource. Linear (buffers) and optimal (images)
+* resources never share a block, so bufferImageGranularity can not be violated.
+*/
+class MemoryAllocator
+{
+public:
+	void Init(
+		VkPhysicalDevice PhysicalDevice,
+		VkDevice Device
+	);
+
+	void Destroy();
+
+	void AllocateForBuffer(
+		VkBuffer Buffer,
+		VkMemoryPropertyFlags Properties,
+		MemoryAllocation & Allocation
+	);
+
+	void AllocateForImage(
+		VkImage Image,
+		VkMemoryPropertyFlags Properties,
+		MemoryAllocation & Allocation
+	);
+
+	void Free(
+		MemoryAllocation & Allocation
+	);
+
+	std::vector<MemoryHeapStatistics> GetStatistics() const;
+
+	void PrintStatistics(
+		std::ostream & Out
+	) const;
+
+protected:
+	void Allocate(
+		const VkMemoryRequirements & Requirements,
+		VkMemoryPropertyFlags Properties,
+		bool bLinear,
+		MemoryAllocation & Allocation
+	);
+
+	/** Falls back to smaller blocks, down to a quarter of Size but no less than MinSize, if the heap is out of memory. */
+	MemoryBlock * CreateBlock(
+		VkDeviceSize Size,
+		VkDeviceSize MinSize,
+		uint32_t MemoryTypeIndex,
+		bool bLinear,
+		bool bDedicated
+	);
+
+	void DestroyBlock(
+		MemoryBlock * pBlock
+	);
+
+	VkDeviceSize GetPreferredBlockSize(
+		uint32_t MemoryTypeIndex
+	) const;
+
+protected:
+	VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
+	VkDevice m_Device = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties m_MemoryProperties = {};
+
+	const VkDeviceSize m_MaxBlockSize = 256ull * 1024 * 1024;
+
+	std::vector<std::unique_ptr<MemoryBlock>> m_Blocks;
+	mutable std::mutex m_Mutex;
+};
+
+NAMESPACE_END
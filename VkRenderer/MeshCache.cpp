@@ -0,0 +1,241 @@
+#include "MeshCache.hpp"
+#include "Hash.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+const uint32_t s_MeshCacheMagic = MakeFourCC('V', 'K', 'M', 'C');
+/** Chunk data is aligned so it can be read in place */
+const uint64_t s_MeshCacheChunkAlignment = 16;
+
+struct MeshCacheHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t SourceHash;
+	uint64_t SourceSize;
+	uint32_t ImportFlags;
+	uint32_t VertexStride;
+	uint32_t ChunkCount;
+	float WeldEpsilon;
+	float LodReduction;
+	float LodMinReduction;
+	/** Hash of the chunk table, every entry carries the hash of its own data */
+	uint64_t TableHash;
+};
+
+struct MeshCacheChunk
+{
+	uint32_t Id;
+	uint32_t Reserved;
+	uint64_t Offset;
+	uint64_t Size;
+	uint64_t Hash;
+};
+
+const MeshCacheChunk * GetChunkTable(
+	const MappedFile & File
+)
+{
+	return reinterpret_cast<const MeshCacheChunk *>(File.GetData() + sizeof(MeshCacheHeader));
+}
+
+}
+
+bool ComputeMeshCacheKey(
+	const std::string & SourceFilename,
+	uint32_t ImportFlags,
+	uint32_t VertexStride,
+	float WeldEpsilon,
+	float LodReduction,
+	float LodMinReduction,
+	MeshCacheKey & Key
+)
+{
+	MappedFile Source;
+	if (!Source.Open(SourceFilename))
+	{
+		return false;
+	}
+
+	Key.SourceHash = HashBytes(Source.GetData(), Source.GetSize());
+	Key.SourceSize = Source.GetSize();
+	Key.ImportFlags = ImportFlags;
+	Key.VertexStride = VertexStride;
+	Key.WeldEpsilon = WeldEpsilon;
+	Key.LodReduction = LodReduction;
+	Key.LodMinReduction = LodMinReduction;
+
+	return true;
+}
+
+bool MeshCacheReader::Open(
+	const std::string & Filename,
+	const MeshCacheKey & Key,
+	bool bMatchSource
+)
+{
+	Close();
+
+	if (!m_File.Open(Filename) || m_File.GetSize() < sizeof(MeshCacheHeader))
+	{
+		Close();
+		return false;
+	}
+
+	MeshCacheHeader Header;
+	memcpy(&Header, m_File.GetData(), sizeof(Header));
+
+	bool bValid =
+		Header.Magic == s_MeshCacheMagic &&
+		Header.Version == MESH_CACHE_VERSION &&
+		(!bMatchSource || Header.SourceHash == Key.SourceHash) &&
+		(!bMatchSource || Header.SourceSize == Key.SourceSize) &&
+		Header.ImportFlags == Key.ImportFlags &&
+		Header.VertexStride == Key.VertexStride &&
+		Header.WeldEpsilon == Key.WeldEpsilon &&
+		Header.LodReduction == Key.LodReduction &&
+		Header.LodMinReduction == Key.LodMinReduction &&
+		sizeof(MeshCacheHeader) + Header.ChunkCount * sizeof(MeshCacheChunk) <= m_File.GetSize();
+
+	if (bValid)
+	{
+		const MeshCacheChunk * pChunks = GetChunkTable(m_File);
+		bValid = HashBytes(pChunks, Header.ChunkCount * sizeof(MeshCacheChunk)) == Header.TableHash;
+
+		for (uint32_t i = 0; bValid && i < Header.ChunkCount; i++)
+		{
+			bValid = pChunks[i].Offset % s_MeshCacheChunkAlignment == 0 &&
+				pChunks[i].Offset + pChunks[i].Size <= m_File.GetSize() &&
+				HashBytes(m_File.GetData() + pChunks[i].Offset, static_cast<size_t>(pChunks[i].Size)) == pChunks[i].Hash;
+		}
+	}
+
+	if (!bValid)
+	{
+		Close();
+		return false;
+	}
+
+	m_ChunkCount = Header.ChunkCount;
+
+	return true;
+}
+
+void MeshCacheReader::Close()
+{
+	m_File.Close();
+	m_ChunkCount = 0;
+}
+
+const void * MeshCacheReader::GetChunk(
+	uint32_t Id,
+	size_t & Size
+) const
+{
+	const MeshCacheChunk * pChunks = GetChunkTable(m_File);
+
+	for (uint32_t i = 0; i < m_ChunkCount; i++)
+	{
+		if (pChunks[i].Id == Id)
+		{
+			Size = static_cast<size_t>(pChunks[i].Size);
+			return m_File.GetData() + pChunks[i].Offset;
+		}
+	}
+
+	Size = 0;
+	return nullptr;
+}
+
+void MeshCacheWriter::AddChunk(
+	uint32_t Id,
+	const void * pData,
+	size_t Size
+)
+{
+	m_Chunks.push_back({ Id, pData, Size });
+}
+
+bool MeshCacheWriter::Write(
+	const std::string & Filename,
+	const MeshCacheKey & Key
+) const
+{
+	std::vector<MeshCacheChunk> Chunks(m_Chunks.size());
+
+	uint64_t Offset = sizeof(MeshCacheHeader) + Chunks.size() * sizeof(MeshCacheChunk);
+
+	for (size_t i = 0; i < m_Chunks.size(); i++)
+	{
+		Offset = (Offset + s_MeshCacheChunkAlignment - 1) / s_MeshCacheChunkAlignment * s_MeshCacheChunkAlignment;
+
+		Chunks[i].Id = m_Chunks[i].Id;
+		Chunks[i].Reserved = 0;
+		Chunks[i].Offset = Offset;
+		Chunks[i].Size = m_Chunks[i].Size;
+		Chunks[i].Hash = HashBytes(m_Chunks[i].pData, m_Chunks[i].Size);
+
+		Offset += m_Chunks[i].Size;
+	}
+
+	MeshCacheHeader Header = {};
+	Header.Magic = s_MeshCacheMagic;
+	Header.Version = MESH_CACHE_VERSION;
+	Header.SourceHash = Key.SourceHash;
+	Header.SourceSize = Key.SourceSize;
+	Header.ImportFlags = Key.ImportFlags;
+	Header.VertexStride = Key.VertexStride;
+	Header.WeldEpsilon = Key.WeldEpsilon;
+	Header.LodReduction = Key.LodReduction;
+	Header.LodMinReduction = Key.LodMinReduction;
+	Header.ChunkCount = static_cast<uint32_t>(Chunks.size());
+	Header.TableHash = HashBytes(Chunks.data(), Chunks.size() * sizeof(MeshCacheChunk));
+
+	/** A crash while writing must never leave a truncated cache behind */
+	std::string TemporaryFilename = Filename + ".tmp";
+
+	std::ofstream File(TemporaryFilename, std::ios::binary | std::ios::trunc);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	const char Padding[s_MeshCacheChunkAlignment] = {};
+
+	File.write(reinterpret_cast<const char *>(&Header), sizeof(Header));
+	File.write(reinterpret_cast<const char *>(Chunks.data()), Chunks.size() * sizeof(MeshCacheChunk));
+	uint64_t Written = sizeof(Header) + Chunks.size() * sizeof(MeshCacheChunk);
+
+	for (size_t i = 0; i < m_Chunks.size(); i++)
+	{
+		File.write(Padding, static_cast<std::streamsize>(Chunks[i].Offset - Written));
+		File.write(static_cast<const char *>(m_Chunks[i].pData), static_cast<std::streamsize>(m_Chunks[i].Size));
+		Written = Chunks[i].Offset + Chunks[i].Size;
+	}
+
+	File.close();
+	bool bSuccess = !File.fail();
+
+	std::error_code Error;
+	if (bSuccess)
+	{
+		std::filesystem::rename(TemporaryFilename, Filename, Error);
+		bSuccess = !Error;
+	}
+
+	if (!bSuccess)
+	{
+		std::filesystem::remove(TemporaryFilename, Error);
+	}
+
+	return bSuccess;
+}
+
+NAMESPACE_END
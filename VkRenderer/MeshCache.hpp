@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Namespace.hpp"
+#include "MappedFile.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** Bump whenever the meaning of a chunk changes, older caches are then rebuilt. */
+const uint32_t MESH_CACHE_VERSION = 9;
+
+const uint32_t MESH_CACHE_CHUNK_VERTICES = MakeFourCC('V', 'E', 'R', 'T');
+const uint32_t MESH_CACHE_CHUNK_INDICES = MakeFourCC('I', 'N', 'D', 'X');
+const uint32_t MESH_CACHE_CHUNK_SUBMESHES = MakeFourCC('S', 'U', 'B', 'M');
+const uint32_t MESH_CACHE_CHUNK_MESHES = MakeFourCC('M', 'E', 'S', 'H');
+const uint32_t MESH_CACHE_CHUNK_INSTANCES = MakeFourCC('I', 'N', 'S', 'T');
+const uint32_t MESH_CACHE_CHUNK_MESHLETS = MakeFourCC('M', 'L', 'E', 'T');
+/** Written with WriteSceneMaterials */
+const uint32_t MESH_CACHE_CHUNK_MATERIALS = MakeFourCC('M', 'A', 'T', 'L');
+
+/** Everything a cache depends on, a cache is only used if all fields match. */
+struct MeshCacheKey
+{
+	uint64_t SourceHash = 0;
+	uint64_t SourceSize = 0;
+	uint32_t ImportFlags = 0;
+	uint32_t VertexStride = 0;
+	float WeldEpsilon = 0.0f;
+	/** The LOD chain is stored in the cache */
+	float LodReduction = 0.0f;
+	float LodMinReduction = 0.0f;
+};
+
+/** Hashes the whole source file, returns false if it can not be read. */
+bool ComputeMeshCacheKey(
+	const std::string & SourceFilename,
+	uint32_t ImportFlags,
+	uint32_t VertexStride,
+	float WeldEpsilon,
+	float LodReduction,
+	float LodMinReduction,
+	MeshCacheKey & Key
+);
+
+/**
+* Maps a cache file and validates its header, version, key and payload checksum. Chunks
+* point straight into the mapping, so they are only valid while the reader is open.
+* Baked caches ship without their source, bMatchSource false skips the source hash and size.
+*/
+class MeshCacheReader
+{
+public:
+	bool Open(
+		const std::string & Filename,
+		const MeshCacheKey & Key,
+		bool bMatchSource = true
+	);
+
+	void Close();
+
+	/** Returns nullptr if the chunk is not present. */
+	const void * GetChunk(
+		uint32_t Id,
+		size_t & Size
+	) const;
+
+	template <typename TElement>
+	const TElement * GetChunkArray(uint32_t Id, size_t & Count) const
+	{
+		size_t Size = 0;
+		const void * pData = GetChunk(Id, Size);
+		Count = Size / sizeof(TElement);
+		return static_cast<const TElement *>(pData);
+	}
+
+protected:
+	MappedFile m_File;
+	uint32_t m_ChunkCount = 0;
+};
+
+/** Collects chunks and writes them to a temporary file that replaces the cache once complete. */
+class MeshCacheWriter
+{
+public:
+	/** The data is referenced, not copied, and must stay alive until Write(). */
+	void AddChunk(
+		uint32_t Id,
+		const void * pData,
+		size_t Size
+	);
+
+	template <typename TElement>
+	void AddChunkArray(uint32_t Id, const std::vector<TElement> & Elements)
+	{
+		AddChunk(Id, Elements.data(), Elements.size() * sizeof(TElement));
+	}
+
+	bool Write(
+		const std::string & Filename,
+		const MeshCacheKey & Key
+	) const;
+
+protected:
+	struct PendingChunk
+	{
+		uint32_t Id;
+		const void * pData;
+		size_t Size;
+	};
+
+	std::vector<PendingChunk> m_Chunks;
+};
+
+NAMESPACE_END
@@ -0,0 +1,682 @@
+#include "MeshImporter.hpp"
+#include "MeshSimplifier.hpp"
+#include "VertexWelder.hpp"
+#include "ObjParser.hpp"
+#include "ThreadPool.hpp"
+#include "Hash.hpp"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+/** Geometry of one source mesh before it is merged into the shared buffers */
+struct ImportedMesh
+{
+	std::vector<MeshVertex> Vertices;
+	std::vector<uint32_t> Indices;
+	std::vector<SubMesh> SubMeshes;
+	std::vector<Meshlet> Meshlets;
+	/** Everything but FirstSubMesh, which is assigned when merging */
+	SceneMesh Info;
+	/** Post-transform cache misses before and after the optimization */
+	size_t TransformsBefore = 0;
+	size_t TransformsAfter = 0;
+	VertexWeldStatistics Weld;
+};
+
+/** Build the vertices from the staging streams once the tangents are generated */
+void CopyStagingToVertices(
+	const TangentStaging & Staging,
+	std::vector<MeshVertex> & Vertices
+)
+{
+	Vertices.resize(Staging.GetVertexCount());
+
+	for (size_t i = 0; i < Vertices.size(); i++)
+	{
+		MeshVertex & Vertex = Vertices[i];
+		Vertex.Position = glm::vec3(Staging.PositionX[i], Staging.PositionY[i], Staging.PositionZ[i]);
+		Vertex.Color = { 1.0f, 1.0f, 1.0f };
+		Vertex.Normal = glm::vec3(Staging.NormalX[i], Staging.NormalY[i], Staging.NormalZ[i]);
+		Vertex.Tangent = glm::vec3(Staging.TangentX[i], Staging.TangentY[i], Staging.TangentZ[i]);
+		Vertex.TexCoord = glm::vec2(Staging.TexCoordU[i], Staging.TexCoordV[i]);
+	}
+}
+
+void ImportMesh(
+	const aiMesh * pMesh,
+	ImportedMesh & Mesh
+)
+{
+	Mesh.Info.MaterialIndex = pMesh->mMaterialIndex;
+	Mesh.Indices.reserve(pMesh->mNumFaces * 3);
+
+	for (uint32_t i = 0; i < pMesh->mNumFaces; i++)
+	{
+		/** Points and lines survive triangulation, they are not drawn */
+		if (pMesh->mFaces[i].mNumIndices != 3)
+		{
+			continue;
+		}
+
+		Mesh.Indices.push_back(pMesh->mFaces[i].mIndices[0]);
+		Mesh.Indices.push_back(pMesh->mFaces[i].mIndices[1]);
+		Mesh.Indices.push_back(pMesh->mFaces[i].mIndices[2]);
+	}
+
+	TangentStaging Staging;
+	FillTangentStaging(pMesh, Staging);
+	GenerateTangents(Mesh.Indices, Staging);
+
+	CopyStagingToVertices(Staging, Mesh.Vertices);
+}
+
+void ImportObjMesh(
+	const ObjModel & Model,
+	uint32_t Material,
+	ImportedMesh & Mesh
+)
+{
+	Mesh.Info.MaterialIndex = Material;
+
+	size_t CornerCount = 0;
+	for (const ObjMaterialRun & Run : Model.MaterialRuns)
+	{
+		CornerCount += Run.Material == Material ? Run.CornerCount : 0;
+	}
+
+	TangentStaging Staging;
+	Staging.Resize(CornerCount);
+
+	/** One vertex per corner with missing attributes left zero, as Assimp imports OBJ files */
+	size_t VertexIndex = 0;
+	for (const ObjMaterialRun & Run : Model.MaterialRuns)
+	{
+		if (Run.Material != Material)
+		{
+			continue;
+		}
+
+		for (size_t c = Run.FirstCorner; c < Run.FirstCorner + Run.CornerCount; c++, VertexIndex++)
+		{
+			const ObjCorner & Corner = Model.Corners[c];
+
+			Staging.PositionX[VertexIndex] = Model.Positions[Corner.Position * 3 + 0];
+			Staging.PositionY[VertexIndex] = Model.Positions[Corner.Position * 3 + 1];
+			Staging.PositionZ[VertexIndex] = Model.Positions[Corner.Position * 3 + 2];
+
+			if (Corner.Normal != UINT32_MAX)
+			{
+				Staging.NormalX[VertexIndex] = Model.Normals[Corner.Normal * 3 + 0];
+				Staging.NormalY[VertexIndex] = Model.Normals[Corner.Normal * 3 + 1];
+				Staging.NormalZ[VertexIndex] = Model.Normals[Corner.Normal * 3 + 2];
+			}
+
+			/** Same as aiProcess_FlipUVs */
+			if (Corner.TexCoord != UINT32_MAX)
+			{
+				Staging.TexCoordU[VertexIndex] = Model.TexCoords[Corner.TexCoord * 2 + 0];
+				Staging.TexCoordV[VertexIndex] = 1.0f - Model.TexCoords[Corner.TexCoord * 2 + 1];
+			}
+		}
+	}
+
+	Mesh.Indices.resize(CornerCount);
+	for (size_t i = 0; i < CornerCount; i++)
+	{
+		Mesh.Indices[i] = static_cast<uint32_t>(i);
+	}
+
+	GenerateTangents(Mesh.Indices, Staging);
+
+	CopyStagingToVertices(Staging, Mesh.Vertices);
+}
+
+/** Parse the model with ParseObj and convert it like Assimp would: one mesh per material, one vertex per corner */
+void ImportObjScene(
+	const std::string & Filename,
+	ThreadPool & Pool,
+	std::vector<ImportedMesh> & Meshes,
+	MeshScene & Scene,
+	std::ostream & Log
+)
+{
+	ObjModel Model;
+	ObjParseStatistics Statistics;
+	ParseObj(Filename, &Pool, Model, &Statistics);
+
+	Log << "Parsed " << Filename << ", " << Statistics.Bytes / (1024.0 * 1024.0) << " MB in " << Statistics.Milliseconds
+		<< " ms (" << Statistics.GetMegabytesPerSecond() << " MB/s) on " << Statistics.Chunks << " chunks" << std::endl;
+
+	Meshes.clear();
+	Meshes.resize(Model.MaterialNames.size());
+
+	Pool.ParallelFor(static_cast<uint32_t>(Meshes.size()), [&](uint32_t Material)
+	{
+		ImportObjMesh(Model, Material, Meshes[Material]);
+	});
+
+	std::string BaseDirectory = std::filesystem::path(Filename).parent_path().generic_string();
+	LoadObjMaterials(Model, BaseDirectory, Scene.Materials);
+
+	/** OBJ has no node graph, every mesh is placed once at the origin */
+	Scene.Instances.resize(Meshes.size());
+	for (uint32_t i = 0; i < Meshes.size(); i++)
+	{
+		Scene.Instances[i] = SceneInstance();
+		Scene.Instances[i].MeshIndex = i;
+	}
+}
+
+/** Merge duplicate vertices, OBJ files arrive with one vertex per corner. Uses the pool, so it must not run on it */
+void WeldMesh(
+	const MeshImportSettings & Settings,
+	ThreadPool & Pool,
+	ImportedMesh & Mesh
+)
+{
+	/** Welds after the tangent generation, which separates mirrored UVs, so those keep their own vertices */
+	std::vector<uint32_t> Remap;
+	size_t VertexCount = WeldVertices(Mesh.Vertices.data(), sizeof(MeshVertex), Mesh.Vertices.size(), Remap,
+		Settings.VertexWeldEpsilon, &Pool, &Mesh.Weld);
+
+	if (VertexCount == Mesh.Vertices.size())
+	{
+		return;
+	}
+
+	for (uint32_t & Index : Mesh.Indices)
+	{
+		Index = Remap[Index];
+	}
+
+	RemapVertices(Mesh.Vertices, Remap, VertexCount);
+}
+
+/** Simplify every sub-mesh into a chain of levels of detail, appended after level 0 */
+void BuildMeshLods(
+	const MeshImportSettings & Settings,
+	ImportedMesh & Mesh
+)
+{
+	uint32_t PartCount = static_cast<uint32_t>(Mesh.SubMeshes.size());
+
+	Mesh.Info.SubMeshCount = PartCount;
+	Mesh.Info.LodCount = 1;
+	Mesh.Info.LodErrors[0] = 0.0f;
+
+	if (!Mesh.Vertices.empty())
+	{
+		glm::vec3 Min = Mesh.Vertices[0].Position, Max = Mesh.Vertices[0].Position;
+		for (const MeshVertex & Vertex : Mesh.Vertices)
+		{
+			Min = glm::min(Min, Vertex.Position);
+			Max = glm::max(Max, Vertex.Position);
+		}
+
+		Mesh.Info.BoundsCenter = (Min + Max) * 0.5f;
+		Mesh.Info.BoundsRadius = 0.0f;
+		for (const MeshVertex & Vertex : Mesh.Vertices)
+		{
+			Mesh.Info.BoundsRadius = std::max(Mesh.Info.BoundsRadius, glm::length(Vertex.Position - Mesh.Info.BoundsCenter));
+		}
+	}
+
+	/** Each level is simplified from the previous one and the errors add up, so they stay conservative */
+	std::vector<std::vector<uint32_t>> Levels(PartCount);
+	std::vector<uint32_t> Previous, Clusters;
+
+	for (uint32_t Lod = 1; Lod < SCENE_MAX_LOD_COUNT; Lod++)
+	{
+		size_t PreviousCount = 0, Count = 0;
+		float Error = 0.0f;
+
+		for (uint32_t p = 0; p < PartCount; p++)
+		{
+			SubMesh Part = Mesh.SubMeshes[(Lod - 1) * PartCount + p];
+			Previous.assign(Mesh.Indices.begin() + Part.FirstIndex, Mesh.Indices.begin() + Part.FirstIndex + Part.IndexCount);
+
+			/** Parts of a split mesh share their borders, moving them on one side only would open cracks */
+			size_t Target = static_cast<size_t>(Part.IndexCount * Settings.LodReduction) / 3 * 3;
+			float PartError = SimplifyMesh(
+				Previous,
+				&Mesh.Vertices[Part.VertexOffset],
+				sizeof(MeshVertex),
+				Part.VertexCount,
+				Target,
+				std::numeric_limits<float>::max(),
+				PartCount > 1,
+				Levels[p]
+			);
+			OptimizeVertexCache(Levels[p], Part.VertexCount, Clusters);
+
+			PreviousCount += Part.IndexCount;
+			Count += Levels[p].size();
+			Error = std::max(Error, PartError);
+		}
+
+		if (Count == 0 || Count > PreviousCount * (1.0f - Settings.LodMinReduction))
+		{
+			break;
+		}
+
+		for (uint32_t p = 0; p < PartCount; p++)
+		{
+			SubMesh Level = Mesh.SubMeshes[p];
+			Level.FirstIndex = static_cast<uint32_t>(Mesh.Indices.size());
+			Level.IndexCount = static_cast<uint32_t>(Levels[p].size());
+			Mesh.SubMeshes.push_back(Level);
+			Mesh.Indices.insert(Mesh.Indices.end(), Levels[p].begin(), Levels[p].end());
+		}
+
+		Mesh.Info.LodErrors[Lod] = Mesh.Info.LodErrors[Lod - 1] + Error;
+		Mesh.Info.LodCount = Lod + 1;
+	}
+}
+
+/** Cluster every sub-mesh of every level into meshlets, reordering its triangles */
+void BuildMeshMeshlets(
+	ImportedMesh & Mesh
+)
+{
+	std::vector<uint32_t> Indices;
+	std::vector<Meshlet> Meshlets;
+
+	for (uint32_t i = 0; i < Mesh.SubMeshes.size(); i++)
+	{
+		SubMesh & Part = Mesh.SubMeshes[i];
+		Indices.assign(Mesh.Indices.begin() + Part.FirstIndex, Mesh.Indices.begin() + Part.FirstIndex + Part.IndexCount);
+
+		BuildMeshlets(Indices, &Mesh.Vertices[Part.VertexOffset].Position.x, sizeof(MeshVertex), Part.VertexCount, Meshlets);
+
+		std::copy(Indices.begin(), Indices.end(), Mesh.Indices.begin() + Part.FirstIndex);
+		Part.FirstMeshlet = static_cast<uint32_t>(Mesh.Meshlets.size());
+		Part.MeshletCount = static_cast<uint32_t>(Meshlets.size());
+		Mesh.Meshlets.insert(Mesh.Meshlets.end(), Meshlets.begin(), Meshlets.end());
+	}
+
+	/** The clustering reorders the triangles, report the cache behaviour of the final order of level 0 */
+	if (!Mesh.Indices.empty())
+	{
+		Mesh.TransformsAfter = 0;
+		for (uint32_t i = 0; i < Mesh.Info.SubMeshCount; i++)
+		{
+			const SubMesh & Part = Mesh.SubMeshes[i];
+			Indices.assign(Mesh.Indices.begin() + Part.FirstIndex, Mesh.Indices.begin() + Part.FirstIndex + Part.IndexCount);
+			Mesh.TransformsAfter += AnalyzeVertexCache(Indices, Part.VertexCount).VertexTransforms;
+		}
+	}
+}
+
+/** Reorder the triangles and vertices for the post-transform cache, overdraw and vertex fetch, then split for 16-bit indices */
+void OptimizeMesh(
+	const MeshImportSettings & Settings,
+	ImportedMesh & Mesh
+)
+{
+	if (!Mesh.Indices.empty())
+	{
+		Mesh.TransformsBefore = AnalyzeVertexCache(Mesh.Indices, Mesh.Vertices.size()).VertexTransforms;
+
+		std::vector<uint32_t> Clusters;
+		OptimizeVertexCache(Mesh.Indices, Mesh.Vertices.size(), Clusters);
+		OptimizeOverdraw(Mesh.Indices, Clusters, &Mesh.Vertices[0].Position.x, sizeof(MeshVertex), Mesh.Vertices.size());
+
+		std::vector<uint32_t> Remap;
+		size_t VertexCount = OptimizeVertexFetch(Mesh.Indices, Mesh.Vertices.size(), Remap);
+		RemapVertices(Mesh.Vertices, Remap, VertexCount);
+
+		Mesh.TransformsAfter = AnalyzeVertexCache(Mesh.Indices, Mesh.Vertices.size()).VertexTransforms;
+	}
+
+	/** Runs after the vertex fetch optimization, so splitting in triangle order keeps each sub-mesh's vertices local */
+	std::vector<uint32_t> VertexSources;
+	SplitMesh(Mesh.Indices, Mesh.Vertices.size(), MESH_MAX_16BIT_VERTICES, VertexSources, Mesh.SubMeshes);
+
+	if (Mesh.SubMeshes.size() > 1)
+	{
+		GatherVertices(Mesh.Vertices, VertexSources);
+	}
+
+	BuildMeshLods(Settings, Mesh);
+
+	BuildMeshMeshlets(Mesh);
+}
+
+}
+
+bool IsObjParserUsed(
+	const MeshImportSettings & Settings,
+	const std::string & Filename
+)
+{
+	std::string Extension = std::filesystem::path(Filename).extension().string();
+	std::transform(Extension.begin(), Extension.end(), Extension.begin(), [](char Char) { return static_cast<char>(std::tolower(Char)); });
+
+	return Settings.bObjParserEnabled && Extension == ".obj";
+}
+
+uint32_t GetMeshImportFlags(
+	const MeshImportSettings & Settings,
+	const std::string & Filename
+)
+{
+	/** Tangents are generated by ImportMesh, not by Assimp. The OBJ parser does not run Assimp, zero keeps its caches apart */
+	return IsObjParserUsed(Settings, Filename) ? 0 :
+		aiProcess_Triangulate |
+		aiProcess_FlipUVs |
+		aiProcess_OptimizeMeshes;
+}
+
+uint64_t GetMeshImportSettingsHash(
+	const MeshImportSettings & Settings
+)
+{
+	uint32_t WeldEpsilonBits = 0;
+	memcpy(&WeldEpsilonBits, &Settings.VertexWeldEpsilon, sizeof(WeldEpsilonBits));
+	uint32_t LodReductionBits = 0;
+	memcpy(&LodReductionBits, &Settings.LodReduction, sizeof(LodReductionBits));
+	uint32_t LodMinReductionBits = 0;
+	memcpy(&LodMinReductionBits, &Settings.LodMinReduction, sizeof(LodMinReductionBits));
+
+	uint64_t Hash = HashCombine(HashCombine(HashCombine(MESH_CACHE_VERSION, sizeof(MeshVertex)), WeldEpsilonBits), Settings.bObjParserEnabled);
+	return HashCombine(HashCombine(Hash, LodReductionBits), LodMinReductionBits);
+}
+
+bool ComputeMeshImportCacheKey(
+	const MeshImportSettings & Settings,
+	const std::string & Filename,
+	MeshCacheKey & Key
+)
+{
+	return ComputeMeshCacheKey(Filename, GetMeshImportFlags(Settings, Filename), sizeof(MeshVertex), Settings.VertexWeldEpsilon,
+		Settings.LodReduction, Settings.LodMinReduction, Key);
+}
+
+void ImportMeshScene(
+	const MeshImportSettings & Settings,
+	const std::string & Filename,
+	ThreadPool & Pool,
+	MeshScene & Scene,
+	std::ostream & Log
+)
+{
+	/** Assimp materials are resized into, so start from an empty scene */
+	Scene = MeshScene();
+
+	/** Meshes are independent, convert and optimize them on the pool and merge them in order afterwards */
+	std::vector<ImportedMesh> Meshes;
+
+	if (IsObjParserUsed(Settings, Filename))
+	{
+		ImportObjScene(Filename, Pool, Meshes, Scene, Log);
+	}
+	else
+	{
+		Assimp::Importer Import;
+		const aiScene * pScene = Import.ReadFile(Filename, GetMeshImportFlags(Settings, Filename));
+
+		if (!pScene || pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !pScene->mRootNode)
+		{
+			throw std::runtime_error(Import.GetErrorString());
+		}
+
+		Meshes.resize(pScene->mNumMeshes);
+
+		Pool.ParallelFor(pScene->mNumMeshes, [&](uint32_t MeshIndex)
+		{
+			ImportMesh(pScene->mMeshes[MeshIndex], Meshes[MeshIndex]);
+		});
+
+		std::string BaseDirectory = std::filesystem::path(Filename).parent_path().generic_string();
+		ImportSceneMaterials(pScene, BaseDirectory, Scene.Materials);
+
+		FlattenSceneNodes(pScene, Scene.Instances);
+	}
+
+	/** One mesh at a time, large meshes are welded across the whole pool */
+	for (ImportedMesh & Mesh : Meshes)
+	{
+		WeldMesh(Settings, Pool, Mesh);
+	}
+
+	Pool.ParallelFor(static_cast<uint32_t>(Meshes.size()), [&](uint32_t MeshIndex)
+	{
+		OptimizeMesh(Settings, Meshes[MeshIndex]);
+	});
+
+	size_t TransformsBefore = 0, TransformsAfter = 0;
+	VertexWeldStatistics Weld;
+
+	for (ImportedMesh & Mesh : Meshes)
+	{
+		SceneMesh Entry = Mesh.Info;
+		Entry.FirstSubMesh = static_cast<uint32_t>(Scene.SubMeshes.size());
+		Scene.Meshes.push_back(Entry);
+
+		for (SubMesh Part : Mesh.SubMeshes)
+		{
+			Part.FirstIndex += static_cast<uint32_t>(Scene.Indices.size());
+			Part.VertexOffset += static_cast<uint32_t>(Scene.Vertices.size());
+			Part.FirstMeshlet += static_cast<uint32_t>(Scene.Meshlets.size());
+			Scene.SubMeshes.push_back(Part);
+		}
+
+		Scene.Meshlets.insert(Scene.Meshlets.end(), Mesh.Meshlets.begin(), Mesh.Meshlets.end());
+
+		Scene.Vertices.insert(Scene.Vertices.end(), Mesh.Vertices.begin(), Mesh.Vertices.end());
+		Scene.Indices.insert(Scene.Indices.end(), Mesh.Indices.begin(), Mesh.Indices.end());
+
+		TransformsBefore += Mesh.TransformsBefore;
+		TransformsAfter += Mesh.TransformsAfter;
+
+		Weld.VerticesBefore += Mesh.Weld.VerticesBefore;
+		Weld.VerticesAfter += Mesh.Weld.VerticesAfter;
+		Weld.Partitions = std::max(Weld.Partitions, Mesh.Weld.Partitions);
+		Weld.Milliseconds += Mesh.Weld.Milliseconds;
+
+		Mesh = ImportedMesh();
+	}
+
+	/** Every draw needs a descriptor set, even if the file has no materials */
+	if (Scene.Materials.empty())
+	{
+		Scene.Materials.emplace_back();
+	}
+
+	size_t TriangleCount = 0, LodTriangleCount = 0;
+	for (const SceneMesh & Mesh : Scene.Meshes)
+	{
+		for (uint32_t i = 0; i < Mesh.SubMeshCount * Mesh.LodCount; i++)
+		{
+			(i < Mesh.SubMeshCount ? TriangleCount : LodTriangleCount) += Scene.SubMeshes[Mesh.FirstSubMesh + i].IndexCount / 3;
+		}
+	}
+
+	float Triangles = static_cast<float>(std::max<size_t>(TriangleCount, 1));
+	Log << "Scene: " << Scene.Meshes.size() << " meshes, " << Scene.SubMeshes.size() << " sub-meshes, " << Scene.Meshlets.size() << " meshlets, "
+		<< Scene.Instances.size() << " instances, " << Scene.Materials.size() << " materials, ACMR "
+		<< TransformsBefore / Triangles << " -> " << TransformsAfter / Triangles
+		<< " (FIFO cache of " << MESH_OPTIMIZER_CACHE_SIZE << "), levels of detail add "
+		<< LodTriangleCount << " triangles to " << TriangleCount << std::endl;
+
+	Log << "Welded " << Weld.VerticesBefore << " -> " << Weld.VerticesAfter << " vertices, "
+		<< Weld.GetDuplicateRatio() * 100.0f << "% duplicates, in " << Weld.Milliseconds << " ms on up to "
+		<< Weld.Partitions << " partitions" << std::endl;
+}
+
+bool LoadMeshScene(
+	const std::string & Filename,
+	const MeshCacheKey & Key,
+	bool bMatchSource,
+	MeshScene & Scene,
+	std::ostream & Log
+)
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	MeshCacheReader Reader;
+	if (!Reader.Open(Filename, Key, bMatchSource))
+	{
+		return false;
+	}
+
+	size_t VertexCount = 0, IndexCount = 0, SubMeshCount = 0, MeshletCount = 0, MeshCount = 0, InstanceCount = 0, MaterialSize = 0;
+	const MeshVertex * pVertices = Reader.GetChunkArray<MeshVertex>(MESH_CACHE_CHUNK_VERTICES, VertexCount);
+	const uint32_t * pIndices = Reader.GetChunkArray<uint32_t>(MESH_CACHE_CHUNK_INDICES, IndexCount);
+	const SubMesh * pSubMeshes = Reader.GetChunkArray<SubMesh>(MESH_CACHE_CHUNK_SUBMESHES, SubMeshCount);
+	const Meshlet * pMeshlets = Reader.GetChunkArray<Meshlet>(MESH_CACHE_CHUNK_MESHLETS, MeshletCount);
+	const SceneMesh * pMeshes = Reader.GetChunkArray<SceneMesh>(MESH_CACHE_CHUNK_MESHES, MeshCount);
+	const SceneInstance * pInstances = Reader.GetChunkArray<SceneInstance>(MESH_CACHE_CHUNK_INSTANCES, InstanceCount);
+	const void * pMaterials = Reader.GetChunk(MESH_CACHE_CHUNK_MATERIALS, MaterialSize);
+
+	if (!ReadSceneMaterials(pMaterials, MaterialSize, Scene.Materials))
+	{
+		return false;
+	}
+
+	Scene.Vertices.assign(pVertices, pVertices + VertexCount);
+	Scene.Indices.assign(pIndices, pIndices + IndexCount);
+	Scene.SubMeshes.assign(pSubMeshes, pSubMeshes + SubMeshCount);
+	Scene.Meshlets.assign(pMeshlets, pMeshlets + MeshletCount);
+	Scene.Meshes.assign(pMeshes, pMeshes + MeshCount);
+	Scene.Instances.assign(pInstances, pInstances + InstanceCount);
+
+	Log << "Loaded mesh cache " << Filename << " in "
+		<< std::chrono::duration<double, std::chrono::milliseconds::period>(
+			std::chrono::high_resolution_clock::now() - StartTime
+			).count() << " ms" << std::endl;
+
+	return true;
+}
+
+bool LoadBakedMeshScene(
+	const MeshImportSettings & Settings,
+	const std::string & BakedFilename,
+	const std::string & SourceFilename,
+	MeshScene & Scene,
+	std::ostream & Log
+)
+{
+	MeshCacheKey Key;
+	Key.ImportFlags = GetMeshImportFlags(Settings, SourceFilename);
+	Key.VertexStride = sizeof(MeshVertex);
+	Key.WeldEpsilon = Settings.VertexWeldEpsilon;
+	Key.LodReduction = Settings.LodReduction;
+	Key.LodMinReduction = Settings.LodMinReduction;
+
+	std::error_code Error;
+	const bool bSourceExists = std::filesystem::is_regular_file(SourceFilename, Error);
+
+	if (bSourceExists && !ComputeMeshImportCacheKey(Settings, SourceFilename, Key))
+	{
+		return false;
+	}
+
+	if (!LoadMeshScene(BakedFilename, Key, bSourceExists, Scene, Log))
+	{
+		std::error_code BakedError;
+		if (bSourceExists && std::filesystem::is_regular_file(BakedFilename, BakedError))
+		{
+			Log << "Baked " << BakedFilename << " does not match " << SourceFilename << ", importing the source" << std::endl;
+		}
+		return false;
+	}
+
+	return true;
+}
+
+bool WriteMeshScene(
+	const std::string & Filename,
+	const MeshCacheKey & Key,
+	const MeshScene & Scene
+)
+{
+	/** The cache holds the optimized and split meshes with their levels of detail and meshlets, loading it skips all of that */
+	std::vector<uint8_t> Materials;
+	WriteSceneMaterials(Scene.Materials, Materials);
+
+	MeshCacheWriter Writer;
+	Writer.AddChunkArray(MESH_CACHE_CHUNK_VERTICES, Scene.Vertices);
+	Writer.AddChunkArray(MESH_CACHE_CHUNK_INDICES, Scene.Indices);
+	Writer.AddChunkArray(MESH_CACHE_CHUNK_SUBMESHES, Scene.SubMeshes);
+	Writer.AddChunkArray(MESH_CACHE_CHUNK_MESHLETS, Scene.Meshlets);
+	Writer.AddChunkArray(MESH_CACHE_CHUNK_MESHES, Scene.Meshes);
+	Writer.AddChunkArray(MESH_CACHE_CHUNK_INSTANCES, Scene.Instances);
+	Writer.AddChunkArray(MESH_CACHE_CHUNK_MATERIALS, Materials);
+
+	return Writer.Write(Filename, Key);
+}
+
+void BakeMeshScene(
+	const MeshImportSettings & Settings,
+	const std::string & SourceFilename,
+	const std::string & BakedFilename,
+	ThreadPool & Pool,
+	std::ostream & Log
+)
+{
+	MeshCacheKey Key;
+	if (!ComputeMeshImportCacheKey(Settings, SourceFilename, Key))
+	{
+		throw std::runtime_error("Failed to open model file!");
+	}
+
+	MeshScene Scene;
+	ImportMeshScene(Settings, SourceFilename, Pool, Scene, Log);
+
+	if (!WriteMeshScene(BakedFilename, Key, Scene))
+	{
+		throw std::runtime_error("Failed to write mesh cache!");
+	}
+}
+
+void FillTangentStaging(
+	const aiMesh * pMesh,
+	TangentStaging & Staging
+)
+{
+	Staging.Resize(pMesh->mNumVertices);
+
+	/** One stream at a time, missing attributes stay zero */
+	for (uint32_t i = 0; i < pMesh->mNumVertices; i++)
+	{
+		Staging.PositionX[i] = pMesh->mVertices[i].x;
+		Staging.PositionY[i] = pMesh->mVertices[i].y;
+		Staging.PositionZ[i] = pMesh->mVertices[i].z;
+	}
+
+	if (pMesh->HasNormals())
+	{
+		for (uint32_t i = 0; i < pMesh->mNumVertices; i++)
+		{
+			Staging.NormalX[i] = pMesh->mNormals[i].x;
+			Staging.NormalY[i] = pMesh->mNormals[i].y;
+			Staging.NormalZ[i] = pMesh->mNormals[i].z;
+		}
+	}
+
+	if (pMesh->HasTextureCoords(0))
+	{
+		for (uint32_t i = 0; i < pMesh->mNumVertices; i++)
+		{
+			Staging.TexCoordU[i] = pMesh->mTextureCoords[0][i].x;
+			Staging.TexCoordV[i] = pMesh->mTextureCoords[0][i].y;
+		}
+	}
+}
+
+NAMESPACE_END
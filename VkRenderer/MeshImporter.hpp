@@ -0,0 +1,152 @@
+#pragma once
+
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Namespace.hpp"
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshletBuilder.hpp"
+#include "TangentGenerator.hpp"
+#include "Scene.hpp"
+
+struct aiMesh;
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+class ThreadPool;
+
+/** CPU side vertex, packed into a VertexFormat when the vertex buffer is created. */
+struct MeshVertex
+{
+	glm::vec3 Position;
+	glm::vec3 Color;
+	glm::vec3 Normal;
+	glm::vec3 Tangent;
+	glm::vec2 TexCoord;
+};
+
+struct MeshImportSettings
+{
+	/** OBJ files skip Assimp and are parsed on the thread pool */
+	bool bObjParserEnabled = true;
+	/** Grid spacing the vertex attributes are snapped to when welding, zero welds exactly equal vertices only */
+	float VertexWeldEpsilon = 0.0f;
+	/** Each level has at most this fraction of the triangles of the previous one */
+	float LodReduction = 0.5f;
+	/** A level that removes less than this fraction of the previous one ends the chain */
+	float LodMinReduction = 0.1f;
+};
+
+/** An imported model, everything a mesh cache holds. */
+struct MeshScene
+{
+	std::vector<MeshVertex> Vertices;
+	/** Relative to the VertexOffset of their sub-mesh */
+	std::vector<uint32_t> Indices;
+	/** Each references few enough vertices for 16-bit indices */
+	std::vector<SubMesh> SubMeshes;
+	/** Clusters of every sub-mesh, each a contiguous part of its index range */
+	std::vector<Meshlet> Meshlets;
+	/** Source meshes, each a run of SubMeshes */
+	std::vector<SceneMesh> Meshes;
+	/** The node graph flattened to one entry per mesh reference */
+	std::vector<SceneInstance> Instances;
+	std::vector<SceneMaterial> Materials;
+};
+
+/** OBJ models are read by ParseObj instead of Assimp if the settings enable it. */
+bool IsObjParserUsed(
+	const MeshImportSettings & Settings,
+	const std::string & Filename
+);
+
+/** Assimp post processing of Filename, part of the cache key. */
+uint32_t GetMeshImportFlags(
+	const MeshImportSettings & Settings,
+	const std::string & Filename
+);
+
+/**
+* Everything that goes into a mesh cache key besides the source, the MeshSettingsHash of the
+* AssetBaker. GetMeshImportFlags follows from the extension and is left out.
+*/
+uint64_t GetMeshImportSettingsHash(
+	const MeshImportSettings & Settings
+);
+
+/** Hashes Filename and the settings its cache depends on, returns false if the file can not be read. */
+bool ComputeMeshImportCacheKey(
+	const MeshImportSettings & Settings,
+	const std::string & Filename,
+	MeshCacheKey & Key
+);
+
+/**
+* Imports every mesh, material and node of Filename with Assimp, or ParseObj for OBJ files, and
+* merges the geometry into Scene. Each mesh gets tangents, is welded, reordered for the
+* post-transform cache, overdraw and vertex fetch, split for 16-bit indices, simplified into its
+* levels of detail and clustered into meshlets. Meshes are converted on Pool, the welder of large
+* meshes uses the whole pool, so this must not run on it. Throws std::runtime_error on failure.
+*/
+void ImportMeshScene(
+	const MeshImportSettings & Settings,
+	const std::string & Filename,
+	ThreadPool & Pool,
+	MeshScene & Scene,
+	std::ostream & Log
+);
+
+/** Fill Scene from a mesh cache, returns false if it is missing, stale or corrupt. */
+bool LoadMeshScene(
+	const std::string & Filename,
+	const MeshCacheKey & Key,
+	bool bMatchSource,
+	MeshScene & Scene,
+	std::ostream & Log
+);
+
+/**
+* Fill Scene from the baked mesh cache of SourceFilename. A shipped bake has no source next to it
+* and is used as it is, but if the source is present its size and hash must still match the ones
+* the bake was made from, an edited source is imported again instead of drawing the old bake.
+* Returns false if the bake is missing, stale or corrupt.
+*/
+bool LoadBakedMeshScene(
+	const MeshImportSettings & Settings,
+	const std::string & BakedFilename,
+	const std::string & SourceFilename,
+	MeshScene & Scene,
+	std::ostream & Log
+);
+
+/** Write Scene, with its levels of detail and meshlets, as a mesh cache. */
+bool WriteMeshScene(
+	const std::string & Filename,
+	const MeshCacheKey & Key,
+	const MeshScene & Scene
+);
+
+/** Import SourceFilename and write it to BakedFilename, the MeshBakeFunction of BakeAssets. */
+void BakeMeshScene(
+	const MeshImportSettings & Settings,
+	const std::string & SourceFilename,
+	const std::string & BakedFilename,
+	ThreadPool & Pool,
+	std::ostream & Log
+);
+
+/** Copy the attributes the tangent generator reads into its structure of arrays. */
+void FillTangentStaging(
+	const aiMesh * pMesh,
+	TangentStaging & Staging
+);
+
+NAMESPACE_END
@@ -0,0 +1,462 @@
+#include "MeshOptimizer.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+/**
+* FIFO cache simulated with time stamps: a vertex is cached if it was inserted less than
+* CacheSize misses ago. Advancing the clock by CacheSize + 1 empties the cache.
+*/
+struct FifoCache
+{
+	std::vector<uint32_t> Timestamps;
+	uint32_t Time;
+	uint32_t Size;
+
+	FifoCache(size_t VertexCount, uint32_t CacheSize) :
+		Timestamps(VertexCount, 0),
+		Time(CacheSize + 1),
+		Size(CacheSize)
+	{
+	}
+
+	/** Returns true on a miss */
+	bool Access(uint32_t Vertex)
+	{
+		if (Time - Timestamps[Vertex] > Size)
+		{
+			Timestamps[Vertex] = Time++;
+			return true;
+		}
+		return false;
+	}
+
+	void Flush()
+	{
+		Time += Size + 1;
+	}
+};
+
+glm::vec3 GetPosition(
+	const float * pPositions,
+	size_t PositionStride,
+	uint32_t Vertex
+)
+{
+	const float * pPosition = reinterpret_cast<const float *>(
+		reinterpret_cast<const uint8_t *>(pPositions) + Vertex * PositionStride
+	);
+	return glm::vec3(pPosition[0], pPosition[1], pPosition[2]);
+}
+
+}
+
+VertexCacheStatistics AnalyzeVertexCache(
+	const std::vector<uint32_t> & Indices,
+	size_t VertexCount,
+	uint32_t CacheSize
+)
+{
+	VertexCacheStatistics Statistics;
+
+	FifoCache Cache(VertexCount, CacheSize);
+	std::vector<uint8_t> Referenced(VertexCount, 0);
+	size_t ReferencedCount = 0;
+
+	for (uint32_t Index : Indices)
+	{
+		Statistics.VertexTransforms += Cache.Access(Index) ? 1 : 0;
+
+		if (!Referenced[Index])
+		{
+			Referenced[Index] = 1;
+			ReferencedCount++;
+		}
+	}
+
+	size_t TriangleCount = Indices.size() / 3;
+	Statistics.Acmr = TriangleCount == 0 ? 0.0f : static_cast<float>(Statistics.VertexTransforms) / TriangleCount;
+	Statistics.Atvr = ReferencedCount == 0 ? 0.0f : static_cast<float>(Statistics.VertexTransforms) / ReferencedCount;
+
+	return Statistics;
+}
+
+void OptimizeVertexCache(
+	std::vector<uint32_t> & Indices,
+	size_t VertexCount,
+	std::vector<uint32_t> & Clusters,
+	uint32_t CacheSize
+)
+{
+	size_t TriangleCount = Indices.size() / 3;
+	Clusters.clear();
+
+	if (TriangleCount == 0)
+	{
+		return;
+	}
+
+	/** Vertex to triangle adjacency in CSR layout, LiveCount is the number of triangles not emitted yet */
+	std::vector<uint32_t> LiveCount(VertexCount, 0);
+	for (uint32_t Index : Indices)
+	{
+		LiveCount[Index]++;
+	}
+
+	std::vector<uint32_t> AdjacencyOffsets(VertexCount + 1, 0);
+	std::partial_sum(LiveCount.begin(), LiveCount.end(), AdjacencyOffsets.begin() + 1);
+
+	std::vector<uint32_t> AdjacencyTriangles(Indices.size());
+	std::vector<uint32_t> AdjacencyFill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < Indices.size(); i++)
+	{
+		AdjacencyTriangles[AdjacencyFill[Indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<uint32_t> Result;
+	Result.reserve(Indices.size());
+
+	std::vector<uint8_t> Emitted(TriangleCount, 0);
+	std::vector<uint32_t> DeadEndStack;
+	DeadEndStack.reserve(Indices.size());
+	std::vector<uint32_t> Candidates;
+
+	FifoCache Cache(VertexCount, CacheSize);
+	uint32_t Cursor = 0;
+	bool bNewCluster = true;
+
+	while (Cursor < VertexCount && LiveCount[Cursor] == 0)
+	{
+		Cursor++;
+	}
+
+	uint32_t Fanning = Cursor < VertexCount ? Cursor : UINT32_MAX;
+
+	while (Fanning != UINT32_MAX)
+	{
+		Candidates.clear();
+
+		/** Emit every remaining triangle around the fanning vertex */
+		for (uint32_t i = AdjacencyOffsets[Fanning]; i < AdjacencyOffsets[Fanning + 1]; i++)
+		{
+			uint32_t Triangle = AdjacencyTriangles[i];
+			if (Emitted[Triangle])
+			{
+				continue;
+			}
+
+			if (bNewCluster)
+			{
+				Clusters.push_back(static_cast<uint32_t>(Result.size() / 3));
+				bNewCluster = false;
+			}
+
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t Vertex = Indices[Triangle * 3 + k];
+				Result.push_back(Vertex);
+				DeadEndStack.push_back(Vertex);
+				Candidates.push_back(Vertex);
+				LiveCount[Vertex]--;
+				Cache.Access(Vertex);
+			}
+
+			Emitted[Triangle] = 1;
+		}
+
+		/** Prefer the oldest candidate that will still be cached after its remaining triangles are emitted */
+		uint32_t Next = UINT32_MAX;
+		int64_t BestPriority = -1;
+
+		for (uint32_t Vertex : Candidates)
+		{
+			if (LiveCount[Vertex] == 0)
+			{
+				continue;
+			}
+
+			int64_t Priority = 0;
+			uint32_t Age = Cache.Time - Cache.Timestamps[Vertex];
+			if (Age + 2 * LiveCount[Vertex] <= CacheSize)
+			{
+				Priority = Age;
+			}
+
+			if (Priority > BestPriority)
+			{
+				BestPriority = Priority;
+				Next = Vertex;
+			}
+		}
+
+		if (Next == UINT32_MAX)
+		{
+			/** Dead end, go back to a recently used vertex or to the next unfinished one in index order */
+			while (!DeadEndStack.empty())
+			{
+				uint32_t Vertex = DeadEndStack.back();
+				DeadEndStack.pop_back();
+
+				if (LiveCount[Vertex] > 0)
+				{
+					Next = Vertex;
+					break;
+				}
+			}
+
+			if (Next == UINT32_MAX)
+			{
+				while (Cursor < VertexCount && LiveCount[Cursor] == 0)
+				{
+					Cursor++;
+				}
+
+				Next = Cursor < VertexCount ? Cursor : UINT32_MAX;
+			}
+
+			bNewCluster = true;
+		}
+
+		Fanning = Next;
+	}
+
+	Indices.swap(Result);
+}
+
+void OptimizeOverdraw(
+	std::vector<uint32_t> & Indices,
+	const std::vector<uint32_t> & Clusters,
+	const float * pPositions,
+	size_t PositionStride,
+	size_t VertexCount,
+	float Threshold,
+	uint32_t CacheSize
+)
+{
+	size_t TriangleCount = Indices.size() / 3;
+
+	if (TriangleCount == 0 || Clusters.empty())
+	{
+		return;
+	}
+
+	/** Split each hard cluster wherever its running ACMR is already as good as the whole cluster's */
+	std::vector<uint32_t> Boundaries;
+	FifoCache Cache(VertexCount, CacheSize);
+
+	for (size_t c = 0; c < Clusters.size(); c++)
+	{
+		uint32_t Begin = Clusters[c];
+		uint32_t End = c + 1 < Clusters.size() ? Clusters[c + 1] : static_cast<uint32_t>(TriangleCount);
+
+		Cache.Flush();
+		size_t ClusterMisses = 0;
+		for (size_t i = Begin * 3; i < End * 3; i++)
+		{
+			ClusterMisses += Cache.Access(Indices[i]) ? 1 : 0;
+		}
+
+		float TargetAcmr = static_cast<float>(ClusterMisses) / (End - Begin) * Threshold;
+
+		Boundaries.push_back(Begin);
+
+		Cache.Flush();
+		size_t Misses = 0;
+		uint32_t SubBegin = Begin;
+
+		for (uint32_t Triangle = Begin; Triangle < End; Triangle++)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				Misses += Cache.Access(Indices[Triangle * 3 + k]) ? 1 : 0;
+			}
+
+			uint32_t SubSize = Triangle + 1 - SubBegin;
+			if (Triangle + 1 < End && Misses <= TargetAcmr * SubSize)
+			{
+				Boundaries.push_back(Triangle + 1);
+				SubBegin = Triangle + 1;
+				Misses = 0;
+				Cache.Flush();
+			}
+		}
+	}
+
+	/** Area weighted centroid and normal of every cluster and of the whole mesh */
+	struct ClusterInfo
+	{
+		uint32_t Begin;
+		uint32_t End;
+		float SortKey;
+	};
+
+	std::vector<ClusterInfo> ClusterInfos(Boundaries.size());
+	std::vector<glm::vec3> ClusterCentroids(Boundaries.size());
+	std::vector<glm::vec3> ClusterNormals(Boundaries.size());
+
+	glm::vec3 MeshCentroid(0.0f);
+	float MeshArea = 0.0f;
+
+	for (size_t c = 0; c < Boundaries.size(); c++)
+	{
+		ClusterInfo & Info = ClusterInfos[c];
+		Info.Begin = Boundaries[c];
+		Info.End = c + 1 < Boundaries.size() ? Boundaries[c + 1] : static_cast<uint32_t>(TriangleCount);
+
+		glm::vec3 Centroid(0.0f), PlainCentroid(0.0f), Normal(0.0f);
+		float Area = 0.0f;
+
+		for (uint32_t Triangle = Info.Begin; Triangle < Info.End; Triangle++)
+		{
+			glm::vec3 P0 = GetPosition(pPositions, PositionStride, Indices[Triangle * 3 + 0]);
+			glm::vec3 P1 = GetPosition(pPositions, PositionStride, Indices[Triangle * 3 + 1]);
+			glm::vec3 P2 = GetPosition(pPositions, PositionStride, Indices[Triangle * 3 + 2]);
+
+			glm::vec3 Cross = glm::cross(P1 - P0, P2 - P0);
+			float TriangleArea = glm::length(Cross);
+
+			Centroid += (P0 + P1 + P2) * (TriangleArea / 3.0f);
+			PlainCentroid += (P0 + P1 + P2) / 3.0f;
+			Normal += Cross;
+			Area += TriangleArea;
+		}
+
+		MeshCentroid += Centroid;
+		MeshArea += Area;
+
+		ClusterCentroids[c] = Area > 0.0f ? Centroid / Area : PlainCentroid / static_cast<float>(Info.End - Info.Begin);
+		float NormalLength = glm::length(Normal);
+		ClusterNormals[c] = NormalLength > 0.0f ? Normal / NormalLength : glm::vec3(0.0f);
+	}
+
+	if (MeshArea > 0.0f)
+	{
+		MeshCentroid /= MeshArea;
+	}
+
+	for (size_t c = 0; c < ClusterInfos.size(); c++)
+	{
+		ClusterInfos[c].SortKey = glm::dot(ClusterCentroids[c] - MeshCentroid, ClusterNormals[c]);
+	}
+
+	/** Clusters far out and facing away from the center tend to occlude the rest, draw them first */
+	std::stable_sort(ClusterInfos.begin(), ClusterInfos.end(), [](const ClusterInfo & Lhs, const ClusterInfo & Rhs)
+	{
+		return Lhs.SortKey > Rhs.SortKey;
+	});
+
+	std::vector<uint32_t> Result;
+	Result.reserve(Indices.size());
+
+	for (const ClusterInfo & Info : ClusterInfos)
+	{
+		Result.insert(Result.end(), Indices.begin() + Info.Begin * 3, Indices.begin() + Info.End * 3);
+	}
+
+	Indices.swap(Result);
+}
+
+size_t OptimizeVertexFetch(
+	std::vector<uint32_t> & Indices,
+	size_t VertexCount,
+	std::vector<uint32_t> & Remap
+)
+{
+	Remap.assign(VertexCount, UINT32_MAX);
+	uint32_t NextVertex = 0;
+
+	for (uint32_t & Index : Indices)
+	{
+		if (Remap[Index] == UINT32_MAX)
+		{
+			Remap[Index] = NextVertex++;
+		}
+
+		Index = Remap[Index];
+	}
+
+	return NextVertex;
+}
+
+void SplitMesh(
+	std::vector<uint32_t> & Indices,
+	size_t VertexCount,
+	uint32_t MaxVertices,
+	std::vector<uint32_t> & VertexSources,
+	std::vector<SubMesh> & SubMeshes
+)
+{
+	VertexSources.clear();
+	SubMeshes.clear();
+
+	if (VertexCount <= MaxVertices)
+	{
+		VertexSources.resize(VertexCount);
+		std::iota(VertexSources.begin(), VertexSources.end(), 0);
+
+		SubMesh Mesh;
+		Mesh.IndexCount = static_cast<uint32_t>(Indices.size());
+		Mesh.VertexCount = static_cast<uint32_t>(VertexCount);
+		SubMeshes.push_back(Mesh);
+		return;
+	}
+
+	/** Local index of every vertex in the current sub-mesh, valid if its stamp is the current sub-mesh */
+	std::vector<uint32_t> LocalIndices(VertexCount, 0);
+	std::vector<uint32_t> Stamps(VertexCount, UINT32_MAX);
+
+	SubMesh Current;
+
+	for (size_t Triangle = 0; Triangle < Indices.size() / 3; Triangle++)
+	{
+		uint32_t Stamp = static_cast<uint32_t>(SubMeshes.size());
+
+		uint32_t NewVertices = 0;
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			uint32_t Vertex = Indices[Triangle * 3 + k];
+			bool bDuplicate = (k > 0 && Indices[Triangle * 3] == Vertex) || (k > 1 && Indices[Triangle * 3 + 1] == Vertex);
+			NewVertices += Stamps[Vertex] != Stamp && !bDuplicate ? 1 : 0;
+		}
+
+		if (Current.VertexCount + NewVertices > MaxVertices)
+		{
+			SubMeshes.push_back(Current);
+
+			Current = SubMesh();
+			Current.FirstIndex = static_cast<uint32_t>(Triangle * 3);
+			Current.VertexOffset = static_cast<uint32_t>(VertexSources.size());
+			Stamp = static_cast<uint32_t>(SubMeshes.size());
+		}
+
+		for (uint32_t k = 0; k < 3; k++)
+		{
+			uint32_t & Index = Indices[Triangle * 3 + k];
+
+			if (Stamps[Index] != Stamp)
+			{
+				Stamps[Index] = Stamp;
+				LocalIndices[Index] = Current.VertexCount++;
+				VertexSources.push_back(Index);
+			}
+
+			Index = LocalIndices[Index];
+		}
+
+		Current.IndexCount += 3;
+	}
+
+	if (Current.IndexCount > 0)
+	{
+		SubMeshes.push_back(Current);
+	}
+}
+
+NAMESPACE_END
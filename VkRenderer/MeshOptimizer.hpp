@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** Cache size the reordering targets, also used when reporting the statistics. */
+const uint32_t MESH_OPTIMIZER_CACHE_SIZE = 16;
+
+/** Most vertices a sub-mesh can reference with 16-bit indices. */
+const uint32_t MESH_MAX_16BIT_VERTICES = 65536;
+
+/** A range of the index buffer, its indices are relative to VertexOffset. */
+struct SubMesh
+{
+	uint32_t FirstIndex = 0;
+	uint32_t IndexCount = 0;
+	uint32_t VertexOffset = 0;
+	uint32_t VertexCount = 0;
+	/** Its clusters in the meshlet table, none if the range was not clustered */
+	uint32_t FirstMeshlet = 0;
+	uint32_t MeshletCount = 0;
+};
+
+/** Result of running an index buffer through a FIFO post-transform cache. */
+struct VertexCacheStatistics
+{
+	/** Vertex shader invocations */
+	size_t VertexTransforms = 0;
+	/** Average cache miss ratio, transforms per triangle (0.5 at best, 3 at worst) */
+	float Acmr = 0.0f;
+	/** Average transform to vertex ratio, transforms per referenced vertex (1 at best) */
+	float Atvr = 0.0f;
+};
+
+VertexCacheStatistics AnalyzeVertexCache(
+	const std::vector<uint32_t> & Indices,
+	size_t VertexCount,
+	uint32_t CacheSize = MESH_OPTIMIZER_CACHE_SIZE
+);
+
+/**
+* Tipsify (Sander et al. 2007), reorders the triangles for vertex reuse in a cache of CacheSize.
+* Clusters receives the first triangle of every run that was started from a dead end, those
+* are the points where the triangle order can be changed without hurting the cache much.
+*/
+void OptimizeVertexCache(
+	std::vector<uint32_t> & Indices,
+	size_t VertexCount,
+	std::vector<uint32_t> & Clusters,
+	uint32_t CacheSize = MESH_OPTIMIZER_CACHE_SIZE
+);
+
+/**
+* Splits the clusters further where the local ACMR is within Threshold of the whole mesh, then sorts
+* them so outward facing clusters on the outside of the mesh are drawn first. Expects the output of
+* OptimizeVertexCache; Threshold trades cache efficiency (1.0) for overdraw (higher).
+*/
+void OptimizeOverdraw(
+	std::vector<uint32_t> & Indices,
+	const std::vector<uint32_t> & Clusters,
+	const float * pPositions,
+	size_t PositionStride,
+	size_t VertexCount,
+	float Threshold = 1.05f,
+	uint32_t CacheSize = MESH_OPTIMIZER_CACHE_SIZE
+);
+
+/**
+* Orders the vertices by first use so the vertex fetch walks memory linearly and rewrites the
+* indices accordingly. Remap[OldIndex] is the new index, or UINT32_MAX for unreferenced vertices
+* which are dropped; returns the new vertex count.
+*/
+size_t OptimizeVertexFetch(
+	std::vector<uint32_t> & Indices,
+	size_t VertexCount,
+	std::vector<uint32_t> & Remap
+);
+
+/**
+* Splits the triangles, in their current order, into sub-meshes that reference at most MaxVertices
+* vertices each. Every sub-mesh gets its own contiguous vertex range, so vertices shared across a split
+* are duplicated: new vertex i is a copy of old vertex VertexSources[i]. Indices are rewritten relative
+* to the VertexOffset of their sub-mesh. A mesh that already fits stays a single sub-mesh, unchanged.
+*/
+void SplitMesh(
+	std::vector<uint32_t> & Indices,
+	size_t VertexCount,
+	uint32_t MaxVertices,
+	std::vector<uint32_t> & VertexSources,
+	std::vector<SubMesh> & SubMeshes
+);
+
+template <typename TVertex>
+void GatherVertices(std::vector<TVertex> & Vertices, const std::vector<uint32_t> & VertexSources)
+{
+	std::vector<TVertex> Gathered(VertexSources.size());
+
+	for (size_t i = 0; i < VertexSources.size(); i++)
+	{
+		Gathered[i] = Vertices[VertexSources[i]];
+	}
+
+	Vertices.swap(Gathered);
+}
+
+template <typename TVertex>
+void RemapVertices(std::vector<TVertex> & Vertices, const std::vector<uint32_t> & Remap, size_t NewVertexCount)
+{
+	std::vector<TVertex> Remapped(NewVertexCount);
+
+	for (size_t i = 0; i < Vertices.size(); i++)
+	{
+		if (Remap[i] != UINT32_MAX)
+		{
+			Remapped[Remap[i]] = Vertices[i];
+		}
+	}
+
+	Vertices.swap(Remapped);
+}
+
+NAMESPACE_END
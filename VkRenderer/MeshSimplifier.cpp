@@ -0,0 +1,556 @@
+#include "MeshSimplifier.hpp"
+#include "Hash.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+enum VertexKind
+{
+	VERTEX_KIND_MANIFOLD = 0,
+	VERTEX_KIND_BORDER = 1,
+	VERTEX_KIND_SEAM = 2,
+	VERTEX_KIND_LOCKED = 3
+};
+
+/** [Source][Target], border and seam vertices stay on their own kind of edge */
+const bool s_CanCollapse[4][4] =
+{
+	{ true, true, true, true },
+	{ false, true, false, false },
+	{ false, false, true, false },
+	{ false, false, false, false }
+};
+
+/** Planes through border and seam edges keep the outline in place, weighted this much more than the surface */
+const double s_BoundaryWeight = 10.0;
+
+const uint32_t s_NoEdge = UINT32_MAX;
+
+/** Symmetric 4x4 plane quadric, Error divides by the accumulated weight to give a squared distance */
+struct Quadric
+{
+	double A00 = 0.0, A11 = 0.0, A22 = 0.0;
+	double A10 = 0.0, A20 = 0.0, A21 = 0.0;
+	double B0 = 0.0, B1 = 0.0, B2 = 0.0;
+	double C = 0.0;
+	double W = 0.0;
+
+	void AddPlane(const glm::dvec3 & N, double D, double Weight)
+	{
+		A00 += Weight * N.x * N.x;
+		A11 += Weight * N.y * N.y;
+		A22 += Weight * N.z * N.z;
+		A10 += Weight * N.y * N.x;
+		A20 += Weight * N.z * N.x;
+		A21 += Weight * N.z * N.y;
+		B0 += Weight * N.x * D;
+		B1 += Weight * N.y * D;
+		B2 += Weight * N.z * D;
+		C += Weight * D * D;
+		W += Weight;
+	}
+
+	void Add(const Quadric & Other)
+	{
+		A00 += Other.A00; A11 += Other.A11; A22 += Other.A22;
+		A10 += Other.A10; A20 += Other.A20; A21 += Other.A21;
+		B0 += Other.B0; B1 += Other.B1; B2 += Other.B2;
+		C += Other.C;
+		W += Other.W;
+	}
+
+	double Error(const glm::dvec3 & P) const
+	{
+		double R =
+			A00 * P.x * P.x + A11 * P.y * P.y + A22 * P.z * P.z +
+			2.0 * (A10 * P.x * P.y + A20 * P.x * P.z + A21 * P.y * P.z) +
+			2.0 * (B0 * P.x + B1 * P.y + B2 * P.z) +
+			C;
+		return W > 0.0 ? std::fabs(R) / W : 0.0;
+	}
+};
+
+/** Remap[i] is the first vertex whose leading KeySize bytes equal those of vertex i */
+void BuildRemap(
+	const uint8_t * pData,
+	size_t Stride,
+	size_t KeySize,
+	size_t Count,
+	std::vector<uint32_t> & Remap
+)
+{
+	size_t Capacity = 1;
+	while (Capacity < Count * 2)
+	{
+		Capacity *= 2;
+	}
+
+	std::vector<uint32_t> Table(Capacity, UINT32_MAX);
+	Remap.resize(Count);
+
+	for (size_t i = 0; i < Count; i++)
+	{
+		const uint8_t * pKey = pData + i * Stride;
+		size_t Slot = static_cast<size_t>(HashBytes(pKey, KeySize)) & (Capacity - 1);
+
+		while (true)
+		{
+			uint32_t Entry = Table[Slot];
+			if (Entry == UINT32_MAX)
+			{
+				Table[Slot] = static_cast<uint32_t>(i);
+				Remap[i] = static_cast<uint32_t>(i);
+				break;
+			}
+			if (std::memcmp(pData + Entry * Stride, pKey, KeySize) == 0)
+			{
+				Remap[i] = Entry;
+				break;
+			}
+			Slot = (Slot + 1) & (Capacity - 1);
+		}
+	}
+}
+
+/** Outgoing half-edges of every vertex in CSR layout */
+struct EdgeAdjacency
+{
+	std::vector<uint32_t> Offsets;
+	std::vector<uint32_t> Targets;
+
+	void Build(const std::vector<uint32_t> & Indices, size_t VertexCount)
+	{
+		Offsets.assign(VertexCount + 1, 0);
+		for (uint32_t Index : Indices)
+		{
+			Offsets[Index + 1]++;
+		}
+		for (size_t i = 0; i < VertexCount; i++)
+		{
+			Offsets[i + 1] += Offsets[i];
+		}
+
+		Targets.resize(Indices.size());
+		std::vector<uint32_t> Fill(Offsets.begin(), Offsets.end() - 1);
+		for (size_t i = 0; i < Indices.size(); i += 3)
+		{
+			for (size_t k = 0; k < 3; k++)
+			{
+				uint32_t From = Indices[i + k];
+				uint32_t To = Indices[i + (k + 1) % 3];
+				Targets[Fill[From]++] = To;
+			}
+		}
+	}
+
+	bool HasEdge(uint32_t From, uint32_t To) const
+	{
+		for (uint32_t i = Offsets[From]; i < Offsets[From + 1]; i++)
+		{
+			if (Targets[i] == To)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+/** Records the single open edge of a vertex, or the vertex itself once there is more than one */
+void SetOpenEdge(
+	uint32_t & Slot,
+	uint32_t Vertex,
+	uint32_t Other
+)
+{
+	Slot = (Slot == s_NoEdge || Slot == Other) ? Other : Vertex;
+}
+
+bool IsSingleOpenEdge(
+	uint32_t Slot,
+	uint32_t Vertex
+)
+{
+	return Slot != s_NoEdge && Slot != Vertex;
+}
+
+}
+
+float SimplifyMesh(
+	const std::vector<uint32_t> & Indices,
+	const void * pVertices,
+	size_t VertexStride,
+	size_t VertexCount,
+	size_t TargetIndexCount,
+	float MaxError,
+	bool bLockBorders,
+	std::vector<uint32_t> & Result
+)
+{
+	const uint8_t * pBytes = static_cast<const uint8_t *>(pVertices);
+
+	auto GetPosition = [&](uint32_t Vertex)
+	{
+		const float * pPosition = reinterpret_cast<const float *>(pBytes + Vertex * VertexStride);
+		return glm::dvec3(pPosition[0], pPosition[1], pPosition[2]);
+	};
+
+	/** Identical vertices are merged first, an unwelded mesh would otherwise be all seams */
+	std::vector<uint32_t> Canonical, Position;
+	BuildRemap(pBytes, VertexStride, VertexStride, VertexCount, Canonical);
+	BuildRemap(pBytes, VertexStride, 3 * sizeof(float), VertexCount, Position);
+
+	Result.resize(Indices.size());
+	for (size_t i = 0; i < Indices.size(); i++)
+	{
+		Result[i] = Canonical[Indices[i]];
+	}
+
+	/** Ring of the canonical vertices that share a position */
+	std::vector<uint32_t> Wedge(VertexCount);
+	for (uint32_t i = 0; i < VertexCount; i++)
+	{
+		Wedge[i] = i;
+	}
+	for (uint32_t i = 0; i < VertexCount; i++)
+	{
+		if (Canonical[i] == i && Position[i] != i)
+		{
+			uint32_t Representative = Position[i];
+			Wedge[i] = Wedge[Representative];
+			Wedge[Representative] = i;
+		}
+	}
+
+	/** An edge is open if its opposite half-edge does not exist, attribute seams are open too */
+	EdgeAdjacency Adjacency;
+	Adjacency.Build(Result, VertexCount);
+
+	std::vector<uint32_t> OpenOut(VertexCount, s_NoEdge), OpenIn(VertexCount, s_NoEdge);
+	for (size_t i = 0; i < Result.size(); i += 3)
+	{
+		for (size_t k = 0; k < 3; k++)
+		{
+			uint32_t From = Result[i + k];
+			uint32_t To = Result[i + (k + 1) % 3];
+
+			if (!Adjacency.HasEdge(To, From))
+			{
+				SetOpenEdge(OpenOut[From], From, To);
+				SetOpenEdge(OpenIn[To], To, From);
+			}
+		}
+	}
+
+	std::vector<uint8_t> Kinds(VertexCount, VERTEX_KIND_LOCKED);
+	for (uint32_t i = 0; i < VertexCount; i++)
+	{
+		if (Canonical[i] != i || Position[i] != i)
+		{
+			continue;
+		}
+
+		VertexKind Kind = VERTEX_KIND_LOCKED;
+
+		if (Wedge[i] == i)
+		{
+			if (OpenIn[i] == s_NoEdge && OpenOut[i] == s_NoEdge)
+			{
+				Kind = VERTEX_KIND_MANIFOLD;
+			}
+			else if (!bLockBorders && IsSingleOpenEdge(OpenIn[i], i) && IsSingleOpenEdge(OpenOut[i], i))
+			{
+				Kind = VERTEX_KIND_BORDER;
+			}
+		}
+		else if (Wedge[Wedge[i]] == i)
+		{
+			/** A seam has one open edge per side and both sides run between the same two positions */
+			uint32_t w = Wedge[i];
+			if (IsSingleOpenEdge(OpenIn[i], i) && IsSingleOpenEdge(OpenOut[i], i) &&
+				IsSingleOpenEdge(OpenIn[w], w) && IsSingleOpenEdge(OpenOut[w], w) &&
+				Position[OpenIn[i]] == Position[OpenOut[w]] &&
+				Position[OpenOut[i]] == Position[OpenIn[w]])
+			{
+				Kind = VERTEX_KIND_SEAM;
+			}
+		}
+
+		Kinds[i] = static_cast<uint8_t>(Kind);
+	}
+	for (uint32_t i = 0; i < VertexCount; i++)
+	{
+		Kinds[i] = Kinds[Position[i]];
+	}
+
+	/** Quadrics live on the position representative */
+	std::vector<Quadric> Quadrics(VertexCount);
+	for (size_t i = 0; i < Result.size(); i += 3)
+	{
+		glm::dvec3 P0 = GetPosition(Result[i + 0]);
+		glm::dvec3 P1 = GetPosition(Result[i + 1]);
+		glm::dvec3 P2 = GetPosition(Result[i + 2]);
+
+		glm::dvec3 Normal = glm::cross(P1 - P0, P2 - P0);
+		double Length = glm::length(Normal);
+		if (Length == 0.0)
+		{
+			continue;
+		}
+		Normal /= Length;
+
+		/** Weighted by area */
+		for (size_t k = 0; k < 3; k++)
+		{
+			Quadrics[Position[Result[i + k]]].AddPlane(Normal, -glm::dot(Normal, P0), Length * 0.5);
+		}
+
+		for (size_t k = 0; k < 3; k++)
+		{
+			uint32_t From = Result[i + k];
+			uint32_t To = Result[i + (k + 1) % 3];
+
+			if ((Kinds[From] == VERTEX_KIND_BORDER || Kinds[From] == VERTEX_KIND_SEAM) && OpenOut[From] == To)
+			{
+				glm::dvec3 PFrom = GetPosition(From);
+				glm::dvec3 Edge = GetPosition(To) - PFrom;
+				glm::dvec3 EdgeNormal = glm::cross(Edge, Normal);
+				double EdgeLength = glm::length(EdgeNormal);
+				if (EdgeLength == 0.0)
+				{
+					continue;
+				}
+				EdgeNormal /= EdgeLength;
+
+				double Weight = glm::dot(Edge, Edge) * s_BoundaryWeight;
+				Quadrics[Position[From]].AddPlane(EdgeNormal, -glm::dot(EdgeNormal, PFrom), Weight);
+				Quadrics[Position[To]].AddPlane(EdgeNormal, -glm::dot(EdgeNormal, PFrom), Weight);
+			}
+		}
+	}
+
+	struct Collapse
+	{
+		uint32_t Source;
+		uint32_t Target;
+		double Error;
+	};
+
+	auto CanCollapse = [&](uint32_t Source, uint32_t Target)
+	{
+		if (Position[Source] == Position[Target] || !s_CanCollapse[Kinds[Source]][Kinds[Target]])
+		{
+			return false;
+		}
+		if (Kinds[Source] == VERTEX_KIND_BORDER || Kinds[Source] == VERTEX_KIND_SEAM)
+		{
+			return OpenOut[Source] == Target || OpenIn[Source] == Target;
+		}
+		return true;
+	};
+
+	double MaxErrorSquared = static_cast<double>(MaxError) * MaxError;
+	double ResultError = 0.0;
+
+	std::vector<Collapse> Collapses;
+	std::vector<uint32_t> CollapseRemap(VertexCount);
+	std::vector<uint8_t> Locked(VertexCount);
+	std::vector<uint32_t> TriangleOffsets, Triangles;
+
+	while (Result.size() > TargetIndexCount)
+	{
+		size_t TriangleCount = Result.size() / 3;
+
+		/** Triangles around every position, for the flip test */
+		TriangleOffsets.assign(VertexCount + 1, 0);
+		for (uint32_t Index : Result)
+		{
+			TriangleOffsets[Position[Index] + 1]++;
+		}
+		for (size_t i = 0; i < VertexCount; i++)
+		{
+			TriangleOffsets[i + 1] += TriangleOffsets[i];
+		}
+		Triangles.resize(Result.size());
+		std::vector<uint32_t> Fill(TriangleOffsets.begin(), TriangleOffsets.end() - 1);
+		for (size_t i = 0; i < Result.size(); i++)
+		{
+			Triangles[Fill[Position[Result[i]]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		Collapses.clear();
+		for (size_t i = 0; i < Result.size(); i += 3)
+		{
+			for (size_t k = 0; k < 3; k++)
+			{
+				uint32_t A = Result[i + k];
+				uint32_t B = Result[i + (k + 1) % 3];
+
+				if (CanCollapse(A, B))
+				{
+					Collapses.push_back({ A, B, Quadrics[Position[A]].Error(GetPosition(B)) });
+				}
+				if (CanCollapse(B, A))
+				{
+					Collapses.push_back({ B, A, Quadrics[Position[B]].Error(GetPosition(A)) });
+				}
+			}
+		}
+
+		std::sort(Collapses.begin(), Collapses.end(), [](const Collapse & Lhs, const Collapse & Rhs)
+		{
+			return Lhs.Error < Rhs.Error;
+		});
+
+		/** A collapse removes about two triangles, stop each pass well short of the target */
+		size_t Goal = std::max<size_t>(1, (Result.size() - TargetIndexCount) / 6);
+		size_t Applied = 0;
+
+		for (uint32_t i = 0; i < VertexCount; i++)
+		{
+			CollapseRemap[i] = i;
+		}
+		std::fill(Locked.begin(), Locked.end(), static_cast<uint8_t>(0));
+
+		for (const Collapse & Candidate : Collapses)
+		{
+			if (Applied >= Goal || Candidate.Error > MaxErrorSquared)
+			{
+				break;
+			}
+
+			uint32_t Source = Candidate.Source;
+			uint32_t Target = Candidate.Target;
+			uint32_t SourcePosition = Position[Source];
+			uint32_t TargetPosition = Position[Target];
+
+			/** Both ends move or grow this pass, their neighborhoods are stale for any other collapse */
+			if (Locked[SourcePosition] || Locked[TargetPosition])
+			{
+				continue;
+			}
+
+			/** The other side of a seam follows the seam in the opposite direction */
+			uint32_t SeamSource = s_NoEdge, SeamTarget = s_NoEdge;
+			if (Kinds[Source] == VERTEX_KIND_SEAM)
+			{
+				SeamSource = Wedge[Source];
+				SeamTarget = OpenOut[Source] == Target ? OpenIn[SeamSource] : OpenOut[SeamSource];
+				if (!IsSingleOpenEdge(SeamTarget, SeamSource) || Position[SeamTarget] != TargetPosition)
+				{
+					continue;
+				}
+			}
+
+			/** Reject collapses that turn a triangle around the source over */
+			glm::dvec3 NewPosition = GetPosition(Target);
+			bool bFlip = false;
+
+			for (uint32_t t = TriangleOffsets[SourcePosition]; t < TriangleOffsets[SourcePosition + 1] && !bFlip; t++)
+			{
+				const uint32_t * pTriangle = &Result[Triangles[t] * 3];
+
+				glm::dvec3 Before[3], After[3];
+				bool bDegenerates = false;
+
+				for (size_t k = 0; k < 3; k++)
+				{
+					uint32_t Corner = Position[pTriangle[k]];
+					bDegenerates = bDegenerates || Corner == TargetPosition;
+					Before[k] = GetPosition(pTriangle[k]);
+					After[k] = Corner == SourcePosition ? NewPosition : Before[k];
+				}
+
+				if (bDegenerates)
+				{
+					continue;
+				}
+
+				glm::dvec3 NormalBefore = glm::cross(Before[1] - Before[0], Before[2] - Before[0]);
+				glm::dvec3 NormalAfter = glm::cross(After[1] - After[0], After[2] - After[0]);
+				bFlip = glm::dot(NormalBefore, NormalAfter) <= 0.0;
+			}
+
+			if (bFlip)
+			{
+				continue;
+			}
+
+			auto CollapseVertex = [&](uint32_t From, uint32_t To)
+			{
+				CollapseRemap[From] = To;
+
+				/** The target inherits the open edge on the far side of the source */
+				if (OpenOut[From] == To)
+				{
+					OpenIn[To] = OpenIn[From];
+				}
+				else if (OpenIn[From] == To)
+				{
+					OpenOut[To] = OpenOut[From];
+				}
+			};
+
+			CollapseVertex(Source, Target);
+			if (SeamSource != s_NoEdge)
+			{
+				CollapseVertex(SeamSource, SeamTarget);
+			}
+
+			Quadrics[TargetPosition].Add(Quadrics[SourcePosition]);
+			Locked[SourcePosition] = 1;
+			Locked[TargetPosition] = 1;
+
+			ResultError = std::max(ResultError, Candidate.Error);
+			Applied++;
+		}
+
+		if (Applied == 0)
+		{
+			break;
+		}
+
+		for (uint32_t i = 0; i < VertexCount; i++)
+		{
+			if (OpenOut[i] != s_NoEdge)
+			{
+				OpenOut[i] = CollapseRemap[OpenOut[i]];
+			}
+			if (OpenIn[i] != s_NoEdge)
+			{
+				OpenIn[i] = CollapseRemap[OpenIn[i]];
+			}
+		}
+
+		/** Rewrite the indices and drop the triangles that collapsed, also where only positions coincide */
+		size_t Write = 0;
+		for (size_t i = 0; i < TriangleCount; i++)
+		{
+			uint32_t A = CollapseRemap[Result[i * 3 + 0]];
+			uint32_t B = CollapseRemap[Result[i * 3 + 1]];
+			uint32_t C = CollapseRemap[Result[i * 3 + 2]];
+
+			if (Position[A] == Position[B] || Position[B] == Position[C] || Position[A] == Position[C])
+			{
+				continue;
+			}
+
+			Result[Write++] = A;
+			Result[Write++] = B;
+			Result[Write++] = C;
+		}
+		Result.resize(Write);
+	}
+
+	return static_cast<float>(std::sqrt(ResultError));
+}
+
+NAMESPACE_END
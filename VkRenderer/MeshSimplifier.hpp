@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/**
+* Quadric error metric edge collapse (Garland and Heckbert 1997) that only moves vertices onto
+* existing ones, so every level of detail indexes the original vertex buffer. Vertices that differ
+* only in their attributes are one position to the metric: UV and normal seams collapse along
+* themselves only, open borders along the border and anything more complex stays locked.
+* Positions are the first three floats of a vertex, all VertexStride bytes are compared to find
+* seams. bLockBorders keeps open borders fixed, for meshes that continue in another one that is
+* simplified separately. Stops at TargetIndexCount or MaxError, returns the largest error reached
+* as an object space distance.
+*/
+float SimplifyMesh(
+	const std::vector<uint32_t> & Indices,
+	const void * pVertices,
+	size_t VertexStride,
+	size_t VertexCount,
+	size_t TargetIndexCount,
+	float MaxError,
+	bool bLockBorders,
+	std::vector<uint32_t> & Result
+);
+
+NAMESPACE_END
@@ -0,0 +1,349 @@
+#include "MeshletBuilder.hpp"
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+/** Below this the cone is too wide for the test to ever pass, the meshlet is not cone culled */
+const float s_MinConeCosine = 0.1f;
+
+/** Favours triangles whose vertices have few triangles left, finishing vertices keeps the meshlets round */
+const float s_LiveTriangleWeight = 0.05f;
+
+glm::vec3 GetPosition(
+	const float * pPositions,
+	size_t PositionStride,
+	uint32_t Vertex
+)
+{
+	const float * pPosition = reinterpret_cast<const float *>(
+		reinterpret_cast<const uint8_t *>(pPositions) + Vertex * PositionStride
+	);
+	return glm::vec3(pPosition[0], pPosition[1], pPosition[2]);
+}
+
+/** Ritter's sphere: start from the most distant pair of axis extremes, then grow to include every point */
+void ComputeBoundingSphere(
+	const std::vector<glm::vec3> & Points,
+	glm::vec3 & Center,
+	float & Radius
+)
+{
+	size_t Min[3] = { 0, 0, 0 }, Max[3] = { 0, 0, 0 };
+
+	for (size_t i = 0; i < Points.size(); i++)
+	{
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			Min[Axis] = Points[i][Axis] < Points[Min[Axis]][Axis] ? i : Min[Axis];
+			Max[Axis] = Points[i][Axis] > Points[Max[Axis]][Axis] ? i : Max[Axis];
+		}
+	}
+
+	int Widest = 0;
+	float WidestDistance = -1.0f;
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		float Distance = glm::length(Points[Max[Axis]] - Points[Min[Axis]]);
+		if (Distance > WidestDistance)
+		{
+			Widest = Axis;
+			WidestDistance = Distance;
+		}
+	}
+
+	Center = (Points[Min[Widest]] + Points[Max[Widest]]) * 0.5f;
+	Radius = WidestDistance * 0.5f;
+
+	for (const glm::vec3 & Point : Points)
+	{
+		float Distance = glm::length(Point - Center);
+		if (Distance > Radius)
+		{
+			float Shift = (Distance - Radius) * 0.5f;
+			Center += (Point - Center) * (Shift / Distance);
+			Radius += Shift;
+		}
+	}
+}
+
+void ComputeMeshletBounds(
+	const uint32_t * pIndices,
+	const float * pPositions,
+	size_t PositionStride,
+	Meshlet & Cluster
+)
+{
+	std::vector<glm::vec3> Points, Normals, Corners;
+
+	for (uint32_t i = 0; i < Cluster.IndexCount; i += 3)
+	{
+		glm::vec3 A = GetPosition(pPositions, PositionStride, pIndices[i + 0]);
+		glm::vec3 B = GetPosition(pPositions, PositionStride, pIndices[i + 1]);
+		glm::vec3 C = GetPosition(pPositions, PositionStride, pIndices[i + 2]);
+		Points.push_back(A);
+		Points.push_back(B);
+		Points.push_back(C);
+
+		glm::vec3 Normal = glm::cross(B - A, C - A);
+		float Length = glm::length(Normal);
+		if (Length > 0.0f)
+		{
+			Normals.push_back(Normal / Length);
+			Corners.push_back(A);
+		}
+	}
+
+	if (Points.empty())
+	{
+		return;
+	}
+
+	ComputeBoundingSphere(Points, Cluster.Center, Cluster.Radius);
+
+	Cluster.ConeApex = Cluster.Center;
+	Cluster.ConeCutoff = 1.0f;
+
+	if (Normals.empty())
+	{
+		return;
+	}
+
+	/** The axis is the center of the smallest sphere around the normals on the unit sphere */
+	glm::vec3 NormalCenter;
+	float NormalRadius;
+	ComputeBoundingSphere(Normals, NormalCenter, NormalRadius);
+
+	float AxisLength = glm::length(NormalCenter);
+	if (AxisLength == 0.0f)
+	{
+		return;
+	}
+	Cluster.ConeAxis = NormalCenter / AxisLength;
+
+	float MinCosine = 1.0f;
+	for (const glm::vec3 & Normal : Normals)
+	{
+		MinCosine = std::min(MinCosine, glm::dot(Cluster.ConeAxis, Normal));
+	}
+
+	if (MinCosine <= s_MinConeCosine)
+	{
+		return;
+	}
+
+	/**
+	* Move the apex back along the axis until it is behind every triangle plane, then a viewer inside
+	* the cone mirrored around the apex sees the back of every triangle.
+	*/
+	float MaxOffset = 0.0f;
+	for (size_t i = 0; i < Normals.size(); i++)
+	{
+		float Offset = glm::dot(Cluster.Center - Corners[i], Normals[i]) / glm::dot(Cluster.ConeAxis, Normals[i]);
+		MaxOffset = std::max(MaxOffset, Offset);
+	}
+
+	Cluster.ConeApex = Cluster.Center - Cluster.ConeAxis * MaxOffset;
+	Cluster.ConeCutoff = std::sqrt(1.0f - MinCosine * MinCosine);
+}
+
+}
+
+void BuildMeshlets(
+	std::vector<uint32_t> & Indices,
+	const float * pPositions,
+	size_t PositionStride,
+	size_t VertexCount,
+	std::vector<Meshlet> & Meshlets,
+	float ConeWeight,
+	uint32_t MaxVertices,
+	uint32_t MaxTriangles
+)
+{
+	Meshlets.clear();
+
+	const size_t TriangleCount = Indices.size() / 3;
+	if (TriangleCount == 0)
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> TriangleNormals(TriangleCount);
+	for (size_t t = 0; t < TriangleCount; t++)
+	{
+		glm::vec3 A = GetPosition(pPositions, PositionStride, Indices[t * 3 + 0]);
+		glm::vec3 B = GetPosition(pPositions, PositionStride, Indices[t * 3 + 1]);
+		glm::vec3 C = GetPosition(pPositions, PositionStride, Indices[t * 3 + 2]);
+		glm::vec3 Normal = glm::cross(B - A, C - A);
+		float Length = glm::length(Normal);
+		TriangleNormals[t] = Length > 0.0f ? Normal / Length : glm::vec3(0.0f);
+	}
+
+	/** Triangles around every vertex, LiveTriangles counts the ones not placed in a meshlet yet */
+	std::vector<uint32_t> LiveTriangles(VertexCount, 0);
+	for (uint32_t Index : Indices)
+	{
+		LiveTriangles[Index]++;
+	}
+
+	std::vector<uint32_t> AdjacencyOffsets(VertexCount + 1, 0);
+	for (size_t v = 0; v < VertexCount; v++)
+	{
+		AdjacencyOffsets[v + 1] = AdjacencyOffsets[v] + LiveTriangles[v];
+	}
+
+	std::vector<uint32_t> Adjacency(Indices.size());
+	std::vector<uint32_t> Fill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < Indices.size(); i++)
+	{
+		Adjacency[Fill[Indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<bool> Emitted(TriangleCount, false);
+	/** Meshlet index + 1 of the meshlet a vertex was last added to */
+	std::vector<uint32_t> VertexOwner(VertexCount, 0);
+
+	std::vector<uint32_t> Reordered;
+	Reordered.reserve(Indices.size());
+
+	std::vector<uint32_t> ClusterVertices;
+	size_t NextSeed = 0;
+
+	while (Reordered.size() < Indices.size())
+	{
+		while (Emitted[NextSeed])
+		{
+			NextSeed++;
+		}
+
+		const uint32_t Owner = static_cast<uint32_t>(Meshlets.size() + 1);
+
+		Meshlet Cluster;
+		Cluster.FirstIndex = static_cast<uint32_t>(Reordered.size());
+		ClusterVertices.clear();
+
+		glm::vec3 NormalSum(0.0f);
+		size_t Candidate = NextSeed;
+
+		while (true)
+		{
+			Emitted[Candidate] = true;
+			NormalSum += TriangleNormals[Candidate];
+
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t Index = Indices[Candidate * 3 + k];
+				Reordered.push_back(Index);
+				LiveTriangles[Index]--;
+
+				if (VertexOwner[Index] != Owner)
+				{
+					VertexOwner[Index] = Owner;
+					ClusterVertices.push_back(Index);
+				}
+			}
+
+			Cluster.IndexCount += 3;
+			if (Cluster.IndexCount / 3 >= MaxTriangles)
+			{
+				break;
+			}
+
+			float NormalLength = glm::length(NormalSum);
+			glm::vec3 Axis = NormalLength > 0.0f ? NormalSum / NormalLength : glm::vec3(0.0f);
+
+			/** Only triangles touching the meshlet are candidates, so it stays connected and compact */
+			float BestScore = std::numeric_limits<float>::max();
+			size_t Best = TriangleCount;
+
+			for (uint32_t Vertex : ClusterVertices)
+			{
+				if (LiveTriangles[Vertex] == 0)
+				{
+					continue;
+				}
+
+				for (uint32_t a = AdjacencyOffsets[Vertex]; a < AdjacencyOffsets[Vertex + 1]; a++)
+				{
+					uint32_t Triangle = Adjacency[a];
+					if (Emitted[Triangle])
+					{
+						continue;
+					}
+
+					uint32_t NewVertices = 0, Live = 0;
+					for (int k = 0; k < 3; k++)
+					{
+						NewVertices += VertexOwner[Indices[Triangle * 3 + k]] != Owner ? 1 : 0;
+						Live += LiveTriangles[Indices[Triangle * 3 + k]];
+					}
+
+					if (ClusterVertices.size() + NewVertices > MaxVertices)
+					{
+						continue;
+					}
+
+					float Score = static_cast<float>(NewVertices) + s_LiveTriangleWeight * Live + ConeWeight * (1.0f - glm::dot(Axis, TriangleNormals[Triangle]));
+					if (Score < BestScore)
+					{
+						BestScore = Score;
+						Best = Triangle;
+					}
+				}
+			}
+
+			if (Best == TriangleCount)
+			{
+				break;
+			}
+			Candidate = Best;
+		}
+
+		Cluster.VertexCount = static_cast<uint32_t>(ClusterVertices.size());
+		Meshlets.push_back(Cluster);
+	}
+
+	Indices.swap(Reordered);
+
+	/** The growth order is not cache friendly, reorder inside every meshlet on its local vertices */
+	std::vector<uint32_t> LocalIndices, LocalToGlobal, Clusters;
+	std::vector<uint32_t> GlobalToLocal(VertexCount, UINT32_MAX);
+
+	for (Meshlet & Cluster : Meshlets)
+	{
+		uint32_t * pIndices = &Indices[Cluster.FirstIndex];
+
+		LocalIndices.resize(Cluster.IndexCount);
+		LocalToGlobal.clear();
+		for (uint32_t i = 0; i < Cluster.IndexCount; i++)
+		{
+			if (GlobalToLocal[pIndices[i]] == UINT32_MAX)
+			{
+				GlobalToLocal[pIndices[i]] = static_cast<uint32_t>(LocalToGlobal.size());
+				LocalToGlobal.push_back(pIndices[i]);
+			}
+			LocalIndices[i] = GlobalToLocal[pIndices[i]];
+		}
+
+		OptimizeVertexCache(LocalIndices, LocalToGlobal.size(), Clusters);
+
+		for (uint32_t i = 0; i < Cluster.IndexCount; i++)
+		{
+			pIndices[i] = LocalToGlobal[LocalIndices[i]];
+		}
+		for (uint32_t Vertex : LocalToGlobal)
+		{
+			GlobalToLocal[Vertex] = UINT32_MAX;
+		}
+
+		ComputeMeshletBounds(pIndices, pPositions, PositionStride, Cluster);
+	}
+}
+
+NAMESPACE_END
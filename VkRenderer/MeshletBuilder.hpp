@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** Limits of a meshlet, the sizes mesh shading hardware handles best. */
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+/** A cluster of triangles stored as a contiguous range of the index buffer, with the data to cull it as a whole. */
+struct Meshlet
+{
+	/** Relative to the first index of the sub-mesh the meshlet belongs to */
+	uint32_t FirstIndex = 0;
+	uint32_t IndexCount = 0;
+	uint32_t VertexCount = 0;
+	/** Object space bounding sphere */
+	glm::vec3 Center = glm::vec3(0.0f);
+	float Radius = 0.0f;
+	/**
+	* Normal cone: every triangle faces away from a viewer at P if
+	* dot(normalize(ConeApex - P), ConeAxis) > ConeCutoff. A cutoff of 1 never culls.
+	*/
+	glm::vec3 ConeApex = glm::vec3(0.0f);
+	glm::vec3 ConeAxis = glm::vec3(0.0f);
+	float ConeCutoff = 1.0f;
+};
+
+/**
+* Greedily grows clusters of at most MaxVertices vertices and MaxTriangles triangles over the edge
+* adjacency, preferring triangles that add no vertex and that face the way of the cluster, and reorders
+* the triangles so every meshlet is contiguous and cache optimized. ConeWeight trades vertex reuse (0)
+* for tighter normal cones, which cull more. Meshlets is overwritten, FirstIndex is relative to Indices.
+*/
+void BuildMeshlets(
+	std::vector<uint32_t> & Indices,
+	const float * pPositions,
+	size_t PositionStride,
+	size_t VertexCount,
+	std::vector<Meshlet> & Meshlets,
+	float ConeWeight = 0.5f,
+	uint32_t MaxVertices = MESHLET_MAX_VERTICES,
+	uint32_t MaxTriangles = MESHLET_MAX_TRIANGLES
+);
+
+NAMESPACE_END
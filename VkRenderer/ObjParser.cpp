@@ -0,0 +1,662 @@
+#include "ObjParser.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+/** Smaller chunks do not amortize the merge */
+const size_t s_MinChunkBytes = 1 << 20;
+
+/** Chunks per thread, so a chunk of long face lines does not leave the other threads idle */
+const uint32_t s_ChunksPerThread = 4;
+
+/** Significant digits that fit a uint64_t, the rest only scale the value */
+const int s_MaxMantissaDigits = 19;
+
+const uint32_t s_MissingIndex = UINT32_MAX;
+
+/** Everything one chunk contributes, indices are absolute unless listed in RelativeIndices */
+struct ObjChunk
+{
+	std::vector<float> Positions;
+	std::vector<float> TexCoords;
+	std::vector<float> Normals;
+	std::vector<ObjCorner> Corners;
+	/** Corner * 3 + attribute of negative indices, stored relative to the first attribute of the chunk */
+	std::vector<size_t> RelativeIndices;
+	/** usemtl statements, the corners before the first one continue the material of the previous chunk */
+	std::vector<std::pair<std::string, size_t>> MaterialStarts;
+	std::vector<std::string> MaterialLibraries;
+	/** Line that failed to parse, empty if the chunk is valid */
+	std::string Error;
+};
+
+bool IsDigit(
+	char Char
+)
+{
+	return static_cast<unsigned>(Char - '0') < 10;
+}
+
+bool IsSpace(
+	char Char
+)
+{
+	return Char == ' ' || Char == '\t' || Char == '\r';
+}
+
+const char * SkipSpaces(
+	const char * p,
+	const char * pEnd
+)
+{
+	while (p < pEnd && IsSpace(*p))
+	{
+		p++;
+	}
+	return p;
+}
+
+const char * SkipToken(
+	const char * p,
+	const char * pEnd
+)
+{
+	while (p < pEnd && !IsSpace(*p))
+	{
+		p++;
+	}
+	return p;
+}
+
+double GetPowerOf10(
+	int Exponent
+)
+{
+	/** Exact in double, a single multiplication or division by them rounds correctly */
+	static const double s_Powers[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	return Exponent <= 22 ? s_Powers[Exponent] : std::pow(10.0, Exponent);
+}
+
+/** The rare forms the fast path does not handle: inf, nan, hexadecimal. strtof needs a terminated copy */
+const char * ParseFloatSlow(
+	const char * p,
+	const char * pEnd,
+	float & Value
+)
+{
+	char Buffer[64];
+	size_t Length = std::min<size_t>(SkipToken(p, pEnd) - p, sizeof(Buffer) - 1);
+	memcpy(Buffer, p, Length);
+	Buffer[Length] = '\0';
+
+	char * pParsed = nullptr;
+	Value = std::strtof(Buffer, &pParsed);
+	return pParsed == Buffer ? nullptr : p + (pParsed - Buffer);
+}
+
+/**
+* Decimal floats with up to 19 significant digits are assembled as an integer and scaled once in double,
+* which is correctly rounded for up to 15 digits and the exponents OBJ exporters write. Returns the end
+* of the number, or nullptr if there is none.
+*/
+const char * ParseFloat(
+	const char * p,
+	const char * pEnd,
+	float & Value
+)
+{
+	const char * pStart = p;
+	bool bNegative = false;
+
+	if (p < pEnd && (*p == '-' || *p == '+'))
+	{
+		bNegative = *p == '-';
+		p++;
+	}
+
+	uint64_t Mantissa = 0;
+	int Digits = 0, Exponent = 0;
+	bool bAnyDigit = false;
+
+	for (; p < pEnd && IsDigit(*p); p++)
+	{
+		bAnyDigit = true;
+		if (Digits < s_MaxMantissaDigits)
+		{
+			Mantissa = Mantissa * 10 + (*p - '0');
+			Digits += Mantissa != 0 ? 1 : 0;
+		}
+		else
+		{
+			Exponent++;
+		}
+	}
+
+	if (p < pEnd && *p == '.')
+	{
+		for (p++; p < pEnd && IsDigit(*p); p++)
+		{
+			bAnyDigit = true;
+			if (Digits < s_MaxMantissaDigits)
+			{
+				Mantissa = Mantissa * 10 + (*p - '0');
+				Digits += Mantissa != 0 ? 1 : 0;
+				Exponent--;
+			}
+		}
+	}
+
+	if (!bAnyDigit)
+	{
+		return ParseFloatSlow(pStart, pEnd, Value);
+	}
+
+	if (p + 1 < pEnd && (*p == 'e' || *p == 'E') && (IsDigit(p[1]) || ((p[1] == '-' || p[1] == '+') && p + 2 < pEnd && IsDigit(p[2]))))
+	{
+		p++;
+		bool bNegativeExponent = *p == '-';
+		p += (*p == '-' || *p == '+') ? 1 : 0;
+
+		int ExplicitExponent = 0;
+		for (; p < pEnd && IsDigit(*p); p++)
+		{
+			ExplicitExponent = std::min(ExplicitExponent * 10 + (*p - '0'), 100000);
+		}
+		Exponent += bNegativeExponent ? -ExplicitExponent : ExplicitExponent;
+	}
+
+	double Result = static_cast<double>(Mantissa);
+	if (Mantissa != 0)
+	{
+		/** Outside of this the float is zero or infinite anyway, the clamp keeps pow finite enough */
+		Exponent = std::max(-400, std::min(400, Exponent));
+		Result = Exponent < 0 ? Result / GetPowerOf10(-Exponent) : Result * GetPowerOf10(Exponent);
+	}
+
+	Value = static_cast<float>(bNegative ? -Result : Result);
+	return p;
+}
+
+const char * ParseIndex(
+	const char * p,
+	const char * pEnd,
+	int64_t & Index
+)
+{
+	bool bNegative = p < pEnd && *p == '-';
+	p += bNegative ? 1 : 0;
+
+	if (p >= pEnd || !IsDigit(*p))
+	{
+		return nullptr;
+	}
+
+	Index = 0;
+	for (; p < pEnd && IsDigit(*p); p++)
+	{
+		Index = std::min<int64_t>(Index * 10 + (*p - '0'), INT64_C(1) << 40);
+	}
+	Index = bNegative ? -Index : Index;
+	return p;
+}
+
+/** Parses Count floats, missing trailing values are zero as in the OBJ specification */
+bool ParseFloats(
+	const char * p,
+	const char * pEnd,
+	uint32_t Count,
+	uint32_t RequiredCount,
+	std::vector<float> & Output
+)
+{
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		p = SkipSpaces(p, pEnd);
+
+		float Value = 0.0f;
+		if (p < pEnd)
+		{
+			p = ParseFloat(p, pEnd, Value);
+			if (!p)
+			{
+				return false;
+			}
+		}
+		else if (i < RequiredCount)
+		{
+			return false;
+		}
+
+		Output.push_back(Value);
+	}
+	return true;
+}
+
+bool ParseFace(
+	const char * p,
+	const char * pEnd,
+	ObjChunk & Chunk,
+	std::vector<ObjCorner> & Polygon,
+	std::vector<uint8_t> & PolygonRelative
+)
+{
+	Polygon.clear();
+	PolygonRelative.clear();
+
+	const size_t AttributeCounts[3] = { Chunk.Positions.size() / 3, Chunk.TexCoords.size() / 2, Chunk.Normals.size() / 3 };
+
+	while (true)
+	{
+		p = SkipSpaces(p, pEnd);
+		if (p >= pEnd)
+		{
+			break;
+		}
+
+		ObjCorner Corner = { s_MissingIndex, s_MissingIndex, s_MissingIndex };
+		uint32_t * pIndices = &Corner.Position;
+		uint8_t Relative = 0;
+
+		/** v, v/vt, v//vn or v/vt/vn */
+		for (int Attribute = 0; Attribute < 3; Attribute++)
+		{
+			if (Attribute > 0)
+			{
+				if (p >= pEnd || *p != '/')
+				{
+					break;
+				}
+				p++;
+				if (p < pEnd && *p == '/')
+				{
+					continue;
+				}
+			}
+
+			int64_t Index = 0;
+			p = ParseIndex(p, pEnd, Index);
+			if (!p || Index == 0)
+			{
+				return false;
+			}
+
+			pIndices[Attribute] = Index > 0 ? static_cast<uint32_t>(std::min<int64_t>(Index - 1, s_MissingIndex - 1)) :
+				static_cast<uint32_t>(static_cast<int64_t>(AttributeCounts[Attribute]) + Index);
+			Relative |= Index < 0 ? 1 << Attribute : 0;
+		}
+
+		if (p < pEnd && !IsSpace(*p))
+		{
+			return false;
+		}
+
+		Polygon.push_back(Corner);
+		PolygonRelative.push_back(Relative);
+	}
+
+	if (Polygon.size() < 3)
+	{
+		/** Points and lines written as faces are not drawn, as with Assimp */
+		return true;
+	}
+
+	for (size_t i = 1; i + 1 < Polygon.size(); i++)
+	{
+		const size_t Fan[3] = { 0, i, i + 1 };
+		for (size_t Corner : Fan)
+		{
+			for (int Attribute = 0; Attribute < 3; Attribute++)
+			{
+				if (PolygonRelative[Corner] & (1 << Attribute))
+				{
+					Chunk.RelativeIndices.push_back(Chunk.Corners.size() * 3 + Attribute);
+				}
+			}
+			Chunk.Corners.push_back(Polygon[Corner]);
+		}
+	}
+
+	return true;
+}
+
+void ParseChunk(
+	const char * p,
+	const char * pEnd,
+	ObjChunk & Chunk
+)
+{
+	std::vector<ObjCorner> Polygon;
+	std::vector<uint8_t> PolygonRelative;
+
+	while (p < pEnd)
+	{
+		const char * pLineEnd = static_cast<const char *>(memchr(p, '\n', pEnd - p));
+		pLineEnd = pLineEnd ? pLineEnd : pEnd;
+
+		const char * pLine = SkipSpaces(p, pLineEnd);
+		bool bValid = true;
+
+		if (pLineEnd - pLine >= 2 && pLine[0] == 'v' && IsSpace(pLine[1]))
+		{
+			bValid = ParseFloats(pLine + 2, pLineEnd, 3, 3, Chunk.Positions);
+		}
+		else if (pLineEnd - pLine >= 3 && pLine[0] == 'v' && pLine[1] == 't' && IsSpace(pLine[2]))
+		{
+			bValid = ParseFloats(pLine + 3, pLineEnd, 2, 1, Chunk.TexCoords);
+		}
+		else if (pLineEnd - pLine >= 3 && pLine[0] == 'v' && pLine[1] == 'n' && IsSpace(pLine[2]))
+		{
+			bValid = ParseFloats(pLine + 3, pLineEnd, 3, 3, Chunk.Normals);
+		}
+		else if (pLineEnd - pLine >= 2 && pLine[0] == 'f' && IsSpace(pLine[1]))
+		{
+			bValid = ParseFace(pLine + 2, pLineEnd, Chunk, Polygon, PolygonRelative);
+		}
+		else if (pLineEnd - pLine >= 7 && strncmp(pLine, "usemtl", 6) == 0 && IsSpace(pLine[6]))
+		{
+			const char * pName = SkipSpaces(pLine + 7, pLineEnd);
+			const char * pNameEnd = pLineEnd;
+			while (pNameEnd > pName && IsSpace(pNameEnd[-1]))
+			{
+				pNameEnd--;
+			}
+			Chunk.MaterialStarts.emplace_back(std::string(pName, pNameEnd), Chunk.Corners.size());
+		}
+		else if (pLineEnd - pLine >= 7 && strncmp(pLine, "mtllib", 6) == 0 && IsSpace(pLine[6]))
+		{
+			for (const char * pName = SkipSpaces(pLine + 7, pLineEnd); pName < pLineEnd; pName = SkipSpaces(pName, pLineEnd))
+			{
+				const char * pNameEnd = SkipToken(pName, pLineEnd);
+				Chunk.MaterialLibraries.emplace_back(pName, pNameEnd);
+				pName = pNameEnd;
+			}
+		}
+
+		if (!bValid && Chunk.Error.empty())
+		{
+			Chunk.Error.assign(pLine, std::min<size_t>(pLineEnd - pLine, 80));
+		}
+
+		p = pLineEnd + 1;
+	}
+}
+
+}
+
+double ObjParseStatistics::GetMegabytesPerSecond() const
+{
+	return Milliseconds > 0.0 ? Bytes / (1024.0 * 1024.0) / (Milliseconds / 1000.0) : 0.0;
+}
+
+void ParseObj(
+	const std::string & Filename,
+	ThreadPool * pPool,
+	ObjModel & Model,
+	ObjParseStatistics * pStatistics
+)
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	MappedFile File;
+	if (!File.Open(Filename))
+	{
+		throw std::runtime_error("Failed to open OBJ file!");
+	}
+
+	const char * pData = reinterpret_cast<const char *>(File.GetData());
+	const size_t Size = File.GetSize();
+
+	uint32_t ChunkCount = 1;
+	if (pPool)
+	{
+		ChunkCount = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(Size / s_MinChunkBytes, pPool->GetThreadCount() * s_ChunksPerThread)));
+	}
+
+	/** Every chunk but the first starts after a line break, a chunk may be empty */
+	std::vector<size_t> ChunkStarts(ChunkCount + 1, Size);
+	ChunkStarts[0] = 0;
+	for (uint32_t i = 1; i < ChunkCount; i++)
+	{
+		size_t Start = std::max(ChunkStarts[i - 1], Size / ChunkCount * i);
+		const void * pLineBreak = memchr(pData + Start, '\n', Size - Start);
+		ChunkStarts[i] = pLineBreak ? static_cast<const char *>(pLineBreak) - pData + 1 : Size;
+	}
+
+	std::vector<ObjChunk> Chunks(ChunkCount);
+
+	auto ParseChunkAt = [&](uint32_t i)
+	{
+		ParseChunk(pData + ChunkStarts[i], pData + ChunkStarts[i + 1], Chunks[i]);
+	};
+
+	if (pPool && ChunkCount > 1)
+	{
+		pPool->ParallelFor(ChunkCount, ParseChunkAt);
+	}
+	else
+	{
+		ParseChunkAt(0);
+	}
+
+	File.Close();
+
+	/** Merge in file order: offsets of every chunk, then the materials, then the copies in parallel */
+	struct ChunkOffsets
+	{
+		size_t Positions = 0, TexCoords = 0, Normals = 0, Corners = 0;
+	};
+
+	std::vector<ChunkOffsets> Offsets(ChunkCount + 1);
+	for (uint32_t i = 0; i < ChunkCount; i++)
+	{
+		if (!Chunks[i].Error.empty())
+		{
+			throw std::runtime_error("Failed to parse OBJ line \"" + Chunks[i].Error + "\"!");
+		}
+
+		Offsets[i + 1].Positions = Offsets[i].Positions + Chunks[i].Positions.size();
+		Offsets[i + 1].TexCoords = Offsets[i].TexCoords + Chunks[i].TexCoords.size();
+		Offsets[i + 1].Normals = Offsets[i].Normals + Chunks[i].Normals.size();
+		Offsets[i + 1].Corners = Offsets[i].Corners + Chunks[i].Corners.size();
+	}
+
+	Model = ObjModel();
+
+	std::unordered_map<std::string, uint32_t> MaterialIndices;
+	std::string CurrentMaterial;
+
+	auto AddRun = [&](const std::string & Name, size_t FirstCorner, size_t EndCorner)
+	{
+		if (FirstCorner == EndCorner)
+		{
+			return;
+		}
+
+		auto Inserted = MaterialIndices.emplace(Name, static_cast<uint32_t>(Model.MaterialNames.size()));
+		if (Inserted.second)
+		{
+			Model.MaterialNames.push_back(Name);
+		}
+
+		uint32_t Material = Inserted.first->second;
+		if (!Model.MaterialRuns.empty() && Model.MaterialRuns.back().Material == Material)
+		{
+			Model.MaterialRuns.back().CornerCount += EndCorner - FirstCorner;
+		}
+		else
+		{
+			Model.MaterialRuns.push_back({ Material, FirstCorner, EndCorner - FirstCorner });
+		}
+	};
+
+	for (uint32_t i = 0; i < ChunkCount; i++)
+	{
+		const ObjChunk & Chunk = Chunks[i];
+		size_t RunStart = Offsets[i].Corners;
+
+		for (const auto & Start : Chunk.MaterialStarts)
+		{
+			AddRun(CurrentMaterial, RunStart, Offsets[i].Corners + Start.second);
+			CurrentMaterial = Start.first;
+			RunStart = Offsets[i].Corners + Start.second;
+		}
+		AddRun(CurrentMaterial, RunStart, Offsets[i + 1].Corners);
+
+		Model.MaterialLibraries.insert(Model.MaterialLibraries.end(), Chunk.MaterialLibraries.begin(), Chunk.MaterialLibraries.end());
+	}
+
+	const ChunkOffsets & Totals = Offsets[ChunkCount];
+	Model.Positions.resize(Totals.Positions);
+	Model.TexCoords.resize(Totals.TexCoords);
+	Model.Normals.resize(Totals.Normals);
+	Model.Corners.resize(Totals.Corners);
+
+	const size_t Components[3] = { 3, 2, 3 };
+	const size_t AttributeCounts[3] = { Totals.Positions / 3, Totals.TexCoords / 2, Totals.Normals / 3 };
+
+	auto MergeChunk = [&](uint32_t i)
+	{
+		ObjChunk & Chunk = Chunks[i];
+
+		std::copy(Chunk.Positions.begin(), Chunk.Positions.end(), Model.Positions.begin() + Offsets[i].Positions);
+		std::copy(Chunk.TexCoords.begin(), Chunk.TexCoords.end(), Model.TexCoords.begin() + Offsets[i].TexCoords);
+		std::copy(Chunk.Normals.begin(), Chunk.Normals.end(), Model.Normals.begin() + Offsets[i].Normals);
+
+		const size_t ChunkBases[3] = { Offsets[i].Positions / Components[0], Offsets[i].TexCoords / Components[1], Offsets[i].Normals / Components[2] };
+
+		for (size_t Slot : Chunk.RelativeIndices)
+		{
+			uint32_t & Index = (&Chunk.Corners[Slot / 3].Position)[Slot % 3];
+			int64_t Resolved = static_cast<int64_t>(static_cast<int32_t>(Index)) + static_cast<int64_t>(ChunkBases[Slot % 3]);
+
+			/** Checked here, one before the first vertex would otherwise wrap to the missing index */
+			if (Resolved < 0)
+			{
+				throw std::runtime_error("Failed to parse OBJ file, a face references a missing vertex!");
+			}
+
+			Index = static_cast<uint32_t>(Resolved);
+		}
+
+		ObjCorner * pCorners = &Model.Corners[Offsets[i].Corners];
+		for (size_t c = 0; c < Chunk.Corners.size(); c++)
+		{
+			const ObjCorner & Corner = Chunk.Corners[c];
+			const uint32_t * pIndices = &Corner.Position;
+
+			for (int Attribute = 0; Attribute < 3; Attribute++)
+			{
+				if (pIndices[Attribute] != s_MissingIndex && pIndices[Attribute] >= AttributeCounts[Attribute])
+				{
+					throw std::runtime_error("Failed to parse OBJ file, a face references a missing vertex!");
+				}
+			}
+
+			pCorners[c] = Corner;
+		}
+
+		Chunk = ObjChunk();
+	};
+
+	if (pPool && ChunkCount > 1)
+	{
+		pPool->ParallelFor(ChunkCount, MergeChunk);
+	}
+	else
+	{
+		MergeChunk(0);
+	}
+
+	if (pStatistics)
+	{
+		pStatistics->Bytes = Size;
+		pStatistics->Chunks = ChunkCount;
+		pStatistics->Milliseconds = std::chrono::duration<double, std::chrono::milliseconds::period>(
+			std::chrono::high_resolution_clock::now() - StartTime
+			).count();
+	}
+}
+
+void LoadObjMaterials(
+	const ObjModel & Model,
+	const std::string & BaseDirectory,
+	std::vector<SceneMaterial> & Materials
+)
+{
+	std::map<std::string, int> MaterialMap;
+	std::vector<tinyobj::material_t> Libraries;
+
+	for (const std::string & Library : Model.MaterialLibraries)
+	{
+		std::ifstream Stream((std::filesystem::path(BaseDirectory) / Library).generic_string());
+		if (Stream.is_open())
+		{
+			std::string Warning, Error;
+			tinyobj::LoadMtl(&MaterialMap, &Libraries, &Stream, &Warning, &Error);
+		}
+	}
+
+	auto GetTexturePath = [&BaseDirectory](std::initializer_list<const std::string *> Names)
+	{
+		for (const std::string * pName : Names)
+		{
+			if (!pName->empty())
+			{
+				std::string Filename(*pName);
+				std::replace(Filename.begin(), Filename.end(), '\\', '/');
+				return (std::filesystem::path(BaseDirectory) / Filename).generic_string();
+			}
+		}
+		return std::string();
+	};
+
+	Materials.clear();
+	Materials.resize(Model.MaterialNames.size());
+
+	for (size_t i = 0; i < Model.MaterialNames.size(); i++)
+	{
+		SceneMaterial & Material = Materials[i];
+		Material.Name = Model.MaterialNames[i];
+
+		auto Found = MaterialMap.find(Material.Name);
+		if (Found == MaterialMap.end())
+		{
+			continue;
+		}
+
+		const tinyobj::material_t & Source = Libraries[Found->second];
+		Material.BaseColor = glm::vec4(Source.diffuse[0], Source.diffuse[1], Source.diffuse[2], 1.0f);
+
+		/** The PBR extension maps first, then the slots Assimp uses for OBJ */
+		Material.Textures[SCENE_TEXTURE_ALBEDO] = GetTexturePath({ &Source.diffuse_texname });
+		Material.Textures[SCENE_TEXTURE_NORMAL] = GetTexturePath({ &Source.normal_texname, &Source.bump_texname });
+		Material.Textures[SCENE_TEXTURE_METALLIC] = GetTexturePath({ &Source.metallic_texname, &Source.specular_texname });
+		Material.Textures[SCENE_TEXTURE_ROUGHNESS] = GetTexturePath({ &Source.roughness_texname, &Source.specular_highlight_texname });
+		Material.Textures[SCENE_TEXTURE_AO] = GetTexturePath({ &Source.ambient_texname });
+	}
+}
+
+NAMESPACE_END
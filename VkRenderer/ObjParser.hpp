@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Namespace.hpp"
+#include "Scene.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+class ThreadPool;
+
+/** Attribute indices of one triangle corner, UINT32_MAX if the face does not reference that attribute. */
+struct ObjCorner
+{
+	uint32_t Position;
+	uint32_t TexCoord;
+	uint32_t Normal;
+};
+
+/** Consecutive triangles using the same material. */
+struct ObjMaterialRun
+{
+	/** Into ObjModel::MaterialNames */
+	uint32_t Material;
+	size_t FirstCorner;
+	size_t CornerCount;
+};
+
+/** The geometry of an OBJ file with every face fan triangulated, attribute arrays are tightly packed floats. */
+struct ObjModel
+{
+	std::vector<float> Positions;
+	std::vector<float> TexCoords;
+	std::vector<float> Normals;
+	/** Three per triangle */
+	std::vector<ObjCorner> Corners;
+	std::vector<ObjMaterialRun> MaterialRuns;
+	/** In order of first use, faces before the first usemtl use an empty name */
+	std::vector<std::string> MaterialNames;
+	/** As written after mtllib, relative to the OBJ file */
+	std::vector<std::string> MaterialLibraries;
+};
+
+struct ObjParseStatistics
+{
+	size_t Bytes = 0;
+	uint32_t Chunks = 0;
+	double Milliseconds = 0.0;
+
+	double GetMegabytesPerSecond() const;
+};
+
+/**
+* Maps the file and parses line aligned chunks of it in parallel on Pool (inline without one), then
+* merges them in file order, so the result does not depend on the thread count. Vertex, texture
+* coordinate, normal, face, usemtl and mtllib statements are read, everything else is skipped.
+* Throws if the file can not be read or a face references an attribute that does not exist.
+*/
+void ParseObj(
+	const std::string & Filename,
+	ThreadPool * pPool,
+	ObjModel & Model,
+	ObjParseStatistics * pStatistics = nullptr
+);
+
+/**
+* Builds a material for every name in Model.MaterialNames from the material libraries, which are read
+* with tinyobjloader and resolved against BaseDirectory. Texture slots are filled as ImportSceneMaterials
+* fills them for an OBJ file, unknown names keep the default material.
+*/
+void LoadObjMaterials(
+	const ObjModel & Model,
+	const std::string & BaseDirectory,
+	std::vector<SceneMaterial> & Materials
+);
+
+NAMESPACE_END
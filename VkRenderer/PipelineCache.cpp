@@ -0,0 +1,201 @@
+#include "PipelineCache.hpp"
+#include "MappedFile.hpp"
+#include "Hash.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+const uint32_t s_PipelineCacheMagic = MakeFourCC('V', 'K', 'P', 'C');
+
+/** Guards against truncated or corrupted files, drivers do not always validate the blob */
+struct PipelineCachePrefix
+{
+	uint32_t Magic;
+	uint32_t Reserved;
+	uint64_t DataSize;
+	uint64_t DataHash;
+};
+
+}
+
+void PipelineCache::Init(
+	VkPhysicalDevice PhysicalDevice,
+	VkDevice Device,
+	const std::string & Filename,
+	std::ostream & Log
+)
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	m_PhysicalDevice = PhysicalDevice;
+	m_Device = Device;
+	m_Filename = Filename;
+	m_bWarm = false;
+
+	const uint8_t * pInitialData = nullptr;
+	size_t InitialDataSize = 0;
+
+	MappedFile File;
+	if (File.Open(m_Filename) && File.GetSize() >= sizeof(PipelineCachePrefix))
+	{
+		PipelineCachePrefix Prefix;
+		memcpy(&Prefix, File.GetData(), sizeof(Prefix));
+
+		const uint8_t * pData = File.GetData() + sizeof(PipelineCachePrefix);
+
+		if (Prefix.Magic != s_PipelineCacheMagic ||
+			Prefix.DataSize != File.GetSize() - sizeof(PipelineCachePrefix) ||
+			HashBytes(pData, static_cast<size_t>(Prefix.DataSize)) != Prefix.DataHash)
+		{
+			Log << "Pipeline cache " << m_Filename << " is corrupted, starting empty" << std::endl;
+		}
+		else if (ValidateDriverHeader(pData, static_cast<size_t>(Prefix.DataSize), Log))
+		{
+			pInitialData = pData;
+			InitialDataSize = static_cast<size_t>(Prefix.DataSize);
+		}
+	}
+
+	VkPipelineCacheCreateInfo CreateInfo = {};
+	CreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	CreateInfo.initialDataSize = InitialDataSize;
+	CreateInfo.pInitialData = pInitialData;
+
+	VkResult Result = vkCreatePipelineCache(m_Device, &CreateInfo, nullptr, &m_Cache);
+
+	if (Result != VK_SUCCESS && pInitialData != nullptr)
+	{
+		/** The driver may still reject data that passed our checks */
+		Log << "Pipeline cache " << m_Filename << " was rejected by the driver, starting empty" << std::endl;
+
+		CreateInfo.initialDataSize = 0;
+		CreateInfo.pInitialData = nullptr;
+		pInitialData = nullptr;
+		Result = vkCreatePipelineCache(m_Device, &CreateInfo, nullptr, &m_Cache);
+	}
+
+	if (Result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create pipeline cache!");
+	}
+
+	m_bWarm = pInitialData != nullptr;
+
+	Log << "Pipeline cache " << (m_bWarm ? "loaded " : "created empty ") << m_Filename
+		<< " (" << InitialDataSize << " bytes) in "
+		<< std::chrono::duration<double, std::chrono::milliseconds::period>(
+			std::chrono::high_resolution_clock::now() - StartTime
+			).count() << " ms" << std::endl;
+}
+
+void PipelineCache::Destroy()
+{
+	vkDestroyPipelineCache(m_Device, m_Cache, nullptr);
+	m_Cache = VK_NULL_HANDLE;
+}
+
+bool PipelineCache::Save(
+	std::ostream & Log
+) const
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	size_t DataSize = 0;
+	if (vkGetPipelineCacheData(m_Device, m_Cache, &DataSize, nullptr) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> Buffer(sizeof(PipelineCachePrefix) + DataSize);
+	uint8_t * pData = Buffer.data() + sizeof(PipelineCachePrefix);
+
+	/** VK_INCOMPLETE would mean the cache grew in between, keep whatever was written */
+	if (vkGetPipelineCacheData(m_Device, m_Cache, &DataSize, pData) < 0)
+	{
+		return false;
+	}
+
+	Buffer.resize(sizeof(PipelineCachePrefix) + DataSize);
+	pData = Buffer.data() + sizeof(PipelineCachePrefix);
+
+	PipelineCachePrefix Prefix = {};
+	Prefix.Magic = s_PipelineCacheMagic;
+	Prefix.DataSize = DataSize;
+	Prefix.DataHash = HashBytes(pData, DataSize);
+	memcpy(Buffer.data(), &Prefix, sizeof(Prefix));
+
+	bool bSuccess = WriteFileAtomically(m_Filename, Buffer.data(), Buffer.size());
+
+	Log << (bSuccess ? "Pipeline cache saved to " : "Failed to save pipeline cache to ") << m_Filename
+		<< " (" << DataSize << " bytes) in "
+		<< std::chrono::duration<double, std::chrono::milliseconds::period>(
+			std::chrono::high_resolution_clock::now() - StartTime
+			).count() << " ms" << std::endl;
+
+	return bSuccess;
+}
+
+VkPipelineCache PipelineCache::GetHandle() const
+{
+	return m_Cache;
+}
+
+bool PipelineCache::IsWarm() const
+{
+	return m_bWarm;
+}
+
+bool PipelineCache::ValidateDriverHeader(
+	const uint8_t * pData,
+	size_t Size,
+	std::ostream & Log
+) const
+{
+	/** VkPipelineCacheHeaderVersionOne, read field by field since the blob is not aligned for us */
+	uint32_t HeaderSize = 0, HeaderVersion = 0, VendorID = 0, DeviceID = 0;
+	uint8_t CacheUUID[VK_UUID_SIZE] = {};
+
+	if (Size < 16 + VK_UUID_SIZE)
+	{
+		Log << "Pipeline cache " << m_Filename << " is too small, starting empty" << std::endl;
+		return false;
+	}
+
+	memcpy(&HeaderSize, pData + 0, sizeof(uint32_t));
+	memcpy(&HeaderVersion, pData + 4, sizeof(uint32_t));
+	memcpy(&VendorID, pData + 8, sizeof(uint32_t));
+	memcpy(&DeviceID, pData + 12, sizeof(uint32_t));
+	memcpy(CacheUUID, pData + 16, VK_UUID_SIZE);
+
+	VkPhysicalDeviceProperties Properties;
+	vkGetPhysicalDeviceProperties(m_PhysicalDevice, &Properties);
+
+	if (HeaderSize < 16 + VK_UUID_SIZE || HeaderSize > Size || HeaderVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+	{
+		Log << "Pipeline cache " << m_Filename << " has an unknown header, starting empty" << std::endl;
+		return false;
+	}
+
+	if (VendorID != Properties.vendorID || DeviceID != Properties.deviceID)
+	{
+		Log << "Pipeline cache " << m_Filename << " was created on another device, starting empty" << std::endl;
+		return false;
+	}
+
+	if (memcmp(CacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+	{
+		Log << "Pipeline cache " << m_Filename << " was created by another driver version, starting empty" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+NAMESPACE_END
@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/**
+* A VkPipelineCache persisted to disk. The blob is only handed to the driver if our own
+* size/checksum prefix and the driver header (vendor, device, cache UUID) both match the
+* current device, otherwise the cache starts empty and is rewritten on Save().
+*/
+class PipelineCache
+{
+public:
+	void Init(
+		VkPhysicalDevice PhysicalDevice,
+		VkDevice Device,
+		const std::string & Filename,
+		std::ostream & Log
+	);
+
+	void Destroy();
+
+	/** Writes the current contents, replacing the file atomically. */
+	bool Save(
+		std::ostream & Log
+	) const;
+
+	VkPipelineCache GetHandle() const;
+
+	/** True if valid data was loaded from disk. */
+	bool IsWarm() const;
+
+protected:
+	bool ValidateDriverHeader(
+		const uint8_t * pData,
+		size_t Size,
+		std::ostream & Log
+	) const;
+
+protected:
+	VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
+	VkDevice m_Device = VK_NULL_HANDLE;
+	VkPipelineCache m_Cache = VK_NULL_HANDLE;
+	std::string m_Filename;
+	bool m_bWarm = false;
+};
+
+NAMESPACE_END
@@ -0,0 +1,245 @@
+#include "Scene.hpp"
+
+#include <assimp/scene.h>
+#include <assimp/pbrmaterial.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+glm::mat4 ToGlm(
+	const aiMatrix4x4 & Matrix
+)
+{
+	/** Assimp matrices are row major, glm ones column major */
+	glm::mat4 Result;
+	for (int Row = 0; Row < 4; Row++)
+	{
+		for (int Column = 0; Column < 4; Column++)
+		{
+			Result[Column][Row] = Matrix[Row][Column];
+		}
+	}
+	return Result;
+}
+
+std::string GetTexturePath(
+	const aiMaterial * pMaterial,
+	const std::string & BaseDirectory,
+	std::initializer_list<aiTextureType> Types
+)
+{
+	for (aiTextureType Type : Types)
+	{
+		aiString Path;
+		if (pMaterial->GetTexture(Type, 0, &Path) != AI_SUCCESS || Path.length == 0)
+		{
+			continue;
+		}
+
+		/** Embedded textures are referenced as "*Index", those are not supported */
+		if (Path.data[0] == '*')
+		{
+			continue;
+		}
+
+		std::string Filename(Path.C_Str());
+		std::replace(Filename.begin(), Filename.end(), '\\', '/');
+		return (std::filesystem::path(BaseDirectory) / Filename).generic_string();
+	}
+
+	return std::string();
+}
+
+void WriteString(
+	const std::string & String,
+	std::vector<uint8_t> & Data
+)
+{
+	uint32_t Length = static_cast<uint32_t>(String.size());
+	const uint8_t * pLength = reinterpret_cast<const uint8_t *>(&Length);
+	Data.insert(Data.end(), pLength, pLength + sizeof(Length));
+	Data.insert(Data.end(), String.begin(), String.end());
+}
+
+template <typename TValue>
+void WriteValue(
+	const TValue & Value,
+	std::vector<uint8_t> & Data
+)
+{
+	const uint8_t * pValue = reinterpret_cast<const uint8_t *>(&Value);
+	Data.insert(Data.end(), pValue, pValue + sizeof(TValue));
+}
+
+/** Bounds checked cursor over a chunk, every read fails once the data runs out */
+struct ByteReader
+{
+	const uint8_t * pData;
+	size_t Size;
+	size_t Offset = 0;
+
+	template <typename TValue>
+	bool Read(TValue & Value)
+	{
+		if (Size - Offset < sizeof(TValue))
+		{
+			return false;
+		}
+		std::memcpy(&Value, pData + Offset, sizeof(TValue));
+		Offset += sizeof(TValue);
+		return true;
+	}
+
+	bool ReadString(std::string & String)
+	{
+		uint32_t Length = 0;
+		if (!Read(Length) || Size - Offset < Length)
+		{
+			return false;
+		}
+		String.assign(reinterpret_cast<const char *>(pData + Offset), Length);
+		Offset += Length;
+		return true;
+	}
+};
+
+}
+
+void FlattenSceneNodes(
+	const aiScene * pScene,
+	std::vector<SceneInstance> & Instances
+)
+{
+	Instances.clear();
+
+	/** Iterative so deep hierarchies can not overflow the stack */
+	std::vector<std::pair<const aiNode *, glm::mat4>> Stack;
+	Stack.emplace_back(pScene->mRootNode, glm::mat4(1.0f));
+
+	while (!Stack.empty())
+	{
+		const aiNode * pNode = Stack.back().first;
+		glm::mat4 World = Stack.back().second * ToGlm(pNode->mTransformation);
+		Stack.pop_back();
+
+		for (uint32_t i = 0; i < pNode->mNumMeshes; i++)
+		{
+			SceneInstance Instance;
+			Instance.World = World;
+			Instance.MeshIndex = pNode->mMeshes[i];
+			Instances.push_back(Instance);
+		}
+
+		for (uint32_t i = 0; i < pNode->mNumChildren; i++)
+		{
+			Stack.emplace_back(pNode->mChildren[i], World);
+		}
+	}
+}
+
+void ImportSceneMaterials(
+	const aiScene * pScene,
+	const std::string & BaseDirectory,
+	std::vector<SceneMaterial> & Materials
+)
+{
+	Materials.resize(pScene->mNumMaterials);
+
+	for (uint32_t i = 0; i < pScene->mNumMaterials; i++)
+	{
+		const aiMaterial * pSource = pScene->mMaterials[i];
+		SceneMaterial & Material = Materials[i];
+
+		aiString Name;
+		if (pSource->Get(AI_MATKEY_NAME, Name) == AI_SUCCESS)
+		{
+			Material.Name = Name.C_Str();
+		}
+
+		aiColor4D Color;
+		if (pSource->Get(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_BASE_COLOR_FACTOR, Color) == AI_SUCCESS ||
+			pSource->Get(AI_MATKEY_COLOR_DIFFUSE, Color) == AI_SUCCESS)
+		{
+			Material.BaseColor = glm::vec4(Color.r, Color.g, Color.b, Color.a);
+		}
+
+		pSource->Get(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLIC_FACTOR, Material.Metallic);
+		pSource->Get(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_ROUGHNESS_FACTOR, Material.Roughness);
+
+		Material.Textures[SCENE_TEXTURE_ALBEDO] = GetTexturePath(pSource, BaseDirectory, { aiTextureType_DIFFUSE });
+		Material.Textures[SCENE_TEXTURE_NORMAL] = GetTexturePath(pSource, BaseDirectory, { aiTextureType_NORMALS, aiTextureType_HEIGHT });
+		Material.Textures[SCENE_TEXTURE_METALLIC] = GetTexturePath(pSource, BaseDirectory, { aiTextureType_SPECULAR });
+		Material.Textures[SCENE_TEXTURE_ROUGHNESS] = GetTexturePath(pSource, BaseDirectory, { aiTextureType_SHININESS });
+		Material.Textures[SCENE_TEXTURE_AO] = GetTexturePath(pSource, BaseDirectory, { aiTextureType_LIGHTMAP, aiTextureType_AMBIENT });
+	}
+}
+
+void WriteSceneMaterials(
+	const std::vector<SceneMaterial> & Materials,
+	std::vector<uint8_t> & Data
+)
+{
+	Data.clear();
+	WriteValue(static_cast<uint32_t>(Materials.size()), Data);
+
+	for (const SceneMaterial & Material : Materials)
+	{
+		WriteString(Material.Name, Data);
+		WriteValue(Material.BaseColor, Data);
+		WriteValue(Material.Metallic, Data);
+		WriteValue(Material.Roughness, Data);
+
+		for (const std::string & Texture : Material.Textures)
+		{
+			WriteString(Texture, Data);
+		}
+	}
+}
+
+bool ReadSceneMaterials(
+	const void * pData,
+	size_t Size,
+	std::vector<SceneMaterial> & Materials
+)
+{
+	ByteReader Reader = { static_cast<const uint8_t *>(pData), pData == nullptr ? 0 : Size };
+
+	uint32_t Count = 0;
+	if (!Reader.Read(Count) || Count > Size)
+	{
+		return false;
+	}
+
+	Materials.clear();
+	Materials.resize(Count);
+
+	for (SceneMaterial & Material : Materials)
+	{
+		if (!Reader.ReadString(Material.Name) ||
+			!Reader.Read(Material.BaseColor) ||
+			!Reader.Read(Material.Metallic) ||
+			!Reader.Read(Material.Roughness))
+		{
+			return false;
+		}
+
+		for (std::string & Texture : Material.Textures)
+		{
+			if (!Reader.ReadString(Texture))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+NAMESPACE_END
@@ -0,0 +1,96 @@
+#pragma once
+
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Namespace.hpp"
+
+struct aiScene;
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** Texture slots of a material. Metallic, roughness and AO are packed into one ORM texture before the shader sees them. */
+enum SceneTextureSlot
+{
+	SCENE_TEXTURE_ALBEDO = 0,
+	SCENE_TEXTURE_NORMAL = 1,
+	SCENE_TEXTURE_METALLIC = 2,
+	SCENE_TEXTURE_ROUGHNESS = 3,
+	SCENE_TEXTURE_AO = 4,
+	SCENE_TEXTURE_COUNT = 5
+};
+
+struct SceneMaterial
+{
+	std::string Name;
+	glm::vec4 BaseColor = glm::vec4(1.0f);
+	float Metallic = 1.0f;
+	float Roughness = 1.0f;
+	/** Paths relative to the working directory, empty if the material has no such texture */
+	std::array<std::string, SCENE_TEXTURE_COUNT> Textures;
+};
+
+/** Most levels of detail a mesh can have, level 0 is the source mesh. */
+const uint32_t SCENE_MAX_LOD_COUNT = 6;
+
+/**
+* One source mesh inside the shared vertex and index buffers. Every level of detail has SubMeshCount
+* sub-meshes over the same vertex ranges, level L starts at FirstSubMesh + L * SubMeshCount.
+*/
+struct SceneMesh
+{
+	uint32_t FirstSubMesh = 0;
+	uint32_t SubMeshCount = 0;
+	uint32_t MaterialIndex = 0;
+	uint32_t LodCount = 1;
+	/** Object space distance between each level and the source mesh, never decreasing */
+	float LodErrors[SCENE_MAX_LOD_COUNT] = {};
+	/** Object space bounding sphere */
+	glm::vec3 BoundsCenter = glm::vec3(0.0f);
+	float BoundsRadius = 0.0f;
+};
+
+struct SceneInstance
+{
+	glm::mat4 World = glm::mat4(1.0f);
+	uint32_t MeshIndex = 0;
+};
+
+/** Walks the node graph and emits an instance for every mesh reference, with the accumulated transform. */
+void FlattenSceneNodes(
+	const aiScene * pScene,
+	std::vector<SceneInstance> & Instances
+);
+
+/**
+* Builds the material table, texture paths are resolved against BaseDirectory. Formats without
+* PBR maps fill the closest slots: specular for metallic, shininess for roughness, bump for normal.
+*/
+void ImportSceneMaterials(
+	const aiScene * pScene,
+	const std::string & BaseDirectory,
+	std::vector<SceneMaterial> & Materials
+);
+
+/** Flat binary form of the material table, used as a mesh cache chunk. */
+void WriteSceneMaterials(
+	const std::vector<SceneMaterial> & Materials,
+	std::vector<uint8_t> & Data
+);
+
+/** Returns false if the data is truncated. */
+bool ReadSceneMaterials(
+	const void * pData,
+	size_t Size,
+	std::vector<SceneMaterial> & Materials
+);
+
+NAMESPACE_END
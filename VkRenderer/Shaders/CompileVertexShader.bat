@@ -1 +1,2 @@
-%VULKAN_SDK%/Bin/glslangValidator -V Shader.vert -o Shader.vert.spv
\ No newline at end of file
+%VULKAN_SDK%/Bin/glslangValidator -V Shader.vert -o Shader.vert.spv
+%VULKAN_SDK%/Bin/glslangValidator -V Depth.vert -o Depth.vert.spv
\ No newline at end of file
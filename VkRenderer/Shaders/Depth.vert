@@ -0,0 +1,38 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Position only variant of Shader.vert for depth only passes, binds nothing but the position stream
+
+layout(binding = 0) uniform MvpUniformBufferObject
+{
+    mat4 View;
+    mat4 Projection;
+} Transformation;
+
+// Must match InstancePushConstants in App.hpp
+layout(push_constant) uniform InstancePushConstants
+{
+    mat4 Model;
+    // Dequantization of the mesh of the instance, see VertexDequantization in VertexFormat.hpp
+    vec4 PositionScale;
+    vec4 PositionOffset;
+    vec4 TexCoordScaleOffset;
+} Instance;
+
+// Must match VertexPositionFormat in VertexFormat.hpp
+layout(constant_id = 0) const int POSITION_FORMAT = 0;
+
+const int POSITION_UNORM16 = 1;
+
+layout(location = 0) in vec4 PackedPosition;
+
+invariant gl_Position;
+
+void main()
+{
+    vec3 Position = POSITION_FORMAT == POSITION_UNORM16 ?
+        Instance.PositionOffset.xyz + Instance.PositionScale.xyz * PackedPosition.xyz :
+        PackedPosition.xyz;
+
+    gl_Position = Transformation.Projection * Transformation.View * Instance.Model * vec4(Position, 1.0);
+}
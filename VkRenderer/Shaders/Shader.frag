@@ -21,9 +21,8 @@ layout(binding = 2) uniform MaterialUniformBufferObject
 
 layout(binding = 3) uniform sampler2D AlbedoSampler;
 layout(binding = 4) uniform sampler2D NormalSampler;
-layout(binding = 5) uniform sampler2D MetallicSampler;
-layout(binding = 6) uniform sampler2D RoughnessSampler;
-layout(binding = 7) uniform sampler2D AoSampler;
+// Occlusion, roughness and metallic in r, g and b
+layout(binding = 5) uniform sampler2D OrmSampler;
 
 layout(location = 0) in vec4 FragPositionH;
 layout(location = 1) in vec3 FragColor;
@@ -76,7 +75,10 @@ vec3 FresnelSchlick(float NDotV, vec3 F0)
 
 vec3 TangentSpaceToWorldSpace(vec3 NormalMapSample, vec3 NormalW, vec3 TangentW)
 {
-    vec3 NormalRemapped = NormalMapSample * 2.0 - 1.0;
+    // Only x and y are read, BC5 normal maps do not store z
+    vec3 NormalRemapped;
+    NormalRemapped.xy = NormalMapSample.xy * 2.0 - 1.0;
+    NormalRemapped.z = sqrt(max(1.0 - dot(NormalRemapped.xy, NormalRemapped.xy), 0.0));
 
     vec3 N = NormalW;
     vec3 T = normalize(TangentW - dot(TangentW, N) * N);
@@ -97,9 +99,10 @@ void main()
         FragNormalW,
         FragTangentW
     );
-    float Metallic = Material.Metallic * texture(MetallicSampler, FragTexCoord).x;
-    float Roughness = Material.Roughness * texture(RoughnessSampler, FragTexCoord).x;
-    float Ao = Material.Ao * texture(AoSampler, FragTexCoord).x;
+    vec3 Orm = texture(OrmSampler, FragTexCoord).xyz;
+    float Metallic = Material.Metallic * Orm.z;
+    float Roughness = Material.Roughness * Orm.y;
+    float Ao = Material.Ao * Orm.x;
 
     vec3 N = normalize(Normal);
     vec3 V = normalize(Lighting.ViewPosition.xyz - FragPositionW);
@@ -3,17 +3,36 @@
 
 layout(binding = 0) uniform MvpUniformBufferObject
 {
-    mat4 Model;
-    mat4 ModelInvTranspose;
     mat4 View;
     mat4 Projection;
 } Transformation;
 
-layout(location = 0) in vec3 Position;
-layout(location = 1) in vec3 Color;
-layout(location = 2) in vec3 Normal;
-layout(location = 3) in vec3 Tangent;
-layout(location = 4) in vec2 TexCoord;
+// Must match InstancePushConstants in App.hpp
+layout(push_constant) uniform InstancePushConstants
+{
+    mat4 Model;
+    // Dequantization of the mesh of the instance, see VertexDequantization in VertexFormat.hpp
+    vec4 PositionScale;
+    vec4 PositionOffset;
+    vec4 TexCoordScaleOffset;
+} Instance;
+
+// Must match VertexPositionFormat, VertexDirectionFormat and VertexTexCoordFormat in VertexFormat.hpp
+layout(constant_id = 0) const int POSITION_FORMAT = 0;
+layout(constant_id = 1) const int DIRECTION_FORMAT = 0;
+layout(constant_id = 2) const int TEXCOORD_FORMAT = 0;
+
+const int POSITION_UNORM16 = 1;
+const int DIRECTION_OCT_SNORM16 = 1;
+const int DIRECTION_UNORM10 = 2;
+const int TEXCOORD_UNORM16 = 2;
+
+// Declared as vec4 so that every packed format can feed them, missing components read as (0, 0, 1)
+layout(location = 0) in vec4 PackedPosition;
+layout(location = 1) in vec4 Color;
+layout(location = 2) in vec4 PackedNormal;
+layout(location = 3) in vec4 PackedTangent;
+layout(location = 4) in vec2 PackedTexCoord;
 
 layout(location = 0) out vec4 FragPositionH;
 layout(location = 1) out vec3 FragColor;
@@ -22,14 +41,51 @@ layout(location = 3) out vec3 FragPositionW;
 layout(location = 4) out vec3 FragNormalW;
 layout(location = 5) out vec3 FragTangentW;
 
+// Depth.vert computes the same expression, so the color pass passes LESS_OR_EQUAL against the prepass depth
+invariant gl_Position;
+
+vec3 DecodeDirection(vec4 Packed)
+{
+    if (DIRECTION_FORMAT == DIRECTION_OCT_SNORM16)
+    {
+        vec3 Direction = vec3(Packed.xy, 1.0 - abs(Packed.x) - abs(Packed.y));
+        float Fold = max(-Direction.z, 0.0);
+        Direction.x += Direction.x >= 0.0 ? -Fold : Fold;
+        Direction.y += Direction.y >= 0.0 ? -Fold : Fold;
+        return normalize(Direction);
+    }
+    else if (DIRECTION_FORMAT == DIRECTION_UNORM10)
+    {
+        return normalize(Packed.xyz * 2.0 - 1.0);
+    }
+    return Packed.xyz;
+}
+
 void main()
 {
-    FragPositionH = Transformation.Projection * Transformation.View * Transformation.Model * vec4(Position, 1.0);
-    FragColor = Color;
+    vec3 Position = POSITION_FORMAT == POSITION_UNORM16 ?
+        Instance.PositionOffset.xyz + Instance.PositionScale.xyz * PackedPosition.xyz :
+        PackedPosition.xyz;
+    vec3 Normal = DecodeDirection(PackedNormal);
+    vec3 Tangent = DecodeDirection(PackedTangent);
+    vec2 TexCoord = TEXCOORD_FORMAT == TEXCOORD_UNORM16 ?
+        Instance.TexCoordScaleOffset.zw + Instance.TexCoordScaleOffset.xy * PackedTexCoord :
+        PackedTexCoord;
+
+    FragPositionH = Transformation.Projection * Transformation.View * Instance.Model * vec4(Position, 1.0);
+    FragColor = Color.rgb;
     FragTexCoord = TexCoord;
-    FragPositionW = (Transformation.Model * vec4(Position, 1.0)).xyz;
-    FragNormalW = (Transformation.ModelInvTranspose * vec4(Normal, 1.0)).xyz;
-    FragTangentW = (Transformation.Model * vec4(Tangent, 1.0)).xyz;
+    FragPositionW = (Instance.Model * vec4(Position, 1.0)).xyz;
+    // The cofactor matrix is the inverse transpose of the upper 3x3 of Model times its determinant,
+    // normalizing drops the determinant and the sign flip keeps mirrored instances facing outwards
+    vec3 Axis0 = Instance.Model[0].xyz;
+    vec3 Axis1 = Instance.Model[1].xyz;
+    vec3 Axis2 = Instance.Model[2].xyz;
+    mat3 Cofactor = mat3(cross(Axis1, Axis2), cross(Axis2, Axis0), cross(Axis0, Axis1));
+    float Handedness = dot(Axis0, Cofactor[0]) < 0.0 ? -1.0 : 1.0;
+
+    FragNormalW = normalize(Cofactor * Normal) * Handedness;
+    FragTangentW = mat3(Axis0, Axis1, Axis2) * Tangent;
     gl_Position = FragPositionH;
 }
 
@@ -0,0 +1,49 @@
+#include "Simd.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+bool DetectAvx2()
+{
+#if defined(SIMD_AVX2) && defined(_MSC_VER)
+	int Registers[4];
+
+	__cpuid(Registers, 0);
+	if (Registers[0] < 7)
+	{
+		return false;
+	}
+
+	/** The OS has to save the YMM registers on context switches, XCR0 bits 1 and 2 */
+	__cpuid(Registers, 1);
+	const int OsXsave = 1 << 27;
+	if ((Registers[2] & OsXsave) == 0 || (_xgetbv(0) & 0x6) != 0x6)
+	{
+		return false;
+	}
+
+	__cpuidex(Registers, 7, 0);
+	const int Avx2 = 1 << 5;
+	return (Registers[1] & Avx2) != 0;
+#elif defined(SIMD_AVX2)
+	return __builtin_cpu_supports("avx2") != 0;
+#else
+	return false;
+#endif
+}
+
+}
+
+bool IsAvx2Supported()
+{
+	static const bool bSupported = DetectAvx2();
+	return bSupported;
+}
+
+NAMESPACE_END
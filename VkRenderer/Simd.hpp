@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+/** SSE2 is part of x64, every x64 build has it. */
+#if defined(_M_X64) || defined(__SSE2__)
+#define SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/** MSVC emits AVX2 intrinsics in any translation unit, other compilers only when targeting AVX2. */
+#if (defined(_MSC_VER) && defined(_M_X64)) || defined(__AVX2__)
+#define SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** True if both the CPU and the OS support AVX2. AVX2 code paths must only run if this is true. */
+bool IsAvx2Supported();
+
+/**
+* Float vectors of 1, 4 and 8 lanes with the same interface, so a kernel written once as a template
+* runs scalar, on SSE2 and on AVX2. Only exactly rounded operations are exposed (no FMA, no reciprocal
+* estimates), every lane of every width computes bit identical results to the scalar path.
+*/
+struct FloatX1
+{
+	static const int Width = 1;
+	typedef bool Mask;
+
+	float V;
+
+	static FloatX1 Set(float Value) { return { Value }; }
+	static FloatX1 Load(const float * pData) { return { *pData }; }
+	static FloatX1 Gather(const float * pBase, const uint32_t * pIndices) { return { pBase[pIndices[0]] }; }
+	void Store(float * pData) const { *pData = V; }
+};
+
+inline FloatX1 operator+(FloatX1 A, FloatX1 B) { return { A.V + B.V }; }
+inline FloatX1 operator-(FloatX1 A, FloatX1 B) { return { A.V - B.V }; }
+inline FloatX1 operator*(FloatX1 A, FloatX1 B) { return { A.V * B.V }; }
+inline FloatX1 operator/(FloatX1 A, FloatX1 B) { return { A.V / B.V }; }
+inline FloatX1 Sqrt(FloatX1 A) { return { std::sqrt(A.V) }; }
+/** Same as minps and maxps, which return the second operand if either is NaN */
+inline FloatX1 Min(FloatX1 A, FloatX1 B) { return { A.V < B.V ? A.V : B.V }; }
+inline FloatX1 Max(FloatX1 A, FloatX1 B) { return { A.V > B.V ? A.V : B.V }; }
+inline FloatX1 Abs(FloatX1 A) { return { std::fabs(A.V) }; }
+inline bool Less(FloatX1 A, FloatX1 B) { return A.V < B.V; }
+inline bool Greater(FloatX1 A, FloatX1 B) { return A.V > B.V; }
+inline FloatX1 Select(bool Condition, FloatX1 IfTrue, FloatX1 IfFalse) { return Condition ? IfTrue : IfFalse; }
+
+#ifdef SIMD_SSE2
+struct FloatX4
+{
+	static const int Width = 4;
+	typedef FloatX4 Mask;
+
+	__m128 V;
+
+	static FloatX4 Set(float Value) { return { _mm_set1_ps(Value) }; }
+	static FloatX4 Load(const float * pData) { return { _mm_loadu_ps(pData) }; }
+	static FloatX4 Gather(const float * pBase, const uint32_t * pIndices)
+	{
+		return { _mm_setr_ps(pBase[pIndices[0]], pBase[pIndices[1]], pBase[pIndices[2]], pBase[pIndices[3]]) };
+	}
+	void Store(float * pData) const { _mm_storeu_ps(pData, V); }
+};
+
+inline FloatX4 operator+(FloatX4 A, FloatX4 B) { return { _mm_add_ps(A.V, B.V) }; }
+inline FloatX4 operator-(FloatX4 A, FloatX4 B) { return { _mm_sub_ps(A.V, B.V) }; }
+inline FloatX4 operator*(FloatX4 A, FloatX4 B) { return { _mm_mul_ps(A.V, B.V) }; }
+inline FloatX4 operator/(FloatX4 A, FloatX4 B) { return { _mm_div_ps(A.V, B.V) }; }
+inline FloatX4 Sqrt(FloatX4 A) { return { _mm_sqrt_ps(A.V) }; }
+inline FloatX4 Min(FloatX4 A, FloatX4 B) { return { _mm_min_ps(A.V, B.V) }; }
+inline FloatX4 Max(FloatX4 A, FloatX4 B) { return { _mm_max_ps(A.V, B.V) }; }
+inline FloatX4 Abs(FloatX4 A) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), A.V) }; }
+inline FloatX4 Less(FloatX4 A, FloatX4 B) { return { _mm_cmplt_ps(A.V, B.V) }; }
+inline FloatX4 Greater(FloatX4 A, FloatX4 B) { return { _mm_cmpgt_ps(A.V, B.V) }; }
+inline FloatX4 Select(FloatX4 Condition, FloatX4 IfTrue, FloatX4 IfFalse)
+{
+	return { _mm_or_ps(_mm_and_ps(Condition.V, IfTrue.V), _mm_andnot_ps(Condition.V, IfFalse.V)) };
+}
+#endif
+
+#ifdef SIMD_AVX2
+struct FloatX8
+{
+	static const int Width = 8;
+	typedef FloatX8 Mask;
+
+	__m256 V;
+
+	static FloatX8 Set(float Value) { return { _mm256_set1_ps(Value) }; }
+	static FloatX8 Load(const float * pData) { return { _mm256_loadu_ps(pData) }; }
+	static FloatX8 Gather(const float * pBase, const uint32_t * pIndices)
+	{
+		__m256i Indices = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pIndices));
+		return { _mm256_i32gather_ps(pBase, Indices, 4) };
+	}
+	void Store(float * pData) const { _mm256_storeu_ps(pData, V); }
+};
+
+inline FloatX8 operator+(FloatX8 A, FloatX8 B) { return { _mm256_add_ps(A.V, B.V) }; }
+inline FloatX8 operator-(FloatX8 A, FloatX8 B) { return { _mm256_sub_ps(A.V, B.V) }; }
+inline FloatX8 operator*(FloatX8 A, FloatX8 B) { return { _mm256_mul_ps(A.V, B.V) }; }
+inline FloatX8 operator/(FloatX8 A, FloatX8 B) { return { _mm256_div_ps(A.V, B.V) }; }
+inline FloatX8 Sqrt(FloatX8 A) { return { _mm256_sqrt_ps(A.V) }; }
+inline FloatX8 Min(FloatX8 A, FloatX8 B) { return { _mm256_min_ps(A.V, B.V) }; }
+inline FloatX8 Max(FloatX8 A, FloatX8 B) { return { _mm256_max_ps(A.V, B.V) }; }
+inline FloatX8 Abs(FloatX8 A) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), A.V) }; }
+inline FloatX8 Less(FloatX8 A, FloatX8 B) { return { _mm256_cmp_ps(A.V, B.V, _CMP_LT_OQ) }; }
+inline FloatX8 Greater(FloatX8 A, FloatX8 B) { return { _mm256_cmp_ps(A.V, B.V, _CMP_GT_OQ) }; }
+inline FloatX8 Select(FloatX8 Condition, FloatX8 IfTrue, FloatX8 IfFalse) { return { _mm256_blendv_ps(IfFalse.V, IfTrue.V, Condition.V) }; }
+#endif
+
+NAMESPACE_END
@@ -0,0 +1,431 @@
+#include "TangentGenerator.hpp"
+#include "Hash.hpp"
+#include "Simd.hpp"
+
+#include <cmath>
+#include <cstring>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+template <typename TFloat>
+struct Vector3
+{
+	TFloat X, Y, Z;
+};
+
+template <typename TFloat>
+Vector3<TFloat> operator+(const Vector3<TFloat> & A, const Vector3<TFloat> & B) { return { A.X + B.X, A.Y + B.Y, A.Z + B.Z }; }
+
+template <typename TFloat>
+Vector3<TFloat> operator-(const Vector3<TFloat> & A, const Vector3<TFloat> & B) { return { A.X - B.X, A.Y - B.Y, A.Z - B.Z }; }
+
+template <typename TFloat>
+Vector3<TFloat> operator*(const Vector3<TFloat> & A, TFloat S) { return { A.X * S, A.Y * S, A.Z * S }; }
+
+template <typename TFloat>
+TFloat Dot(const Vector3<TFloat> & A, const Vector3<TFloat> & B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+
+/** Zero stays zero */
+template <typename TFloat>
+Vector3<TFloat> NormalizeSafe(const Vector3<TFloat> & A)
+{
+	TFloat Length = Sqrt(Dot(A, A));
+	auto bValid = Greater(Length, TFloat::Set(0.0f));
+	TFloat Zero = TFloat::Set(0.0f);
+	return { Select(bValid, A.X / Length, Zero), Select(bValid, A.Y / Length, Zero), Select(bValid, A.Z / Length, Zero) };
+}
+
+template <typename TFloat>
+Vector3<TFloat> ProjectOnPlane(const Vector3<TFloat> & A, const Vector3<TFloat> & Normal)
+{
+	return A - Normal * Dot(Normal, A);
+}
+
+/** Abramowitz and Stegun 4.4.45, within 7e-5 radians, plenty for a weight */
+template <typename TFloat>
+TFloat Acos(TFloat X)
+{
+	TFloat A = Abs(X);
+	TFloat Polynomial = ((TFloat::Set(-0.0187293f) * A + TFloat::Set(0.0742610f)) * A - TFloat::Set(0.2121144f)) * A + TFloat::Set(1.5707288f);
+	TFloat Result = Sqrt(TFloat::Set(1.0f) - A) * Polynomial;
+	return Select(Less(X, TFloat::Set(0.0f)), TFloat::Set(3.14159265f) - Result, Result);
+}
+
+template <typename TFloat>
+Vector3<TFloat> GatherVector(const std::vector<float> & X, const std::vector<float> & Y, const std::vector<float> & Z, const uint32_t * pIndices)
+{
+	return { TFloat::Gather(X.data(), pIndices), TFloat::Gather(Y.data(), pIndices), TFloat::Gather(Z.data(), pIndices) };
+}
+
+/** Weighted tangent contribution of every corner, Contribution[Corner][Triangle] */
+struct CornerStreams
+{
+	std::vector<float> ContributionX[3], ContributionY[3], ContributionZ[3];
+	std::vector<float> Weight[3];
+	/** -1 if the UV mapping of the triangle is mirrored */
+	std::vector<float> Sign;
+};
+
+/** Per triangle work, Width triangles at a time. LastTriangle - FirstTriangle must be a multiple of the width. */
+template <typename TFloat>
+void ComputeCornerTangents(
+	const std::vector<uint32_t> & Indices,
+	const TangentStaging & Staging,
+	size_t FirstTriangle,
+	size_t LastTriangle,
+	CornerStreams & Corners
+)
+{
+	const int Width = TFloat::Width;
+	const TFloat Zero = TFloat::Set(0.0f), One = TFloat::Set(1.0f);
+
+	for (size_t Triangle = FirstTriangle; Triangle < LastTriangle; Triangle += Width)
+	{
+		uint32_t CornerIndices[3][Width];
+		for (int Lane = 0; Lane < Width; Lane++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				CornerIndices[k][Lane] = Indices[(Triangle + Lane) * 3 + k];
+			}
+		}
+
+		Vector3<TFloat> Positions[3], Normals[3];
+		TFloat U[3], V[3];
+		for (int k = 0; k < 3; k++)
+		{
+			Positions[k] = GatherVector<TFloat>(Staging.PositionX, Staging.PositionY, Staging.PositionZ, CornerIndices[k]);
+			Normals[k] = GatherVector<TFloat>(Staging.NormalX, Staging.NormalY, Staging.NormalZ, CornerIndices[k]);
+			U[k] = TFloat::Gather(Staging.TexCoordU.data(), CornerIndices[k]);
+			V[k] = TFloat::Gather(Staging.TexCoordV.data(), CornerIndices[k]);
+		}
+
+		/** Direction of increasing U on the triangle, flipped for mirrored mappings so both halves agree */
+		Vector3<TFloat> Edge1 = Positions[1] - Positions[0];
+		Vector3<TFloat> Edge2 = Positions[2] - Positions[0];
+		TFloat DeltaU1 = U[1] - U[0], DeltaV1 = V[1] - V[0];
+		TFloat DeltaU2 = U[2] - U[0], DeltaV2 = V[2] - V[0];
+		TFloat SignedArea = DeltaU1 * DeltaV2 - DeltaU2 * DeltaV1;
+		TFloat Sign = Select(Less(SignedArea, Zero), TFloat::Set(-1.0f), One);
+		Vector3<TFloat> FaceTangent = (Edge1 * DeltaV2 - Edge2 * DeltaV1) * Sign;
+
+		Sign.Store(&Corners.Sign[Triangle]);
+
+		for (int k = 0; k < 3; k++)
+		{
+			const Vector3<TFloat> & Normal = Normals[k];
+			Vector3<TFloat> Tangent = NormalizeSafe(ProjectOnPlane(FaceTangent, Normal));
+
+			/** The corner angle is measured in the tangent plane, like MikkTSpace does */
+			Vector3<TFloat> EdgeA = NormalizeSafe(ProjectOnPlane(Positions[(k + 1) % 3] - Positions[k], Normal));
+			Vector3<TFloat> EdgeB = NormalizeSafe(ProjectOnPlane(Positions[(k + 2) % 3] - Positions[k], Normal));
+			TFloat Angle = Acos(Max(Min(Dot(EdgeA, EdgeB), One), TFloat::Set(-1.0f)));
+
+			(Tangent.X * Angle).Store(&Corners.ContributionX[k][Triangle]);
+			(Tangent.Y * Angle).Store(&Corners.ContributionY[k][Triangle]);
+			(Tangent.Z * Angle).Store(&Corners.ContributionZ[k][Triangle]);
+			Angle.Store(&Corners.Weight[k][Triangle]);
+		}
+	}
+}
+
+template <typename TFloat>
+void NormalizeTangents(
+	std::vector<float> & X,
+	std::vector<float> & Y,
+	std::vector<float> & Z,
+	size_t First,
+	size_t Last
+)
+{
+	for (size_t i = First; i < Last; i += TFloat::Width)
+	{
+		Vector3<TFloat> Tangent = NormalizeSafe<TFloat>({ TFloat::Load(&X[i]), TFloat::Load(&Y[i]), TFloat::Load(&Z[i]) });
+		Tangent.X.Store(&X[i]);
+		Tangent.Y.Store(&Y[i]);
+		Tangent.Z.Store(&Z[i]);
+	}
+}
+
+/**
+* Corners share a tangent if their vertices have bit identical position, normal and UV, the same
+* grouping MikkTSpace does. Groups[Vertex] is a dense group index, returns the group count.
+*/
+size_t GroupVertices(
+	const TangentStaging & Staging,
+	std::vector<uint32_t> & Groups
+)
+{
+	const size_t VertexCount = Staging.GetVertexCount();
+
+	/** Slots hold the group and the upper half of its hash, keys are only compared when the hashes match */
+	struct Slot
+	{
+		uint32_t Group;
+		uint32_t Hash;
+	};
+
+	std::vector<Slot> Table;
+	/** Position, normal and UV of every group, 8 floats each */
+	std::vector<float> GroupKeys;
+	std::vector<uint64_t> GroupHashes;
+
+	/** Un-indexed meshes have about one group per six vertices, so start small and grow at half load */
+	auto Rehash = [&](size_t TableSize)
+	{
+		Table.assign(TableSize, { UINT32_MAX, 0 });
+		for (uint32_t Group = 0; Group < GroupHashes.size(); Group++)
+		{
+			size_t Index = static_cast<size_t>(GroupHashes[Group]) & (TableSize - 1);
+			while (Table[Index].Group != UINT32_MAX)
+			{
+				Index = (Index + 1) & (TableSize - 1);
+			}
+			Table[Index] = { Group, static_cast<uint32_t>(GroupHashes[Group] >> 32) };
+		}
+	};
+
+	size_t TableSize = 64;
+	while (TableSize < VertexCount / 4)
+	{
+		TableSize *= 2;
+	}
+	Rehash(TableSize);
+
+	Groups.resize(VertexCount);
+
+	for (uint32_t Vertex = 0; Vertex < VertexCount; Vertex++)
+	{
+		const float Key[8] =
+		{
+			Staging.PositionX[Vertex], Staging.PositionY[Vertex], Staging.PositionZ[Vertex],
+			Staging.NormalX[Vertex], Staging.NormalY[Vertex], Staging.NormalZ[Vertex],
+			Staging.TexCoordU[Vertex], Staging.TexCoordV[Vertex]
+		};
+
+		uint64_t Hash = HashBytes(Key, sizeof(Key));
+		size_t Index = static_cast<size_t>(Hash) & (TableSize - 1);
+		uint32_t UpperHash = static_cast<uint32_t>(Hash >> 32);
+
+		while (true)
+		{
+			Slot & Entry = Table[Index];
+
+			if (Entry.Group == UINT32_MAX)
+			{
+				uint32_t Group = static_cast<uint32_t>(GroupHashes.size());
+				Entry = { Group, UpperHash };
+				GroupKeys.insert(GroupKeys.end(), Key, Key + 8);
+				GroupHashes.push_back(Hash);
+				Groups[Vertex] = Group;
+
+				if (GroupHashes.size() * 2 > TableSize)
+				{
+					TableSize *= 2;
+					Rehash(TableSize);
+				}
+				break;
+			}
+
+			if (Entry.Hash == UpperHash && std::memcmp(Key, &GroupKeys[Entry.Group * 8], sizeof(Key)) == 0)
+			{
+				Groups[Vertex] = Entry.Group;
+				break;
+			}
+
+			Index = (Index + 1) & (TableSize - 1);
+		}
+	}
+
+	return GroupHashes.size();
+}
+
+template <typename TFloat>
+void GenerateTangentsWith(
+	const std::vector<uint32_t> & Indices,
+	TangentStaging & Staging
+)
+{
+	const size_t VertexCount = Staging.GetVertexCount();
+	const size_t TriangleCount = Indices.size() / 3;
+
+	CornerStreams Corners;
+	for (int k = 0; k < 3; k++)
+	{
+		Corners.ContributionX[k].resize(TriangleCount);
+		Corners.ContributionY[k].resize(TriangleCount);
+		Corners.ContributionZ[k].resize(TriangleCount);
+		Corners.Weight[k].resize(TriangleCount);
+	}
+	Corners.Sign.resize(TriangleCount);
+
+	/** The remainder that does not fill a vector runs through the scalar kernel */
+	size_t Vectorized = TriangleCount - TriangleCount % TFloat::Width;
+	ComputeCornerTangents<TFloat>(Indices, Staging, 0, Vectorized, Corners);
+	ComputeCornerTangents<FloatX1>(Indices, Staging, Vectorized, TriangleCount, Corners);
+
+	/** Mirrored and regular corners of a vertex are summed apart, group 2g and 2g + 1 */
+	std::vector<uint32_t> Groups;
+	size_t GroupCount = GroupVertices(Staging, Groups) * 2;
+
+	std::vector<float> SumX(GroupCount, 0.0f), SumY(GroupCount, 0.0f), SumZ(GroupCount, 0.0f);
+	std::vector<float> SumWeight(GroupCount, 0.0f);
+
+	/** Scattered adds conflict between lanes, this stays scalar and in order so every path sums the same way */
+	for (size_t Triangle = 0; Triangle < TriangleCount; Triangle++)
+	{
+		uint32_t Mirrored = Corners.Sign[Triangle] < 0.0f ? 1 : 0;
+
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t Group = Groups[Indices[Triangle * 3 + k]] * 2 + Mirrored;
+			SumX[Group] += Corners.ContributionX[k][Triangle];
+			SumY[Group] += Corners.ContributionY[k][Triangle];
+			SumZ[Group] += Corners.ContributionZ[k][Triangle];
+			SumWeight[Group] += Corners.Weight[k][Triangle];
+		}
+	}
+
+	Vectorized = GroupCount - GroupCount % TFloat::Width;
+	NormalizeTangents<TFloat>(SumX, SumY, SumZ, 0, Vectorized);
+	NormalizeTangents<FloatX1>(SumX, SumY, SumZ, Vectorized, GroupCount);
+
+	for (size_t Vertex = 0; Vertex < VertexCount; Vertex++)
+	{
+		/** A vertex used by both mirrored and regular triangles takes the side with more weight */
+		uint32_t Group = Groups[Vertex] * 2;
+		Group += SumWeight[Group + 1] > SumWeight[Group] ? 1 : 0;
+
+		float X = SumX[Group], Y = SumY[Group], Z = SumZ[Group];
+
+		if (X == 0.0f && Y == 0.0f && Z == 0.0f)
+		{
+			/** Any direction in the tangent plane, so the shader never normalizes a zero vector */
+			float NX = Staging.NormalX[Vertex], NY = Staging.NormalY[Vertex], NZ = Staging.NormalZ[Vertex];
+			bool bNearX = std::fabs(NX) > 0.9f;
+			float AX = bNearX ? 0.0f : 1.0f, AY = bNearX ? 1.0f : 0.0f;
+
+			/** Tangent = normalize(Axis - N * dot(N, Axis)) */
+			float Projection = NX * AX + NY * AY;
+			X = AX - NX * Projection;
+			Y = AY - NY * Projection;
+			Z = -NZ * Projection;
+
+			float Length = std::sqrt(X * X + Y * Y + Z * Z);
+			if (Length > 0.0f)
+			{
+				X /= Length;
+				Y /= Length;
+				Z /= Length;
+			}
+			else
+			{
+				X = 1.0f;
+				Y = 0.0f;
+				Z = 0.0f;
+			}
+		}
+
+		Staging.TangentX[Vertex] = X;
+		Staging.TangentY[Vertex] = Y;
+		Staging.TangentZ[Vertex] = Z;
+	}
+}
+
+}
+
+void TangentStaging::Resize(
+	size_t VertexCount
+)
+{
+	for (std::vector<float> * pStream : {
+		&PositionX, &PositionY, &PositionZ,
+		&NormalX, &NormalY, &NormalZ,
+		&TexCoordU, &TexCoordV,
+		&TangentX, &TangentY, &TangentZ })
+	{
+		pStream->resize(VertexCount, 0.0f);
+	}
+}
+
+size_t TangentStaging::GetVertexCount() const
+{
+	return PositionX.size();
+}
+
+TangentPath GenerateTangents(
+	const std::vector<uint32_t> & Indices,
+	TangentStaging & Staging,
+	TangentPath Path
+)
+{
+	if (Path == TANGENT_PATH_AUTO)
+	{
+		Path = IsTangentPathSupported(TANGENT_PATH_AVX2) ? TANGENT_PATH_AVX2 :
+			IsTangentPathSupported(TANGENT_PATH_SSE2) ? TANGENT_PATH_SSE2 : TANGENT_PATH_SCALAR;
+	}
+	else if (!IsTangentPathSupported(Path))
+	{
+		Path = TANGENT_PATH_SCALAR;
+	}
+
+	switch (Path)
+	{
+#ifdef SIMD_AVX2
+	case TANGENT_PATH_AVX2:
+		GenerateTangentsWith<FloatX8>(Indices, Staging);
+		break;
+#endif
+#ifdef SIMD_SSE2
+	case TANGENT_PATH_SSE2:
+		GenerateTangentsWith<FloatX4>(Indices, Staging);
+		break;
+#endif
+	default:
+		GenerateTangentsWith<FloatX1>(Indices, Staging);
+		break;
+	}
+
+	return Path;
+}
+
+bool IsTangentPathSupported(
+	TangentPath Path
+)
+{
+	switch (Path)
+	{
+	case TANGENT_PATH_AUTO:
+	case TANGENT_PATH_SCALAR:
+		return true;
+#ifdef SIMD_SSE2
+	case TANGENT_PATH_SSE2:
+		return true;
+#endif
+#ifdef SIMD_AVX2
+	case TANGENT_PATH_AVX2:
+		return IsAvx2Supported();
+#endif
+	default:
+		return false;
+	}
+}
+
+const char * GetTangentPathName(
+	TangentPath Path
+)
+{
+	switch (Path)
+	{
+	case TANGENT_PATH_AUTO: return "Auto";
+	case TANGENT_PATH_SCALAR: return "Scalar";
+	case TANGENT_PATH_SSE2: return "SSE2";
+	case TANGENT_PATH_AVX2: return "AVX2";
+	default: return "Unknown";
+	}
+}
+
+NAMESPACE_END
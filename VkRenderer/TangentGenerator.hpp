@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+enum TangentPath
+{
+	/** The widest path the CPU supports */
+	TANGENT_PATH_AUTO = 0,
+	TANGENT_PATH_SCALAR = 1,
+	TANGENT_PATH_SSE2 = 2,
+	TANGENT_PATH_AVX2 = 3
+};
+
+/** A mesh as structure of arrays, the layout the tangent generator vectorizes over. */
+struct TangentStaging
+{
+	std::vector<float> PositionX, PositionY, PositionZ;
+	std::vector<float> NormalX, NormalY, NormalZ;
+	std::vector<float> TexCoordU, TexCoordV;
+	/** Output, unit length and orthogonal to the normal */
+	std::vector<float> TangentX, TangentY, TangentZ;
+
+	void Resize(
+		size_t VertexCount
+	);
+
+	size_t GetVertexCount() const;
+};
+
+/**
+* MikkTSpace style tangents: every corner projects the UV derived tangent of its triangle onto the
+* plane of its normal and adds it, weighted by the corner angle, to all corners with the same position,
+* normal, UV and UV winding. Vertices do not have to be welded, so un-indexed meshes are smooth too.
+* Vertices without a usable UV mapping get an arbitrary tangent orthogonal to the normal.
+* Every path returns bit identical results. Returns the path that ran, AUTO falls back to narrower ones.
+*/
+TangentPath GenerateTangents(
+	const std::vector<uint32_t> & Indices,
+	TangentStaging & Staging,
+	TangentPath Path = TANGENT_PATH_AUTO
+);
+
+bool IsTangentPathSupported(
+	TangentPath Path
+);
+
+const char * GetTangentPathName(
+	TangentPath Path
+);
+
+NAMESPACE_END
@@ -0,0 +1,438 @@
+#include "TextureLoader.hpp"
+#include "DdsFile.hpp"
+#include "MappedFile.hpp"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+struct PendingTexture
+{
+	uint32_t Width = 1;
+	uint32_t Height = 1;
+	VkDeviceSize Size = 4;
+	bool bMissing = false;
+	VkFormat Format = VK_FORMAT_R8G8B8A8_UNORM;
+
+	VkBuffer StagingBuffer = VK_NULL_HANDLE;
+	VkDeviceSize StagingOffset = 0;
+	void * pStaging = nullptr;
+
+	/** Compressed only: the RGBA chain the workers build and where each encoded level goes in staging */
+	bool bCompressed = false;
+	BcFormat BlockFormat = BC_FORMAT_BC7;
+	std::vector<std::vector<uint8_t>> Levels;
+	/** Compressed and pre-baked: where each level starts in staging */
+	std::vector<VkDeviceSize> LevelOffsets;
+
+	/** ORM only: packed from the channel images instead of decoded from Filename */
+	bool bPacked = false;
+
+	/** Pre-baked only: the mapped container, its levels are copied into staging as they are */
+	std::unique_ptr<MappedFile> pContainer;
+	DdsImage Container;
+	bool bContainer = false;
+	std::string Filename;
+
+	double DecodeMilliseconds = 0.0;
+	uint32_t ThreadIndex = 0;
+};
+
+}
+
+std::string GetTextureContainerFilename(
+	const std::string & Filename
+)
+{
+	std::filesystem::path Path(Filename);
+	std::string Extension = Path.extension().string();
+	std::transform(Extension.begin(), Extension.end(), Extension.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+
+	if (Extension == ".dds")
+	{
+		return Filename;
+	}
+
+	std::error_code Error;
+	Path.replace_extension(".dds");
+	return std::filesystem::is_regular_file(Path, Error) ? Path.string() : std::string();
+}
+
+bool IsTextureFormatSupported(
+	VkPhysicalDevice PhysicalDevice,
+	VkFormat Format
+)
+{
+	VkFormatProperties FormatProperties;
+	vkGetPhysicalDeviceFormatProperties(PhysicalDevice, Format, &FormatProperties);
+	return (FormatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+}
+
+void LoadTextures(
+	VkPhysicalDevice PhysicalDevice,
+	VkDevice Device,
+	MemoryAllocator & Allocator,
+	UploadContext & Uploader,
+	ThreadPool & Pool,
+	const std::vector<TextureLoadRequest> & Requests,
+	const TextureCompressionSettings & Compression,
+	std::ostream & Log
+)
+{
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	std::vector<PendingTexture> Pendings(Requests.size());
+
+	bool bCompress = Compression.bEnabled;
+	for (BcFormat Format : { BC_FORMAT_BC4, BC_FORMAT_BC5, BC_FORMAT_BC7 })
+	{
+		bCompress = bCompress && IsTextureFormatSupported(PhysicalDevice, GetBcVkFormat(Format));
+	}
+
+	if (Compression.bEnabled && !bCompress)
+	{
+		Log << "BC formats are not supported, textures are loaded uncompressed" << std::endl;
+	}
+
+	/** Only the headers are parsed here, the images need their final size before the decode finishes */
+	for (size_t i = 0; i < Requests.size(); i++)
+	{
+		PendingTexture & Pending = Pendings[i];
+		TextureInfo & Texture = *Requests[i].pTexture;
+
+		Pending.Filename = Requests[i].Filename;
+		Pending.bPacked = Requests[i].Content == TEXTURE_CONTENT_ORM && Requests[i].Filename.empty();
+
+		if (Pending.bPacked)
+		{
+			for (const std::string & ChannelFilename : Requests[i].ChannelFilenames)
+			{
+				Pending.Filename += (Pending.Filename.empty() ? "" : " + ") + (ChannelFilename.empty() ? "none" : ChannelFilename);
+			}
+		}
+
+		/** A pre-baked container wins over the source image, an unusable one falls back to it */
+		std::string ContainerFilename = Pending.bPacked ? std::string() : GetTextureContainerFilename(Requests[i].Filename);
+		if (!ContainerFilename.empty())
+		{
+			std::unique_ptr<MappedFile> pContainer(new MappedFile());
+
+			if (pContainer->Open(ContainerFilename) &&
+				ParseDds(pContainer->GetData(), pContainer->GetSize(), Pending.Container) &&
+				IsTextureFormatSupported(PhysicalDevice, Pending.Container.Format))
+			{
+				Pending.pContainer = std::move(pContainer);
+				Pending.bContainer = true;
+				Pending.Filename = ContainerFilename;
+			}
+			else
+			{
+				Log << "Failed to load " << ContainerFilename << ", the container or its format is not supported" << std::endl;
+			}
+		}
+
+		int TexWidth = -1, TexHeight = -1, TexChannels = -1;
+		if (Pending.bContainer)
+		{
+			Pending.Width = Pending.Container.Width;
+			Pending.Height = Pending.Container.Height;
+			Pending.Size = Pending.Container.DataSize;
+		}
+		else if (Pending.bPacked)
+		{
+			Pending.bMissing = !GetPackedOrmSize(Requests[i].ChannelFilenames, Pending.Width, Pending.Height);
+			Pending.Size = static_cast<VkDeviceSize>(Pending.Width) * Pending.Height * 4;
+		}
+		else if (stbi_info(Requests[i].Filename.c_str(), &TexWidth, &TexHeight, &TexChannels) == 0)
+		{
+			Pending.bMissing = true;
+		}
+		else
+		{
+			Pending.Width = static_cast<uint32_t>(TexWidth);
+			Pending.Height = static_cast<uint32_t>(TexHeight);
+			Pending.Size = static_cast<VkDeviceSize>(TexWidth) * TexHeight * 4;
+		}
+
+		Texture.MipLevels = static_cast<uint32_t>(
+			std::floor(std::log2(std::max(Pending.Width, Pending.Height)))
+			) + 1;
+
+		/** Block compressed and pre-baked levels are sized up front, the GPU never blits them */
+		VkImageUsageFlags Usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+		if (Pending.bContainer)
+		{
+			Texture.MipLevels = Pending.Container.MipLevels;
+			Pending.Format = Pending.Container.Format;
+			Pending.LevelOffsets.assign(Pending.Container.LevelOffsets.begin(), Pending.Container.LevelOffsets.end());
+
+			Usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		}
+		else if (bCompress)
+		{
+			Pending.bCompressed = true;
+			Pending.BlockFormat = GetTextureBcFormat(Requests[i].Content);
+			Pending.Format = GetBcVkFormat(Pending.BlockFormat);
+			Pending.Levels.resize(Texture.MipLevels);
+			Pending.LevelOffsets.resize(Texture.MipLevels);
+			Pending.Size = 0;
+
+			for (uint32_t Level = 0; Level < Texture.MipLevels; Level++)
+			{
+				Pending.LevelOffsets[Level] = Pending.Size;
+				Pending.Size += GetBcImageSize(
+					Pending.BlockFormat,
+					std::max(Pending.Width >> Level, 1u),
+					std::max(Pending.Height >> Level, 1u)
+				);
+			}
+
+			Usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		}
+
+		CreateImage(
+			Device,
+			Allocator,
+			Pending.Width,
+			Pending.Height,
+			Texture.MipLevels,
+			VK_SAMPLE_COUNT_1_BIT,
+			Pending.Format,
+			VK_IMAGE_TILING_OPTIMAL,
+			Usage,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			Texture.TextureImage,
+			Texture.TextureImageAllocation
+		);
+
+		/** The workers still write into this memory, so it must not be recycled by an implicit submit */
+		Pending.pStaging = Uploader.AllocateStaging(
+			Pending.Size,
+			16,
+			false,
+			Pending.StagingBuffer,
+			Pending.StagingOffset
+		);
+
+		for (VkDeviceSize & Offset : Pending.LevelOffsets)
+		{
+			Offset += Pending.StagingOffset;
+		}
+	}
+
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	std::deque<size_t> Finished;
+
+	for (size_t i = 0; i < Requests.size(); i++)
+	{
+		Pool.Submit([&, i]()
+		{
+			auto DecodeStartTime = std::chrono::high_resolution_clock::now();
+
+			PendingTexture & Pending = Pendings[i];
+
+			if (Pending.bContainer)
+			{
+				/** Straight from the mapping into staging, the page faults are taken here on the worker */
+				memcpy(Pending.pStaging, Pending.Container.pData, Pending.Container.DataSize);
+				Pending.pContainer.reset();
+			}
+			else if (Pending.bPacked)
+			{
+				/** Packed straight into the base level, or into staging if the GPU builds the chain */
+				uint8_t * pPixels = static_cast<uint8_t *>(Pending.pStaging);
+
+				if (Pending.bCompressed)
+				{
+					Pending.Levels[0].resize(static_cast<size_t>(Pending.Width) * Pending.Height * 4);
+					pPixels = Pending.Levels[0].data();
+				}
+
+				PackOrmTexture(Requests[i].ChannelFilenames, Pending.Width, Pending.Height, pPixels);
+
+				if (Pending.bCompressed)
+				{
+					BuildTextureMipChain(Pending.Width, Pending.Height, static_cast<uint32_t>(Pending.Levels.size()), Requests[i].Content, Pending.Levels);
+				}
+			}
+			else
+			{
+				int TexWidth = -1, TexHeight = -1, TexChannels = -1;
+				stbi_uc * pPixels = Pending.bMissing ? nullptr : stbi_load(
+					Requests[i].Filename.c_str(),
+					&TexWidth,
+					&TexHeight,
+					&TexChannels,
+					STBI_rgb_alpha
+				);
+
+				bool bDecoded = pPixels != nullptr &&
+					static_cast<uint32_t>(TexWidth) == Pending.Width &&
+					static_cast<uint32_t>(TexHeight) == Pending.Height;
+
+				if (Pending.bCompressed)
+				{
+					const size_t BaseSize = static_cast<size_t>(Pending.Width) * Pending.Height * 4;
+					std::vector<uint8_t> & Base = Pending.Levels[0];
+
+					if (bDecoded)
+					{
+						Base.assign(pPixels, pPixels + BaseSize);
+					}
+					else
+					{
+						Base.assign(BaseSize, 255);
+					}
+
+					BuildTextureMipChain(Pending.Width, Pending.Height, static_cast<uint32_t>(Pending.Levels.size()), Requests[i].Content, Pending.Levels);
+				}
+				else if (bDecoded)
+				{
+					memcpy(Pending.pStaging, pPixels, static_cast<size_t>(Pending.Size));
+				}
+				else
+				{
+					memset(Pending.pStaging, 255, static_cast<size_t>(Pending.Size));
+				}
+
+				stbi_image_free(pPixels);
+			}
+
+			Pending.DecodeMilliseconds = std::chrono::duration<double, std::chrono::milliseconds::period>(
+				std::chrono::high_resolution_clock::now() - DecodeStartTime
+				).count();
+			Pending.ThreadIndex = Pool.GetCurrentThreadIndex();
+
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Finished.push_back(i);
+			}
+
+			Condition.notify_one();
+		});
+	}
+
+	/** Record the copy of every texture as soon as its decode is done */
+	for (size_t Count = 0; Count < Requests.size(); Count++)
+	{
+		size_t Index = 0;
+
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			Condition.wait(Lock, [&]() { return !Finished.empty(); });
+			Index = Finished.front();
+			Finished.pop_front();
+		}
+
+		PendingTexture & Pending = Pendings[Index];
+		TextureInfo & Texture = *Requests[Index].pTexture;
+
+		BcEncodeStatistics EncodeStatistics;
+
+		if (Pending.bCompressed)
+		{
+			/** Encoded here so every level is spread over the whole pool, not one worker per texture */
+			BcEncodeSettings Settings;
+			Settings.Format = Pending.BlockFormat;
+			Settings.Quality = Compression.Quality;
+
+			for (uint32_t Level = 0; Level < Texture.MipLevels; Level++)
+			{
+				BcEncodeStatistics LevelStatistics;
+
+				EncodeBcImage(
+					Settings,
+					Pending.Levels[Level].data(),
+					std::max(Pending.Width >> Level, 1u),
+					std::max(Pending.Height >> Level, 1u),
+					static_cast<uint8_t *>(Pending.pStaging) + (Pending.LevelOffsets[Level] - Pending.StagingOffset),
+					&Pool,
+					&LevelStatistics
+				);
+
+				EncodeStatistics.Texels += LevelStatistics.Texels;
+				EncodeStatistics.Blocks += LevelStatistics.Blocks;
+				EncodeStatistics.Milliseconds += LevelStatistics.Milliseconds;
+			}
+
+			Pending.Levels.clear();
+			Pending.Levels.shrink_to_fit();
+		}
+
+		if (Pending.bCompressed || Pending.bContainer)
+		{
+			Uploader.CopyStagedImageLevels(
+				Pending.StagingBuffer,
+				Pending.LevelOffsets,
+				Texture.TextureImage,
+				Pending.Format,
+				Pending.Width,
+				Pending.Height
+			);
+		}
+		else
+		{
+			Uploader.CopyStagedImage(
+				Pending.StagingBuffer,
+				Pending.StagingOffset,
+				Texture.TextureImage,
+				Pending.Format,
+				Pending.Width,
+				Pending.Height,
+				Texture.MipLevels
+			);
+		}
+
+		CreateImageView(
+			Device,
+			Texture.TextureImage,
+			Pending.Format,
+			Texture.MipLevels,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			Texture.TextureImageView
+		);
+
+		CreateTextureSampler(Device, Texture.MipLevels, Texture.TextureSampler);
+
+		Log << (Pending.bContainer ? "Copied " : Pending.bPacked ? "Packed " : "Decoded ") << Pending.Filename
+			<< " (" << Pending.Width << "x" << Pending.Height << (Pending.bMissing ? ", missing" : "")
+			<< (Pending.bContainer ? ", " + std::to_string(Texture.MipLevels) + " pre-baked levels" : "") << ")"
+			<< " in " << std::fixed << std::setprecision(2) << Pending.DecodeMilliseconds << " ms"
+			<< " on worker " << Pending.ThreadIndex;
+
+		if (Pending.bCompressed)
+		{
+			Log << ", " << GetBcFormatName(Pending.BlockFormat) << " " << GetBcQualityName(Compression.Quality)
+				<< " in " << EncodeStatistics.Milliseconds << " ms"
+				<< " (" << EncodeStatistics.GetMegatexelsPerSecond() << " Mtexel/s)";
+		}
+
+		Log << std::endl;
+	}
+
+	double TotalMilliseconds = std::chrono::duration<double, std::chrono::milliseconds::period>(
+		std::chrono::high_resolution_clock::now() - StartTime
+		).count();
+
+	Log << "Loaded " << Requests.size() << " textures in " << std::fixed << std::setprecision(2) << TotalMilliseconds
+		<< " ms with " << Pool.GetThreadCount() << " workers" << std::endl;
+}
+
+NAMESPACE_END
@@ -0,0 +1,74 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "Namespace.hpp"
+#include "BcEncoder.hpp"
+#include "TextureProcessing.hpp"
+#include "VulkanHelper.hpp"
+#include "ThreadPool.hpp"
+#include "UploadContext.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** The DDS to load instead of Filename: Filename itself or a .dds next to it, empty if there is none. */
+std::string GetTextureContainerFilename(
+	const std::string & Filename
+);
+
+/** Whether images of Format can be sampled with linear filtering. */
+bool IsTextureFormatSupported(
+	VkPhysicalDevice PhysicalDevice,
+	VkFormat Format
+);
+
+struct TextureLoadRequest
+{
+	/** ORM: an already packed image, if empty the texture is packed from ChannelFilenames */
+	std::string Filename;
+	TextureInfo * pTexture = nullptr;
+	TextureContent Content = TEXTURE_CONTENT_COLOR;
+	OrmFilenames ChannelFilenames;
+};
+
+struct TextureCompressionSettings
+{
+	/** Ignored if the device can not sample the BC formats */
+	bool bEnabled = false;
+	BcQuality Quality = BC_QUALITY_NORMAL;
+};
+
+/**
+* Decodes every requested file concurrently on the pool. Headers are read up front so the
+* images and their staging memory exist before decoding starts, each worker writes its
+* pixels into its own staging slice and the copy is recorded into the upload context as
+* soon as that decode finishes. Missing files become a 1x1 white texture as before.
+*
+* With compression the workers also build the mip chain on the CPU, the calling thread then
+* encodes every level on the pool straight into staging and the whole chain is copied at once.
+*
+* ORM requests without a Filename are packed from their channel images by the workers first.
+*
+* A DDS file, either requested or lying next to the requested image, is loaded instead: its
+* levels are copied from the mapped file into staging and uploaded with one copy, so nothing
+* is decoded, encoded or blitted. Compression does not apply to it.
+*/
+void LoadTextures(
+	VkPhysicalDevice PhysicalDevice,
+	VkDevice Device,
+	MemoryAllocator & Allocator,
+	UploadContext & Uploader,
+	ThreadPool & Pool,
+	const std::vector<TextureLoadRequest> & Requests,
+	const TextureCompressionSettings & Compression,
+	std::ostream & Log
+);
+
+NAMESPACE_END
@@ -0,0 +1,160 @@
+#include "TextureProcessing.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+BcFormat GetTextureBcFormat(
+	TextureContent Content
+)
+{
+	switch (Content)
+	{
+	case TEXTURE_CONTENT_NORMAL: return BC_FORMAT_BC5;
+	case TEXTURE_CONTENT_SCALAR: return BC_FORMAT_BC4;
+	default: return BC_FORMAT_BC7;
+	}
+}
+
+void BuildTextureMipChain(
+	uint32_t Width,
+	uint32_t Height,
+	uint32_t MipLevels,
+	TextureContent Content,
+	std::vector<std::vector<uint8_t>> & Levels
+)
+{
+	for (uint32_t Level = 1; Level < MipLevels; Level++)
+	{
+		const uint32_t SrcWidth = std::max(Width >> (Level - 1), 1u);
+		const uint32_t SrcHeight = std::max(Height >> (Level - 1), 1u);
+		const uint32_t DstWidth = std::max(Width >> Level, 1u);
+		const uint32_t DstHeight = std::max(Height >> Level, 1u);
+
+		const std::vector<uint8_t> & Src = Levels[Level - 1];
+		std::vector<uint8_t> & Dst = Levels[Level];
+		Dst.resize(static_cast<size_t>(DstWidth) * DstHeight * 4);
+
+		for (uint32_t y = 0; y < DstHeight; y++)
+		{
+			const uint32_t Y0 = std::min(y * 2, SrcHeight - 1);
+			const uint32_t Y1 = std::min(y * 2 + 1, SrcHeight - 1);
+
+			for (uint32_t x = 0; x < DstWidth; x++)
+			{
+				const uint32_t X0 = std::min(x * 2, SrcWidth - 1);
+				const uint32_t X1 = std::min(x * 2 + 1, SrcWidth - 1);
+
+				const uint8_t * pTexels[4] =
+				{
+					&Src[(static_cast<size_t>(Y0) * SrcWidth + X0) * 4],
+					&Src[(static_cast<size_t>(Y0) * SrcWidth + X1) * 4],
+					&Src[(static_cast<size_t>(Y1) * SrcWidth + X0) * 4],
+					&Src[(static_cast<size_t>(Y1) * SrcWidth + X1) * 4]
+				};
+
+				uint8_t * pDst = &Dst[(static_cast<size_t>(y) * DstWidth + x) * 4];
+
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					pDst[c] = static_cast<uint8_t>((pTexels[0][c] + pTexels[1][c] + pTexels[2][c] + pTexels[3][c] + 2) / 4);
+				}
+
+				if (Content == TEXTURE_CONTENT_NORMAL)
+				{
+					float Normal[3] = {};
+					for (uint32_t i = 0; i < 4; i++)
+					{
+						for (uint32_t c = 0; c < 3; c++)
+						{
+							Normal[c] += pTexels[i][c] / 127.5f - 1.0f;
+						}
+					}
+
+					float Length = std::sqrt(Normal[0] * Normal[0] + Normal[1] * Normal[1] + Normal[2] * Normal[2]);
+					if (Length > 0.0f)
+					{
+						for (uint32_t c = 0; c < 3; c++)
+						{
+							pDst[c] = static_cast<uint8_t>(std::min(std::max((Normal[c] / Length + 1.0f) * 127.5f + 0.5f, 0.0f), 255.0f));
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+bool GetPackedOrmSize(
+	const OrmFilenames & Filenames,
+	uint32_t & Width,
+	uint32_t & Height
+)
+{
+	bool bFound = false;
+	Width = 1;
+	Height = 1;
+
+	for (const std::string & Filename : Filenames)
+	{
+		int TexWidth = -1, TexHeight = -1, TexChannels = -1;
+		if (!Filename.empty() && stbi_info(Filename.c_str(), &TexWidth, &TexHeight, &TexChannels) != 0)
+		{
+			Width = std::max(Width, static_cast<uint32_t>(TexWidth));
+			Height = std::max(Height, static_cast<uint32_t>(TexHeight));
+			bFound = true;
+		}
+	}
+
+	return bFound;
+}
+
+void PackOrmTexture(
+	const OrmFilenames & Filenames,
+	uint32_t Width,
+	uint32_t Height,
+	uint8_t * pPixels
+)
+{
+	memset(pPixels, 255, static_cast<size_t>(Width) * Height * 4);
+
+	for (uint32_t Channel = 0; Channel < ORM_CHANNEL_COUNT; Channel++)
+	{
+		int TexWidth = -1, TexHeight = -1, TexChannels = -1;
+		stbi_uc * pSource = Filenames[Channel].empty() ? nullptr : stbi_load(
+			Filenames[Channel].c_str(),
+			&TexWidth,
+			&TexHeight,
+			&TexChannels,
+			STBI_rgb_alpha
+		);
+
+		if (pSource == nullptr)
+		{
+			continue;
+		}
+
+		const uint32_t SrcWidth = static_cast<uint32_t>(TexWidth);
+		const uint32_t SrcHeight = static_cast<uint32_t>(TexHeight);
+
+		for (uint32_t y = 0; y < Height; y++)
+		{
+			const stbi_uc * pSrcRow = pSource + static_cast<size_t>(std::min(y * SrcHeight / Height, SrcHeight - 1)) * SrcWidth * 4;
+			uint8_t * pDst = pPixels + static_cast<size_t>(y) * Width * 4 + Channel;
+
+			for (uint32_t x = 0; x < Width; x++, pDst += 4)
+			{
+				*pDst = pSrcRow[std::min(x * SrcWidth / Width, SrcWidth - 1) * 4];
+			}
+		}
+
+		stbi_image_free(pSource);
+	}
+}
+
+NAMESPACE_END
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Namespace.hpp"
+#include "BcEncoder.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** What a texture holds, decides the block format it is compressed to. */
+enum TextureContent
+{
+	/** RGBA, BC7 */
+	TEXTURE_CONTENT_COLOR = 0,
+	/** Tangent space normal, BC5 keeps x and y and the shader rebuilds z */
+	TEXTURE_CONTENT_NORMAL = 1,
+	/** One value in red, BC4 */
+	TEXTURE_CONTENT_SCALAR = 2,
+	/** Occlusion, roughness and metallic in red, green and blue, BC7 */
+	TEXTURE_CONTENT_ORM = 3
+};
+
+/** Where each map goes in an ORM texture, also the order of the files it is packed from. */
+enum OrmChannel
+{
+	ORM_CHANNEL_OCCLUSION = 0,
+	ORM_CHANNEL_ROUGHNESS = 1,
+	ORM_CHANNEL_METALLIC = 2,
+	ORM_CHANNEL_COUNT = 3
+};
+
+using OrmFilenames = std::array<std::string, ORM_CHANNEL_COUNT>;
+
+/** Block format a texture of Content is compressed to. */
+BcFormat GetTextureBcFormat(
+	TextureContent Content
+);
+
+/**
+* Fills Levels[1..MipLevels) from the RGBA8 base in Levels[0] with a box filter, like the blits of
+* CmdGenerateMipmaps with odd edges repeating the last texel. Normals are averaged as vectors and
+* renormalized so the chain stays unit length.
+*/
+void BuildTextureMipChain(
+	uint32_t Width,
+	uint32_t Height,
+	uint32_t MipLevels,
+	TextureContent Content,
+	std::vector<std::vector<uint8_t>> & Levels
+);
+
+/** Size of the texture PackOrmTexture builds, the largest of the images. False if none of them exists. */
+bool GetPackedOrmSize(
+	const OrmFilenames & Filenames,
+	uint32_t & Width,
+	uint32_t & Height
+);
+
+/**
+* Decodes the images and packs the red channel of each into its channel of Width x Height RGBA8
+* Pixels, smaller images are scaled up with nearest filtering. Channels without an image and
+* alpha are 255, like a missing texture.
+*/
+void PackOrmTexture(
+	const OrmFilenames & Filenames,
+	uint32_t Width,
+	uint32_t Height,
+	uint8_t * pPixels
+);
+
+NAMESPACE_END
@@ -0,0 +1,570 @@
+#include "TextureStreamer.hpp"
+#include "TextureLoader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+TextureStreamer::~TextureStreamer()
+{
+	StopReader();
+}
+
+void TextureStreamer::Init(
+	VkInstance Instance,
+	VkPhysicalDevice PhysicalDevice,
+	VkDevice Device,
+	MemoryAllocator & Allocator,
+	UploadContext & Uploader,
+	bool bMemoryBudget,
+	const TextureStreamingSettings & Settings
+)
+{
+	m_Instance = Instance;
+	m_PhysicalDevice = PhysicalDevice;
+	m_Device = Device;
+	m_pAllocator = &Allocator;
+	m_pUploader = &Uploader;
+	m_bMemoryBudget = bMemoryBudget;
+	m_Settings = Settings;
+
+	VkPhysicalDeviceMemoryProperties MemoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &MemoryProperties);
+
+	for (uint32_t i = 0; i < MemoryProperties.memoryHeapCount; i++)
+	{
+		const VkMemoryHeap & Heap = MemoryProperties.memoryHeaps[i];
+		if ((Heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0 && Heap.size > m_HeapSize)
+		{
+			m_HeapIndex = i;
+			m_HeapSize = Heap.size;
+		}
+	}
+
+	m_Statistics.bMemoryBudgetExtension = m_bMemoryBudget;
+
+	m_bStopping = false;
+	m_Reader = std::thread(&TextureStreamer::ReaderLoop, this);
+}
+
+void TextureStreamer::Destroy()
+{
+	if (m_Device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	StopReader();
+
+	/** Nothing may still be uploading into the images about to be destroyed */
+	m_pUploader->Flush();
+
+	for (PendingUpload & Upload : m_PendingUploads)
+	{
+		DestroyTexture(m_Device, *m_pAllocator, Upload.Texture);
+	}
+
+	for (RetiredTexture & Retired : m_RetiredTextures)
+	{
+		DestroyTexture(m_Device, *m_pAllocator, Retired.Texture);
+	}
+
+	m_PendingUploads.clear();
+	m_RetiredTextures.clear();
+	m_ReadQueue.clear();
+	m_ReadDone.clear();
+	m_TextureIndices.clear();
+	m_Textures.clear();
+	m_States.clear();
+}
+
+bool TextureStreamer::AddTexture(
+	const std::string & Filename,
+	TextureInfo * pTexture
+)
+{
+	std::string ContainerFilename = Filename.empty() ? std::string() : GetTextureContainerFilename(Filename);
+	if (ContainerFilename.empty())
+	{
+		return false;
+	}
+
+	StreamedTexture Streamed;
+	Streamed.pTexture = pTexture;
+	Streamed.Filename = ContainerFilename;
+	Streamed.pFile.reset(new MappedFile());
+
+	if (!Streamed.pFile->Open(ContainerFilename) ||
+		!ParseDds(Streamed.pFile->GetData(), Streamed.pFile->GetSize(), Streamed.Image) ||
+		!IsTextureFormatSupported(m_PhysicalDevice, Streamed.Image.Format))
+	{
+		return false;
+	}
+
+	/** The finest level that is small enough to always stay, or the last one */
+	const DdsImage & Image = Streamed.Image;
+	TextureStreamingState State;
+	while (State.TailLevel + 1 < Image.MipLevels &&
+		std::max(Image.Width >> State.TailLevel, Image.Height >> State.TailLevel) > m_Settings.ResidentTailSize)
+	{
+		State.TailLevel++;
+	}
+
+	State.ResidentLevel = State.TailLevel;
+	State.WantedLevel = State.TailLevel;
+
+	/** Block compressed levels are padded and aligned on the device, the file sizes would undercount them */
+	for (uint32_t Level = 0; Level <= State.TailLevel; Level++)
+	{
+		State.ChainBytes.push_back(GetImageMemorySize(
+			m_Device,
+			std::max(Image.Width >> Level, 1u),
+			std::max(Image.Height >> Level, 1u),
+			Image.MipLevels - Level,
+			Image.Format,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+		));
+	}
+
+	uint32_t TextureIndex = static_cast<uint32_t>(m_Textures.size());
+	m_Textures.push_back(std::move(Streamed));
+	m_States.push_back(std::move(State));
+	m_TextureIndices[pTexture] = TextureIndex;
+
+	/** Only a few KB, straight from the mapping. It goes out with whatever the caller submits next. */
+	const StreamedTexture & Added = m_Textures.back();
+	const uint32_t TailLevel = m_States.back().TailLevel;
+	RecordUpload(TextureIndex, TailLevel, Added.Image.pData + Added.Image.LevelOffsets[TailLevel], *pTexture);
+
+	return true;
+}
+
+void TextureStreamer::RequestResolution(
+	const TextureInfo * pTexture,
+	float PixelsPerUv
+)
+{
+	auto Iter = m_TextureIndices.find(pTexture);
+	if (Iter == m_TextureIndices.end() || PixelsPerUv <= 0.0f)
+	{
+		return;
+	}
+
+	StreamedTexture & Streamed = m_Textures[Iter->second];
+
+	/** The level whose texels are about as large as a pixel, trilinear filtering also reads the next coarser one */
+	float Texels = static_cast<float>(std::max(Streamed.Image.Width, Streamed.Image.Height));
+	float Level = std::log2(Texels / PixelsPerUv) + m_Settings.MipBias;
+
+	uint32_t WantedLevel = Level <= 0.0f ? 0 : std::min(static_cast<uint32_t>(Level), m_States[Iter->second].TailLevel);
+	Streamed.RequestedLevel = std::min(Streamed.RequestedLevel, WantedLevel);
+}
+
+void TextureStreamer::Update(
+	uint64_t InUseGeneration,
+	std::ostream & Log
+)
+{
+	m_Frame++;
+
+	while (!m_RetiredTextures.empty() && m_RetiredTextures.front().Generation <= InUseGeneration)
+	{
+		DestroyTexture(m_Device, *m_pAllocator, m_RetiredTextures.front().Texture);
+		m_RetiredTextures.pop_front();
+	}
+
+	std::vector<ReadRequest> Reads;
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		Reads.swap(m_ReadDone);
+	}
+
+	/** Everything read since the last frame goes out in one batch */
+	size_t FirstUpload = m_PendingUploads.size();
+
+	for (ReadRequest & Read : Reads)
+	{
+		PendingUpload Upload;
+		Upload.TextureIndex = Read.TextureIndex;
+		Upload.Level = Read.Level;
+
+		RecordUpload(Read.TextureIndex, Read.Level, Read.Data.data(), Upload.Texture);
+		m_PendingUploads.push_back(Upload);
+	}
+
+	if (FirstUpload < m_PendingUploads.size())
+	{
+		UploadTicket Ticket = m_pUploader->Submit();
+
+		for (size_t i = FirstUpload; i < m_PendingUploads.size(); i++)
+		{
+			m_PendingUploads[i].Ticket = Ticket;
+		}
+	}
+
+	FinishUploads(Log);
+
+	for (size_t i = 0; i < m_Textures.size(); i++)
+	{
+		StreamedTexture & Streamed = m_Textures[i];
+		TextureStreamingState & State = m_States[i];
+
+		if (Streamed.RequestedLevel != UINT32_MAX)
+		{
+			State.WantedLevel = Streamed.RequestedLevel;
+			State.LastDrawnFrame = m_Frame;
+		}
+		else
+		{
+			State.WantedLevel = State.TailLevel;
+		}
+
+		Streamed.RequestedLevel = UINT32_MAX;
+	}
+
+	m_BudgetBytes = QueryBudget();
+
+	ScheduleRequests();
+}
+
+uint64_t TextureStreamer::GetGeneration() const
+{
+	return m_Generation;
+}
+
+bool TextureStreamer::IsStreamed(
+	const TextureInfo * pTexture
+) const
+{
+	return m_TextureIndices.count(pTexture) > 0;
+}
+
+void TextureStreamer::SetBudget(
+	VkDeviceSize BudgetBytes
+)
+{
+	m_Settings.BudgetBytes = BudgetBytes;
+}
+
+std::vector<TextureResidency> TextureStreamer::GetResidency() const
+{
+	std::vector<TextureResidency> Residency(m_Textures.size());
+
+	for (size_t i = 0; i < m_Textures.size(); i++)
+	{
+		const StreamedTexture & Streamed = m_Textures[i];
+		const TextureStreamingState & State = m_States[i];
+
+		Residency[i].Filename = Streamed.Filename;
+		Residency[i].Width = Streamed.Image.Width;
+		Residency[i].Height = Streamed.Image.Height;
+		Residency[i].MipLevels = Streamed.Image.MipLevels;
+		Residency[i].ResidentLevel = State.ResidentLevel;
+		Residency[i].WantedLevel = State.WantedLevel;
+		Residency[i].TailLevel = State.TailLevel;
+		Residency[i].PendingLevel = State.PendingLevel;
+		Residency[i].ResidentBytes = Streamed.pTexture->TextureImageAllocation.Size;
+		Residency[i].IdleFrames = m_Frame - State.LastDrawnFrame;
+	}
+
+	return Residency;
+}
+
+TextureStreamingStatistics TextureStreamer::GetStatistics() const
+{
+	TextureStreamingStatistics Statistics = m_Statistics;
+	Statistics.TextureCount = static_cast<uint32_t>(m_Textures.size());
+	Statistics.BudgetBytes = m_BudgetBytes;
+
+	for (size_t i = 0; i < m_Textures.size(); i++)
+	{
+		Statistics.PendingCount += m_States[i].PendingLevel != UINT32_MAX ? 1 : 0;
+		Statistics.ResidentBytes += m_Textures[i].pTexture->TextureImageAllocation.Size;
+		Statistics.FullBytes += m_States[i].ChainBytes[0];
+	}
+
+	return Statistics;
+}
+
+void TextureStreamer::PrintResidency(
+	std::ostream & Out
+) const
+{
+	const double MB = 1024.0 * 1024.0;
+	TextureStreamingStatistics Statistics = GetStatistics();
+
+	Out << std::fixed << std::setprecision(1)
+		<< "[Texture streaming] " << Statistics.TextureCount << " textures, "
+		<< Statistics.ResidentBytes / MB << " MB resident of " << Statistics.FullBytes / MB << " MB, "
+		<< "budget " << Statistics.BudgetBytes / MB << " MB, "
+		<< "heap " << Statistics.HeapUsageBytes / MB << " / " << Statistics.HeapBudgetBytes / MB << " MB"
+		<< (Statistics.bMemoryBudgetExtension ? " (VK_EXT_memory_budget)" : " (heap size)") << ", "
+		<< Statistics.PendingCount << " pending, "
+		<< Statistics.StreamInCount << " streamed in (" << Statistics.StreamedInBytes / MB << " MB), "
+		<< Statistics.EvictionCount << " evicted (" << Statistics.EvictedBytes / MB << " MB)" << std::endl;
+
+	for (const TextureResidency & Residency : GetResidency())
+	{
+		Out << "    " << Residency.Filename << " " << Residency.Width << "x" << Residency.Height
+			<< " : level " << Residency.ResidentLevel << " of " << Residency.MipLevels
+			<< ", wanted " << Residency.WantedLevel << ", tail " << Residency.TailLevel;
+
+		if (Residency.PendingLevel != UINT32_MAX)
+		{
+			Out << ", loading " << Residency.PendingLevel;
+		}
+
+		Out << ", " << Residency.ResidentBytes / MB << " MB, idle " << Residency.IdleFrames << " frames" << std::endl;
+	}
+}
+
+void TextureStreamer::ReaderLoop()
+{
+	for (;;)
+	{
+		ReadRequest Read;
+
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_Condition.wait(Lock, [this]() { return m_bStopping || !m_ReadQueue.empty(); });
+
+			if (m_bStopping)
+			{
+				return;
+			}
+
+			Read = std::move(m_ReadQueue.front());
+			m_ReadQueue.pop_front();
+		}
+
+		/** The page faults of the mapped file are taken here instead of on the frame */
+		Read.Data.assign(Read.pSource, Read.pSource + Read.Size);
+
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+			m_ReadDone.push_back(std::move(Read));
+		}
+	}
+}
+
+void TextureStreamer::StopReader()
+{
+	if (!m_Reader.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_bStopping = true;
+	}
+
+	m_Condition.notify_all();
+	m_Reader.join();
+}
+
+void TextureStreamer::RecordUpload(
+	uint32_t TextureIndex,
+	uint32_t Level,
+	const uint8_t * pData,
+	TextureInfo & Texture
+)
+{
+	const StreamedTexture & Streamed = m_Textures[TextureIndex];
+	const DdsImage & Image = Streamed.Image;
+
+	const uint32_t Width = std::max(Image.Width >> Level, 1u);
+	const uint32_t Height = std::max(Image.Height >> Level, 1u);
+	const VkDeviceSize Size = GetFileBytes(Streamed, Level);
+
+	/** Level Level of the file is level 0 of the image */
+	Texture.MipLevels = Image.MipLevels - Level;
+
+	CreateImage(
+		m_Device,
+		*m_pAllocator,
+		Width,
+		Height,
+		Texture.MipLevels,
+		VK_SAMPLE_COUNT_1_BIT,
+		Image.Format,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		Texture.TextureImage,
+		Texture.TextureImageAllocation
+	);
+
+	VkBuffer StagingBuffer = VK_NULL_HANDLE;
+	VkDeviceSize StagingOffset = 0;
+	void * pStaging = m_pUploader->AllocateStaging(Size, 16, true, StagingBuffer, StagingOffset);
+
+	memcpy(pStaging, pData, static_cast<size_t>(Size));
+
+	std::vector<VkDeviceSize> LevelOffsets(Texture.MipLevels);
+	for (uint32_t i = 0; i < Texture.MipLevels; i++)
+	{
+		LevelOffsets[i] = StagingOffset + (Image.LevelOffsets[Level + i] - Image.LevelOffsets[Level]);
+	}
+
+	m_pUploader->CopyStagedImageLevels(StagingBuffer, LevelOffsets, Texture.TextureImage, Image.Format, Width, Height);
+
+	CreateImageView(
+		m_Device,
+		Texture.TextureImage,
+		Image.Format,
+		Texture.MipLevels,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		Texture.TextureImageView
+	);
+
+	CreateTextureSampler(m_Device, Texture.MipLevels, Texture.TextureSampler);
+}
+
+void TextureStreamer::FinishUploads(
+	std::ostream & Log
+)
+{
+	const double MB = 1024.0 * 1024.0;
+
+	for (size_t i = 0; i < m_PendingUploads.size();)
+	{
+		PendingUpload & Upload = m_PendingUploads[i];
+
+		if (!m_pUploader->IsComplete(Upload.Ticket))
+		{
+			i++;
+			continue;
+		}
+
+		StreamedTexture & Streamed = m_Textures[Upload.TextureIndex];
+		TextureStreamingState & State = m_States[Upload.TextureIndex];
+		VkDeviceSize OldBytes = Streamed.pTexture->TextureImageAllocation.Size;
+		VkDeviceSize NewBytes = Upload.Texture.TextureImageAllocation.Size;
+		bool bEvicted = Upload.Level > State.ResidentLevel;
+
+		/** Frames recorded from now on see the new image, the old one waits for the frames still holding it */
+		m_Generation++;
+		m_RetiredTextures.push_back({ *Streamed.pTexture, m_Generation });
+		*Streamed.pTexture = Upload.Texture;
+
+		if (bEvicted)
+		{
+			m_Statistics.EvictionCount++;
+			m_Statistics.EvictedBytes += OldBytes > NewBytes ? OldBytes - NewBytes : 0;
+		}
+		else
+		{
+			m_Statistics.StreamInCount++;
+			m_Statistics.StreamedInBytes += NewBytes > OldBytes ? NewBytes - OldBytes : 0;
+		}
+
+		Log << (bEvicted ? "Evicted " : "Streamed in ") << Streamed.Filename
+			<< " to level " << Upload.Level << " (" << std::max(Streamed.Image.Width >> Upload.Level, 1u)
+			<< "x" << std::max(Streamed.Image.Height >> Upload.Level, 1u) << ", "
+			<< std::fixed << std::setprecision(2) << NewBytes / MB << " MB)" << std::endl;
+
+		State.ResidentLevel = Upload.Level;
+		State.PendingLevel = UINT32_MAX;
+
+		m_PendingUploads.erase(m_PendingUploads.begin() + i);
+	}
+}
+
+VkDeviceSize TextureStreamer::QueryBudget()
+{
+	VkDeviceSize HeapBudget = m_HeapSize;
+	VkDeviceSize HeapUsage = m_pAllocator->GetStatistics()[m_HeapIndex].BlockBytes;
+
+	if (m_bMemoryBudget)
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT Budget = {};
+		Budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2KHR MemoryProperties = {};
+		MemoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+		MemoryProperties.pNext = &Budget;
+
+		ProxyVulkanFunction::vkGetPhysicalDeviceMemoryProperties2KHR(m_Instance, m_PhysicalDevice, &MemoryProperties);
+
+		/** Covers every process on the device, not only our blocks */
+		HeapBudget = Budget.heapBudget[m_HeapIndex];
+		HeapUsage = Budget.heapUsage[m_HeapIndex];
+	}
+
+	m_Statistics.HeapBudgetBytes = HeapBudget;
+	m_Statistics.HeapUsageBytes = HeapUsage;
+
+	/** Everything the streamer holds, including the images still in flight, can be given back */
+	VkDeviceSize StreamedBytes = 0;
+	for (const StreamedTexture & Streamed : m_Textures)
+	{
+		StreamedBytes += Streamed.pTexture->TextureImageAllocation.Size;
+	}
+	for (const PendingUpload & Upload : m_PendingUploads)
+	{
+		StreamedBytes += Upload.Texture.TextureImageAllocation.Size;
+	}
+	for (const RetiredTexture & Retired : m_RetiredTextures)
+	{
+		StreamedBytes += Retired.Texture.TextureImageAllocation.Size;
+	}
+
+	VkDeviceSize OtherBytes = HeapUsage > StreamedBytes ? HeapUsage - StreamedBytes : 0;
+	VkDeviceSize Available = HeapBudget > OtherBytes ? HeapBudget - OtherBytes : 0;
+	VkDeviceSize BudgetBytes = static_cast<VkDeviceSize>(static_cast<double>(Available) * m_Settings.BudgetFraction);
+
+	if (m_Settings.BudgetBytes > 0)
+	{
+		BudgetBytes = std::min(BudgetBytes, m_Settings.BudgetBytes);
+	}
+
+	return BudgetBytes;
+}
+
+void TextureStreamer::ScheduleRequests()
+{
+	std::vector<TextureStreamingRequest> Requests;
+	ScheduleTextureRequests(m_States, m_BudgetBytes, m_Settings.MaxPendingRequests, Requests);
+
+	for (const TextureStreamingRequest & Planned : Requests)
+	{
+		Request(Planned.TextureIndex, Planned.Level);
+	}
+}
+
+void TextureStreamer::Request(
+	uint32_t TextureIndex,
+	uint32_t Level
+)
+{
+	const StreamedTexture & Streamed = m_Textures[TextureIndex];
+
+	ReadRequest Read;
+	Read.TextureIndex = TextureIndex;
+	Read.Level = Level;
+	Read.pSource = Streamed.Image.pData + Streamed.Image.LevelOffsets[Level];
+	Read.Size = static_cast<size_t>(GetFileBytes(Streamed, Level));
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_ReadQueue.push_back(std::move(Read));
+	}
+
+	m_Condition.notify_one();
+}
+
+VkDeviceSize TextureStreamer::GetFileBytes(
+	const StreamedTexture & Texture,
+	uint32_t Level
+) const
+{
+	return static_cast<VkDeviceSize>(Texture.Image.DataSize - Texture.Image.LevelOffsets[Level]);
+}
+
+NAMESPACE_END
@@ -0,0 +1,263 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Namespace.hpp"
+#include "VulkanHelper.hpp"
+#include "UploadContext.hpp"
+#include "MappedFile.hpp"
+#include "DdsFile.hpp"
+#include "TextureStreamingPlanner.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+struct TextureStreamingSettings
+{
+	/** Levels of at most this many texels on their longer side are loaded up front and never evicted */
+	uint32_t ResidentTailSize = 64;
+	/** Bytes the streamed textures may occupy, zero takes BudgetFraction of what the device local heap has left */
+	VkDeviceSize BudgetBytes = 0;
+	float BudgetFraction = 0.8f;
+	/** Added to the level the screen size asks for, positive values trade sharpness for memory */
+	float MipBias = 0.0f;
+	/** Textures read and uploaded at once, each request is the whole chain below its level */
+	uint32_t MaxPendingRequests = 4;
+};
+
+/** Where one streamed texture stands, levels count from the full resolution one. */
+struct TextureResidency
+{
+	std::string Filename;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t MipLevels = 0;
+	/** Finest level on the GPU */
+	uint32_t ResidentLevel = 0;
+	/** Finest level the last frames asked for, the tail level if the texture was not drawn */
+	uint32_t WantedLevel = 0;
+	/** Finest level that is never evicted */
+	uint32_t TailLevel = 0;
+	/** Level being read or uploaded, UINT32_MAX if none */
+	uint32_t PendingLevel = UINT32_MAX;
+	VkDeviceSize ResidentBytes = 0;
+	/** Frames since the texture was last drawn */
+	uint64_t IdleFrames = 0;
+};
+
+struct TextureStreamingStatistics
+{
+	uint32_t TextureCount = 0;
+	uint32_t PendingCount = 0;
+	VkDeviceSize ResidentBytes = 0;
+	/** What the streamed textures would take with every level */
+	VkDeviceSize FullBytes = 0;
+	VkDeviceSize BudgetBytes = 0;
+	/** Of the device local heap, from VK_EXT_memory_budget if it is enabled, the heap size otherwise */
+	VkDeviceSize HeapBudgetBytes = 0;
+	VkDeviceSize HeapUsageBytes = 0;
+	bool bMemoryBudgetExtension = false;
+	uint64_t StreamedInBytes = 0;
+	uint64_t EvictedBytes = 0;
+	uint32_t StreamInCount = 0;
+	uint32_t EvictionCount = 0;
+};
+
+/**
+* Keeps only the levels of pre-baked DDS textures the screen needs on the GPU. AddTexture loads the
+* small tail of the chain right away, the renderer reports every frame how many pixels a UV unit of
+* each drawn texture covers and Update moves every texture towards the level that matches.
+*
+* A background thread copies the levels out of the mapped files, so the disk reads and page faults
+* never stall a frame. The main thread creates an image with the new chain, records the upload and
+* swaps it into the TextureInfo once the upload has landed, which bumps the generation. Descriptors
+* must be rewritten with the new TextureInfo and the replaced image lives on until no pending frame
+* references an older generation. Coarser chains for eviction take the same path.
+*
+* The budget is BudgetFraction of what VK_EXT_memory_budget says the device local heap has left for
+* the streamed textures, or BudgetBytes if that is smaller. ScheduleTextureRequests plans against it
+* with the memory requirements of every chain, measured once per level by AddTexture.
+*/
+class TextureStreamer
+{
+public:
+	~TextureStreamer();
+
+	/** bMemoryBudget if VK_EXT_memory_budget and VK_KHR_get_physical_device_properties2 are enabled. */
+	void Init(
+		VkInstance Instance,
+		VkPhysicalDevice PhysicalDevice,
+		VkDevice Device,
+		MemoryAllocator & Allocator,
+		UploadContext & Uploader,
+		bool bMemoryBudget,
+		const TextureStreamingSettings & Settings
+	);
+
+	/** Stops the reader thread and destroys every replaced image, the streamed TextureInfos stay with their owners. */
+	void Destroy();
+
+	/**
+	* Streams pTexture from Filename, or a DDS next to it, and records the upload of its tail levels.
+	* Returns false without touching pTexture if there is no usable DDS, the caller loads it instead.
+	*/
+	bool AddTexture(
+		const std::string & Filename,
+		TextureInfo * pTexture
+	);
+
+	/** The texture was drawn with PixelsPerUv screen pixels across one UV unit, the largest request of a frame wins. */
+	void RequestResolution(
+		const TextureInfo * pTexture,
+		float PixelsPerUv
+	);
+
+	/**
+	* Once per frame: swap in finished uploads, destroy images replaced before InUseGeneration, which no
+	* pending frame references anymore, and issue reads and evictions from the resolutions requested
+	* since the last call.
+	*/
+	void Update(
+		uint64_t InUseGeneration,
+		std::ostream & Log
+	);
+
+	/** Bumped by every swap, descriptors written before hold replaced images. */
+	uint64_t GetGeneration() const;
+
+	bool IsStreamed(
+		const TextureInfo * pTexture
+	) const;
+
+	/** Replaces BudgetBytes, zero goes back to the fraction of the heap budget. */
+	void SetBudget(
+		VkDeviceSize BudgetBytes
+	);
+
+	std::vector<TextureResidency> GetResidency() const;
+
+	TextureStreamingStatistics GetStatistics() const;
+
+	void PrintResidency(
+		std::ostream & Out
+	) const;
+
+protected:
+	struct StreamedTexture
+	{
+		TextureInfo * pTexture = nullptr;
+		std::string Filename;
+		/** Kept mapped, every level is read from it again whenever the chain changes */
+		std::unique_ptr<MappedFile> pFile;
+		DdsImage Image;
+		/** Finest level asked for since the last Update, UINT32_MAX if none */
+		uint32_t RequestedLevel = UINT32_MAX;
+	};
+
+	/** Levels [Level, MipLevels) of a texture, copied out of the mapping by the reader thread */
+	struct ReadRequest
+	{
+		uint32_t TextureIndex = 0;
+		uint32_t Level = 0;
+		const uint8_t * pSource = nullptr;
+		size_t Size = 0;
+		std::vector<uint8_t> Data;
+	};
+
+	/** Recorded, waiting for its upload batch to complete */
+	struct PendingUpload
+	{
+		uint32_t TextureIndex = 0;
+		uint32_t Level = 0;
+		TextureInfo Texture;
+		UploadTicket Ticket = 0;
+	};
+
+	struct RetiredTexture
+	{
+		TextureInfo Texture;
+		/** Descriptors of this generation or later no longer reference it */
+		uint64_t Generation = 0;
+	};
+
+	void ReaderLoop();
+
+	void StopReader();
+
+	/** Create the image of levels [Level, MipLevels) and record their upload from Data. */
+	void RecordUpload(
+		uint32_t TextureIndex,
+		uint32_t Level,
+		const uint8_t * pData,
+		TextureInfo & Texture
+	);
+
+	void FinishUploads(
+		std::ostream & Log
+	);
+
+	/** Budget of the streamed textures, from the heap budget and the settings */
+	VkDeviceSize QueryBudget();
+
+	/** Issue evictions and reads for the wanted levels, within the budget. */
+	void ScheduleRequests();
+
+	void Request(
+		uint32_t TextureIndex,
+		uint32_t Level
+	);
+
+	/** Bytes of levels [Level, MipLevels) in the DDS file, what is read and staged */
+	VkDeviceSize GetFileBytes(
+		const StreamedTexture & Texture,
+		uint32_t Level
+	) const;
+
+protected:
+	VkInstance m_Instance = VK_NULL_HANDLE;
+	VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
+	VkDevice m_Device = VK_NULL_HANDLE;
+	MemoryAllocator * m_pAllocator = nullptr;
+	UploadContext * m_pUploader = nullptr;
+	TextureStreamingSettings m_Settings;
+	bool m_bMemoryBudget = false;
+	/** The largest device local heap, where the images end up */
+	uint32_t m_HeapIndex = 0;
+	VkDeviceSize m_HeapSize = 0;
+
+	std::vector<StreamedTexture> m_Textures;
+	/** The levels of m_Textures, same indices */
+	std::vector<TextureStreamingState> m_States;
+	std::unordered_map<const TextureInfo *, uint32_t> m_TextureIndices;
+
+	std::vector<PendingUpload> m_PendingUploads;
+	std::deque<RetiredTexture> m_RetiredTextures;
+
+	uint64_t m_Frame = 0;
+	uint64_t m_Generation = 0;
+	VkDeviceSize m_BudgetBytes = 0;
+	TextureStreamingStatistics m_Statistics;
+
+	/** Shared with the reader thread */
+	std::thread m_Reader;
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	std::deque<ReadRequest> m_ReadQueue;
+	std::vector<ReadRequest> m_ReadDone;
+	bool m_bStopping = false;
+};
+
+NAMESPACE_END
@@ -0,0 +1,160 @@
+#include "TextureStreamingPlanner.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+static void Request(
+	std::vector<TextureStreamingState> & Textures,
+	uint32_t TextureIndex,
+	uint32_t Level,
+	std::vector<TextureStreamingRequest> & Requests
+)
+{
+	Textures[TextureIndex].PendingLevel = Level;
+
+	TextureStreamingRequest Request;
+	Request.TextureIndex = TextureIndex;
+	Request.Level = Level;
+	Requests.push_back(Request);
+}
+
+VkDeviceSize GetPlannedTextureBytes(
+	const std::vector<TextureStreamingState> & Textures
+)
+{
+	VkDeviceSize Bytes = 0;
+
+	for (const TextureStreamingState & Texture : Textures)
+	{
+		Bytes += Texture.ChainBytes[Texture.PendingLevel != UINT32_MAX ? Texture.PendingLevel : Texture.ResidentLevel];
+	}
+
+	return Bytes;
+}
+
+void ScheduleTextureRequests(
+	std::vector<TextureStreamingState> & Textures,
+	VkDeviceSize BudgetBytes,
+	uint32_t MaxPendingRequests,
+	std::vector<TextureStreamingRequest> & Requests
+)
+{
+	const uint32_t TextureCount = static_cast<uint32_t>(Textures.size());
+
+	VkDeviceSize PlannedBytes = GetPlannedTextureBytes(Textures);
+	VkDeviceSize DemandBytes = 0;
+	uint32_t PendingCount = 0;
+
+	for (const TextureStreamingState & Texture : Textures)
+	{
+		if (Texture.PendingLevel != UINT32_MAX)
+		{
+			PendingCount++;
+		}
+		else if (Texture.WantedLevel < Texture.ResidentLevel)
+		{
+			DemandBytes += Texture.ChainBytes[Texture.WantedLevel] - Texture.ChainBytes[Texture.ResidentLevel];
+		}
+	}
+
+	std::vector<uint32_t> Order(TextureCount);
+	std::iota(Order.begin(), Order.end(), 0);
+
+	/** Give back levels nobody needs, least recently drawn first, but only if they are in the way */
+	std::stable_sort(Order.begin(), Order.end(), [&Textures](uint32_t Lhs, uint32_t Rhs)
+	{
+		return Textures[Lhs].LastDrawnFrame < Textures[Rhs].LastDrawnFrame;
+	});
+
+	for (uint32_t TextureIndex : Order)
+	{
+		if (PlannedBytes + DemandBytes <= BudgetBytes)
+		{
+			break;
+		}
+
+		const TextureStreamingState & Texture = Textures[TextureIndex];
+		if (Texture.PendingLevel != UINT32_MAX || Texture.ResidentLevel >= Texture.WantedLevel)
+		{
+			continue;
+		}
+
+		PlannedBytes -= Texture.ChainBytes[Texture.ResidentLevel] - Texture.ChainBytes[Texture.WantedLevel];
+		Request(Textures, TextureIndex, Texture.WantedLevel, Requests);
+	}
+
+	/** Still over budget, the drawn textures lose their finest level, largest first */
+	while (PlannedBytes > BudgetBytes)
+	{
+		uint32_t Victim = UINT32_MAX;
+		VkDeviceSize VictimBytes = 0;
+
+		for (uint32_t TextureIndex = 0; TextureIndex < TextureCount; TextureIndex++)
+		{
+			const TextureStreamingState & Texture = Textures[TextureIndex];
+			if (Texture.PendingLevel != UINT32_MAX || Texture.ResidentLevel >= Texture.TailLevel)
+			{
+				continue;
+			}
+
+			VkDeviceSize Bytes = Texture.ChainBytes[Texture.ResidentLevel];
+			if (Bytes > VictimBytes)
+			{
+				Victim = TextureIndex;
+				VictimBytes = Bytes;
+			}
+		}
+
+		if (Victim == UINT32_MAX)
+		{
+			break;
+		}
+
+		const TextureStreamingState & Texture = Textures[Victim];
+		PlannedBytes -= VictimBytes - Texture.ChainBytes[Texture.ResidentLevel + 1];
+		Request(Textures, Victim, Texture.ResidentLevel + 1, Requests);
+	}
+
+	/** Stream in whatever fits, the textures missing the most levels first */
+	std::stable_sort(Order.begin(), Order.end(), [&Textures](uint32_t Lhs, uint32_t Rhs)
+	{
+		const TextureStreamingState & L = Textures[Lhs];
+		const TextureStreamingState & R = Textures[Rhs];
+		return static_cast<int32_t>(L.ResidentLevel - L.WantedLevel) > static_cast<int32_t>(R.ResidentLevel - R.WantedLevel);
+	});
+
+	for (uint32_t TextureIndex : Order)
+	{
+		if (PendingCount >= MaxPendingRequests)
+		{
+			break;
+		}
+
+		const TextureStreamingState & Texture = Textures[TextureIndex];
+		if (Texture.PendingLevel != UINT32_MAX || Texture.WantedLevel >= Texture.ResidentLevel)
+		{
+			continue;
+		}
+
+		const VkDeviceSize ResidentBytes = Texture.ChainBytes[Texture.ResidentLevel];
+
+		uint32_t Level = Texture.WantedLevel;
+		while (Level < Texture.ResidentLevel && PlannedBytes + Texture.ChainBytes[Level] - ResidentBytes > BudgetBytes)
+		{
+			Level++;
+		}
+
+		if (Level == Texture.ResidentLevel)
+		{
+			continue;
+		}
+
+		PlannedBytes += Texture.ChainBytes[Level] - ResidentBytes;
+		Request(Textures, TextureIndex, Level, Requests);
+		PendingCount++;
+	}
+}
+
+NAMESPACE_END
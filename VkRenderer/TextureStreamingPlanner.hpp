@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** What the planner knows of one streamed texture, levels count from the full resolution one. */
+struct TextureStreamingState
+{
+	/**
+	* Device memory of the image holding levels [Level, MipLevels), indexed by Level up to TailLevel.
+	* From vkGetImageMemoryRequirements, so it matches the allocations the budget is measured in.
+	*/
+	std::vector<VkDeviceSize> ChainBytes;
+	uint32_t TailLevel = 0;
+	/** Finest level on the GPU */
+	uint32_t ResidentLevel = 0;
+	/** Finest level the last frames asked for, the tail level if the texture was not drawn */
+	uint32_t WantedLevel = 0;
+	/** Level being read or uploaded, UINT32_MAX if none */
+	uint32_t PendingLevel = UINT32_MAX;
+	uint64_t LastDrawnFrame = 0;
+};
+
+/** Replace the chain of texture TextureIndex with levels [Level, MipLevels). */
+struct TextureStreamingRequest
+{
+	uint32_t TextureIndex = 0;
+	uint32_t Level = 0;
+};
+
+/** Bytes of every texture at its pending level, or its resident one if nothing is pending */
+VkDeviceSize GetPlannedTextureBytes(
+	const std::vector<TextureStreamingState> & Textures
+);
+
+/**
+* Plans the evictions and reads of one frame, without touching the device. Over BudgetBytes, levels
+* nobody wants are given back least recently drawn first, then drawn textures lose their finest level,
+* largest first. What is left of the budget streams in the textures missing the most levels, at most
+* MaxPendingRequests in flight. Appends to Requests and sets PendingLevel of every requested texture.
+*/
+void ScheduleTextureRequests(
+	std::vector<TextureStreamingState> & Textures,
+	VkDeviceSize BudgetBytes,
+	uint32_t MaxPendingRequests,
+	std::vector<TextureStreamingRequest> & Requests
+);
+
+NAMESPACE_END
@@ -0,0 +1,132 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+thread_local uint32_t s_ThreadIndex = UINT32_MAX;
+
+}
+
+ThreadPool::~ThreadPool()
+{
+	Destroy();
+}
+
+void ThreadPool::Init(
+	uint32_t ThreadCount
+)
+{
+	if (ThreadCount == 0)
+	{
+		ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	m_bStopping = false;
+
+	for (uint32_t i = 0; i < ThreadCount; i++)
+	{
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+void ThreadPool::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_bStopping = true;
+	}
+
+	m_Condition.notify_all();
+
+	for (std::thread & Worker : m_Workers)
+	{
+		Worker.join();
+	}
+
+	m_Workers.clear();
+}
+
+std::future<void> ThreadPool::Submit(
+	std::function<void()> Task
+)
+{
+	std::packaged_task<void()> PackagedTask(std::move(Task));
+	std::future<void> Future = PackagedTask.get_future();
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_Tasks.push_back(std::move(PackagedTask));
+	}
+
+	m_Condition.notify_one();
+
+	return Future;
+}
+
+void ThreadPool::ParallelFor(
+	uint32_t Count,
+	const std::function<void(uint32_t)> & Task
+)
+{
+	std::vector<std::future<void>> Futures;
+	Futures.reserve(Count);
+
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		Futures.push_back(Submit([&Task, i]() { Task(i); }));
+	}
+
+	/** get() rethrows the first exception thrown by a task */
+	for (std::future<void> & Future : Futures)
+	{
+		Future.wait();
+	}
+
+	for (std::future<void> & Future : Futures)
+	{
+		Future.get();
+	}
+}
+
+uint32_t ThreadPool::GetThreadCount() const
+{
+	return static_cast<uint32_t>(m_Workers.size());
+}
+
+uint32_t ThreadPool::GetCurrentThreadIndex() const
+{
+	return s_ThreadIndex == UINT32_MAX ? GetThreadCount() : s_ThreadIndex;
+}
+
+void ThreadPool::WorkerLoop(
+	uint32_t ThreadIndex
+)
+{
+	s_ThreadIndex = ThreadIndex;
+
+	while (true)
+	{
+		std::packaged_task<void()> Task;
+
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_Condition.wait(Lock, [this]() { return m_bStopping || !m_Tasks.empty(); });
+
+			if (m_Tasks.empty())
+			{
+				return;
+			}
+
+			Task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+		}
+
+		Task();
+	}
+}
+
+NAMESPACE_END
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** A fixed set of worker threads consuming a FIFO task queue. */
+class ThreadPool
+{
+public:
+	~ThreadPool();
+
+	/** Zero means one thread per hardware thread. */
+	void Init(
+		uint32_t ThreadCount
+	);
+
+	/** Finishes the queued tasks and joins the workers. */
+	void Destroy();
+
+	std::future<void> Submit(
+		std::function<void()> Task
+	);
+
+	/** Runs Task(i) for i in [0, Count) on the workers and blocks until all of them are done. */
+	void ParallelFor(
+		uint32_t Count,
+		const std::function<void(uint32_t)> & Task
+	);
+
+	uint32_t GetThreadCount() const;
+
+	/** Index of the calling worker, or the thread count if called from outside the pool. */
+	uint32_t GetCurrentThreadIndex() const;
+
+protected:
+	void WorkerLoop(
+		uint32_t ThreadIndex
+	);
+
+protected:
+	std::vector<std::thread> m_Workers;
+	std::deque<std::packaged_task<void()>> m_Tasks;
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	bool m_bStopping = false;
+};
+
+NAMESPACE_END
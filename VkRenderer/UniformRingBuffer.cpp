@@ -0,0 +1,86 @@
+#include "UniformRingBuffer.hpp"
+
+#include <stdexcept>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+void UniformRingBuffer::Init(
+	VkPhysicalDevice PhysicalDevice
+)
+{
+	VkPhysicalDeviceProperties PhysicalDeviceProperties;
+	vkGetPhysicalDeviceProperties(PhysicalDevice, &PhysicalDeviceProperties);
+
+	m_Alignment = PhysicalDeviceProperties.limits.minUniformBufferOffsetAlignment;
+}
+
+void UniformRingBuffer::Create(
+	VkDevice Device,
+	MemoryAllocator & Allocator,
+	VkDeviceSize RegionSize,
+	uint32_t RegionCount
+)
+{
+	m_RegionSize = GetAlignedSize(RegionSize);
+	m_RegionCount = RegionCount;
+	m_RegionBegin = 0;
+	m_Cursor = 0;
+
+	CreateBuffer(
+		Device,
+		Allocator,
+		m_RegionSize * m_RegionCount,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		m_Buffer
+	);
+
+	if (m_Buffer.Allocation.pMappedData == nullptr)
+	{
+		throw std::runtime_error("Uniform ring buffer is not persistently mapped!");
+	}
+}
+
+void UniformRingBuffer::Destroy(
+	VkDevice Device,
+	MemoryAllocator & Allocator
+)
+{
+	DestroyBuffer(Device, Allocator, m_Buffer);
+	m_Buffer = BufferInfo();
+}
+
+void UniformRingBuffer::BeginRegion(
+	uint32_t RegionIndex
+)
+{
+	m_RegionBegin = m_RegionSize * (RegionIndex % m_RegionCount);
+	m_Cursor = m_RegionBegin;
+}
+
+void * UniformRingBuffer::Allocate(
+	VkDeviceSize Size,
+	uint32_t & DynamicOffset
+)
+{
+	VkDeviceSize AlignedSize = GetAlignedSize(Size);
+
+	if (m_Cursor + AlignedSize > m_RegionBegin + m_RegionSize)
+	{
+		throw std::runtime_error("Uniform ring buffer region overflow!");
+	}
+
+	DynamicOffset = static_cast<uint32_t>(m_Cursor);
+	m_Cursor += AlignedSize;
+
+	return static_cast<uint8_t *>(m_Buffer.Allocation.pMappedData) + DynamicOffset;
+}
+
+VkDeviceSize UniformRingBuffer::GetAlignedSize(
+	VkDeviceSize Size
+) const
+{
+	return (Size + m_Alignment - 1) / m_Alignment * m_Alignment;
+}
+
+NAMESPACE_END
@@ -0,0 +1,77 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+
+#include "Namespace.hpp"
+#include "VulkanHelper.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/**
+* A single persistently mapped, host coherent uniform buffer split into one region per
+* frame. Per frame constants are bump allocated from the current region and written in
+* place, the returned offsets are meant to be used as dynamic uniform buffer offsets.
+*/
+class UniformRingBuffer
+{
+public:
+	/** Query minUniformBufferOffsetAlignment once, GetAlignedSize() can be used from here on. */
+	void Init(
+		VkPhysicalDevice PhysicalDevice
+	);
+
+	void Create(
+		VkDevice Device,
+		MemoryAllocator & Allocator,
+		VkDeviceSize RegionSize,
+		uint32_t RegionCount
+	);
+
+	void Destroy(
+		VkDevice Device,
+		MemoryAllocator & Allocator
+	);
+
+	/** Reset the bump pointer to the start of the given region. */
+	void BeginRegion(
+		uint32_t RegionIndex
+	);
+
+	void * Allocate(
+		VkDeviceSize Size,
+		uint32_t & DynamicOffset
+	);
+
+	template <typename TBuffer>
+	TBuffer * Allocate(uint32_t & DynamicOffset)
+	{
+		return static_cast<TBuffer *>(Allocate(sizeof(TBuffer), DynamicOffset));
+	}
+
+	template <typename TBuffer>
+	VkDescriptorBufferInfo GetDescriptorBufferInfo() const
+	{
+		return m_Buffer.GetDescriptorBufferInfo<TBuffer>();
+	}
+
+	/** Size rounded up to minUniformBufferOffsetAlignment. */
+	VkDeviceSize GetAlignedSize(
+		VkDeviceSize Size
+	) const;
+
+protected:
+	BufferInfo m_Buffer;
+	VkDeviceSize m_Alignment = 0;
+	VkDeviceSize m_RegionSize = 0;
+	uint32_t m_RegionCount = 0;
+
+	VkDeviceSize m_RegionBegin = 0;
+	VkDeviceSize m_Cursor = 0;
+};
+
+NAMESPACE_END
@@ -0,0 +1,659 @@
+#include "UploadContext.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <limits>
+#include <utility>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+void UploadContext::Init(
+	VkPhysicalDevice PhysicalDevice,
+	VkDevice Device,
+	MemoryAllocator & Allocator,
+	uint32_t GraphicsFamily,
+	VkQueue GraphicsQueue,
+	uint32_t TransferFamily,
+	VkQueue TransferQueue,
+	VkDeviceSize StagingSize
+)
+{
+	m_PhysicalDevice = PhysicalDevice;
+	m_Device = Device;
+	m_pAllocator = &Allocator;
+	m_GraphicsFamily = GraphicsFamily;
+	m_GraphicsQueue = GraphicsQueue;
+	m_TransferFamily = TransferFamily;
+	m_TransferQueue = TransferQueue;
+
+	VkCommandPoolCreateInfo CmdPoolCreateInfo = {};
+	CmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	CmdPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	CmdPoolCreateInfo.queueFamilyIndex = m_GraphicsFamily;
+
+	if (vkCreateCommandPool(m_Device, &CmdPoolCreateInfo, nullptr, &m_GraphicsCommandPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create upload command pool!");
+	}
+
+	if (HasDedicatedTransfer())
+	{
+		CmdPoolCreateInfo.queueFamilyIndex = m_TransferFamily;
+
+		if (vkCreateCommandPool(m_Device, &CmdPoolCreateInfo, nullptr, &m_TransferCommandPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create upload command pool!");
+		}
+	}
+
+	m_StagingSize = StagingSize;
+	m_StagingHead = 0;
+	m_StagingUsed = 0;
+
+	CreateBuffer(
+		m_Device,
+		*m_pAllocator,
+		m_StagingSize,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		m_StagingBuffer
+	);
+
+	if (m_StagingBuffer.Allocation.pMappedData == nullptr)
+	{
+		throw std::runtime_error("Upload staging buffer is not persistently mapped!");
+	}
+}
+
+void UploadContext::Destroy()
+{
+	Flush();
+
+	DestroyBuffer(m_Device, *m_pAllocator, m_StagingBuffer);
+	m_StagingBuffer = BufferInfo();
+
+	if (m_TransferCommandPool != VK_NULL_HANDLE)
+	{
+		vkDestroyCommandPool(m_Device, m_TransferCommandPool, nullptr);
+		m_TransferCommandPool = VK_NULL_HANDLE;
+	}
+
+	vkDestroyCommandPool(m_Device, m_GraphicsCommandPool, nullptr);
+	m_GraphicsCommandPool = VK_NULL_HANDLE;
+}
+
+void * UploadContext::AllocateStaging(
+	VkDeviceSize Size,
+	VkDeviceSize Alignment,
+	bool bAllowFlush,
+	VkBuffer & Buffer,
+	VkDeviceSize & Offset
+)
+{
+	BeginBatch();
+
+	if (Size <= m_StagingSize)
+	{
+		bool bAllocated = TryAllocateRing(Size, Alignment, Offset);
+
+		if (!bAllocated && bAllowFlush)
+		{
+			Submit();
+
+			while (!bAllocated && !m_InFlight.empty())
+			{
+				RetireOldest();
+				bAllocated = TryAllocateRing(Size, Alignment, Offset);
+			}
+
+			BeginBatch();
+		}
+
+		if (bAllocated)
+		{
+			Buffer = m_StagingBuffer.Buffer;
+			return static_cast<uint8_t *>(m_StagingBuffer.Allocation.pMappedData) + Offset;
+		}
+	}
+
+	/** Released together with the batch */
+	BufferInfo TemporaryBuffer;
+
+	CreateBuffer(
+		m_Device,
+		*m_pAllocator,
+		Size,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		TemporaryBuffer
+	);
+
+	if (TemporaryBuffer.Allocation.pMappedData == nullptr)
+	{
+		throw std::runtime_error("Upload staging buffer is not persistently mapped!");
+	}
+
+	m_Recording.TemporaryBuffers.push_back(TemporaryBuffer);
+
+	Buffer = TemporaryBuffer.Buffer;
+	Offset = 0;
+	return TemporaryBuffer.Allocation.pMappedData;
+}
+
+void UploadContext::UploadBuffer(
+	const void * pData,
+	VkDeviceSize Size,
+	VkBuffer DstBuffer,
+	VkDeviceSize DstOffset,
+	VkAccessFlags DstAccess,
+	VkPipelineStageFlags DstStage
+)
+{
+	VkBuffer StagingBuffer = VK_NULL_HANDLE;
+	VkDeviceSize StagingOffset = 0;
+	void * pStaging = AllocateStaging(Size, 16, true, StagingBuffer, StagingOffset);
+
+	memcpy(pStaging, pData, static_cast<size_t>(Size));
+
+	CopyStagedBuffer(StagingBuffer, StagingOffset, Size, DstBuffer, DstOffset, DstAccess, DstStage);
+}
+
+void UploadContext::CopyStagedBuffer(
+	VkBuffer StagingBuffer,
+	VkDeviceSize StagingOffset,
+	VkDeviceSize Size,
+	VkBuffer DstBuffer,
+	VkDeviceSize DstOffset,
+	VkAccessFlags DstAccess,
+	VkPipelineStageFlags DstStage
+)
+{
+	BeginBatch();
+
+	VkCommandBuffer CopyCommandBuffer = HasDedicatedTransfer() ? m_Recording.TransferCommandBuffer : m_Recording.GraphicsCommandBuffer;
+
+	VkBufferCopy CopyRegion = {};
+	CopyRegion.srcOffset = StagingOffset;
+	CopyRegion.dstOffset = DstOffset;
+	CopyRegion.size = Size;
+	vkCmdCopyBuffer(CopyCommandBuffer, StagingBuffer, DstBuffer, 1, &CopyRegion);
+
+	VkBufferMemoryBarrier Barrier = {};
+	Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	Barrier.dstAccessMask = DstAccess;
+	Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.buffer = DstBuffer;
+	Barrier.offset = DstOffset;
+	Barrier.size = Size;
+
+	if (HasDedicatedTransfer())
+	{
+		/** Release on the transfer queue, the acquire below must match it exactly */
+		Barrier.srcQueueFamilyIndex = m_TransferFamily;
+		Barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+		Barrier.dstAccessMask = 0;
+
+		vkCmdPipelineBarrier(
+			m_Recording.TransferCommandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			0, nullptr,
+			1, &Barrier,
+			0, nullptr
+		);
+
+		Barrier.srcAccessMask = 0;
+		Barrier.dstAccessMask = DstAccess;
+	}
+
+	vkCmdPipelineBarrier(
+		m_Recording.GraphicsCommandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		DstStage,
+		0,
+		0, nullptr,
+		1, &Barrier,
+		0, nullptr
+	);
+}
+
+void UploadContext::UploadImage(
+	const void * pPixels,
+	VkDeviceSize Size,
+	VkImage Image,
+	VkFormat Format,
+	uint32_t Width,
+	uint32_t Height,
+	uint32_t MipLevels
+)
+{
+	VkBuffer StagingBuffer = VK_NULL_HANDLE;
+	VkDeviceSize StagingOffset = 0;
+	void * pStaging = AllocateStaging(Size, 16, true, StagingBuffer, StagingOffset);
+
+	memcpy(pStaging, pPixels, static_cast<size_t>(Size));
+
+	CopyStagedImage(StagingBuffer, StagingOffset, Image, Format, Width, Height, MipLevels);
+}
+
+void UploadContext::CopyStagedImage(
+	VkBuffer StagingBuffer,
+	VkDeviceSize StagingOffset,
+	VkImage Image,
+	VkFormat Format,
+	uint32_t Width,
+	uint32_t Height,
+	uint32_t MipLevels
+)
+{
+	BeginBatch();
+
+	VkCommandBuffer CopyCommandBuffer = HasDedicatedTransfer() ? m_Recording.TransferCommandBuffer : m_Recording.GraphicsCommandBuffer;
+
+	CmdTransitionImageLayout(
+		CopyCommandBuffer,
+		Image,
+		Format,
+		MipLevels,
+		VK_IMAGE_LAYOUT_UNDEFINED,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+	);
+
+	CmdCopyBufferToImage(CopyCommandBuffer, StagingBuffer, StagingOffset, Image, Width, Height);
+
+	if (HasDedicatedTransfer())
+	{
+		VkImageMemoryBarrier Barrier = {};
+		Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		Barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		Barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		Barrier.srcQueueFamilyIndex = m_TransferFamily;
+		Barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+		Barrier.image = Image;
+		Barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		Barrier.subresourceRange.baseMipLevel = 0;
+		Barrier.subresourceRange.levelCount = MipLevels;
+		Barrier.subresourceRange.baseArrayLayer = 0;
+		Barrier.subresourceRange.layerCount = 1;
+		Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		Barrier.dstAccessMask = 0;
+
+		vkCmdPipelineBarrier(
+			m_Recording.TransferCommandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			0, nullptr,
+			0, nullptr,
+			1, &Barrier
+		);
+
+		/** Acquire, the mipmap blits write the image again so only transfer access is needed */
+		Barrier.srcAccessMask = 0;
+		Barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(
+			m_Recording.GraphicsCommandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0,
+			0, nullptr,
+			0, nullptr,
+			1, &Barrier
+		);
+	}
+
+	CmdGenerateMipmaps(
+		m_PhysicalDevice,
+		m_Recording.GraphicsCommandBuffer,
+		Image,
+		Format,
+		Width,
+		Height,
+		MipLevels
+	);
+}
+
+void UploadContext::CopyStagedImageLevels(
+	VkBuffer StagingBuffer,
+	const std::vector<VkDeviceSize> & LevelOffsets,
+	VkImage Image,
+	VkFormat Format,
+	uint32_t Width,
+	uint32_t Height
+)
+{
+	BeginBatch();
+
+	const uint32_t MipLevels = static_cast<uint32_t>(LevelOffsets.size());
+
+	VkCommandBuffer CopyCommandBuffer = HasDedicatedTransfer() ? m_Recording.TransferCommandBuffer : m_Recording.GraphicsCommandBuffer;
+
+	CmdTransitionImageLayout(
+		CopyCommandBuffer,
+		Image,
+		Format,
+		MipLevels,
+		VK_IMAGE_LAYOUT_UNDEFINED,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+	);
+
+	std::vector<VkBufferImageCopy> Regions(MipLevels);
+	for (uint32_t Level = 0; Level < MipLevels; Level++)
+	{
+		VkBufferImageCopy & Region = Regions[Level];
+		Region = {};
+		Region.bufferOffset = LevelOffsets[Level];
+		Region.bufferRowLength = 0;
+		Region.bufferImageHeight = 0;
+		Region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		Region.imageSubresource.mipLevel = Level;
+		Region.imageSubresource.baseArrayLayer = 0;
+		Region.imageSubresource.layerCount = 1;
+		Region.imageOffset = { 0, 0, 0 };
+		Region.imageExtent = { std::max(Width >> Level, 1u), std::max(Height >> Level, 1u), 1 };
+	}
+
+	vkCmdCopyBufferToImage(
+		CopyCommandBuffer,
+		StagingBuffer,
+		Image,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		MipLevels,
+		Regions.data()
+	);
+
+	if (!HasDedicatedTransfer())
+	{
+		CmdTransitionImageLayout(
+			m_Recording.GraphicsCommandBuffer,
+			Image,
+			Format,
+			MipLevels,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		);
+		return;
+	}
+
+	/** The release and acquire carry the same layout transition, it happens once between them */
+	VkImageMemoryBarrier Barrier = {};
+	Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	Barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	Barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	Barrier.srcQueueFamilyIndex = m_TransferFamily;
+	Barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+	Barrier.image = Image;
+	Barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	Barrier.subresourceRange.baseMipLevel = 0;
+	Barrier.subresourceRange.levelCount = MipLevels;
+	Barrier.subresourceRange.baseArrayLayer = 0;
+	Barrier.subresourceRange.layerCount = 1;
+	Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	Barrier.dstAccessMask = 0;
+
+	vkCmdPipelineBarrier(
+		m_Recording.TransferCommandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0,
+		0, nullptr,
+		0, nullptr,
+		1, &Barrier
+	);
+
+	Barrier.srcAccessMask = 0;
+	Barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	/** Transfer is the stage the graphics submit waits on the semaphore at */
+	vkCmdPipelineBarrier(
+		m_Recording.GraphicsCommandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		0,
+		0, nullptr,
+		0, nullptr,
+		1, &Barrier
+	);
+}
+
+VkCommandBuffer UploadContext::GetGraphicsCommandBuffer()
+{
+	BeginBatch();
+	return m_Recording.GraphicsCommandBuffer;
+}
+
+UploadTicket UploadContext::Submit()
+{
+	if (!m_bRecording)
+	{
+		return m_LastSubmitted;
+	}
+
+	VkFenceCreateInfo FenceCreateInfo = {};
+	FenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	if (vkCreateFence(m_Device, &FenceCreateInfo, nullptr, &m_Recording.Fence) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to create upload fence!");
+	}
+
+	vkEndCommandBuffer(m_Recording.GraphicsCommandBuffer);
+
+	VkSubmitInfo SubmitInfo = {};
+	SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+	if (HasDedicatedTransfer())
+	{
+		vkEndCommandBuffer(m_Recording.TransferCommandBuffer);
+
+		VkSemaphoreCreateInfo SemaphoreCreateInfo = {};
+		SemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		if (vkCreateSemaphore(m_Device, &SemaphoreCreateInfo, nullptr, &m_Recording.OwnershipSemaphore) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create upload semaphore!");
+		}
+
+		SubmitInfo.commandBufferCount = 1;
+		SubmitInfo.pCommandBuffers = &m_Recording.TransferCommandBuffer;
+		SubmitInfo.signalSemaphoreCount = 1;
+		SubmitInfo.pSignalSemaphores = &m_Recording.OwnershipSemaphore;
+
+		if (vkQueueSubmit(m_TransferQueue, 1, &SubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit upload command buffer!");
+		}
+
+		VkPipelineStageFlags WaitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		SubmitInfo = {};
+		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		SubmitInfo.waitSemaphoreCount = 1;
+		SubmitInfo.pWaitSemaphores = &m_Recording.OwnershipSemaphore;
+		SubmitInfo.pWaitDstStageMask = &WaitStage;
+		SubmitInfo.commandBufferCount = 1;
+		SubmitInfo.pCommandBuffers = &m_Recording.GraphicsCommandBuffer;
+
+		if (vkQueueSubmit(m_GraphicsQueue, 1, &SubmitInfo, m_Recording.Fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit upload command buffer!");
+		}
+	}
+	else
+	{
+		SubmitInfo.commandBufferCount = 1;
+		SubmitInfo.pCommandBuffers = &m_Recording.GraphicsCommandBuffer;
+
+		if (vkQueueSubmit(m_GraphicsQueue, 1, &SubmitInfo, m_Recording.Fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit upload command buffer!");
+		}
+	}
+
+	m_LastSubmitted = m_Recording.Ticket;
+	m_SubmitCount++;
+
+	m_InFlight.push_back(std::move(m_Recording));
+	m_Recording = Batch();
+	m_bRecording = false;
+
+	return m_LastSubmitted;
+}
+
+bool UploadContext::IsComplete(
+	UploadTicket Ticket
+)
+{
+	if (Ticket > m_LastSubmitted)
+	{
+		return false;
+	}
+
+	while (!m_InFlight.empty() && vkGetFenceStatus(m_Device, m_InFlight.front().Fence) == VK_SUCCESS)
+	{
+		RetireOldest();
+	}
+
+	return m_InFlight.empty() || m_InFlight.front().Ticket > Ticket;
+}
+
+void UploadContext::Wait(
+	UploadTicket Ticket
+)
+{
+	if (Ticket > m_LastSubmitted)
+	{
+		Submit();
+	}
+
+	while (!m_InFlight.empty() && m_InFlight.front().Ticket <= Ticket)
+	{
+		RetireOldest();
+	}
+}
+
+void UploadContext::Flush()
+{
+	Wait(Submit());
+}
+
+uint32_t UploadContext::GetSubmitCount() const
+{
+	return m_SubmitCount;
+}
+
+void UploadContext::BeginBatch()
+{
+	if (m_bRecording)
+	{
+		return;
+	}
+
+	m_Recording = Batch();
+	m_Recording.Ticket = m_NextTicket++;
+
+	VkCommandBufferAllocateInfo AllocInfo = {};
+	AllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	AllocInfo.commandPool = m_GraphicsCommandPool;
+	AllocInfo.commandBufferCount = 1;
+
+	if (vkAllocateCommandBuffers(m_Device, &AllocInfo, &m_Recording.GraphicsCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate upload command buffer!");
+	}
+
+	VkCommandBufferBeginInfo CmdBeginInfo = {};
+	CmdBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	CmdBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(m_Recording.GraphicsCommandBuffer, &CmdBeginInfo);
+
+	if (HasDedicatedTransfer())
+	{
+		AllocInfo.commandPool = m_TransferCommandPool;
+
+		if (vkAllocateCommandBuffers(m_Device, &AllocInfo, &m_Recording.TransferCommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate upload command buffer!");
+		}
+
+		vkBeginCommandBuffer(m_Recording.TransferCommandBuffer, &CmdBeginInfo);
+	}
+
+	m_bRecording = true;
+}
+
+bool UploadContext::TryAllocateRing(
+	VkDeviceSize Size,
+	VkDeviceSize Alignment,
+	VkDeviceSize & Offset
+)
+{
+	if (m_StagingUsed == 0)
+	{
+		m_StagingHead = 0;
+	}
+
+	VkDeviceSize AlignedHead = (m_StagingHead + Alignment - 1) / Alignment * Alignment;
+	VkDeviceSize Consumed = 0;
+
+	if (AlignedHead + Size <= m_StagingSize)
+	{
+		Offset = AlignedHead;
+		Consumed = AlignedHead - m_StagingHead + Size;
+	}
+	else
+	{
+		/** Wrap around, the tail end of the ring is wasted until this batch retires */
+		Offset = 0;
+		Consumed = m_StagingSize - m_StagingHead + Size;
+	}
+
+	if (m_StagingUsed + Consumed > m_StagingSize)
+	{
+		return false;
+	}
+
+	m_StagingHead = Offset + Size;
+	m_StagingUsed += Consumed;
+	m_Recording.StagingBytes += Consumed;
+
+	return true;
+}
+
+void UploadContext::RetireOldest()
+{
+	Batch & Oldest = m_InFlight.front();
+
+	vkWaitForFences(m_Device, 1, &Oldest.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+	vkDestroyFence(m_Device, Oldest.Fence, nullptr);
+	vkFreeCommandBuffers(m_Device, m_GraphicsCommandPool, 1, &Oldest.GraphicsCommandBuffer);
+
+	if (HasDedicatedTransfer())
+	{
+		vkDestroySemaphore(m_Device, Oldest.OwnershipSemaphore, nullptr);
+		vkFreeCommandBuffers(m_Device, m_TransferCommandPool, 1, &Oldest.TransferCommandBuffer);
+	}
+
+	for (BufferInfo & TemporaryBuffer : Oldest.TemporaryBuffers)
+	{
+		DestroyBuffer(m_Device, *m_pAllocator, TemporaryBuffer);
+	}
+
+	m_StagingUsed -= Oldest.StagingBytes;
+	m_InFlight.pop_front();
+}
+
+bool UploadContext::HasDedicatedTransfer() const
+{
+	return m_TransferQueue != VK_NULL_HANDLE && m_TransferFamily != m_GraphicsFamily;
+}
+
+NAMESPACE_END
@@ -0,0 +1,181 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "Namespace.hpp"
+#include "VulkanHelper.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** Identifies a batch of uploads, tickets increase monotonically. */
+using UploadTicket = uint64_t;
+
+/**
+* Records buffer/image uploads into a shared command buffer fed from a persistently
+* mapped staging ring, and submits the whole batch at once with a fence. When a dedicated
+* transfer family is given the copies run on it and the resources are handed over to the
+* graphics family with queue ownership transfers, mipmap generation stays on graphics.
+*/
+class UploadContext
+{
+public:
+	void Init(
+		VkPhysicalDevice PhysicalDevice,
+		VkDevice Device,
+		MemoryAllocator & Allocator,
+		uint32_t GraphicsFamily,
+		VkQueue GraphicsQueue,
+		uint32_t TransferFamily,
+		VkQueue TransferQueue,
+		VkDeviceSize StagingSize
+	);
+
+	void Destroy();
+
+	/**
+	* Reserve staging memory for the current batch. If the ring is full the pending batch is
+	* submitted and older batches are retired when bAllowFlush is set, otherwise (or if the
+	* request is larger than the ring) a temporary staging buffer is created.
+	*/
+	void * AllocateStaging(
+		VkDeviceSize Size,
+		VkDeviceSize Alignment,
+		bool bAllowFlush,
+		VkBuffer & Buffer,
+		VkDeviceSize & Offset
+	);
+
+	void UploadBuffer(
+		const void * pData,
+		VkDeviceSize Size,
+		VkBuffer DstBuffer,
+		VkDeviceSize DstOffset,
+		VkAccessFlags DstAccess,
+		VkPipelineStageFlags DstStage
+	);
+
+	/** Copy already staged data into a buffer. */
+	void CopyStagedBuffer(
+		VkBuffer StagingBuffer,
+		VkDeviceSize StagingOffset,
+		VkDeviceSize Size,
+		VkBuffer DstBuffer,
+		VkDeviceSize DstOffset,
+		VkAccessFlags DstAccess,
+		VkPipelineStageFlags DstStage
+	);
+
+	/** Upload the base level and generate the rest of the chain, leaves the image shader readable. */
+	void UploadImage(
+		const void * pPixels,
+		VkDeviceSize Size,
+		VkImage Image,
+		VkFormat Format,
+		uint32_t Width,
+		uint32_t Height,
+		uint32_t MipLevels
+	);
+
+	/** Same as UploadImage() for pixels that were already written to staging memory. */
+	void CopyStagedImage(
+		VkBuffer StagingBuffer,
+		VkDeviceSize StagingOffset,
+		VkImage Image,
+		VkFormat Format,
+		uint32_t Width,
+		uint32_t Height,
+		uint32_t MipLevels
+	);
+
+	/**
+	* Copy a complete, already staged mip chain with a single copy command, one region per level
+	* at LevelOffsets[Level] in StagingBuffer. Works for block compressed formats since nothing is
+	* blitted, leaves the image shader readable.
+	*/
+	void CopyStagedImageLevels(
+		VkBuffer StagingBuffer,
+		const std::vector<VkDeviceSize> & LevelOffsets,
+		VkImage Image,
+		VkFormat Format,
+		uint32_t Width,
+		uint32_t Height
+	);
+
+	/** Command buffer on the graphics family that is submitted with the current batch. */
+	VkCommandBuffer GetGraphicsCommandBuffer();
+
+	/** Submit the current batch, returns the ticket of the last submitted batch if it is empty. */
+	UploadTicket Submit();
+
+	bool IsComplete(
+		UploadTicket Ticket
+	);
+
+	void Wait(
+		UploadTicket Ticket
+	);
+
+	/** Submit and wait for everything recorded so far. */
+	void Flush();
+
+	uint32_t GetSubmitCount() const;
+
+protected:
+	struct Batch
+	{
+		UploadTicket Ticket = 0;
+		VkCommandBuffer TransferCommandBuffer = VK_NULL_HANDLE;
+		VkCommandBuffer GraphicsCommandBuffer = VK_NULL_HANDLE;
+		VkSemaphore OwnershipSemaphore = VK_NULL_HANDLE;
+		VkFence Fence = VK_NULL_HANDLE;
+		VkDeviceSize StagingBytes = 0;
+		std::vector<BufferInfo> TemporaryBuffers;
+	};
+
+	void BeginBatch();
+
+	bool TryAllocateRing(
+		VkDeviceSize Size,
+		VkDeviceSize Alignment,
+		VkDeviceSize & Offset
+	);
+
+	void RetireOldest();
+
+	bool HasDedicatedTransfer() const;
+
+protected:
+	VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
+	VkDevice m_Device = VK_NULL_HANDLE;
+	MemoryAllocator * m_pAllocator = nullptr;
+
+	uint32_t m_GraphicsFamily = 0;
+	uint32_t m_TransferFamily = 0;
+	VkQueue m_GraphicsQueue = VK_NULL_HANDLE;
+	VkQueue m_TransferQueue = VK_NULL_HANDLE;
+	VkCommandPool m_GraphicsCommandPool = VK_NULL_HANDLE;
+	VkCommandPool m_TransferCommandPool = VK_NULL_HANDLE;
+
+	BufferInfo m_StagingBuffer;
+	VkDeviceSize m_StagingSize = 0;
+	VkDeviceSize m_StagingHead = 0;
+	/** Bytes held by the recording and in flight batches, including the waste left when wrapping. */
+	VkDeviceSize m_StagingUsed = 0;
+
+	Batch m_Recording;
+	bool m_bRecording = false;
+	std::deque<Batch> m_InFlight;
+
+	UploadTicket m_NextTicket = 1;
+	UploadTicket m_LastSubmitted = 0;
+	uint32_t m_SubmitCount = 0;
+};
+
+NAMESPACE_END
@@ -0,0 +1,409 @@
+#include "VertexFormat.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <cstring>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+uint32_t GetPositionSize(VertexPositionFormat Format)
+{
+	return Format == VERTEX_POSITION_UNORM16 ? 8 : 12;
+}
+
+uint32_t GetDirectionSize(VertexDirectionFormat Format)
+{
+	return Format == VERTEX_DIRECTION_FLOAT32 ? 12 : 4;
+}
+
+uint32_t GetTexCoordSize(VertexTexCoordFormat Format)
+{
+	return Format == VERTEX_TEXCOORD_FLOAT32 ? 8 : 4;
+}
+
+/** Color is white for every imported model, 8 bits are lossless for it */
+const uint32_t s_ColorSize = 4;
+
+/** The stream holding everything but the position */
+uint32_t GetAttributeStream(const VertexFormat & Format)
+{
+	return Format.Layout == VERTEX_LAYOUT_SPLIT_POSITIONS ? 1 : 0;
+}
+
+/** Where the color starts inside the attribute stream */
+uint32_t GetAttributeOffset(const VertexFormat & Format)
+{
+	return Format.Layout == VERTEX_LAYOUT_SPLIT_POSITIONS ? 0 : GetPositionSize(Format.Position);
+}
+
+glm::vec3 DecodeOctahedral(
+	const glm::vec2 & Encoded
+)
+{
+	glm::vec3 Direction(Encoded.x, Encoded.y, 1.0f - std::abs(Encoded.x) - std::abs(Encoded.y));
+	float Fold = glm::max(-Direction.z, 0.0f);
+	Direction.x += Direction.x >= 0.0f ? -Fold : Fold;
+	Direction.y += Direction.y >= 0.0f ? -Fold : Fold;
+	return glm::normalize(Direction);
+}
+
+float DecodeSnorm16(int16_t Value)
+{
+	return glm::max(static_cast<float>(Value) / 32767.0f, -1.0f);
+}
+
+/** Projects onto the octahedron and unfolds the lower half, then picks the best of the four neighbouring snorm16 codes. */
+void EncodeOctahedralSnorm16(
+	const glm::vec3 & Direction,
+	int16_t * pDst
+)
+{
+	float Length = std::abs(Direction.x) + std::abs(Direction.y) + std::abs(Direction.z);
+	if (Length == 0.0f)
+	{
+		pDst[0] = pDst[1] = 0;
+		return;
+	}
+
+	glm::vec3 Normalized = glm::normalize(Direction);
+	glm::vec2 Encoded = glm::vec2(Direction.x, Direction.y) / Length;
+
+	if (Direction.z < 0.0f)
+	{
+		glm::vec2 Sign(Encoded.x >= 0.0f ? 1.0f : -1.0f, Encoded.y >= 0.0f ? 1.0f : -1.0f);
+		Encoded = (glm::vec2(1.0f) - glm::abs(glm::vec2(Encoded.y, Encoded.x))) * Sign;
+	}
+
+	glm::vec2 Scaled = glm::clamp(Encoded, -1.0f, 1.0f) * 32767.0f;
+	glm::vec2 Floor = glm::floor(Scaled);
+
+	float BestDot = -2.0f;
+	for (int i = 0; i < 4; i++)
+	{
+		int16_t X = static_cast<int16_t>(glm::clamp(Floor.x + (i & 1), -32767.0f, 32767.0f));
+		int16_t Y = static_cast<int16_t>(glm::clamp(Floor.y + (i >> 1), -32767.0f, 32767.0f));
+
+		float Dot = glm::dot(DecodeOctahedral(glm::vec2(DecodeSnorm16(X), DecodeSnorm16(Y))), Normalized);
+		if (Dot > BestDot)
+		{
+			BestDot = Dot;
+			pDst[0] = X;
+			pDst[1] = Y;
+		}
+	}
+}
+
+uint16_t QuantizeUnorm16(float Value)
+{
+	return static_cast<uint16_t>(glm::round(glm::clamp(Value, 0.0f, 1.0f) * 65535.0f));
+}
+
+uint32_t QuantizeUnorm10(float Value)
+{
+	return static_cast<uint32_t>(glm::round(glm::clamp(Value, 0.0f, 1.0f) * 1023.0f));
+}
+
+void PackDirection(
+	VertexDirectionFormat Format,
+	const glm::vec3 & Direction,
+	uint8_t * pDst
+)
+{
+	switch (Format)
+	{
+	case VERTEX_DIRECTION_OCT_SNORM16:
+	{
+		int16_t Encoded[2];
+		EncodeOctahedralSnorm16(Direction, Encoded);
+		memcpy(pDst, Encoded, sizeof(Encoded));
+		break;
+	}
+	case VERTEX_DIRECTION_UNORM10:
+	{
+		glm::vec3 Mapped = glm::length(Direction) > 0.0f ? glm::normalize(Direction) * 0.5f + 0.5f : glm::vec3(0.5f);
+		uint32_t Packed = QuantizeUnorm10(Mapped.x) | (QuantizeUnorm10(Mapped.y) << 10) | (QuantizeUnorm10(Mapped.z) << 20);
+		memcpy(pDst, &Packed, sizeof(Packed));
+		break;
+	}
+	default:
+		memcpy(pDst, &Direction, sizeof(glm::vec3));
+		break;
+	}
+}
+
+glm::vec3 UnpackDirection(
+	VertexDirectionFormat Format,
+	const uint8_t * pSrc
+)
+{
+	switch (Format)
+	{
+	case VERTEX_DIRECTION_OCT_SNORM16:
+	{
+		int16_t Encoded[2];
+		memcpy(Encoded, pSrc, sizeof(Encoded));
+		return DecodeOctahedral(glm::vec2(DecodeSnorm16(Encoded[0]), DecodeSnorm16(Encoded[1])));
+	}
+	case VERTEX_DIRECTION_UNORM10:
+	{
+		uint32_t Packed;
+		memcpy(&Packed, pSrc, sizeof(Packed));
+		glm::vec3 Mapped(
+			static_cast<float>(Packed & 0x3FF) / 1023.0f,
+			static_cast<float>((Packed >> 10) & 0x3FF) / 1023.0f,
+			static_cast<float>((Packed >> 20) & 0x3FF) / 1023.0f
+		);
+		return glm::normalize(Mapped * 2.0f - 1.0f);
+	}
+	default:
+	{
+		glm::vec3 Direction;
+		memcpy(&Direction, pSrc, sizeof(glm::vec3));
+		return Direction;
+	}
+	}
+}
+
+}
+
+uint32_t GetVertexStride(
+	const VertexFormat & Format
+)
+{
+	return GetPositionSize(Format.Position) + s_ColorSize + 2 * GetDirectionSize(Format.Direction) + GetTexCoordSize(Format.TexCoord);
+}
+
+uint32_t GetVertexStreamCount(
+	const VertexFormat & Format
+)
+{
+	return GetAttributeStream(Format) + 1;
+}
+
+uint32_t GetVertexStreamStride(
+	const VertexFormat & Format,
+	uint32_t Stream
+)
+{
+	if (Format.Layout == VERTEX_LAYOUT_INTERLEAVED)
+	{
+		return GetVertexStride(Format);
+	}
+
+	return Stream == 0 ? GetPositionSize(Format.Position) : GetVertexStride(Format) - GetPositionSize(Format.Position);
+}
+
+std::vector<VkVertexInputBindingDescription> GetVertexBindingDescriptions(
+	const VertexFormat & Format
+)
+{
+	std::vector<VkVertexInputBindingDescription> BindingDescriptions(GetVertexStreamCount(Format));
+
+	for (uint32_t i = 0; i < BindingDescriptions.size(); i++)
+	{
+		BindingDescriptions[i].binding = i;
+		BindingDescriptions[i].stride = GetVertexStreamStride(Format, i);
+		BindingDescriptions[i].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	}
+
+	return BindingDescriptions;
+}
+
+std::array<VkVertexInputAttributeDescription, 5> GetVertexAttributeDescriptions(
+	const VertexFormat & Format
+)
+{
+	std::array<VkVertexInputAttributeDescription, 5> AttributeDescriptions = {};
+
+	VkFormat DirectionFormat =
+		Format.Direction == VERTEX_DIRECTION_OCT_SNORM16 ? VK_FORMAT_R16G16_SNORM :
+		Format.Direction == VERTEX_DIRECTION_UNORM10 ? VK_FORMAT_A2B10G10R10_UNORM_PACK32 :
+		VK_FORMAT_R32G32B32_SFLOAT;
+
+	VkFormat TexCoordFormat =
+		Format.TexCoord == VERTEX_TEXCOORD_HALF ? VK_FORMAT_R16G16_SFLOAT :
+		Format.TexCoord == VERTEX_TEXCOORD_UNORM16 ? VK_FORMAT_R16G16_UNORM :
+		VK_FORMAT_R32G32_SFLOAT;
+
+	AttributeDescriptions[0].format = Format.Position == VERTEX_POSITION_UNORM16 ? VK_FORMAT_R16G16B16A16_UNORM : VK_FORMAT_R32G32B32_SFLOAT;
+	AttributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+	AttributeDescriptions[2].format = DirectionFormat;
+	AttributeDescriptions[3].format = DirectionFormat;
+	AttributeDescriptions[4].format = TexCoordFormat;
+
+	uint32_t Sizes[] =
+	{
+		GetPositionSize(Format.Position),
+		s_ColorSize,
+		GetDirectionSize(Format.Direction),
+		GetDirectionSize(Format.Direction),
+		GetTexCoordSize(Format.TexCoord)
+	};
+
+	AttributeDescriptions[0].binding = 0;
+	AttributeDescriptions[0].location = 0;
+	AttributeDescriptions[0].offset = 0;
+
+	uint32_t Offset = GetAttributeOffset(Format);
+	for (uint32_t i = 1; i < AttributeDescriptions.size(); i++)
+	{
+		AttributeDescriptions[i].binding = GetAttributeStream(Format);
+		AttributeDescriptions[i].location = i;
+		AttributeDescriptions[i].offset = Offset;
+		Offset += Sizes[i];
+	}
+
+	return AttributeDescriptions;
+}
+
+std::array<int32_t, 3> GetVertexSpecializationConstants(
+	const VertexFormat & Format
+)
+{
+	return
+	{
+		static_cast<int32_t>(Format.Position),
+		static_cast<int32_t>(Format.Direction),
+		static_cast<int32_t>(Format.TexCoord)
+	};
+}
+
+VertexDequantization ComputeVertexDequantization(
+	const glm::vec3 & PositionMin,
+	const glm::vec3 & PositionMax,
+	const glm::vec2 & TexCoordMin,
+	const glm::vec2 & TexCoordMax
+)
+{
+	VertexDequantization Dequantization;
+
+	glm::vec3 PositionExtent = PositionMax - PositionMin;
+	glm::vec2 TexCoordExtent = TexCoordMax - TexCoordMin;
+
+	for (int i = 0; i < 3; i++)
+	{
+		Dequantization.PositionScale[i] = PositionExtent[i] > 0.0f ? PositionExtent[i] : 1.0f;
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		Dequantization.TexCoordScale[i] = TexCoordExtent[i] > 0.0f ? TexCoordExtent[i] : 1.0f;
+	}
+
+	Dequantization.PositionOffset = PositionMin;
+	Dequantization.TexCoordOffset = TexCoordMin;
+
+	return Dequantization;
+}
+
+void PackVertex(
+	const VertexFormat & Format,
+	const VertexDequantization & Dequantization,
+	const glm::vec3 & Position,
+	const glm::vec3 & Color,
+	const glm::vec3 & Normal,
+	const glm::vec3 & Tangent,
+	const glm::vec2 & TexCoord,
+	size_t Index,
+	uint8_t * const * ppStreams
+)
+{
+	uint8_t * pDst = ppStreams[0] + Index * GetVertexStreamStride(Format, 0);
+
+	if (Format.Position == VERTEX_POSITION_UNORM16)
+	{
+		glm::vec3 Normalized = (Position - Dequantization.PositionOffset) / Dequantization.PositionScale;
+		uint16_t Packed[4] = { QuantizeUnorm16(Normalized.x), QuantizeUnorm16(Normalized.y), QuantizeUnorm16(Normalized.z), 65535 };
+		memcpy(pDst, Packed, sizeof(Packed));
+	}
+	else
+	{
+		memcpy(pDst, &Position, sizeof(glm::vec3));
+	}
+
+	const uint32_t AttributeStream = GetAttributeStream(Format);
+	pDst = ppStreams[AttributeStream] + Index * GetVertexStreamStride(Format, AttributeStream) + GetAttributeOffset(Format);
+
+	uint32_t PackedColor = glm::packUnorm4x8(glm::vec4(Color, 1.0f));
+	memcpy(pDst, &PackedColor, sizeof(PackedColor));
+	pDst += s_ColorSize;
+
+	PackDirection(Format.Direction, Normal, pDst);
+	pDst += GetDirectionSize(Format.Direction);
+
+	PackDirection(Format.Direction, Tangent, pDst);
+	pDst += GetDirectionSize(Format.Direction);
+
+	if (Format.TexCoord == VERTEX_TEXCOORD_HALF)
+	{
+		uint16_t Packed[2] = { glm::packHalf1x16(TexCoord.x), glm::packHalf1x16(TexCoord.y) };
+		memcpy(pDst, Packed, sizeof(Packed));
+	}
+	else if (Format.TexCoord == VERTEX_TEXCOORD_UNORM16)
+	{
+		glm::vec2 Normalized = (TexCoord - Dequantization.TexCoordOffset) / Dequantization.TexCoordScale;
+		uint16_t Packed[2] = { QuantizeUnorm16(Normalized.x), QuantizeUnorm16(Normalized.y) };
+		memcpy(pDst, Packed, sizeof(Packed));
+	}
+	else
+	{
+		memcpy(pDst, &TexCoord, sizeof(glm::vec2));
+	}
+}
+
+void UnpackVertex(
+	const VertexFormat & Format,
+	const VertexDequantization & Dequantization,
+	size_t Index,
+	const uint8_t * const * ppStreams,
+	glm::vec3 & Position,
+	glm::vec3 & Normal,
+	glm::vec3 & Tangent,
+	glm::vec2 & TexCoord
+)
+{
+	const uint8_t * pSrc = ppStreams[0] + Index * GetVertexStreamStride(Format, 0);
+
+	if (Format.Position == VERTEX_POSITION_UNORM16)
+	{
+		uint16_t Packed[4];
+		memcpy(Packed, pSrc, sizeof(Packed));
+		glm::vec3 Normalized(Packed[0] / 65535.0f, Packed[1] / 65535.0f, Packed[2] / 65535.0f);
+		Position = Dequantization.PositionOffset + Dequantization.PositionScale * Normalized;
+	}
+	else
+	{
+		memcpy(&Position, pSrc, sizeof(glm::vec3));
+	}
+
+	const uint32_t AttributeStream = GetAttributeStream(Format);
+	pSrc = ppStreams[AttributeStream] + Index * GetVertexStreamStride(Format, AttributeStream) + GetAttributeOffset(Format) + s_ColorSize;
+
+	Normal = UnpackDirection(Format.Direction, pSrc);
+	pSrc += GetDirectionSize(Format.Direction);
+
+	Tangent = UnpackDirection(Format.Direction, pSrc);
+	pSrc += GetDirectionSize(Format.Direction);
+
+	if (Format.TexCoord == VERTEX_TEXCOORD_HALF)
+	{
+		uint16_t Packed[2];
+		memcpy(Packed, pSrc, sizeof(Packed));
+		TexCoord = glm::vec2(glm::unpackHalf1x16(Packed[0]), glm::unpackHalf1x16(Packed[1]));
+	}
+	else if (Format.TexCoord == VERTEX_TEXCOORD_UNORM16)
+	{
+		uint16_t Packed[2];
+		memcpy(Packed, pSrc, sizeof(Packed));
+		TexCoord = Dequantization.TexCoordOffset + Dequantization.TexCoordScale * glm::vec2(Packed[0] / 65535.0f, Packed[1] / 65535.0f);
+	}
+	else
+	{
+		memcpy(&TexCoord, pSrc, sizeof(glm::vec2));
+	}
+}
+
+NAMESPACE_END
@@ -0,0 +1,280 @@
+#pragma once
+
+#ifndef GLFW_INCLUDE_VULKAN
+#define GLFW_INCLUDE_VULKAN
+#endif
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+/** The values double as the specialization constants of the vertex shader, keep them in sync with Shader.vert. */
+enum VertexPositionFormat
+{
+	VERTEX_POSITION_FLOAT32 = 0,
+	/** Quantized to the mesh bounds, see VertexDequantization */
+	VERTEX_POSITION_UNORM16 = 1
+};
+
+/** Used for both normals and tangents. */
+enum VertexDirectionFormat
+{
+	VERTEX_DIRECTION_FLOAT32 = 0,
+	/** Octahedral encoding in two snorm16 */
+	VERTEX_DIRECTION_OCT_SNORM16 = 1,
+	/** xyz mapped to [0, 1] in A2B10G10R10 unorm */
+	VERTEX_DIRECTION_UNORM10 = 2
+};
+
+enum VertexTexCoordFormat
+{
+	VERTEX_TEXCOORD_FLOAT32 = 0,
+	VERTEX_TEXCOORD_HALF = 1,
+	/** Quantized to the texture coordinate bounds, see VertexDequantization */
+	VERTEX_TEXCOORD_UNORM16 = 2
+};
+
+/** How the attributes are spread over vertex buffer bindings. */
+enum VertexLayout
+{
+	/** Everything in stream 0 */
+	VERTEX_LAYOUT_INTERLEAVED = 0,
+	/** Positions alone in stream 0, the other attributes in stream 1, so depth only passes fetch only positions */
+	VERTEX_LAYOUT_SPLIT_POSITIONS = 1
+};
+
+/** Layout of the GPU vertex buffer, the CPU side always keeps full floats. */
+struct VertexFormat
+{
+	VertexPositionFormat Position = VERTEX_POSITION_UNORM16;
+	VertexDirectionFormat Direction = VERTEX_DIRECTION_OCT_SNORM16;
+	VertexTexCoordFormat TexCoord = VERTEX_TEXCOORD_HALF;
+	VertexLayout Layout = VERTEX_LAYOUT_SPLIT_POSITIONS;
+};
+
+/** Per mesh transform from quantized to object space values: Value = Offset + Scale * Quantized. */
+struct VertexDequantization
+{
+	glm::vec3 PositionScale = glm::vec3(1.0f);
+	glm::vec3 PositionOffset = glm::vec3(0.0f);
+	glm::vec2 TexCoordScale = glm::vec2(1.0f);
+	glm::vec2 TexCoordOffset = glm::vec2(0.0f);
+};
+
+/** Vertices [First, First + Count), quantized with one VertexDequantization. */
+struct VertexRange
+{
+	size_t First = 0;
+	size_t Count = 0;
+};
+
+/** Largest difference between the float attributes and what the shader decodes from the packed ones. */
+struct VertexQuantizationError
+{
+	float Position = 0.0f;
+	/** In degrees */
+	float NormalAngle = 0.0f;
+	float TangentAngle = 0.0f;
+	float TexCoord = 0.0f;
+};
+
+/** Bytes of one vertex summed over all streams. */
+uint32_t GetVertexStride(
+	const VertexFormat & Format
+);
+
+/** Stream i is bound to binding i. */
+uint32_t GetVertexStreamCount(
+	const VertexFormat & Format
+);
+
+/** Stream 0 always starts with the position, a position only pass binds nothing else. */
+uint32_t GetVertexStreamStride(
+	const VertexFormat & Format,
+	uint32_t Stream
+);
+
+std::vector<VkVertexInputBindingDescription> GetVertexBindingDescriptions(
+	const VertexFormat & Format
+);
+
+/** Locations 0 to 4 are Position, Color, Normal, Tangent and TexCoord, each on the binding of its stream. */
+std::array<VkVertexInputAttributeDescription, 5> GetVertexAttributeDescriptions(
+	const VertexFormat & Format
+);
+
+/** Values for the vertex shader specialization constants 0 to 2. */
+std::array<int32_t, 3> GetVertexSpecializationConstants(
+	const VertexFormat & Format
+);
+
+/** Quantization ranges covering every vertex, degenerate axes get a scale of one. */
+VertexDequantization ComputeVertexDequantization(
+	const glm::vec3 & PositionMin,
+	const glm::vec3 & PositionMax,
+	const glm::vec2 & TexCoordMin,
+	const glm::vec2 & TexCoordMax
+);
+
+/** Writes vertex Index into every stream, Streams must hold GetVertexStreamCount(Format) buffers large enough for it. */
+void PackVertex(
+	const VertexFormat & Format,
+	const VertexDequantization & Dequantization,
+	const glm::vec3 & Position,
+	const glm::vec3 & Color,
+	const glm::vec3 & Normal,
+	const glm::vec3 & Tangent,
+	const glm::vec2 & TexCoord,
+	size_t Index,
+	uint8_t * const * ppStreams
+);
+
+/** Decodes vertex Index exactly like the vertex shader does, Color is not returned. */
+void UnpackVertex(
+	const VertexFormat & Format,
+	const VertexDequantization & Dequantization,
+	size_t Index,
+	const uint8_t * const * ppStreams,
+	glm::vec3 & Position,
+	glm::vec3 & Normal,
+	glm::vec3 & Tangent,
+	glm::vec2 & TexCoord
+);
+
+/**
+* TVertex needs Position, Color, Normal, Tangent and TexCoord members, Streams receives one buffer per stream.
+* Every range is quantized to its own bounds, so the precision of a mesh does not depend on what else
+* shares the buffer. Returns one VertexDequantization per range, vertices outside every range stay zero.
+*/
+template <typename TVertex>
+std::vector<VertexDequantization> PackVertices(
+	const VertexFormat & Format,
+	const std::vector<TVertex> & Vertices,
+	const std::vector<VertexRange> & Ranges,
+	std::vector<std::vector<uint8_t>> & Streams
+)
+{
+	Streams.resize(GetVertexStreamCount(Format));
+	std::array<uint8_t *, 2> StreamData = {};
+
+	for (uint32_t i = 0; i < Streams.size(); i++)
+	{
+		Streams[i].assign(Vertices.size() * GetVertexStreamStride(Format, i), 0);
+		StreamData[i] = Streams[i].data();
+	}
+
+	std::vector<VertexDequantization> Dequantizations(Ranges.size());
+
+	for (size_t r = 0; r < Ranges.size(); r++)
+	{
+		const size_t First = Ranges[r].First;
+		const size_t Last = First + Ranges[r].Count;
+
+		glm::vec3 PositionMin(0.0f), PositionMax(0.0f);
+		glm::vec2 TexCoordMin(0.0f), TexCoordMax(0.0f);
+
+		if (First < Last)
+		{
+			PositionMin = PositionMax = Vertices[First].Position;
+			TexCoordMin = TexCoordMax = Vertices[First].TexCoord;
+		}
+
+		for (size_t i = First; i < Last; i++)
+		{
+			PositionMin = glm::min(PositionMin, Vertices[i].Position);
+			PositionMax = glm::max(PositionMax, Vertices[i].Position);
+			TexCoordMin = glm::min(TexCoordMin, Vertices[i].TexCoord);
+			TexCoordMax = glm::max(TexCoordMax, Vertices[i].TexCoord);
+		}
+
+		Dequantizations[r] = ComputeVertexDequantization(PositionMin, PositionMax, TexCoordMin, TexCoordMax);
+
+		for (size_t i = First; i < Last; i++)
+		{
+			const TVertex & Vertex = Vertices[i];
+			PackVertex(
+				Format, Dequantizations[r],
+				Vertex.Position, Vertex.Color, Vertex.Normal, Vertex.Tangent, Vertex.TexCoord,
+				i, StreamData.data()
+			);
+		}
+	}
+
+	return Dequantizations;
+}
+
+/** All vertices as one range. */
+template <typename TVertex>
+VertexDequantization PackVertices(
+	const VertexFormat & Format,
+	const std::vector<TVertex> & Vertices,
+	std::vector<std::vector<uint8_t>> & Streams
+)
+{
+	return PackVertices(Format, Vertices, { VertexRange{ 0, Vertices.size() } }, Streams)[0];
+}
+
+/** Each range is decoded with the VertexDequantization of the same index, the largest error over all of them is returned. */
+template <typename TVertex>
+VertexQuantizationError MeasureVertexQuantizationError(
+	const VertexFormat & Format,
+	const std::vector<VertexDequantization> & Dequantizations,
+	const std::vector<VertexRange> & Ranges,
+	const std::vector<TVertex> & Vertices,
+	const std::vector<std::vector<uint8_t>> & Streams
+)
+{
+	VertexQuantizationError Error;
+
+	std::array<const uint8_t *, 2> StreamData = {};
+	for (uint32_t i = 0; i < Streams.size() && i < StreamData.size(); i++)
+	{
+		StreamData[i] = Streams[i].data();
+	}
+
+	auto AngleBetween = [](const glm::vec3 & Lhs, const glm::vec3 & Rhs)
+	{
+		/** atan2 stays accurate for tiny angles where acos of the dot product does not */
+		return glm::degrees(std::atan2(glm::length(glm::cross(Lhs, Rhs)), glm::dot(Lhs, Rhs)));
+	};
+
+	for (size_t r = 0; r < Ranges.size(); r++)
+	{
+		for (size_t i = Ranges[r].First; i < Ranges[r].First + Ranges[r].Count; i++)
+		{
+			glm::vec3 Position, Normal, Tangent;
+			glm::vec2 TexCoord;
+			UnpackVertex(Format, Dequantizations[r], i, StreamData.data(), Position, Normal, Tangent, TexCoord);
+
+			const TVertex & Vertex = Vertices[i];
+			Error.Position = glm::max(Error.Position, glm::length(Position - Vertex.Position));
+			Error.NormalAngle = glm::max(Error.NormalAngle, AngleBetween(Normal, Vertex.Normal));
+			Error.TangentAngle = glm::max(Error.TangentAngle, AngleBetween(Tangent, Vertex.Tangent));
+			Error.TexCoord = glm::max(Error.TexCoord, glm::length(TexCoord - Vertex.TexCoord));
+		}
+	}
+
+	return Error;
+}
+
+template <typename TVertex>
+VertexQuantizationError MeasureVertexQuantizationError(
+	const VertexFormat & Format,
+	const VertexDequantization & Dequantization,
+	const std::vector<TVertex> & Vertices,
+	const std::vector<std::vector<uint8_t>> & Streams
+)
+{
+	return MeasureVertexQuantizationError(Format, { Dequantization }, { VertexRange{ 0, Vertices.size() } }, Vertices, Streams);
+}
+
+NAMESPACE_END
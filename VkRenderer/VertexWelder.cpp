@@ -0,0 +1,337 @@
+#include "VertexWelder.hpp"
+#include "Hash.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+namespace
+{
+
+/** 128 byte vertices, far more than any format here uses */
+const size_t s_MaxVertexFloats = 32;
+
+/** Resolution of the histogram the slab boundaries are placed on */
+const uint32_t s_PartitionBins = 1024;
+
+const uint32_t s_EmptySlot = UINT32_MAX;
+
+struct WeldSlot
+{
+	uint32_t Vertex;
+	/** Upper half of the hash, most mismatches are rejected without building the other key */
+	uint32_t Tag;
+};
+
+struct WeldInput
+{
+	const uint8_t * pVertices;
+	size_t VertexStride;
+	size_t FloatCount;
+	/** Zero compares the exact values */
+	float InverseEpsilon;
+};
+
+/**
+* The values that are compared: the float with -0 turned into +0 so they weld, or the index of the
+* nearest grid line if snapping, both stored as float bits so equal keys are equal bytes.
+*/
+void MakeWeldKey(
+	const WeldInput & Input,
+	size_t Vertex,
+	float * pKey
+)
+{
+	const uint8_t * pVertex = Input.pVertices + Vertex * Input.VertexStride;
+	memcpy(pKey, pVertex, Input.FloatCount * sizeof(float));
+
+	if (Input.InverseEpsilon > 0.0f)
+	{
+		for (size_t i = 0; i < Input.FloatCount; i++)
+		{
+			pKey[i] = std::floor(pKey[i] * Input.InverseEpsilon + 0.5f) + 0.0f;
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < Input.FloatCount; i++)
+		{
+			pKey[i] = pKey[i] + 0.0f;
+		}
+	}
+}
+
+/** Splits [0, Count) into RangeCount contiguous ranges and runs them on the pool, or inline without one */
+void ForEachRange(
+	ThreadPool * pPool,
+	size_t Count,
+	uint32_t RangeCount,
+	const std::function<void(uint32_t, size_t, size_t)> & Task
+)
+{
+	auto RunRange = [&](uint32_t Range)
+	{
+		Task(Range, Count * Range / RangeCount, Count * (Range + 1) / RangeCount);
+	};
+
+	if (pPool && RangeCount > 1)
+	{
+		pPool->ParallelFor(RangeCount, RunRange);
+	}
+	else
+	{
+		for (uint32_t Range = 0; Range < RangeCount; Range++)
+		{
+			RunRange(Range);
+		}
+	}
+}
+
+/** Points every vertex of the list at the first vertex of the list with the same key, the list must be ascending */
+void WeldPartition(
+	const WeldInput & Input,
+	const uint32_t * pVertices,
+	size_t Count,
+	uint32_t * pRepresentatives
+)
+{
+	size_t TableSize = 16;
+	while (TableSize < Count * 2)
+	{
+		TableSize *= 2;
+	}
+	const size_t TableMask = TableSize - 1;
+
+	std::vector<WeldSlot> Table(TableSize, WeldSlot{ s_EmptySlot, 0 });
+
+	float Key[s_MaxVertexFloats], OtherKey[s_MaxVertexFloats];
+	const size_t KeySize = Input.FloatCount * sizeof(float);
+
+	for (size_t i = 0; i < Count; i++)
+	{
+		const uint32_t Vertex = pVertices[i];
+		MakeWeldKey(Input, Vertex, Key);
+
+		const uint64_t Hash = HashBytes(Key, KeySize);
+		const uint32_t Tag = static_cast<uint32_t>(Hash >> 32);
+
+		size_t Slot = static_cast<size_t>(Hash) & TableMask;
+
+		while (true)
+		{
+			WeldSlot & Entry = Table[Slot];
+
+			if (Entry.Vertex == s_EmptySlot)
+			{
+				Entry.Vertex = Vertex;
+				Entry.Tag = Tag;
+				pRepresentatives[Vertex] = Vertex;
+				break;
+			}
+
+			if (Entry.Tag == Tag)
+			{
+				MakeWeldKey(Input, Entry.Vertex, OtherKey);
+				if (memcmp(Key, OtherKey, KeySize) == 0)
+				{
+					pRepresentatives[Vertex] = Entry.Vertex;
+					break;
+				}
+			}
+
+			Slot = (Slot + 1) & TableMask;
+		}
+	}
+}
+
+}
+
+float VertexWeldStatistics::GetDuplicateRatio() const
+{
+	return VerticesBefore == 0 ? 0.0f : static_cast<float>(VerticesBefore - VerticesAfter) / VerticesBefore;
+}
+
+size_t WeldVertices(
+	const void * pVertices,
+	size_t VertexStride,
+	size_t VertexCount,
+	std::vector<uint32_t> & Remap,
+	float SnapEpsilon,
+	ThreadPool * pPool,
+	VertexWeldStatistics * pStatistics
+)
+{
+	if (VertexStride % sizeof(float) != 0 || VertexStride < 3 * sizeof(float) || VertexStride > s_MaxVertexFloats * sizeof(float))
+	{
+		throw std::runtime_error("Failed to weld vertices, unsupported vertex stride!");
+	}
+
+	auto StartTime = std::chrono::high_resolution_clock::now();
+
+	WeldInput Input;
+	Input.pVertices = static_cast<const uint8_t *>(pVertices);
+	Input.VertexStride = VertexStride;
+	Input.FloatCount = VertexStride / sizeof(float);
+	Input.InverseEpsilon = SnapEpsilon > 0.0f ? 1.0f / SnapEpsilon : 0.0f;
+
+	uint32_t PartitionCount = 1;
+	if (pPool && VertexCount >= VERTEX_WELDER_MIN_PARALLEL_VERTICES)
+	{
+		PartitionCount = std::max(1u, pPool->GetThreadCount());
+	}
+
+	std::vector<uint32_t> Representatives(VertexCount);
+
+	if (PartitionCount == 1)
+	{
+		std::vector<uint32_t> Vertices(VertexCount);
+		for (size_t i = 0; i < VertexCount; i++)
+		{
+			Vertices[i] = static_cast<uint32_t>(i);
+		}
+		WeldPartition(Input, Vertices.data(), VertexCount, Representatives.data());
+	}
+	else
+	{
+		/**
+		* Equal vertices have equal keys and so equal key positions, slabs of the key position never
+		* separate them. The slabs are cut on a histogram so they hold about the same number of vertices.
+		*/
+		auto GetKeyPosition = [&Input](size_t Vertex, int Axis)
+		{
+			float Key[s_MaxVertexFloats];
+			MakeWeldKey(Input, Vertex, Key);
+			return Key[Axis];
+		};
+
+		std::vector<float> RangeMin(PartitionCount * 3, std::numeric_limits<float>::max());
+		std::vector<float> RangeMax(PartitionCount * 3, std::numeric_limits<float>::lowest());
+
+		ForEachRange(pPool, VertexCount, PartitionCount, [&](uint32_t Range, size_t Begin, size_t End)
+		{
+			float Key[s_MaxVertexFloats];
+			for (size_t i = Begin; i < End; i++)
+			{
+				MakeWeldKey(Input, i, Key);
+				for (int Axis = 0; Axis < 3; Axis++)
+				{
+					/** Written so NaN never widens the bounds */
+					RangeMin[Range * 3 + Axis] = Key[Axis] < RangeMin[Range * 3 + Axis] ? Key[Axis] : RangeMin[Range * 3 + Axis];
+					RangeMax[Range * 3 + Axis] = Key[Axis] > RangeMax[Range * 3 + Axis] ? Key[Axis] : RangeMax[Range * 3 + Axis];
+				}
+			}
+		});
+
+		float Min[3], Max[3];
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			Min[Axis] = std::numeric_limits<float>::max();
+			Max[Axis] = std::numeric_limits<float>::lowest();
+			for (uint32_t Range = 0; Range < PartitionCount; Range++)
+			{
+				Min[Axis] = std::min(Min[Axis], RangeMin[Range * 3 + Axis]);
+				Max[Axis] = std::max(Max[Axis], RangeMax[Range * 3 + Axis]);
+			}
+		}
+
+		int Axis = 0;
+		for (int i = 1; i < 3; i++)
+		{
+			Axis = Max[i] - Min[i] > Max[Axis] - Min[Axis] ? i : Axis;
+		}
+
+		const float AxisMin = Min[Axis];
+		const float BinScale = Max[Axis] > Min[Axis] ? s_PartitionBins / (Max[Axis] - Min[Axis]) : 0.0f;
+
+		/** NaN and infinite positions all land in the first bin */
+		auto GetBin = [&](size_t Vertex)
+		{
+			float Bin = (GetKeyPosition(Vertex, Axis) - AxisMin) * BinScale;
+			return Bin >= 0.0f ? std::min(static_cast<uint32_t>(Bin), s_PartitionBins - 1) : 0u;
+		};
+
+		std::vector<uint32_t> Bins(VertexCount);
+		std::vector<uint32_t> RangeHistograms(PartitionCount * s_PartitionBins, 0);
+
+		ForEachRange(pPool, VertexCount, PartitionCount, [&](uint32_t Range, size_t Begin, size_t End)
+		{
+			uint32_t * pHistogram = &RangeHistograms[Range * s_PartitionBins];
+			for (size_t i = Begin; i < End; i++)
+			{
+				Bins[i] = GetBin(i);
+				pHistogram[Bins[i]]++;
+			}
+		});
+
+		std::vector<uint32_t> BinPartitions(s_PartitionBins);
+		size_t Accumulated = 0;
+		for (uint32_t Bin = 0; Bin < s_PartitionBins; Bin++)
+		{
+			size_t BinCount = 0;
+			for (uint32_t Range = 0; Range < PartitionCount; Range++)
+			{
+				BinCount += RangeHistograms[Range * s_PartitionBins + Bin];
+			}
+
+			/** A bin belongs to the partition its middle vertex falls into */
+			size_t Middle = Accumulated + BinCount / 2;
+			BinPartitions[Bin] = static_cast<uint32_t>(std::min<size_t>(Middle * PartitionCount / VertexCount, PartitionCount - 1));
+			Accumulated += BinCount;
+		}
+
+		/** Counting sort by partition, stable so every partition lists its vertices in ascending order */
+		std::vector<size_t> PartitionOffsets(PartitionCount + 1, 0);
+		for (size_t i = 0; i < VertexCount; i++)
+		{
+			PartitionOffsets[BinPartitions[Bins[i]] + 1]++;
+		}
+		for (uint32_t p = 0; p < PartitionCount; p++)
+		{
+			PartitionOffsets[p + 1] += PartitionOffsets[p];
+		}
+
+		std::vector<uint32_t> PartitionVertices(VertexCount);
+		std::vector<size_t> Fill(PartitionOffsets.begin(), PartitionOffsets.end() - 1);
+		for (size_t i = 0; i < VertexCount; i++)
+		{
+			PartitionVertices[Fill[BinPartitions[Bins[i]]]++] = static_cast<uint32_t>(i);
+		}
+
+		/** Partitions write disjoint entries of Representatives */
+		pPool->ParallelFor(PartitionCount, [&](uint32_t Partition)
+		{
+			size_t Begin = PartitionOffsets[Partition];
+			WeldPartition(Input, &PartitionVertices[Begin], PartitionOffsets[Partition + 1] - Begin, Representatives.data());
+		});
+	}
+
+	/** A representative is the first vertex with its key, so it always comes before its duplicates */
+	Remap.resize(VertexCount);
+	uint32_t NewVertexCount = 0;
+
+	for (size_t i = 0; i < VertexCount; i++)
+	{
+		Remap[i] = Representatives[i] == i ? NewVertexCount++ : Remap[Representatives[i]];
+	}
+
+	if (pStatistics)
+	{
+		pStatistics->VerticesBefore = VertexCount;
+		pStatistics->VerticesAfter = NewVertexCount;
+		pStatistics->Partitions = PartitionCount;
+		pStatistics->Milliseconds = std::chrono::duration<double, std::chrono::milliseconds::period>(
+			std::chrono::high_resolution_clock::now() - StartTime
+			).count();
+	}
+
+	return NewVertexCount;
+}
+
+NAMESPACE_END
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Namespace.hpp"
+
+NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
+
+class ThreadPool;
+
+/** Below this many vertices the partitioning costs more than the threads save. */
+const size_t VERTEX_WELDER_MIN_PARALLEL_VERTICES = 1 << 16;
+
+struct VertexWeldStatistics
+{
+	size_t VerticesBefore = 0;
+	size_t VerticesAfter = 0;
+	/** Spatial partitions hashed in parallel, 1 if the welder ran on the calling thread */
+	uint32_t Partitions = 0;
+	double Milliseconds = 0.0;
+
+	/** Share of the input vertices that were duplicates */
+	float GetDuplicateRatio() const;
+};
+
+/**
+* Finds vertices whose attributes are all equal and builds a remap table in the format of
+* OptimizeVertexFetch, Remap[i] is the new index of vertex i and new indices follow the order of
+* first occurrence. Vertices are VertexStride bytes of floats starting with the position, every float
+* is compared. With a SnapEpsilon above zero every float is snapped to a grid of that spacing before
+* comparing, values closer than the spacing usually but not always weld (not across a grid line).
+* Large inputs are split into slabs of the position along its longest axis, hashed on Pool; the
+* result does not depend on the thread count. Returns the new vertex count.
+*/
+size_t WeldVertices(
+	const void * pVertices,
+	size_t VertexStride,
+	size_t VertexCount,
+	std::vector<uint32_t> & Remap,
+	float SnapEpsilon = 0.0f,
+	ThreadPool * pPool = nullptr,
+	VertexWeldStatistics * pStatistics = nullptr
+);
+
+NAMESPACE_END
@@ -1,6 +1,6 @@
 #include "VulkanHelper.hpp"
+#include "UploadContext.hpp"
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include <memory>
@@ -60,14 +60,39 @@ bool CheckValidationLayerSupport(
 	return true;
 }
 
+bool CheckInstanceExtensionSupport(
+	const char * pExtension
+)
+{
+	uint32_t ExtensionCount = 0;
+	vkEnumerateInstanceExtensionProperties(nullptr, &ExtensionCount, nullptr);
+	std::unique_ptr<VkExtensionProperties[]> AvailableExtensions(new VkExtensionProperties[ExtensionCount]);
+	vkEnumerateInstanceExtensionProperties(nullptr, &ExtensionCount, AvailableExtensions.get());
+
+	for (uint32_t i = 0; i < ExtensionCount; i++)
+	{
+		if (strcmp(pExtension, AvailableExtensions[i].extensionName) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 std::vector<const char *> GetRequiredExtensions(
-	bool bEnableValidationLayers
+	bool bEnableValidationLayers,
+	bool bHeadless
 )
 {
-	uint32_t GlfwExtensionCount = 0;
-	const char ** ppGlfwExtensions = glfwGetRequiredInstanceExtensions(&GlfwExtensionCount);
+	std::vector<const char *> Extensions;
 
-	std::vector<const char *> Extensions(ppGlfwExtensions, ppGlfwExtensions + GlfwExtensionCount);
+	if (!bHeadless)
+	{
+		uint32_t GlfwExtensionCount = 0;
+		const char ** ppGlfwExtensions = glfwGetRequiredInstanceExtensions(&GlfwExtensionCount);
+		Extensions.assign(ppGlfwExtensions, ppGlfwExtensions + GlfwExtensionCount);
+	}
 
 	if (bEnableValidationLayers)
 	{
@@ -85,9 +110,9 @@ bool IsPhysicalDeviceSuitable(
 {
 	QueueFamilyIndices Indices = FindQueueFamilies(Device, Surface);
 	bool bExtensionsSupported = CheckPhysicalDeviceExtensionsSupport(Device, Extensions);
-	bool bSwapChainAdequate = false;
+	bool bSwapChainAdequate = Surface == VK_NULL_HANDLE;
 
-	if (bExtensionsSupported)
+	if (bExtensionsSupported && Surface != VK_NULL_HANDLE)
 	{
 		SwapChainSupportDetails SwapChainSupport = QuerySwapChainSupport(Device, Surface);
 		bSwapChainAdequate = !SwapChainSupport.Formats.empty() && !SwapChainSupport.PresentModes.empty();
@@ -121,11 +146,18 @@ QueueFamilyIndices FindQueueFamilies(
 			Indices.GraphicsFamily = i;
 		}
 
-		VkBool32 bPresentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(Device, i, Surface, &bPresentSupport);
-		if (QueueFamilies[i].queueCount > 0 && bPresentSupport)
+		if (Surface == VK_NULL_HANDLE)
 		{
-			Indices.PresentFamily = i;
+			Indices.PresentFamily = Indices.GraphicsFamily;
+		}
+		else
+		{
+			VkBool32 bPresentSupport = false;
+			vkGetPhysicalDeviceSurfaceSupportKHR(Device, i, Surface, &bPresentSupport);
+			if (QueueFamilies[i].queueCount > 0 && bPresentSupport)
+			{
+				Indices.PresentFamily = i;
+			}
 		}
 
 		if (Indices.IsComplete())
@@ -134,6 +166,17 @@ QueueFamilyIndices FindQueueFamilies(
 		}
 	}
 
+	for (uint32_t i = 0; i < QueueFamilyCount; i++)
+	{
+		if (QueueFamilies[i].queueCount > 0 &&
+			QueueFamilies[i].queueFlags & VK_QUEUE_TRANSFER_BIT &&
+			!(QueueFamilies[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+		{
+			Indices.TransferFamily = i;
+			break;
+		}
+	}
+
 	return Indices;
 }
 
@@ -374,8 +417,8 @@ uint32_t FindMemoryType(
 }
 
 void CreateBuffer(
-	VkPhysicalDevice PhysicalDevice,
 	VkDevice Device,
+	MemoryAllocator & Allocator,
 	VkDeviceSize Size,
 	VkBufferUsageFlags Usage,
 	VkMemoryPropertyFlags Properties,
@@ -393,20 +436,7 @@ void CreateBuffer(
 		throw std::runtime_error("Failed to create vertex buffer!");
 	}
 
-	VkMemoryRequirements MemoryRequirements;
-	vkGetBufferMemoryRequirements(Device, Buffer.Buffer, &MemoryRequirements);
-
-	VkMemoryAllocateInfo AllocInfo = {};
-	AllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	AllocInfo.allocationSize = MemoryRequirements.size;
-	AllocInfo.memoryTypeIndex = FindMemoryType(PhysicalDevice, MemoryRequirements.memoryTypeBits, Properties);
-
-	if (vkAllocateMemory(Device, &AllocInfo, nullptr, &Buffer.Memory) != VK_SUCCESS)
-	{
-		throw std::runtime_error("Failed to allocate vertex buffer memory!");
-	}
-
-	vkBindBufferMemory(Device, Buffer.Buffer, Buffer.Memory, 0);
+	Allocator.AllocateForBuffer(Buffer.Buffer, Properties, Buffer.Allocation);
 }
 
 void CopyBuffer(
@@ -430,8 +460,8 @@ void CopyBuffer(
 }
 
 void CreateImage(
-	VkPhysicalDevice PhysicalDevice,
 	VkDevice Device,
+	MemoryAllocator & Allocator,
 	uint32_t Width,
 	uint32_t Height,
 	uint32_t MipLevels,
@@ -441,7 +471,7 @@ void CreateImage(
 	VkImageUsageFlags Usage,
 	VkMemoryPropertyFlags Properties,
 	VkImage & Image,
-	VkDeviceMemory & ImageMemory
+	MemoryAllocation & ImageAllocation
 )
 {
 	VkImageCreateInfo ImageCreateInfo = {};
@@ -464,20 +494,46 @@ void CreateImage(
 		throw std::runtime_error("Failed to create texture image!");
 	}
 
-	VkMemoryRequirements MemRequirements;
-	vkGetImageMemoryRequirements(Device, Image, &MemRequirements);
+	Allocator.AllocateForImage(Image, Properties, ImageAllocation);
+}
 
-	VkMemoryAllocateInfo AllocInfo = {};
-	AllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	AllocInfo.allocationSize = MemRequirements.size;
-	AllocInfo.memoryTypeIndex = FindMemoryType(PhysicalDevice, MemRequirements.memoryTypeBits, Properties);
+VkDeviceSize GetImageMemorySize(
+	VkDevice Device,
+	uint32_t Width,
+	uint32_t Height,
+	uint32_t MipLevels,
+	VkFormat Format,
+	VkImageTiling Tiling,
+	VkImageUsageFlags Usage
+)
+{
+	VkImageCreateInfo ImageCreateInfo = {};
+	ImageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	ImageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	ImageCreateInfo.extent.width = Width;
+	ImageCreateInfo.extent.height = Height;
+	ImageCreateInfo.extent.depth = 1;
+	ImageCreateInfo.mipLevels = MipLevels;
+	ImageCreateInfo.arrayLayers = 1;
+	ImageCreateInfo.format = Format;
+	ImageCreateInfo.tiling = Tiling;
+	ImageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	ImageCreateInfo.usage = Usage;
+	ImageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	ImageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 
-	if (vkAllocateMemory(Device, &AllocInfo, nullptr, &ImageMemory) != VK_SUCCESS)
+	VkImage Image = VK_NULL_HANDLE;
+	if (vkCreateImage(Device, &ImageCreateInfo, nullptr, &Image) != VK_SUCCESS)
 	{
-		throw std::runtime_error("Failed to allocate texture image memory!");
+		throw std::runtime_error("Failed to create texture image!");
 	}
 
-	vkBindImageMemory(Device, Image, ImageMemory, 0);
+	VkMemoryRequirements MemoryRequirements;
+	vkGetImageMemoryRequirements(Device, Image, &MemoryRequirements);
+
+	vkDestroyImage(Device, Image, nullptr);
+
+	return MemoryRequirements.size;
 }
 
 VkCommandBuffer BeginSingleTimeCommands(
@@ -536,6 +592,20 @@ void TransitionImageLayout(
 {
 	VkCommandBuffer CommandBuffer = BeginSingleTimeCommands(Device, CommandPool);
 
+	CmdTransitionImageLayout(CommandBuffer, Image, Format, MipLevels, OldLayout, NewLayout);
+
+	EndSingleTimeCommands(Device, Queue, CommandPool, CommandBuffer);
+}
+
+void CmdTransitionImageLayout(
+	VkCommandBuffer CommandBuffer,
+	VkImage Image,
+	VkFormat Format,
+	uint32_t MipLevels,
+	VkImageLayout OldLayout,
+	VkImageLayout NewLayout
+)
+{
 	VkImageMemoryBarrier Barrier = {};
 	Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	Barrier.oldLayout = OldLayout;
@@ -616,8 +686,6 @@ void TransitionImageLayout(
 		1,
 		&Barrier
 	);
-
-	EndSingleTimeCommands(Device, Queue, CommandPool, CommandBuffer);
 }
 
 void CopyBufferToImage(
@@ -632,8 +700,22 @@ void CopyBufferToImage(
 {
 	VkCommandBuffer CommandBuffer = BeginSingleTimeCommands(Device, CommandPool);
 
+	CmdCopyBufferToImage(CommandBuffer, SrcBuffer, 0, DstImage, Width, Height);
+
+	EndSingleTimeCommands(Device, Queue, CommandPool, CommandBuffer);
+}
+
+void CmdCopyBufferToImage(
+	VkCommandBuffer CommandBuffer,
+	VkBuffer SrcBuffer,
+	VkDeviceSize SrcOffset,
+	VkImage DstImage,
+	uint32_t Width,
+	uint32_t Height
+)
+{
 	VkBufferImageCopy Region = {};
-	Region.bufferOffset = 0;
+	Region.bufferOffset = SrcOffset;
 	Region.bufferRowLength = 0;
 	Region.bufferImageHeight = 0;
 	Region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -651,8 +733,6 @@ void CopyBufferToImage(
 		1,
 		&Region
 	);
-
-	EndSingleTimeCommands(Device, Queue, CommandPool, CommandBuffer);
 }
 
 void GenerateMipmaps(
@@ -666,6 +746,23 @@ void GenerateMipmaps(
 	uint32_t Height,
 	uint32_t MipLevels
 )
+{
+	VkCommandBuffer CommandBuffer = BeginSingleTimeCommands(Device, CommandPool);
+
+	CmdGenerateMipmaps(PhysicalDevice, CommandBuffer, Image, Format, Width, Height, MipLevels);
+
+	EndSingleTimeCommands(Device, Queue, CommandPool, CommandBuffer);
+}
+
+void CmdGenerateMipmaps(
+	VkPhysicalDevice PhysicalDevice,
+	VkCommandBuffer CommandBuffer,
+	VkImage Image,
+	VkFormat Format,
+	uint32_t Width,
+	uint32_t Height,
+	uint32_t MipLevels
+)
 {
 	/** Check if image format supports linear blitting */
 	VkFormatProperties FormatProperties;
@@ -676,8 +773,6 @@ void GenerateMipmaps(
 		throw std::runtime_error("Texture image format does not support linear blitting!");
 	}
 
-	VkCommandBuffer CommandBuffer = BeginSingleTimeCommands(Device, CommandPool);
-
 	VkImageMemoryBarrier Barrier = {};
 	Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	Barrier.image = Image;
@@ -789,8 +884,6 @@ void GenerateMipmaps(
 		1,
 		&Barrier
 	);
-
-	EndSingleTimeCommands(Device, Queue, CommandPool, CommandBuffer);
 }
 
 VkSampleCountFlagBits GetMaxUsableSampleCount(
@@ -817,12 +910,12 @@ VkSampleCountFlagBits GetMaxUsableSampleCount(
 void CreateTextureImageFromFile(
 	VkPhysicalDevice PhysicalDevice,
 	VkDevice Device,
-	VkCommandPool CommandPool,
-	VkQueue Queue,
+	MemoryAllocator & Allocator,
+	UploadContext & Uploader,
 	const char * pFilename,
 	uint32_t & MipLevels,
 	VkImage & TextureImage,
-	VkDeviceMemory & TextureImageMemory
+	MemoryAllocation & TextureImageAllocation
 )
 {
 	int TexWidth = -1, TexHeight = -1, TexChannels = -1;
@@ -849,24 +942,9 @@ void CreateTextureImageFromFile(
 		MipLevels = 1;
 	}
 
-	BufferInfo StagingBuffer;
-
-	CreateBuffer(
-		PhysicalDevice,
-		Device,
-		ImageSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		StagingBuffer
-	);
-
-	MapMemory(Device, StagingBuffer.Memory, ImageSize, pPixels);
-
-	stbi_image_free(pPixels);
-
 	CreateImage(
-		PhysicalDevice,
 		Device,
+		Allocator,
 		static_cast<uint32_t>(TexWidth),
 		static_cast<uint32_t>(TexHeight),
 		MipLevels,
@@ -878,50 +956,28 @@ void CreateTextureImageFromFile(
 		VK_IMAGE_USAGE_SAMPLED_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		TextureImage,
-		TextureImageMemory
+		TextureImageAllocation
 	);
 
-	TransitionImageLayout(
-		Device,
-		Queue,
-		CommandPool,
+	/** The copy and the mipmap generation are recorded into the current upload batch */
+	Uploader.UploadImage(
+		pPixels,
+		ImageSize,
 		TextureImage,
 		VK_FORMAT_R8G8B8A8_UNORM,
-		MipLevels,
-		VK_IMAGE_LAYOUT_UNDEFINED,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-	);
-
-	CopyBufferToImage(
-		Device,
-		Queue,
-		CommandPool,
-		StagingBuffer.Buffer,
-		TextureImage,
 		static_cast<uint32_t>(TexWidth),
-		static_cast<uint32_t>(TexHeight)
-	);
-
-	GenerateMipmaps(
-		PhysicalDevice,
-		Device,
-		CommandPool,
-		Queue,
-		TextureImage,
-		VK_FORMAT_R8G8B8A8_UNORM,
-		TexWidth,
-		TexHeight,
+		static_cast<uint32_t>(TexHeight),
 		MipLevels
 	);
 
-	DestroyBuffer(Device, StagingBuffer);
+	stbi_image_free(pPixels);
 }
 
 void CreateTextureFromFile(
 	VkPhysicalDevice PhysicalDevice,
 	VkDevice Device,
-	VkCommandPool CommandPool,
-	VkQueue Queue,
+	MemoryAllocator & Allocator,
+	UploadContext & Uploader,
 	const char * pFilename,
 	TextureInfo & Texture
 )
@@ -929,12 +985,12 @@ void CreateTextureFromFile(
 	CreateTextureImageFromFile(
 		PhysicalDevice,
 		Device,
-		CommandPool,
-		Queue,
+		Allocator,
+		Uploader,
 		pFilename,
 		Texture.MipLevels,
 		Texture.TextureImage,
-		Texture.TextureImageMemory
+		Texture.TextureImageAllocation
 	);
 
 	CreateImageView(
@@ -946,6 +1002,15 @@ void CreateTextureFromFile(
 		Texture.TextureImageView
 	);
 
+	CreateTextureSampler(Device, Texture.MipLevels, Texture.TextureSampler);
+}
+
+void CreateTextureSampler(
+	VkDevice Device,
+	uint32_t MipLevels,
+	VkSampler & Sampler
+)
+{
 	VkSamplerCreateInfo CreateInfo = {};
 	CreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
 	CreateInfo.magFilter = VK_FILTER_LINEAR;
@@ -962,9 +1027,9 @@ void CreateTextureFromFile(
 	CreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	CreateInfo.mipLodBias = 0.0f;
 	CreateInfo.minLod = 0.0f;
-	CreateInfo.maxLod = static_cast<float>(Texture.MipLevels);
+	CreateInfo.maxLod = static_cast<float>(MipLevels);
 
-	if (vkCreateSampler(Device, &CreateInfo, nullptr, &Texture.TextureSampler) != VK_SUCCESS)
+	if (vkCreateSampler(Device, &CreateInfo, nullptr, &Sampler) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create texture sampler!");
 	}
@@ -972,35 +1037,24 @@ void CreateTextureFromFile(
 
 void DestroyTexture(
 	VkDevice Device,
+	MemoryAllocator & Allocator,
 	TextureInfo & Texture
 )
 {
 	vkDestroySampler(Device, Texture.TextureSampler, nullptr);
 	vkDestroyImageView(Device, Texture.TextureImageView, nullptr);
 	vkDestroyImage(Device, Texture.TextureImage, nullptr);
-	vkFreeMemory(Device, Texture.TextureImageMemory, nullptr);
+	Allocator.Free(Texture.TextureImageAllocation);
 }
 
 void DestroyBuffer(
 	VkDevice Device,
+	MemoryAllocator & Allocator,
 	BufferInfo & Buffer
 )
 {
 	vkDestroyBuffer(Device, Buffer.Buffer, nullptr);
-	vkFreeMemory(Device, Buffer.Memory, nullptr);
-}
-
-void MapMemory(
-	VkDevice Device,
-	VkDeviceMemory Memory,
-	VkDeviceSize Size,
-	void * pData
-)
-{
-	void * pMappedData = nullptr;
-	vkMapMemory(Device, Memory, 0, Size, 0, &pMappedData);
-	memcpy(pMappedData, pData, Size);
-	vkUnmapMemory(Device, Memory);
+	Allocator.Free(Buffer.Allocation);
 }
 
 NAMESPACE_BEGIN(ProxyVulkanFunction)
@@ -1041,6 +1095,23 @@ void vkDestroyDebugUtilsMessengerEXT(
 	}
 }
 
+void vkGetPhysicalDeviceMemoryProperties2KHR(
+	VkInstance Instance,
+	VkPhysicalDevice PhysicalDevice,
+	VkPhysicalDeviceMemoryProperties2KHR * pMemoryProperties
+)
+{
+	static auto Func = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(Instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+	if (Func != nullptr)
+	{
+		Func(PhysicalDevice, pMemoryProperties);
+	}
+	else
+	{
+		std::cerr << "Function vkGetPhysicalDeviceMemoryProperties2KHR not found!" << std::endl;
+	}
+}
+
 NAMESPACE_END
 
 NAMESPACE_END
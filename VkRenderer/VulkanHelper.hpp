@@ -10,13 +10,18 @@
 #include <cstdint>
 
 #include "Namespace.hpp"
+#include "MemoryAllocator.hpp"
 
 NAMESPACE_BEGIN(GLOBAL_NAMESPACE)
 
+class UploadContext;
+
 struct QueueFamilyIndices
 {
 	std::optional<uint32_t> GraphicsFamily;
 	std::optional<uint32_t> PresentFamily;
+	/** A transfer only family (usually a DMA engine), not required. */
+	std::optional<uint32_t> TransferFamily;
 
 	bool IsComplete() const;
 };
@@ -36,6 +41,7 @@ struct SwapChainInfo
 
 	/** The images were created by the implementation for the swap chain and
 	* they will be automatically cleaned up once the swap chain has been destroyed.
+	* In headless mode there is no swap chain, they are offscreen images owned by the app.
 	*/
 	std::vector<VkImage> SwapChainImages;
 	std::vector<VkImageView> SwapChainImageViews;
@@ -43,11 +49,11 @@ struct SwapChainInfo
 	VkExtent2D SwapChainExtent = { 0, 0 };
 
 	VkImage ColorImage = VK_NULL_HANDLE;
-	VkDeviceMemory ColorImageMemory = VK_NULL_HANDLE;
+	MemoryAllocation ColorImageAllocation;
 	VkImageView ColorImageView = VK_NULL_HANDLE;
 
 	VkImage DepthImage = VK_NULL_HANDLE;
-	VkDeviceMemory DepthImageMemory = VK_NULL_HANDLE;
+	MemoryAllocation DepthImageAllocation;
 	VkImageView DepthImageView = VK_NULL_HANDLE;
 
 	std::vector<VkFramebuffer> SwapChainFramebuffers;
@@ -58,7 +64,7 @@ struct SwapChainInfo
 struct BufferInfo
 {
 	VkBuffer Buffer = VK_NULL_HANDLE;
-	VkDeviceMemory Memory = VK_NULL_HANDLE;
+	MemoryAllocation Allocation;
 
 	template <typename TBuffer>
 	VkDescriptorBufferInfo GetDescriptorBufferInfo() const
@@ -75,7 +81,7 @@ struct TextureInfo
 {
 	uint32_t MipLevels = 0;
 	VkImage TextureImage = VK_NULL_HANDLE;
-	VkDeviceMemory TextureImageMemory = VK_NULL_HANDLE;
+	MemoryAllocation TextureImageAllocation;
 	VkImageView TextureImageView = VK_NULL_HANDLE;
 	VkSampler TextureSampler = VK_NULL_HANDLE;
 
@@ -86,16 +92,25 @@ bool CheckValidationLayerSupport(
 	const std::vector<const char *> & Layers
 );
 
+/** Optional instance extensions are only enabled if this is true. */
+bool CheckInstanceExtensionSupport(
+	const char * pExtension
+);
+
+/** Headless instances do not need the window system extensions reported by GLFW. */
 std::vector<const char *> GetRequiredExtensions(
-	bool bEnableValidationLayers
+	bool bEnableValidationLayers,
+	bool bHeadless
 );
 
+/** Without a surface (headless) presentation and swap chain support are not required. */
 bool IsPhysicalDeviceSuitable(
 	VkPhysicalDevice Device,
 	VkSurfaceKHR Surface,
 	const std::vector<const char *> Extensions
 );
 
+/** Without a surface (headless) the graphics family stands in for the present family. */
 QueueFamilyIndices FindQueueFamilies(
 	VkPhysicalDevice Device,
 	VkSurfaceKHR Surface
@@ -162,8 +177,8 @@ uint32_t FindMemoryType(
 );
 
 void CreateBuffer(
-	VkPhysicalDevice PhysicalDevice,
 	VkDevice Device,
+	MemoryAllocator & Allocator,
 	VkDeviceSize Size,
 	VkBufferUsageFlags Usage,
 	VkMemoryPropertyFlags Properties,
@@ -180,8 +195,8 @@ void CopyBuffer(
 );
 
 void CreateImage(
-	VkPhysicalDevice PhysicalDevice,
 	VkDevice Device,
+	MemoryAllocator & Allocator,
 	uint32_t Width,
 	uint32_t Height,
 	uint32_t MipLevels,
@@ -191,7 +206,18 @@ void CreateImage(
 	VkImageUsageFlags Usage,
 	VkMemoryPropertyFlags Properties,
 	VkImage & Image,
-	VkDeviceMemory & ImageMemory
+	MemoryAllocation & ImageAllocation
+);
+
+/** Device memory CreateImage would allocate for such an image, from a throwaway image without memory. */
+VkDeviceSize GetImageMemorySize(
+	VkDevice Device,
+	uint32_t Width,
+	uint32_t Height,
+	uint32_t MipLevels,
+	VkFormat Format,
+	VkImageTiling Tiling,
+	VkImageUsageFlags Usage
 );
 
 VkCommandBuffer BeginSingleTimeCommands(
@@ -217,6 +243,15 @@ void TransitionImageLayout(
 	VkImageLayout NewLayout
 );
 
+void CmdTransitionImageLayout(
+	VkCommandBuffer CommandBuffer,
+	VkImage Image,
+	VkFormat Format,
+	uint32_t MipLevels,
+	VkImageLayout OldLayout,
+	VkImageLayout NewLayout
+);
+
 void CopyBufferToImage(
 	VkDevice Device,
 	VkQueue Queue,
@@ -227,6 +262,15 @@ void CopyBufferToImage(
 	uint32_t Height
 );
 
+void CmdCopyBufferToImage(
+	VkCommandBuffer CommandBuffer,
+	VkBuffer SrcBuffer,
+	VkDeviceSize SrcOffset,
+	VkImage DstImage,
+	uint32_t Width,
+	uint32_t Height
+);
+
 void GenerateMipmaps(
 	VkPhysicalDevice PhysicalDevice,
 	VkDevice Device,
@@ -239,6 +283,16 @@ void GenerateMipmaps(
 	uint32_t MipLevels
 );
 
+void CmdGenerateMipmaps(
+	VkPhysicalDevice PhysicalDevice,
+	VkCommandBuffer CommandBuffer,
+	VkImage Image,
+	VkFormat Format,
+	uint32_t Width,
+	uint32_t Height,
+	uint32_t MipLevels
+);
+
 VkSampleCountFlagBits GetMaxUsableSampleCount(
 	VkPhysicalDevice Device
 );
@@ -246,40 +300,41 @@ VkSampleCountFlagBits GetMaxUsableSampleCount(
 void CreateTextureImageFromFile(
 	VkPhysicalDevice PhysicalDevice,
 	VkDevice Device,
-	VkCommandPool CommandPool,
-	VkQueue Queue,
+	MemoryAllocator & Allocator,
+	UploadContext & Uploader,
 	const char * pFilename,
 	uint32_t & MipLevels,
 	VkImage & TextureImage,
-	VkDeviceMemory & TextureImageMemory
+	MemoryAllocation & TextureImageAllocation
 );
 
 void CreateTextureFromFile(
 	VkPhysicalDevice PhysicalDevice,
 	VkDevice Device,
-	VkCommandPool CommandPool,
-	VkQueue Queue,
+	MemoryAllocator & Allocator,
+	UploadContext & Uploader,
 	const char * pFilename,
 	TextureInfo & Texture
 );
 
+void CreateTextureSampler(
+	VkDevice Device,
+	uint32_t MipLevels,
+	VkSampler & Sampler
+);
+
 void DestroyTexture(
 	VkDevice Device,
+	MemoryAllocator & Allocator,
 	TextureInfo & Texture
 );
 
 void DestroyBuffer(
 	VkDevice Device,
+	MemoryAllocator & Allocator,
 	BufferInfo & Buffer
 );
 
-void MapMemory(
-	VkDevice Device,
-	VkDeviceMemory Memory,
-	VkDeviceSize Size,
-	void * pData
-);
-
 namespace ProxyVulkanFunction
 {
 
@@ -296,6 +351,13 @@ void vkDestroyDebugUtilsMessengerEXT(
 	const VkAllocationCallbacks * pAllocator
 );
 
+/** Needs VK_KHR_get_physical_device_properties2, the instance is a Vulkan 1.0 one */
+void vkGetPhysicalDeviceMemoryProperties2KHR(
+	VkInstance Instance,
+	VkPhysicalDevice PhysicalDevice,
+	VkPhysicalDeviceMemoryProperties2KHR * pMemoryProperties
+);
+
 }
 
 NAMESPACE_END
\ No newline at end of file